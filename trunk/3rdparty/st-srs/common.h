@@ -209,12 +209,22 @@ typedef struct _st_mutex {
 } _st_mutex_t;
 
 
+typedef struct _st_pollq_link {
+    struct _st_pollq_link *next; /* Next pollq waiting on the descriptor */
+    struct _st_pollq_link *prev; /* Previous pollq waiting on the descriptor */
+    struct _st_pollq *pq;       /* The pollq of link */
+    int fd;                     /* The descriptor of link */
+} _st_pollq_link_t;
+
+
 typedef struct _st_pollq {
     _st_clist_t links;          /* For putting on io queue */
     _st_thread_t  *thread;      /* Polling thread */
     struct pollfd *pds;         /* Array of poll descriptors */
     int npds;                   /* Length of the array */
     int on_ioq;                 /* Is it on ioq? */
+    _st_pollq_link_t *fd_links; /* Links for each descriptor, to find the pollq by descriptor */
+    _st_pollq_link_t fd_link;   /* Link for single descriptor, to avoid malloc */
 } _st_pollq_t;
 
 
@@ -228,6 +238,9 @@ typedef struct _st_eventsys_ops {
     int  (*fd_new)(int);                       /* New descriptor allocated */
     int  (*fd_close)(int);                     /* Descriptor closed */
     int  (*fd_getlimit)(void);                 /* Descriptor hard limit */
+    int  (*pollq_add)(_st_pollq_t *);          /* Link pollq or return ready count, optional */
+    void (*pollq_del)(_st_pollq_t *);          /* Unlink pollq from its descriptors, optional */
+    void (*fd_unready)(int, int);              /* Descriptor returned EAGAIN, optional */
 } _st_eventsys_t;
 
 
@@ -119,6 +119,9 @@ typedef struct _epoll_fd_data {
     int wr_ref_cnt;
     int ex_ref_cnt;
     int revents;
+    _st_pollq_link_t *waiters;  /* The pollqs waiting on this descriptor */
+    int registered;             /* The events registered edge-triggered for the netfd lifetime */
+    int ready;                  /* Cached readiness of the registered descriptor */
 } _epoll_fd_data_t;
 
 static struct _st_epolldata {
@@ -141,6 +144,18 @@ static struct _st_epolldata {
 #define _ST_EPOLL_WRITE_CNT(fd)  (_st_epoll_data->fd_data[fd].wr_ref_cnt)
 #define _ST_EPOLL_EXCEP_CNT(fd)  (_st_epoll_data->fd_data[fd].ex_ref_cnt)
 #define _ST_EPOLL_REVENTS(fd)    (_st_epoll_data->fd_data[fd].revents)
+#define _ST_EPOLL_WAITERS(fd)    (_st_epoll_data->fd_data[fd].waiters)
+#define _ST_EPOLL_REGISTERED(fd) (_st_epoll_data->fd_data[fd].registered)
+#define _ST_EPOLL_READY(fd)      (_st_epoll_data->fd_data[fd].ready)
+
+/*
+ * The netfds are registered once with EPOLLET, so waiting on them never touches
+ * the epoll set. An edge is reported only once, so we cache it until the I/O on
+ * the descriptor returns EAGAIN. Most netfds never block on write, so EPOLLOUT
+ * is added by the first write wait and kept, instead of reporting the writable
+ * edges nobody waits for.
+ */
+#define _ST_EPOLL_ET_EVENTS      (EPOLLIN | EPOLLPRI | EPOLLET)
 
 #define _ST_EPOLL_READ_BIT(fd)   (_ST_EPOLL_READ_CNT(fd) ? EPOLLIN : 0)
 #define _ST_EPOLL_WRITE_BIT(fd)  (_ST_EPOLL_WRITE_CNT(fd) ? EPOLLOUT : 0)
@@ -441,7 +456,10 @@ static _st_eventsys_t _st_select_eventsys = {
     _st_select_pollset_del,
     _st_select_fd_new,
     _st_select_fd_close,
-    _st_select_fd_getlimit
+    _st_select_fd_getlimit,
+    NULL,
+    NULL,
+    NULL
 };
 
 
@@ -593,7 +611,10 @@ static _st_eventsys_t _st_poll_eventsys = {
     _st_poll_pollset_del,
     _st_poll_fd_new,
     _st_poll_fd_close,
-    _st_poll_fd_getlimit
+    _st_poll_fd_getlimit,
+    NULL,
+    NULL,
+    NULL
 };
 #endif  /* MD_HAVE_POLL */
 
@@ -1002,7 +1023,10 @@ static _st_eventsys_t _st_kq_eventsys = {
     _st_kq_pollset_del,
     _st_kq_fd_new,
     _st_kq_fd_close,  
-    _st_kq_fd_getlimit
+    _st_kq_fd_getlimit,
+    NULL,
+    NULL,
+    NULL
 };
 #endif  /* MD_HAVE_KQUEUE */
 
@@ -1099,6 +1123,32 @@ ST_HIDDEN void _st_epoll_evtlist_expand(void)
     }
 }
 
+ST_HIDDEN int _st_epoll_register(int osfd, int events)
+{
+    struct epoll_event ev;
+    int op = _ST_EPOLL_REGISTERED(osfd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+    ev.events = events;
+    ev.data.fd = osfd;
+    if (epoll_ctl(_st_epoll_data->epfd, op, osfd, &ev) < 0) {
+        /* The descriptor is being polled by st_poll() with its raw number */
+        if (op != EPOLL_CTL_ADD || errno != EEXIST)
+            return -1;
+        op = EPOLL_CTL_MOD;
+        if (epoll_ctl(_st_epoll_data->epfd, op, osfd, &ev) < 0)
+            return -1;
+    }
+
+    if (op == EPOLL_CTL_ADD) {
+        _st_epoll_data->evtlist_cnt++;
+        if (_st_epoll_data->evtlist_cnt > _st_epoll_data->evtlist_size)
+            _st_epoll_evtlist_expand();
+    }
+    _ST_EPOLL_REGISTERED(osfd) = events;
+
+    return 0;
+}
+
 ST_HIDDEN void _st_epoll_pollset_del(struct pollfd *pds, int npds)
 {
     struct epoll_event ev;
@@ -1121,6 +1171,9 @@ ST_HIDDEN void _st_epoll_pollset_del(struct pollfd *pds, int npds)
         if (pd->events & POLLPRI)
             _ST_EPOLL_EXCEP_CNT(pd->fd)--;
 
+        if (_ST_EPOLL_REGISTERED(pd->fd))
+            continue;
+
         events = _ST_EPOLL_EVENTS(pd->fd);
         /*
          * The _ST_EPOLL_REVENTS check below is needed so we can use
@@ -1167,6 +1220,9 @@ ST_HIDDEN int _st_epoll_pollset_add(struct pollfd *pds, int npds)
         if (pds[i].events & POLLPRI)
             _ST_EPOLL_EXCEP_CNT(fd)++;
 
+        if (_ST_EPOLL_REGISTERED(fd))
+            continue;
+
         events = _ST_EPOLL_EVENTS(fd);
         if (events != old_events) {
             op = old_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
@@ -1194,11 +1250,88 @@ ST_HIDDEN int _st_epoll_pollset_add(struct pollfd *pds, int npds)
     return 0;
 }
 
+ST_HIDDEN int _st_epoll_pollq_add(_st_pollq_t *pq)
+{
+    _st_pollq_link_t *link;
+    struct pollfd *pd;
+    int i, fd, n, ready;
+
+    /* Don't wait if the cached edges of the registered descriptors match */
+    n = 0;
+    for (i = 0; i < pq->npds; i++) {
+        pd = &pq->pds[i];
+        pd->revents = 0;
+        if (!_ST_EPOLL_REGISTERED(pd->fd))
+            continue;
+        /* The EPOLLOUT is added by the first write wait, and epoll reports the current state for it */
+        if ((pd->events & POLLOUT) && !(_ST_EPOLL_REGISTERED(pd->fd) & EPOLLOUT) &&
+            _st_epoll_register(pd->fd, _ST_EPOLL_REGISTERED(pd->fd) | EPOLLOUT) < 0)
+            return -1;
+        ready = _ST_EPOLL_READY(pd->fd);
+        if ((pd->events & POLLIN) && (ready & EPOLLIN))
+            pd->revents |= POLLIN;
+        if ((pd->events & POLLOUT) && (ready & EPOLLOUT))
+            pd->revents |= POLLOUT;
+        if ((pd->events & POLLPRI) && (ready & EPOLLPRI))
+            pd->revents |= POLLPRI;
+        if (ready & EPOLLERR)
+            pd->revents |= POLLERR;
+        if (ready & EPOLLHUP)
+            pd->revents |= POLLHUP;
+        if (pd->revents)
+            n++;
+    }
+    if (n > 0)
+        return n;
+
+    if (pq->npds == 1) {
+        pq->fd_links = &pq->fd_link;
+    } else if ((pq->fd_links = (_st_pollq_link_t *)malloc(pq->npds * sizeof(_st_pollq_link_t))) == NULL) {
+        return -1;
+    }
+
+    /* The descriptors are checked and expanded by _st_epoll_pollset_add() */
+    for (i = 0; i < pq->npds; i++) {
+        fd = pq->pds[i].fd;
+        link = &pq->fd_links[i];
+        link->pq = pq;
+        link->fd = fd;
+        link->prev = NULL;
+        link->next = _ST_EPOLL_WAITERS(fd);
+        if (link->next)
+            link->next->prev = link;
+        _ST_EPOLL_WAITERS(fd) = link;
+    }
+
+    return 0;
+}
+
+ST_HIDDEN void _st_epoll_pollq_del(_st_pollq_t *pq)
+{
+    _st_pollq_link_t *link;
+    int i;
+
+    for (i = 0; i < pq->npds; i++) {
+        link = &pq->fd_links[i];
+        if (link->prev)
+            link->prev->next = link->next;
+        else
+            _ST_EPOLL_WAITERS(link->fd) = link->next;
+        if (link->next)
+            link->next->prev = link->prev;
+    }
+
+    if (pq->fd_links != &pq->fd_link)
+        free(pq->fd_links);
+    pq->fd_links = NULL;
+}
+
 ST_HIDDEN void _st_epoll_dispatch(void)
 {
     st_utime_t min_timeout;
     _st_clist_t *q;
     _st_pollq_t *pq;
+    _st_pollq_link_t *link, *next;
     struct pollfd *pds, *epds;
     struct epoll_event ev;
     int timeout, nfd, i, osfd, notify;
@@ -1223,9 +1356,21 @@ ST_HIDDEN void _st_epoll_dispatch(void)
         fcntl(_st_epoll_data->epfd, F_SETFD, FD_CLOEXEC);
         _st_epoll_data->pid = getpid();
 
-        /* Put all descriptors on ioq into new epoll set */
-        memset(_st_epoll_data->fd_data, 0, _st_epoll_data->fd_data_size * sizeof(_epoll_fd_data_t));
+        /* Put all descriptors on ioq into new epoll set, the waiters are kept */
+        for (i = 0; i < _st_epoll_data->fd_data_size; i++) {
+            _st_epoll_data->fd_data[i].rd_ref_cnt = 0;
+            _st_epoll_data->fd_data[i].wr_ref_cnt = 0;
+            _st_epoll_data->fd_data[i].ex_ref_cnt = 0;
+            _st_epoll_data->fd_data[i].revents = 0;
+            _st_epoll_data->fd_data[i].ready = 0;
+        }
         _st_epoll_data->evtlist_cnt = 0;
+        for (i = 0; i < _st_epoll_data->fd_data_size; i++) {
+            if ((events = _st_epoll_data->fd_data[i].registered) != 0) {
+                _st_epoll_data->fd_data[i].registered = 0;
+                _st_epoll_register(i, events);
+            }
+        }
         for (q = _ST_IOQ.next; q != &_ST_IOQ; q = q->next) {
             pq = _ST_POLLQUEUE_PTR(q);
             _st_epoll_pollset_add(pq->pds, pq->npds);
@@ -1239,54 +1384,67 @@ ST_HIDDEN void _st_epoll_dispatch(void)
         for (i = 0; i < nfd; i++) {
             osfd = _st_epoll_data->evtlist[i].data.fd;
             _ST_EPOLL_REVENTS(osfd) = _st_epoll_data->evtlist[i].events;
+            if (_ST_EPOLL_REGISTERED(osfd))
+                _ST_EPOLL_READY(osfd) |= _ST_EPOLL_REVENTS(osfd);
             if (_ST_EPOLL_REVENTS(osfd) & (EPOLLERR | EPOLLHUP)) {
                 /* Also set I/O bits on error */
                 _ST_EPOLL_REVENTS(osfd) |= _ST_EPOLL_EVENTS(osfd);
             }
         }
 
-        for (q = _ST_IOQ.next; q != &_ST_IOQ; q = q->next) {
-            pq = _ST_POLLQUEUE_PTR(q);
-            notify = 0;
-            epds = pq->pds + pq->npds;
+        /*
+         * Only check the pollqs waiting on the fired descriptors, so the cost is
+         * proportional to the ready descriptors, not all blocked threads on ioq.
+         */
+        for (i = 0; i < nfd; i++) {
+            osfd = _st_epoll_data->evtlist[i].data.fd;
+            for (link = _ST_EPOLL_WAITERS(osfd); link; link = next) {
+                pq = link->pq;
+                next = link->next;
+                notify = 0;
+                epds = pq->pds + pq->npds;
 
-            for (pds = pq->pds; pds < epds; pds++) {
-                if (_ST_EPOLL_REVENTS(pds->fd) == 0) {
-                    pds->revents = 0;
-                    continue;
+                for (pds = pq->pds; pds < epds; pds++) {
+                    if (_ST_EPOLL_REVENTS(pds->fd) == 0) {
+                        pds->revents = 0;
+                        continue;
+                    }
+                    events = pds->events;
+                    revents = 0;
+                    if ((events & POLLIN) && (_ST_EPOLL_REVENTS(pds->fd) & EPOLLIN))
+                        revents |= POLLIN;
+                    if ((events & POLLOUT) && (_ST_EPOLL_REVENTS(pds->fd) & EPOLLOUT))
+                        revents |= POLLOUT;
+                    if ((events & POLLPRI) && (_ST_EPOLL_REVENTS(pds->fd) & EPOLLPRI))
+                        revents |= POLLPRI;
+                    if (_ST_EPOLL_REVENTS(pds->fd) & EPOLLERR)
+                        revents |= POLLERR;
+                    if (_ST_EPOLL_REVENTS(pds->fd) & EPOLLHUP)
+                        revents |= POLLHUP;
+
+                    pds->revents = revents;
+                    if (revents) {
+                        notify = 1;
+                    }
                 }
-                osfd = pds->fd;
-                events = pds->events;
-                revents = 0;
-                if ((events & POLLIN) && (_ST_EPOLL_REVENTS(osfd) & EPOLLIN))
-                    revents |= POLLIN;
-                if ((events & POLLOUT) && (_ST_EPOLL_REVENTS(osfd) & EPOLLOUT))
-                    revents |= POLLOUT;
-                if ((events & POLLPRI) && (_ST_EPOLL_REVENTS(osfd) & EPOLLPRI))
-                    revents |= POLLPRI;
-                if (_ST_EPOLL_REVENTS(osfd) & EPOLLERR)
-                    revents |= POLLERR;
-                if (_ST_EPOLL_REVENTS(osfd) & EPOLLHUP)
-                    revents |= POLLHUP;
+                if (notify) {
+                    ST_REMOVE_LINK(&pq->links);
+                    pq->on_ioq = 0;
+                    /*
+                     * Here we will only delete/modify descriptors that
+                     * didn't fire (see comments in _st_epoll_pollset_del()).
+                     */
+                    _st_epoll_pollq_del(pq);
+                    _st_epoll_pollset_del(pq->pds, pq->npds);
 
-                pds->revents = revents;
-                if (revents) {
-                    notify = 1;
-                }
-            }
-            if (notify) {
-                ST_REMOVE_LINK(&pq->links);
-                pq->on_ioq = 0;
-                /*
-                 * Here we will only delete/modify descriptors that
-                 * didn't fire (see comments in _st_epoll_pollset_del()).
-                 */
-                _st_epoll_pollset_del(pq->pds, pq->npds);
+                    if (pq->thread->flags & _ST_FL_ON_SLEEPQ)
+                        _ST_DEL_SLEEPQ(pq->thread);
+                    pq->thread->state = _ST_ST_RUNNABLE;
+                    _ST_ADD_RUNQ(pq->thread);
 
-                if (pq->thread->flags & _ST_FL_ON_SLEEPQ)
-                    _ST_DEL_SLEEPQ(pq->thread);
-                pq->thread->state = _ST_ST_RUNNABLE;
-                _ST_ADD_RUNQ(pq->thread);
+                    /* The next link may be removed with the pollq, so restart from the first waiter */
+                    next = _ST_EPOLL_WAITERS(osfd);
+                }
             }
         }
 
@@ -1294,6 +1452,8 @@ ST_HIDDEN void _st_epoll_dispatch(void)
             /* Delete/modify descriptors that fired */
             osfd = _st_epoll_data->evtlist[i].data.fd;
             _ST_EPOLL_REVENTS(osfd) = 0;
+            if (_ST_EPOLL_REGISTERED(osfd))
+                continue;
             events = _ST_EPOLL_EVENTS(osfd);
             op = events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
             ev.events = events;
@@ -1310,19 +1470,52 @@ ST_HIDDEN int _st_epoll_fd_new(int osfd)
     if (osfd >= _st_epoll_data->fd_data_size && _st_epoll_fd_data_expand(osfd) < 0)
         return -1;
 
+    /*
+     * A descriptor that epoll doesn't support, such as a regular file, isn't
+     * registered and falls back to the per-wait registration.
+     */
+    _ST_EPOLL_REGISTERED(osfd) = 0;
+    _ST_EPOLL_READY(osfd) = 0;
+    _st_epoll_register(osfd, _ST_EPOLL_ET_EVENTS);
+
     return 0;   
 }
 
 ST_HIDDEN int _st_epoll_fd_close(int osfd)
 {
+    struct epoll_event ev;
+
     if (_ST_EPOLL_READ_CNT(osfd) || _ST_EPOLL_WRITE_CNT(osfd) || _ST_EPOLL_EXCEP_CNT(osfd)) {
         errno = EBUSY;
         return -1;
     }
 
+    if (_ST_EPOLL_REGISTERED(osfd)) {
+        /* Delete it now, or the closed number might be reused by a descriptor not registered */
+        ev.events = 0;
+        ev.data.fd = osfd;
+        if (epoll_ctl(_st_epoll_data->epfd, EPOLL_CTL_DEL, osfd, &ev) == 0)
+            _st_epoll_data->evtlist_cnt--;
+        _ST_EPOLL_REGISTERED(osfd) = 0;
+        _ST_EPOLL_READY(osfd) = 0;
+    }
+
     return 0;
 }
 
+ST_HIDDEN void _st_epoll_fd_unready(int osfd, int how)
+{
+    if (osfd >= _st_epoll_data->fd_data_size)
+        return;
+
+    if (how & POLLIN)
+        _ST_EPOLL_READY(osfd) &= ~EPOLLIN;
+    if (how & POLLOUT)
+        _ST_EPOLL_READY(osfd) &= ~EPOLLOUT;
+    if (how & POLLPRI)
+        _ST_EPOLL_READY(osfd) &= ~EPOLLPRI;
+}
+
 ST_HIDDEN int _st_epoll_fd_getlimit(void)
 {
     /* zero means no specific limit */
@@ -1353,7 +1546,10 @@ static _st_eventsys_t _st_epoll_eventsys = {
     _st_epoll_pollset_del,
     _st_epoll_fd_new,
     _st_epoll_fd_close,
-    _st_epoll_fd_getlimit
+    _st_epoll_fd_getlimit,
+    _st_epoll_pollq_add,
+    _st_epoll_pollq_del,
+    _st_epoll_fd_unready
 };
 #endif  /* MD_HAVE_EPOLL */
 
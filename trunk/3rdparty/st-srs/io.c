@@ -243,6 +243,19 @@ int st_netfd_poll(_st_netfd_t *fd, int how, st_utime_t timeout)
 }
 
 
+/*
+ * Wait for I/O after the syscall returned EAGAIN or a short count, which means
+ * the descriptor is drained, so its cached readiness is stale (see epoll(7)).
+ */
+static int _st_netfd_wait(_st_netfd_t *fd, int how, st_utime_t timeout)
+{
+    if (_st_eventsys->fd_unready)
+        (*_st_eventsys->fd_unready)(fd->osfd, how);
+    
+    return st_netfd_poll(fd, how, timeout);
+}
+
+
 #ifdef MD_ALWAYS_UNSERIALIZED_ACCEPT
 /* No-op */
 int st_netfd_serialize_accept(_st_netfd_t *fd)
@@ -268,7 +281,7 @@ _st_netfd_t *st_accept(_st_netfd_t *fd, struct sockaddr *addr, int *addrlen, st_
         if (!_IO_NOT_READY_ERROR)
             return NULL;
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return NULL;
     }
     
@@ -373,7 +386,7 @@ _st_netfd_t *st_accept(_st_netfd_t *fd, struct sockaddr *addr, int *addrlen, st_
         if (!_IO_NOT_READY_ERROR)
             return NULL;
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return NULL;
     }
     
@@ -415,7 +428,7 @@ int st_connect(_st_netfd_t *fd, const struct sockaddr *addr, int addrlen, st_uti
             if (errno != EINPROGRESS && (errno != EADDRINUSE || err == 0))
                 return -1;
             /* Wait until the socket becomes writable */
-            if (st_netfd_poll(fd, POLLOUT, timeout) < 0)
+            if (_st_netfd_wait(fd, POLLOUT, timeout) < 0)
                 return -1;
             /* Try to find out whether the connection setup succeeded or failed */
             n = sizeof(int);
@@ -444,7 +457,7 @@ ssize_t st_read(_st_netfd_t *fd, void *buf, size_t nbyte, st_utime_t timeout)
         if (!_IO_NOT_READY_ERROR)
             return -1;
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return -1;
     }
     
@@ -477,7 +490,7 @@ ssize_t st_readv(_st_netfd_t *fd, const struct iovec *iov, int iov_size, st_utim
         if (!_IO_NOT_READY_ERROR)
             return -1;
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return -1;
     }
     
@@ -516,7 +529,7 @@ int st_readv_resid(_st_netfd_t *fd, struct iovec **iov, int *iov_size, st_utime_
             (*iov)->iov_len -= n;
         }
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return -1;
     }
     
@@ -617,7 +630,7 @@ ssize_t st_writev(_st_netfd_t *fd, const struct iovec *iov, int iov_size, st_uti
             }
         }
         /* Wait until the socket becomes writable */
-        if (st_netfd_poll(fd, POLLOUT, timeout) < 0) {
+        if (_st_netfd_wait(fd, POLLOUT, timeout) < 0) {
             rv = -1;
             break;
         }
@@ -660,7 +673,7 @@ int st_writev_resid(_st_netfd_t *fd, struct iovec **iov, int *iov_size, st_utime
             (*iov)->iov_len -= n;
         }
         /* Wait until the socket becomes writable */
-        if (st_netfd_poll(fd, POLLOUT, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLOUT, timeout) < 0)
             return -1;
     }
     
@@ -681,7 +694,7 @@ int st_recvfrom(_st_netfd_t *fd, void *buf, int len, struct sockaddr *from, int
         if (!_IO_NOT_READY_ERROR)
             return -1;
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return -1;
     }
     
@@ -699,7 +712,7 @@ int st_sendto(_st_netfd_t *fd, const void *msg, int len, const struct sockaddr *
         if (!_IO_NOT_READY_ERROR)
             return -1;
         /* Wait until the socket becomes writable */
-        if (st_netfd_poll(fd, POLLOUT, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLOUT, timeout) < 0)
             return -1;
     }
     
@@ -717,7 +730,7 @@ int st_recvmsg(_st_netfd_t *fd, struct msghdr *msg, int flags, st_utime_t timeou
         if (!_IO_NOT_READY_ERROR)
             return -1;
         /* Wait until the socket becomes readable */
-        if (st_netfd_poll(fd, POLLIN, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLIN, timeout) < 0)
             return -1;
     }
     
@@ -735,7 +748,7 @@ int st_sendmsg(_st_netfd_t *fd, const struct msghdr *msg, int flags, st_utime_t
         if (!_IO_NOT_READY_ERROR)
             return -1;
         /* Wait until the socket becomes writable */
-        if (st_netfd_poll(fd, POLLOUT, timeout) < 0)
+        if (_st_netfd_wait(fd, POLLOUT, timeout) < 0)
             return -1;
     }
     
@@ -82,6 +82,15 @@ typedef struct _st_netfd *  st_netfd_t;
 typedef void (*st_switch_cb_t)(void);
 #endif
 
+/* The stacks of the scheduler */
+typedef struct _st_stack_stat {
+    int nn_stacks;              /* Allocated stacks, in use or free */
+    int nn_free;                /* Stacks on the free list */
+    long long nn_bytes;         /* Virtual memory of the allocated stacks */
+    long long nn_reused;        /* Stacks reused from the free list */
+    long long nn_unmapped;      /* Stacks released because the free list is full */
+} st_stack_stat_t;
+
 extern int st_init(void);
 extern int st_getfdlimit(void);
 
@@ -100,6 +109,10 @@ extern int st_thread_join(st_thread_t thread, void **retvalp);
 extern void st_thread_interrupt(st_thread_t thread);
 extern st_thread_t st_thread_create(void *(*start)(void *arg), void *arg, int joinable, int stack_size);
 extern int st_randomize_stacks(int on);
+extern int st_set_stack_guard(int on);
+extern int st_set_stack_pool(int max_free);
+extern void st_stack_stat(st_stack_stat_t *stat);
+extern int st_thread_stack(char **bottom, char **top);
 extern int st_set_utime_function(st_utime_t (*func)(void));
 
 extern st_utime_t st_utime(void);
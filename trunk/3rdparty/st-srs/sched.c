@@ -83,6 +83,11 @@ int st_poll(struct pollfd *pds, int npds, st_utime_t timeout)
     pq.npds = npds;
     pq.thread = me;
     pq.on_ioq = 1;
+    if (_st_eventsys->pollq_add && (n = (*_st_eventsys->pollq_add)(&pq)) != 0) {
+        /* Failed, or some descriptors are known to be ready, so don't wait */
+        (*_st_eventsys->pollset_del)(pds, npds);
+        return n;
+    }
     _ST_ADD_IOQ(pq);
     if (timeout != ST_UTIME_NO_TIMEOUT)
         _ST_ADD_SLEEPQ(me, timeout);
@@ -94,6 +99,8 @@ int st_poll(struct pollfd *pds, int npds, st_utime_t timeout)
     if (pq.on_ioq) {
         /* If we timed out, the pollq might still be on the ioq. Remove it */
         _ST_DEL_IOQ(pq);
+        if (_st_eventsys->pollq_del)
+            (*_st_eventsys->pollq_del)(&pq);
         (*_st_eventsys->pollset_del)(pds, npds);
     } else {
         /* Count the number of ready descriptors */
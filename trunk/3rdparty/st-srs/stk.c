@@ -52,27 +52,47 @@
 
 _st_clist_t _st_free_stacks = ST_INIT_STATIC_CLIST(&_st_free_stacks);
 int _st_num_free_stacks = 0;
+st_stack_stat_t _st_stack_stats;
 int _st_randomize_stacks = 0;
 
+/* The max number of free stacks to keep, zero for unlimited */
+int _st_stack_pool_max = 0;
+
+/* Whether to protect the redzones, which costs extra mappings for each stack */
+#if defined(DEBUG) && !defined(MALLOC_STACK)
+int _st_stack_guard = 1;
+#else
+int _st_stack_guard = 0;
+#endif
+
 static char *_st_new_stk_segment(int size);
+static void _st_delete_stk_segment(char *vaddr, int size);
 
 _st_stack_t *_st_stack_new(int stack_size)
 {
     _st_clist_t *qp;
-    _st_stack_t *ts;
+    _st_stack_t *ts, *best;
     int extra;
     
+    /* Find the smallest stack that is big enough, so the small stacks of some roles are not wasted */
+    best = NULL;
     for (qp = _st_free_stacks.next; qp != &_st_free_stacks; qp = qp->next) {
         ts = _ST_THREAD_STACK_PTR(qp);
-        if (ts->stk_size >= stack_size) {
-            /* Found a stack that is big enough */
-            ST_REMOVE_LINK(&ts->links);
-            _st_num_free_stacks--;
-            ts->links.next = NULL;
-            ts->links.prev = NULL;
-            return ts;
+        if (ts->stk_size >= stack_size && (!best || ts->stk_size < best->stk_size)) {
+            best = ts;
+            if (ts->stk_size == stack_size)
+                break;
         }
     }
+    if (best) {
+        ts = best;
+        ST_REMOVE_LINK(&ts->links);
+        _st_num_free_stacks--;
+        _st_stack_stats.nn_reused++;
+        ts->links.next = NULL;
+        ts->links.prev = NULL;
+        return ts;
+    }
     
     /* Make a new thread stack object. */
     if ((ts = (_st_stack_t *)calloc(1, sizeof(_st_stack_t))) == NULL)
@@ -87,10 +107,14 @@ _st_stack_t *_st_stack_new(int stack_size)
     ts->stk_size = stack_size;
     ts->stk_bottom = ts->vaddr + REDZONE;
     ts->stk_top = ts->stk_bottom + stack_size;
+    _st_stack_stats.nn_stacks++;
+    _st_stack_stats.nn_bytes += ts->vaddr_size;
     
-#ifdef DEBUG
-    mprotect(ts->vaddr, REDZONE, PROT_NONE);
-    mprotect(ts->stk_top + extra, REDZONE, PROT_NONE);
+#ifndef MALLOC_STACK
+    if (_st_stack_guard) {
+        mprotect(ts->vaddr, REDZONE, PROT_NONE);
+        mprotect(ts->stk_top + extra, REDZONE, PROT_NONE);
+    }
 #endif
     
     if (extra) {
@@ -109,12 +133,32 @@ _st_stack_t *_st_stack_new(int stack_size)
  */
 void _st_stack_free(_st_stack_t *ts)
 {
+    _st_stack_t *head;
+    
     if (!ts)
         return;
     
     /* Put the stack on the free list */
     ST_APPEND_LINK(&ts->links, _st_free_stacks.prev);
     _st_num_free_stacks++;
+    
+    /*
+     * Release the oldest stacks when the list is full. The freed stack is
+     * still in use by the exiting thread, so it's never released here, and
+     * it's at the tail of list.
+     */
+    while (_st_stack_pool_max > 0 && _st_num_free_stacks > _st_stack_pool_max) {
+        head = _ST_THREAD_STACK_PTR(_st_free_stacks.next);
+        if (head == ts)
+            break;
+        ST_REMOVE_LINK(&head->links);
+        _st_num_free_stacks--;
+        _st_stack_stats.nn_stacks--;
+        _st_stack_stats.nn_bytes -= head->vaddr_size;
+        _st_stack_stats.nn_unmapped++;
+        _st_delete_stk_segment(head->vaddr, head->vaddr_size);
+        free(head);
+    }
 }
 
 
@@ -149,9 +193,7 @@ static char *_st_new_stk_segment(int size)
 }
 
 
-/* Not used */
-#if 0
-void _st_delete_stk_segment(char *vaddr, int size)
+static void _st_delete_stk_segment(char *vaddr, int size)
 {
 #ifdef MALLOC_STACK
     free(vaddr);
@@ -159,7 +201,6 @@ void _st_delete_stk_segment(char *vaddr, int size)
     (void) munmap(vaddr, size);
 #endif
 }
-#endif
 
 int st_randomize_stacks(int on)
 {
@@ -171,3 +212,42 @@ int st_randomize_stacks(int on)
     
     return wason;
 }
+
+int st_set_stack_guard(int on)
+{
+    int wason = _st_stack_guard;
+    
+#ifndef MALLOC_STACK
+    _st_stack_guard = on;
+#endif
+    
+    return wason;
+}
+
+int st_set_stack_pool(int max_free)
+{
+    int old = _st_stack_pool_max;
+    
+    _st_stack_pool_max = (max_free > 0) ? max_free : 0;
+    
+    return old;
+}
+
+void st_stack_stat(st_stack_stat_t *stat)
+{
+    *stat = _st_stack_stats;
+    stat->nn_free = _st_num_free_stacks;
+}
+
+int st_thread_stack(char **bottom, char **top)
+{
+    _st_thread_t *me = _ST_CURRENT_THREAD();
+    
+    /* The primordial thread runs on the stack of process, which is not allocated by ST */
+    if (!me || !me->stack)
+        return -1;
+    
+    *bottom = me->stack->stk_bottom;
+    *top = me->stack->stk_top;
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -10,7 +11,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
-#include "public.h"
+#include <public.h>
 
 #define srs_trace(msg, ...)   printf(msg, ##__VA_ARGS__);printf("\n")
 
@@ -429,6 +430,132 @@ int pipe_test()
     return 0;
 }
 
+int conns_nn = 1000;
+int conns_rounds = 100;
+
+void* conns_pong(void* arg)
+{
+    st_netfd_t stfd = (st_netfd_t)arg;
+    
+    char buf[1];
+    int i;
+    for (i = 0; i < conns_rounds; i++) {
+        if (st_read(stfd, buf, sizeof(buf), ST_UTIME_NO_TIMEOUT) != sizeof(buf)) {
+            break;
+        }
+        if (st_write(stfd, buf, sizeof(buf), ST_UTIME_NO_TIMEOUT) != sizeof(buf)) {
+            break;
+        }
+    }
+    
+    st_netfd_close(stfd);
+    return NULL;
+}
+
+void* conns_ping(void* arg)
+{
+    st_netfd_t stfd = (st_netfd_t)arg;
+    
+    char buf[1] = {'x'};
+    int i;
+    for (i = 0; i < conns_rounds; i++) {
+        if (st_write(stfd, buf, sizeof(buf), ST_UTIME_NO_TIMEOUT) != sizeof(buf)) {
+            break;
+        }
+        if (st_read(stfd, buf, sizeof(buf), ST_UTIME_NO_TIMEOUT) != sizeof(buf)) {
+            break;
+        }
+    }
+    
+    st_netfd_close(stfd);
+    return NULL;
+}
+
+// Many connections do ping-pong concurrently, to measure the cost of each wait, run by:
+//      ./objs/srs conns 10000 100
+int conns_test()
+{
+    srs_trace("===================================================");
+    srs_trace("conns test: start, port=%d, conns=%d, rounds=%d", io_port + 1, conns_nn, conns_rounds);
+    
+    int fd;
+    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+        srs_trace("create linux socket error.");
+        return -1;
+    }
+    
+    int reuse_socket = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse_socket, sizeof(int)) == -1) {
+        srs_trace("setsockopt reuse-addr error.");
+        return -1;
+    }
+    
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(io_port + 1);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (const struct sockaddr*)&addr, sizeof(struct sockaddr_in)) == -1) {
+        srs_trace("bind socket error.");
+        return -1;
+    }
+    
+    if (listen(fd, conns_nn) == -1) {
+        srs_trace("listen socket error.");
+        return -1;
+    }
+    
+    st_netfd_t stfd;
+    if ((stfd = st_netfd_open_socket(fd)) == NULL){
+        srs_trace("st_netfd_open_socket open socket failed.");
+        return -1;
+    }
+    
+    // Connect all clients before the ping-pong starts.
+    st_thread_t* trds = (st_thread_t*)calloc(conns_nn * 2, sizeof(st_thread_t));
+    st_netfd_t* fds = (st_netfd_t*)calloc(conns_nn * 2, sizeof(st_netfd_t));
+    int i;
+    for (i = 0; i < conns_nn; i++) {
+        int cfd;
+        if ((cfd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+            srs_trace("create client socket error, i=%d.", i);
+            return -1;
+        }
+        if ((fds[i * 2] = st_netfd_open_socket(cfd)) == NULL) {
+            srs_trace("st_netfd_open_socket open client socket failed.");
+            return -1;
+        }
+        if (st_connect(fds[i * 2], (const struct sockaddr*)&addr, sizeof(struct sockaddr_in), ST_UTIME_NO_TIMEOUT) == -1) {
+            srs_trace("st_connect error, i=%d.", i);
+            return -1;
+        }
+        if ((fds[i * 2 + 1] = st_accept(stfd, NULL, NULL, ST_UTIME_NO_TIMEOUT)) == NULL) {
+            srs_trace("st_accept error, i=%d.", i);
+            return -1;
+        }
+    }
+    srs_trace("1. %d conns established", conns_nn);
+    
+    st_utime_t start = st_utime();
+    for (i = 0; i < conns_nn; i++) {
+        trds[i * 2] = st_thread_create(conns_ping, fds[i * 2], 1, 64 * 1024);
+        trds[i * 2 + 1] = st_thread_create(conns_pong, fds[i * 2 + 1], 1, 64 * 1024);
+    }
+    for (i = 0; i < conns_nn * 2; i++) {
+        st_thread_join(trds[i], NULL);
+    }
+    st_utime_t end = st_utime();
+    
+    srs_trace("2. ping-pong ok, cost=%dms, %.2fus/round, %.2fus/conn/round", (int)((end - start) / 1000),
+        (double)(end - start) / conns_rounds, (double)(end - start) / conns_rounds / conns_nn);
+    
+    free(trds);
+    free(fds);
+    st_netfd_close(stfd);
+    
+    srs_trace("conns test: end");
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
     srs_trace("ETIME=%d", ETIME);
@@ -443,6 +570,13 @@ int main(int argc, char** argv)
         return -1;
     }
     
+    // Only run the benchmark of connections.
+    if (argc > 1 && !strcmp(argv[1], "conns")) {
+        conns_nn = (argc > 2)? atoi(argv[2]) : conns_nn;
+        conns_rounds = (argc > 3)? atoi(argv[3]) : conns_rounds;
+        return conns_test();
+    }
+    
     if (sleep2_test() < 0) {
         srs_trace("sleep2_test failed");
         return -1;
@@ -0,0 +1,327 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <srs_app_abr.hpp>
+
+using namespace std;
+
+#include <srs_kernel_error.hpp>
+#include <srs_kernel_log.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_rtmp_stack.hpp>
+#include <srs_protocol_kbps.hpp>
+#include <srs_app_config.hpp>
+#include <srs_app_source.hpp>
+#include <srs_app_conn.hpp>
+#include <srs_core_autofree.hpp>
+
+SrsAbrSwitcher::SrsAbrSwitcher(SrsConnection* c)
+{
+    conn = c;
+    req = NULL;
+    
+    current = 0;
+    source = NULL;
+    consumer = NULL;
+    
+    next = -1;
+    target = NULL;
+    pending = NULL;
+    pending_at = 0;
+    keyframe = -1;
+    
+    down_queue = up_queue = up_hold = hold = 0;
+    stable_at = switch_at = 0;
+    switch_up = false;
+    
+    sample_at = 0;
+    sample_bytes = 0;
+    throughput = 0;
+}
+
+SrsAbrSwitcher::~SrsAbrSwitcher()
+{
+    if (pending) {
+        cancel();
+    }
+    
+    if (source) {
+        source->release();
+    }
+    
+    srs_freep(req);
+}
+
+srs_error_t SrsAbrSwitcher::initialize(SrsRequest* r, SrsSource* s, SrsConsumer* c)
+{
+    srs_error_t err = srs_success;
+    
+    req = r->copy();
+    
+    source = s;
+    source->acquire();
+    consumer = c;
+    
+    renditions.push_back(req->stream);
+    if (_srs_config->get_abr_enabled(req->vhost)) {
+        vector<string> lowers = _srs_config->get_abr_renditions(req->vhost);
+        for (int i = 0; i < (int)lowers.size(); i++) {
+            string stream = srs_string_replace(lowers.at(i), "[stream]", req->stream);
+            if (stream != req->stream) {
+                renditions.push_back(stream);
+            }
+        }
+    }
+    bitrates.resize(renditions.size(), 0);
+    
+    down_queue = _srs_config->get_abr_down_queue(req->vhost);
+    up_queue = _srs_config->get_abr_up_queue(req->vhost);
+    hold = up_hold = _srs_config->get_abr_up_hold(req->vhost);
+    
+    if (renditions.size() > 1) {
+        srs_trace("abr: renditions=%d, down=%dms, up=%dms, hold=%dms", (int)renditions.size(),
+            srsu2msi(down_queue), srsu2msi(up_queue), srsu2msi(up_hold));
+    }
+    
+    return err;
+}
+
+srs_error_t SrsAbrSwitcher::cycle()
+{
+    srs_error_t err = srs_success;
+    
+    if (renditions.size() <= 1) {
+        return err;
+    }
+    
+    srs_utime_t now = srs_get_system_time();
+    
+    if (pending) {
+        return do_switch(now);
+    }
+    
+    if (now - sample_at < SRS_ABR_INTERVAL) {
+        return err;
+    }
+    sample(now);
+    
+    int index = decide(now);
+    if (index == current) {
+        return err;
+    }
+    
+    if ((err = prepare(index, now)) != srs_success) {
+        return srs_error_wrap(err, "prepare %s", renditions.at(index).c_str());
+    }
+    
+    return err;
+}
+
+srs_error_t SrsAbrSwitcher::do_switch(srs_utime_t now)
+{
+    srs_error_t err = srs_success;
+    
+    // Cancel when rendition unpublished, or the keyframe not found in time.
+    if (target->inactive() || (keyframe < 0 && now - pending_at > SRS_ABR_SWITCH_TIMEOUT)) {
+        srs_warn("abr: cancel switch to %s, inactive=%d, keyframe=%" PRId64, renditions.at(next).c_str(),
+            target->inactive(), keyframe);
+        cancel();
+        return err;
+    }
+    
+    // Switch at the first keyframe of rendition after the messages of current one,
+    // and drop the messages of current one after it, so the stream is continued without gap.
+    if (keyframe < 0) {
+        if ((keyframe = pending->find_keyframe(consumer->get_time())) < 0) {
+            return err;
+        }
+        consumer->set_cut_time(keyframe);
+    }
+    
+    // Wait for the current rendition to reach the keyframe, except it's unpublished.
+    if (consumer->get_time() < keyframe && !source->inactive() && now - pending_at < SRS_ABR_SWITCH_TIMEOUT) {
+        return err;
+    }
+    
+    return commit(now);
+}
+
+void SrsAbrSwitcher::sample(srs_utime_t now)
+{
+    SrsKbps* kbps = conn? conn->get_kbps() : NULL;
+    if (!kbps) {
+        return;
+    }
+    
+    kbps->sample();
+    int64_t bytes = kbps->get_send_bytes();
+    
+    if (sample_at > 0 && now > sample_at) {
+        throughput = (int)((bytes - sample_bytes) * 8 / srsu2ms(now - sample_at));
+    }
+    
+    sample_at = now;
+    sample_bytes = bytes;
+}
+
+int SrsAbrSwitcher::decide(srs_utime_t now)
+{
+    srs_utime_t depth = consumer->duration();
+    
+    // Switch down when congested, to the rendition fits the throughput, or the next lower one.
+    if (depth >= down_queue) {
+        stable_at = 0;
+        
+        // Wait longer to switch up again, when it's congested soon after switching up.
+        if (switch_up && now - switch_at < 2 * hold) {
+            hold = srs_min(2 * hold, 8 * up_hold);
+        } else {
+            hold = up_hold;
+        }
+        
+        int last = (int)renditions.size() - 1;
+        for (int i = current + 1; i <= last; i++) {
+            if (i < last && throughput > 0 && bitrates.at(i) > throughput) {
+                continue;
+            }
+            if (fetch(i)) {
+                return i;
+            }
+        }
+        return current;
+    }
+    
+    if (depth >= up_queue) {
+        stable_at = 0;
+        return current;
+    }
+    
+    // Without congestion, the throughput is about the bitrate of rendition.
+    if (throughput > 0) {
+        int& bitrate = bitrates.at(current);
+        bitrate = bitrate? (bitrate * 3 + throughput) / 4 : throughput;
+    }
+    
+    // Switch up when the queue keeps empty for a while.
+    if (!stable_at) {
+        stable_at = now;
+    }
+    if (now - stable_at < hold) {
+        return current;
+    }
+    
+    for (int i = current - 1; i >= 0; i--) {
+        if (fetch(i)) {
+            return i;
+        }
+    }
+    return current;
+}
+
+SrsSource* SrsAbrSwitcher::fetch(int index)
+{
+    SrsRequest* r = req->copy();
+    SrsAutoFree(SrsRequest, r);
+    
+    r->stream = renditions.at(index);
+    
+    SrsSource* s = _srs_sources->fetch(r);
+    if (!s || s->inactive()) {
+        return NULL;
+    }
+    
+    return s;
+}
+
+srs_error_t SrsAbrSwitcher::prepare(int index, srs_utime_t now)
+{
+    srs_error_t err = srs_success;
+    
+    SrsSource* s = fetch(index);
+    if (!s) {
+        return err;
+    }
+    
+    // Only dumps the metadata and sequence headers, and wait for the next keyframe.
+    if ((err = s->create_consumer(conn, pending, true, true, false)) != srs_success) {
+        srs_freep(pending);
+        return srs_error_wrap(err, "create consumer");
+    }
+    pending->follow(consumer);
+    
+    target = s;
+    target->acquire();
+    
+    next = index;
+    pending_at = now;
+    keyframe = -1;
+    
+    srs_trace("abr: prepare switch %s to %s, depth=%dms, throughput=%dkbps, bitrate=%dkbps",
+        renditions.at(current).c_str(), renditions.at(next).c_str(), srsu2msi(consumer->duration()),
+        throughput, bitrates.at(next));
+    
+    return err;
+}
+
+srs_error_t SrsAbrSwitcher::commit(srs_utime_t now)
+{
+    srs_error_t err = srs_success;
+    
+    if ((err = consumer->splice(pending, keyframe)) != srs_success) {
+        cancel();
+        return srs_error_wrap(err, "splice");
+    }
+    
+    consumer->switch_source(target);
+    srs_freep(pending);
+    
+    source->release();
+    source = target;
+    target = NULL;
+    
+    srs_trace("abr: switch %s to %s at %" PRId64 "ms, hold=%dms", renditions.at(current).c_str(),
+        renditions.at(next).c_str(), keyframe, srsu2msi(hold));
+    
+    switch_up = next < current;
+    switch_at = now;
+    stable_at = 0;
+    
+    current = next;
+    next = -1;
+    keyframe = -1;
+    
+    return err;
+}
+
+void SrsAbrSwitcher::cancel()
+{
+    consumer->set_cut_time(-1);
+    
+    srs_freep(pending);
+    
+    target->release();
+    target = NULL;
+    
+    next = -1;
+    keyframe = -1;
+}
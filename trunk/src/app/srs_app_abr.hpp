@@ -0,0 +1,103 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SRS_APP_ABR_HPP
+#define SRS_APP_ABR_HPP
+
+#include <srs_core.hpp>
+
+#include <string>
+#include <vector>
+
+class SrsRequest;
+class SrsSource;
+class SrsConsumer;
+class SrsConnection;
+
+// The interval to sample the throughput and check the queue of player.
+#define SRS_ABR_INTERVAL (1 * SRS_UTIME_SECONDS)
+// The timeout to wait for the keyframe of rendition to switch to.
+#define SRS_ABR_SWITCH_TIMEOUT (15 * SRS_UTIME_SECONDS)
+
+// The ABR(adaptive bitrate) of player, which switch the consumer between the renditions of stream,
+// at keyframe, by the depth of queue to send and the throughput of connection. The player never reconnect,
+// the stream is continued by the sequence header and keyframe of rendition.
+class SrsAbrSwitcher
+{
+private:
+    SrsConnection* conn;
+    SrsRequest* req;
+    // The streams of renditions, from the highest to the lowest quality, the first is the requested one.
+    std::vector<std::string> renditions;
+    // The bitrate in kbps of renditions, measured when delivered without congestion, 0 if unknown.
+    std::vector<int> bitrates;
+    // The rendition which is playing.
+    int current;
+    SrsSource* source;
+    SrsConsumer* consumer;
+    // The rendition to switch to, -1 if not switching.
+    int next;
+    SrsSource* target;
+    SrsConsumer* pending;
+    srs_utime_t pending_at;
+    // The timestamp in ms of keyframe to switch at, -1 if not found.
+    int64_t keyframe;
+private:
+    srs_utime_t down_queue;
+    srs_utime_t up_queue;
+    srs_utime_t up_hold;
+    // The hold to switch up, which is doubled when switch down soon after switching up.
+    srs_utime_t hold;
+    // The time since the queue keeps below up_queue, 0 if not.
+    srs_utime_t stable_at;
+    // The last switch, whether to a higher rendition.
+    srs_utime_t switch_at;
+    bool switch_up;
+private:
+    // The throughput in kbps of connection, sampled in interval.
+    srs_utime_t sample_at;
+    int64_t sample_bytes;
+    int throughput;
+public:
+    // @param c The connection of player, to create consumer and measure the throughput.
+    SrsAbrSwitcher(SrsConnection* c);
+    virtual ~SrsAbrSwitcher();
+public:
+    // Initialize the switcher by the source and consumer of player.
+    // @remark The ABR is disabled when no rendition for the stream.
+    virtual srs_error_t initialize(SrsRequest* r, SrsSource* s, SrsConsumer* c);
+    // Check the queue and throughput, switch to another rendition if required,
+    // and the consumer is moved to the source of rendition.
+    // @remark The play loop should call it before dumping messages from consumer.
+    virtual srs_error_t cycle();
+private:
+    virtual srs_error_t do_switch(srs_utime_t now);
+    virtual void sample(srs_utime_t now);
+    virtual int decide(srs_utime_t now);
+    virtual SrsSource* fetch(int index);
+    virtual srs_error_t prepare(int index, srs_utime_t now);
+    virtual srs_error_t commit(srs_utime_t now);
+    virtual void cancel();
+};
+
+#endif
@@ -27,6 +27,8 @@ using namespace std;
 
 #include <srs_kernel_error.hpp>
 #include <srs_kernel_log.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_app_config.hpp>
 
 ISrsAsyncCallTask::ISrsAsyncCallTask()
 {
@@ -36,22 +38,43 @@ ISrsAsyncCallTask::~ISrsAsyncCallTask()
 {
 }
 
-SrsAsyncCallWorker::SrsAsyncCallWorker()
+SrsAsyncCallStat::SrsAsyncCallStat()
 {
-    trd = new SrsDummyCoroutine();
+    nn_queued = 0;
+    nn_running = 0;
+    max_queued = 0;
+    nn_executed = 0;
+    nn_failed = 0;
+}
+
+SrsAsyncCallStat::~SrsAsyncCallStat()
+{
+}
+
+SrsAsyncCallStat* _srs_async_stat = new SrsAsyncCallStat();
+
+SrsAsyncCallWorker::SrsAsyncCallWorker(int c)
+{
+    concurrency = srs_max(1, c);
     wait = srs_cond_new();
     lock = srs_mutex_new();
 }
 
 SrsAsyncCallWorker::~SrsAsyncCallWorker()
 {
-    srs_freep(trd);
+    std::vector<SrsCoroutine*>::iterator it;
+    for (it = trds.begin(); it != trds.end(); ++it) {
+        SrsCoroutine* trd = *it;
+        srs_freep(trd);
+    }
+    trds.clear();
     
-    std::vector<ISrsAsyncCallTask*>::iterator it;
-    for (it = tasks.begin(); it != tasks.end(); ++it) {
-        ISrsAsyncCallTask* task = *it;
+    std::vector<ISrsAsyncCallTask*>::iterator it2;
+    for (it2 = tasks.begin(); it2 != tasks.end(); ++it2) {
+        ISrsAsyncCallTask* task = *it2;
         srs_freep(task);
     }
+    _srs_async_stat->nn_queued -= (int)tasks.size();
     tasks.clear();
     
     srs_cond_destroy(wait);
@@ -65,6 +88,9 @@ srs_error_t SrsAsyncCallWorker::execute(ISrsAsyncCallTask* t)
     tasks.push_back(t);
     srs_cond_signal(wait);
     
+    _srs_async_stat->nn_queued++;
+    _srs_async_stat->max_queued = srs_max(_srs_async_stat->max_queued, (int)tasks.size());
+    
     return err;
 }
 
@@ -73,15 +99,30 @@ int SrsAsyncCallWorker::count()
     return (int)tasks.size();
 }
 
+void SrsAsyncCallWorker::set_concurrency(int c)
+{
+    concurrency = srs_max(1, c);
+}
+
 srs_error_t SrsAsyncCallWorker::start()
 {
     srs_error_t err = srs_success;
     
-    srs_freep(trd);
-    trd = new SrsSTCoroutine("async", this, _srs_context->get_id());
+    std::vector<SrsCoroutine*>::iterator it;
+    for (it = trds.begin(); it != trds.end(); ++it) {
+        SrsCoroutine* trd = *it;
+        srs_freep(trd);
+    }
+    trds.clear();
     
-    if ((err = trd->start()) != srs_success) {
-        return srs_error_wrap(err, "coroutine");
+    for (int i = 0; i < concurrency; i++) {
+        SrsSTCoroutine* trd = new SrsSTCoroutine("async", this, _srs_context->get_id());
+        trd->set_stack_size(_srs_config->get_stack_size("worker"));
+        trds.push_back(trd);
+        
+        if ((err = trd->start()) != srs_success) {
+            return srs_error_wrap(err, "coroutine");
+        }
     }
     
     return err;
@@ -90,8 +131,18 @@ srs_error_t SrsAsyncCallWorker::start()
 void SrsAsyncCallWorker::stop()
 {
     flush_tasks();
-    srs_cond_signal(wait);
-    trd->stop();
+    
+    // Notify all coroutines to quit, then wait for each to terminate.
+    std::vector<SrsCoroutine*>::iterator it;
+    for (it = trds.begin(); it != trds.end(); ++it) {
+        SrsCoroutine* trd = *it;
+        trd->interrupt();
+    }
+    
+    for (it = trds.begin(); it != trds.end(); ++it) {
+        SrsCoroutine* trd = *it;
+        trd->stop();
+    }
 }
 
 srs_error_t SrsAsyncCallWorker::cycle()
@@ -99,24 +150,43 @@ srs_error_t SrsAsyncCallWorker::cycle()
     srs_error_t err = srs_success;
     
     while (true) {
-        if ((err = trd->pull()) != srs_success) {
+        if ((err = pull()) != srs_success) {
             return srs_error_wrap(err, "async call worker");
         }
         
         if (tasks.empty()) {
             srs_cond_wait(wait);
+            continue;
         }
-
-        flush_tasks();
+        
+        // Fetch one task, other coroutines may execute the next ones.
+        ISrsAsyncCallTask* task = tasks.front();
+        tasks.erase(tasks.begin());
+        
+        do_call(task);
     }
     
     return err;
 }
 
-void SrsAsyncCallWorker::flush_tasks()
+srs_error_t SrsAsyncCallWorker::pull()
 {
     srs_error_t err = srs_success;
+    
+    // All coroutines are interrupted together, so quit when any one is.
+    std::vector<SrsCoroutine*>::iterator it;
+    for (it = trds.begin(); it != trds.end(); ++it) {
+        SrsCoroutine* trd = *it;
+        if ((err = trd->pull()) != srs_success) {
+            return err;
+        }
+    }
+    
+    return err;
+}
 
+void SrsAsyncCallWorker::flush_tasks()
+{
     // Avoid the async call blocking other coroutines.
     std::vector<ISrsAsyncCallTask*> copy;
     if (true) {
@@ -133,13 +203,25 @@ void SrsAsyncCallWorker::flush_tasks()
     std::vector<ISrsAsyncCallTask*>::iterator it;
     for (it = copy.begin(); it != copy.end(); ++it) {
         ISrsAsyncCallTask* task = *it;
-
-        if ((err = task->call()) != srs_success) {
-            srs_warn("ignore task failed %s", srs_error_desc(err).c_str());
-            srs_freep(err);
-        }
-        srs_freep(task);
+        do_call(task);
     }
 }
 
+void SrsAsyncCallWorker::do_call(ISrsAsyncCallTask* task)
+{
+    srs_error_t err = srs_success;
+    
+    _srs_async_stat->nn_queued--;
+    _srs_async_stat->nn_running++;
+    
+    if ((err = task->call()) != srs_success) {
+        srs_warn("ignore task failed %s", srs_error_desc(err).c_str());
+        srs_freep(err);
+        _srs_async_stat->nn_failed++;
+    }
+    srs_freep(task);
+    
+    _srs_async_stat->nn_running--;
+    _srs_async_stat->nn_executed++;
+}
 
@@ -51,23 +51,48 @@ public:
     virtual std::string to_string() = 0;
 };
 
+// The statistic of all async call workers, for http api.
+class SrsAsyncCallStat
+{
+public:
+    // The number of tasks waiting in queue, and executing by workers.
+    int nn_queued;
+    int nn_running;
+    // The max number of tasks in queue of a worker.
+    int max_queued;
+    // The total number of executed and failed tasks.
+    uint64_t nn_executed;
+    uint64_t nn_failed;
+public:
+    SrsAsyncCallStat();
+    virtual ~SrsAsyncCallStat();
+};
+
+extern SrsAsyncCallStat* _srs_async_stat;
+
 // The async callback for dvr, callback and other async worker.
 // When worker call with the task, the worker will do it in isolate thread.
 // That is, the task is execute/call in async mode.
+// @remark The tasks are executed one by one in order, unless there are multiple
+//      coroutines to execute them concurrently.
 class SrsAsyncCallWorker : public ISrsCoroutineHandler
 {
 private:
-    SrsCoroutine* trd;
+    std::vector<SrsCoroutine*> trds;
+    // The max number of coroutines to execute tasks concurrently.
+    int concurrency;
 protected:
     std::vector<ISrsAsyncCallTask*> tasks;
     srs_cond_t wait;
     srs_mutex_t lock;
 public:
-    SrsAsyncCallWorker();
+    SrsAsyncCallWorker(int c = 1);
     virtual ~SrsAsyncCallWorker();
 public:
     virtual srs_error_t execute(ISrsAsyncCallTask* t);
     virtual int count();
+    // Set the max number of coroutines, which takes effect when start.
+    virtual void set_concurrency(int c);
 public:
     virtual srs_error_t start();
     virtual void stop();
@@ -75,7 +100,9 @@ public:
 public:
     virtual srs_error_t cycle();
 private:
+    virtual srs_error_t pull();
     virtual void flush_tasks();
+    virtual void do_call(ISrsAsyncCallTask* task);
 };
 
 #endif
@@ -250,6 +250,16 @@ bool srs_config_ingest_is_stream(string type)
     return type == "stream";
 }
 
+bool srs_config_ingest_is_hls(string type)
+{
+    return type == "hls";
+}
+
+bool srs_config_ingest_is_flv(string type)
+{
+    return type == "flv";
+}
+
 bool srs_config_dvr_is_plan_segment(string plan)
 {
     return plan == "segment";
@@ -1124,6 +1134,14 @@ srs_error_t SrsConfDirective::read_token(SrsConfigBuffer* buffer, vector<string>
     return err;
 }
 
+// The subscription of a vhost handler, the position in each section, to unsubscribe it.
+class SrsReloadSubscription
+{
+public:
+    std::string vhost;
+    std::vector< std::pair<int, std::list<ISrsReloadHandler*>::iterator> > positions;
+};
+
 SrsConfig::SrsConfig()
 {
     dolphin = false;
@@ -1139,6 +1157,13 @@ SrsConfig::SrsConfig()
 
 SrsConfig::~SrsConfig()
 {
+    std::map<ISrsReloadHandler*, SrsReloadSubscription*>::iterator it;
+    for (it = subscriptions.begin(); it != subscriptions.end(); ++it) {
+        SrsReloadSubscription* subscription = it->second;
+        srs_freep(subscription);
+    }
+    subscriptions.clear();
+    
     srs_freep(root);
 }
 
@@ -1161,6 +1186,29 @@ void SrsConfig::subscribe(ISrsReloadHandler* handler)
 
 void SrsConfig::unsubscribe(ISrsReloadHandler* handler)
 {
+    // Remove the handler of vhost from the subscribers of each section.
+    std::map<ISrsReloadHandler*, SrsReloadSubscription*>::iterator sit = subscriptions.find(handler);
+    if (sit != subscriptions.end()) {
+        SrsReloadSubscription* subscription = sit->second;
+        subscriptions.erase(sit);
+        
+        std::map<int, std::list<ISrsReloadHandler*> >& handlers = vhost_subscribes[subscription->vhost];
+        for (int i = 0; i < (int)subscription->positions.size(); i++) {
+            int section = subscription->positions[i].first;
+            std::list<ISrsReloadHandler*>& section_handlers = handlers[section];
+            section_handlers.erase(subscription->positions[i].second);
+            if (section_handlers.empty()) {
+                handlers.erase(section);
+            }
+        }
+        if (handlers.empty()) {
+            vhost_subscribes.erase(subscription->vhost);
+        }
+        
+        srs_freep(subscription);
+        return;
+    }
+    
     std::vector<ISrsReloadHandler*>::iterator it;
     
     it = std::find(subscribes.begin(), subscribes.end(), handler);
@@ -1171,6 +1219,44 @@ void SrsConfig::unsubscribe(ISrsReloadHandler* handler)
     subscribes.erase(it);
 }
 
+void SrsConfig::subscribe(ISrsReloadHandler* handler, string vhost, int sections)
+{
+    unsubscribe(handler);
+    
+    SrsReloadSubscription* subscription = new SrsReloadSubscription();
+    subscription->vhost = vhost;
+    subscriptions[handler] = subscription;
+    
+    std::map<int, std::list<ISrsReloadHandler*> >& handlers = vhost_subscribes[vhost];
+    for (int section = SrsReloadVhostAdded; section <= SrsReloadVhostIngest; section <<= 1) {
+        if ((sections & section) == 0) {
+            continue;
+        }
+        
+        std::list<ISrsReloadHandler*>& section_handlers = handlers[section];
+        std::list<ISrsReloadHandler*>::iterator it = section_handlers.insert(section_handlers.end(), handler);
+        subscription->positions.push_back(std::make_pair(section, it));
+    }
+}
+
+vector<ISrsReloadHandler*> SrsConfig::get_subscribes(string vhost, SrsReloadSection section)
+{
+    vector<ISrsReloadHandler*> handlers = subscribes;
+    
+    std::map<std::string, std::map<int, std::list<ISrsReloadHandler*> > >::iterator it = vhost_subscribes.find(vhost);
+    if (it == vhost_subscribes.end()) {
+        return handlers;
+    }
+    
+    std::map<int, std::list<ISrsReloadHandler*> >::iterator sit = it->second.find(section);
+    if (sit == it->second.end()) {
+        return handlers;
+    }
+    
+    handlers.insert(handlers.end(), sit->second.begin(), sit->second.end());
+    return handlers;
+}
+
 // LCOV_EXCL_START
 srs_error_t SrsConfig::reload()
 {
@@ -1206,6 +1292,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
     
     // merge config.
     std::vector<ISrsReloadHandler*>::iterator it;
+    std::vector<ISrsReloadHandler*> handlers;
     
     // following directly support reload.
     //      origin, token_traverse, vhost, debug_srs_upnode
@@ -1278,7 +1365,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             srs_trace("vhost %s maybe modified, reload its detail.", vhost.c_str());
             // chunk_size, only one per vhost.
             if (!srs_directive_equals(new_vhost->get("chunk_size"), old_vhost->get("chunk_size"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostChunkSize);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_chunk_size(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes chunk_size failed", vhost.c_str());
@@ -1289,7 +1377,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // tcp_nodelay, only one per vhost
             if (!srs_directive_equals(new_vhost->get("tcp_nodelay"), old_vhost->get("tcp_nodelay"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostTcpNodelay);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_tcp_nodelay(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes tcp_nodelay failed", vhost.c_str());
@@ -1300,7 +1389,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // min_latency, only one per vhost
             if (!srs_directive_equals(new_vhost->get("min_latency"), old_vhost->get("min_latency"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostRealtime);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_realtime(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes min_latency failed", vhost.c_str());
@@ -1311,7 +1401,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // play, only one per vhost
             if (!srs_directive_equals(new_vhost->get("play"), old_vhost->get("play"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostPlay);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_play(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes play failed", vhost.c_str());
@@ -1322,7 +1413,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // forward, only one per vhost
             if (!srs_directive_equals(new_vhost->get("forward"), old_vhost->get("forward"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostForward);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_forward(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes forward failed", vhost.c_str());
@@ -1333,7 +1425,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // To reload DASH.
             if (!srs_directive_equals(new_vhost->get("dash"), old_vhost->get("dash"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostDash);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_dash(vhost)) != srs_success) {
                         return srs_error_wrap(err, "Reload vhost %s dash failed", vhost.c_str());
@@ -1345,7 +1438,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             // hls, only one per vhost
             // @remark, the hls_on_error directly support reload.
             if (!srs_directive_equals(new_vhost->get("hls"), old_vhost->get("hls"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostHls);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_hls(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes hls failed", vhost.c_str());
@@ -1356,7 +1450,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // hds reload
             if (!srs_directive_equals(new_vhost->get("hds"), old_vhost->get("hds"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostHds);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_hds(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes hds failed", vhost.c_str());
@@ -1367,7 +1462,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // dvr, only one per vhost, except the dvr_apply
             if (!srs_directive_equals(new_vhost->get("dvr"), old_vhost->get("dvr"), "dvr_apply")) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostDvr);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_dvr(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes dvr failed", vhost.c_str());
@@ -1389,7 +1485,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // exec, only one per vhost
             if (!srs_directive_equals(new_vhost->get("exec"), old_vhost->get("exec"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostExec);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_exec(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes exec failed", vhost.c_str());
@@ -1400,7 +1497,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // publish, only one per vhost
             if (!srs_directive_equals(new_vhost->get("publish"), old_vhost->get("publish"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostPublish);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_publish(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes publish failed", vhost.c_str());
@@ -1411,7 +1509,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // http_static, only one per vhost.
             if (!srs_directive_equals(new_vhost->get("http_static"), old_vhost->get("http_static"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostHttpStatic);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_http_updated()) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes http_static failed", vhost.c_str());
@@ -1422,7 +1521,8 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // http_remux, only one per vhost.
             if (!srs_directive_equals(new_vhost->get("http_remux"), old_vhost->get("http_remux"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                handlers = get_subscribes(vhost, SrsReloadVhostHttpRemux);
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_http_remux_updated(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes http_remux failed", vhost.c_str());
@@ -1713,6 +1813,7 @@ srs_error_t SrsConfig::reload_transcode(SrsConfDirective* new_vhost, SrsConfDire
     }
     
     std::vector<ISrsReloadHandler*>::iterator it;
+    std::vector<ISrsReloadHandler*> handlers;
     
     std::string vhost = new_vhost->arg0();
     
@@ -1763,7 +1864,8 @@ srs_error_t SrsConfig::reload_transcode(SrsConfDirective* new_vhost, SrsConfDire
     
     // transcode, many per vhost
     if (changed) {
-        for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+        handlers = get_subscribes(vhost, SrsReloadVhostTranscode);
+        for (it = handlers.begin(); it != handlers.end(); ++it) {
             ISrsReloadHandler* subscribe = *it;
             if ((err = subscribe->on_reload_vhost_transcode(vhost)) != srs_success) {
                 return srs_error_wrap(err, "vhost %s notify subscribes transcode failed", vhost.c_str());
@@ -1796,6 +1898,7 @@ srs_error_t SrsConfig::reload_ingest(SrsConfDirective* new_vhost, SrsConfDirecti
     }
     
     std::vector<ISrsReloadHandler*>::iterator it;
+    std::vector<ISrsReloadHandler*> handlers;
     
     std::string vhost = new_vhost->arg0();
     
@@ -1808,7 +1911,8 @@ srs_error_t SrsConfig::reload_ingest(SrsConfDirective* new_vhost, SrsConfDirecti
         // ENABLED => DISABLED
         if (get_ingest_enabled(old_ingester) && !get_ingest_enabled(new_ingester)) {
             // notice handler ingester removed.
-            for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+            handlers = get_subscribes(vhost, SrsReloadVhostIngest);
+            for (it = handlers.begin(); it != handlers.end(); ++it) {
                 ISrsReloadHandler* subscribe = *it;
                 if ((err = subscribe->on_reload_ingest_removed(vhost, ingest_id)) != srs_success) {
                     return srs_error_wrap(err, "vhost %s notify subscribes ingest=%s removed failed", vhost.c_str(), ingest_id.c_str());
@@ -1826,7 +1930,8 @@ srs_error_t SrsConfig::reload_ingest(SrsConfDirective* new_vhost, SrsConfDirecti
         
         // DISABLED => ENABLED
         if (!get_ingest_enabled(old_ingester) && get_ingest_enabled(new_ingester)) {
-            for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+            handlers = get_subscribes(vhost, SrsReloadVhostIngest);
+            for (it = handlers.begin(); it != handlers.end(); ++it) {
                 ISrsReloadHandler* subscribe = *it;
                 if ((err = subscribe->on_reload_ingest_added(vhost, ingest_id)) != srs_success) {
                     return srs_error_wrap(err, "vhost %s notify subscribes ingest=%s added failed", vhost.c_str(), ingest_id.c_str());
@@ -1849,7 +1954,8 @@ srs_error_t SrsConfig::reload_ingest(SrsConfDirective* new_vhost, SrsConfDirecti
             }
             
             // notice handler ingester removed.
-            for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+            handlers = get_subscribes(vhost, SrsReloadVhostIngest);
+            for (it = handlers.begin(); it != handlers.end(); ++it) {
                 ISrsReloadHandler* subscribe = *it;
                 if ((err = subscribe->on_reload_ingest_updated(vhost, ingest_id)) != srs_success) {
                     return srs_error_wrap(err, "vhost %s notify subscribes ingest=%s updated failed", vhost.c_str(), ingest_id.c_str());
@@ -2068,6 +2174,17 @@ srs_error_t SrsConfig::global_to_json(SrsJsonObject* obj)
                 }
             }
             obj->set(dir->name, sobj);
+        } else if (dir->name == "stack") {
+            SrsJsonObject* sobj = SrsJsonAny::object();
+            for (int j = 0; j < (int)dir->directives.size(); j++) {
+                SrsConfDirective* sdir = dir->directives.at(j);
+                if (sdir->name == "guard") {
+                    sobj->set(sdir->name, sdir->dumps_arg0_to_boolean());
+                } else {
+                    sobj->set(sdir->name, sdir->dumps_arg0_to_integer());
+                }
+            }
+            obj->set(dir->name, sobj);
         } else if (dir->name == "stats") {
             SrsJsonObject* sobj = SrsJsonAny::object();
             for (int j = 0; j < (int)dir->directives.size(); j++) {
@@ -2076,6 +2193,10 @@ srs_error_t SrsConfig::global_to_json(SrsJsonObject* obj)
                     sobj->set(sdir->name, sdir->dumps_arg0_to_integer());
                 } else if (sdir->name == "disk") {
                     sobj->set(sdir->name, sdir->dumps_args());
+                } else if (sdir->name == "shm") {
+                    sobj->set(sdir->name, sdir->dumps_arg0_to_str());
+                } else if (sdir->name == "latency") {
+                    sobj->set(sdir->name, sdir->dumps_arg0_to_boolean());
                 }
             }
             obj->set(dir->name, sobj);
@@ -2137,6 +2258,8 @@ srs_error_t SrsConfig::global_to_json(SrsJsonObject* obj)
                     sobj->set(sdir->name, sdir->dumps_arg0_to_integer());
                 } else if (sdir->name == "rtp_port_max") {
                     sobj->set(sdir->name, sdir->dumps_arg0_to_integer());
+                } else if (sdir->name == "rtp_latency") {
+                    sobj->set(sdir->name, sdir->dumps_arg0_to_integer());
                 }
             }
             obj->set(dir->name, sobj);
@@ -2185,6 +2308,9 @@ srs_error_t SrsConfig::global_to_json(SrsJsonObject* obj)
         if (get_exec_enabled(dir->arg0())) {
             sobj->set("exec", SrsJsonAny::boolean(true));
         }
+        if (get_abr_enabled(dir->arg0())) {
+            sobj->set("abr", SrsJsonAny::boolean(true));
+        }
         if (get_bw_check_enabled(dir->arg0())) {
             sobj->set("bandcheck", SrsJsonAny::boolean(true));
         }
@@ -2319,6 +2445,10 @@ srs_error_t SrsConfig::vhost_to_json(SrsConfDirective* vhost, SrsJsonObject* obj
                 cluster->set("vhost", sdir->dumps_arg0_to_str());
             } else if (sdir->name == "debug_srs_upnode") {
                 cluster->set("debug_srs_upnode", sdir->dumps_arg0_to_boolean());
+            } else if (sdir->name == "origin_lb") {
+                cluster->set("origin_lb", sdir->dumps_arg0_to_str());
+            } else if (sdir->name == "origin_lb_factor") {
+                cluster->set("origin_lb_factor", sdir->dumps_arg0_to_number());
             }
         }
     }
@@ -2365,6 +2495,12 @@ srs_error_t SrsConfig::vhost_to_json(SrsConfDirective* vhost, SrsJsonObject* obj
                 play->set("reduce_sequence_header", sdir->dumps_arg0_to_boolean());
             } else if (sdir->name == "send_min_interval") {
                 play->set("send_min_interval", sdir->dumps_arg0_to_integer());
+            } else if (sdir->name == "frame_drop") {
+                play->set("frame_drop", sdir->dumps_arg0_to_boolean());
+            } else if (sdir->name == "notsent_lowat") {
+                play->set("notsent_lowat", sdir->dumps_arg0_to_integer());
+            } else if (sdir->name == "pacing") {
+                play->set("pacing", sdir->dumps_arg0_to_boolean());
             }
         }
     }
@@ -2525,6 +2661,12 @@ srs_error_t SrsConfig::vhost_to_json(SrsConfDirective* vhost, SrsJsonObject* obj
                 http_hooks->set("on_hls", sdir->dumps_args());
             } else if (sdir->name == "on_hls_notify") {
                 http_hooks->set("on_hls_notify", sdir->dumps_arg0_to_str());
+            } else if (sdir->name == "timeout") {
+                http_hooks->set("timeout", sdir->dumps_arg0_to_number());
+            } else if (sdir->name == "async_workers") {
+                http_hooks->set("async_workers", sdir->dumps_arg0_to_integer());
+            } else if (sdir->name == "on_play_cache") {
+                http_hooks->set("on_play_cache", sdir->dumps_arg0_to_number());
             }
         }
     }
@@ -2653,6 +2795,28 @@ srs_error_t SrsConfig::vhost_to_json(SrsConfDirective* vhost, SrsJsonObject* obj
         }
     }
     
+    // abr
+    if ((dir = vhost->get("abr")) != NULL) {
+        SrsJsonObject* abr = SrsJsonAny::object();
+        obj->set("abr", abr);
+        
+        abr->set("enabled", SrsJsonAny::boolean(get_abr_enabled(vhost->name)));
+        
+        for (int i = 0; i < (int)dir->directives.size(); i++) {
+            SrsConfDirective* sdir = dir->directives.at(i);
+            
+            if (sdir->name == "renditions") {
+                abr->set("renditions", sdir->dumps_args());
+            } else if (sdir->name == "down_queue") {
+                abr->set("down_queue", sdir->dumps_arg0_to_number());
+            } else if (sdir->name == "up_queue") {
+                abr->set("up_queue", sdir->dumps_arg0_to_number());
+            } else if (sdir->name == "up_hold") {
+                abr->set("up_hold", sdir->dumps_arg0_to_number());
+            }
+        }
+    }
+    
     // ingest
     SrsJsonArray* ingests = NULL;
     for (int i = 0; i < (int)vhost->directives.size(); i++) {
@@ -2687,6 +2851,11 @@ srs_error_t SrsConfig::vhost_to_json(SrsConfDirective* vhost, SrsJsonObject* obj
                 if (url) {
                     input->set("url", url->dumps_arg0_to_str());
                 }
+                
+                SrsConfDirective* prefetch = sdir->get("prefetch");
+                if (prefetch) {
+                    input->set("prefetch", prefetch->dumps_arg0_to_integer());
+                }
             } else if (sdir->name == "ffmpeg") {
                 ingest->set("ffmpeg", sdir->dumps_arg0_to_str());
             } else if (sdir->name == "engine") {
@@ -2751,6 +2920,7 @@ srs_error_t SrsConfig::raw_to_json(SrsJsonObject* obj)
     sobj->set("enabled", SrsJsonAny::boolean(get_http_api_enabled()));
     sobj->set("listen", SrsJsonAny::str(get_http_api_listen().c_str()));
     sobj->set("crossdomain", SrsJsonAny::boolean(get_http_api_crossdomain()));
+    sobj->set("profiler", SrsJsonAny::boolean(get_http_api_profiler()));
     
     SrsJsonObject* ssobj = SrsJsonAny::object();
     sobj->set("raw_api", ssobj);
@@ -3278,7 +3448,9 @@ srs_error_t SrsConfig::do_reload_vhost_added(string vhost)
     srs_trace("vhost %s added, reload it.", vhost.c_str());
     
     vector<ISrsReloadHandler*>::iterator it;
-    for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+    vector<ISrsReloadHandler*> handlers;
+    handlers = get_subscribes(vhost, SrsReloadVhostAdded);
+    for (it = handlers.begin(); it != handlers.end(); ++it) {
         ISrsReloadHandler* subscribe = *it;
         if ((err = subscribe->on_reload_vhost_added(vhost)) != srs_success) {
             return srs_error_wrap(err, "notify subscribes added vhost %s failed", vhost.c_str());
@@ -3297,7 +3469,9 @@ srs_error_t SrsConfig::do_reload_vhost_removed(string vhost)
     srs_trace("vhost %s removed, reload it.", vhost.c_str());
     
     vector<ISrsReloadHandler*>::iterator it;
-    for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+    vector<ISrsReloadHandler*> handlers;
+    handlers = get_subscribes(vhost, SrsReloadVhostRemoved);
+    for (it = handlers.begin(); it != handlers.end(); ++it) {
         ISrsReloadHandler* subscribe = *it;
         if ((err = subscribe->on_reload_vhost_removed(vhost)) != srs_success) {
             return srs_error_wrap(err, "notify subscribes removed vhost %s failed", vhost.c_str());
@@ -3313,7 +3487,9 @@ srs_error_t SrsConfig::do_reload_vhost_dvr_apply(string vhost)
     srs_error_t err = srs_success;
     
     vector<ISrsReloadHandler*>::iterator it;
-    for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+    vector<ISrsReloadHandler*> handlers;
+    handlers = get_subscribes(vhost, SrsReloadVhostDvrApply);
+    for (it = handlers.begin(); it != handlers.end(); ++it) {
         ISrsReloadHandler* subscribe = *it;
         if ((err = subscribe->on_reload_vhost_dvr_apply(vhost)) != srs_success) {
             return srs_error_wrap(err, "vhost %s notify subscribes dvr_apply failed", vhost.c_str());
@@ -3489,7 +3665,8 @@ srs_error_t SrsConfig::check_normal_config()
             && n != "utc_time" && n != "work_dir" && n != "asprocess"
             && n != "ff_log_level" && n != "grace_final_wait" && n != "force_grace_quit"
             && n != "grace_start_wait" && n != "empty_ip_ok" && n != "disable_daemon_for_docker"
-            && n != "inotify_auto_reload" && n != "auto_reload_for_docker"
+            && n != "inotify_auto_reload" && n != "auto_reload_for_docker" && n != "source_idle_timeout"
+            && n != "stack"
             ) {
             return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal directive %s", n.c_str());
         }
@@ -3499,7 +3676,7 @@ srs_error_t SrsConfig::check_normal_config()
         for (int i = 0; conf && i < (int)conf->directives.size(); i++) {
             SrsConfDirective* obj = conf->at(i);
             string n = obj->name;
-            if (n != "enabled" && n != "listen" && n != "crossdomain" && n != "raw_api") {
+            if (n != "enabled" && n != "listen" && n != "crossdomain" && n != "raw_api" && n != "profiler") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal http_api.%s", n.c_str());
             }
             
@@ -3536,11 +3713,26 @@ srs_error_t SrsConfig::check_normal_config()
         SrsConfDirective* conf = get_stats();
         for (int i = 0; conf && i < (int)conf->directives.size(); i++) {
             string n = conf->at(i)->name;
-            if (n != "network" && n != "disk") {
+            if (n != "network" && n != "disk" && n != "shm" && n != "latency") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal stats.%s", n.c_str());
             }
         }
     }
+    if (true) {
+        SrsConfDirective* conf = root->get("stack");
+        for (int i = 0; conf && i < (int)conf->directives.size(); i++) {
+            string n = conf->at(i)->name;
+            if (n != "connection" && n != "receiver" && n != "worker" && n != "pool" && n != "guard") {
+                return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal stack.%s", n.c_str());
+            }
+            
+            // A too small stack overflows silently, when the guard pages are off.
+            int size = ::atoi(conf->at(i)->arg0().c_str());
+            if ((n == "connection" || n == "receiver" || n == "worker") && size != 0 && size < 16) {
+                return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "stack.%s=%dKB should >= 16KB", n.c_str(), size);
+            }
+        }
+    }
     
     ////////////////////////////////////////////////////////////////////////
     // check listen for rtmp.
@@ -3636,7 +3828,7 @@ srs_error_t SrsConfig::check_normal_config()
             SrsConfDirective* conf = stream_caster->at(i);
             string n = conf->name;
             if (n != "enabled" && n != "caster" && n != "output"
-                && n != "listen" && n != "rtp_port_min" && n != "rtp_port_max") {
+                && n != "listen" && n != "rtp_port_min" && n != "rtp_port_max" && n != "rtp_latency") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal stream_caster.%s", n.c_str());
             }
         }
@@ -3658,7 +3850,7 @@ srs_error_t SrsConfig::check_normal_config()
                 && n != "play" && n != "publish" && n != "cluster"
                 && n != "security" && n != "http_remux" && n != "dash"
                 && n != "http_static" && n != "hds" && n != "exec"
-                && n != "in_ack_size" && n != "out_ack_size") {
+                && n != "in_ack_size" && n != "out_ack_size" && n != "abr") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.%s", n.c_str());
             }
             // for each sub directives of vhost.
@@ -3677,6 +3869,13 @@ srs_error_t SrsConfig::check_normal_config()
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.refer.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
+            } else if (n == "abr") {
+                for (int j = 0; j < (int)conf->directives.size(); j++) {
+                    string m = conf->at(j)->name;
+                    if (m != "enabled" && m != "renditions" && m != "down_queue" && m != "up_queue" && m != "up_hold") {
+                        return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.abr.%s of %s", m.c_str(), vhost->arg0().c_str());
+                    }
+                }
             } else if (n == "exec") {
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
@@ -3688,7 +3887,8 @@ srs_error_t SrsConfig::check_normal_config()
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
                     if (m != "time_jitter" && m != "mix_correct" && m != "atc" && m != "atc_auto" && m != "mw_latency"
-                        && m != "gop_cache" && m != "queue_length" && m != "send_min_interval" && m != "reduce_sequence_header") {
+                        && m != "gop_cache" && m != "queue_length" && m != "send_min_interval" && m != "reduce_sequence_header"
+                        && m != "frame_drop" && m != "notsent_lowat" && m != "pacing") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.play.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -3696,7 +3896,7 @@ srs_error_t SrsConfig::check_normal_config()
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
                     if (m != "mode" && m != "origin" && m != "token_traverse" && m != "vhost" && m != "debug_srs_upnode" && m != "coworkers"
-                        && m != "origin_cluster") {
+                        && m != "origin_cluster" && m != "origin_lb" && m != "origin_lb_factor") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.cluster.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -3757,7 +3957,8 @@ srs_error_t SrsConfig::check_normal_config()
                     string m = conf->at(j)->name;
                     if (m != "enabled" && m != "on_connect" && m != "on_close" && m != "on_publish"
                         && m != "on_unpublish" && m != "on_play" && m != "on_stop"
-                        && m != "on_dvr" && m != "on_hls" && m != "on_hls_notify") {
+                        && m != "on_dvr" && m != "on_hls" && m != "on_hls_notify" && m != "timeout"
+                        && m != "async_workers" && m != "on_play_cache") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.http_hooks.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -3828,6 +4029,38 @@ srs_error_t SrsConfig::check_normal_config()
             ids.push_back(id);
         }
     }
+    // check the engine of hls/flv ingest, which delivers the frames to source without ffmpeg,
+    // so it's not able to transcode, only the output of engine is used.
+    for (int i = 0; i < (int)vhosts.size(); i++) {
+        SrsConfDirective* vhost = vhosts[i];
+        
+        for (int j = 0; j < (int)vhost->directives.size(); j++) {
+            SrsConfDirective* conf = vhost->at(j);
+            if (conf->name != "ingest") {
+                continue;
+            }
+            
+            std::string type = get_ingest_input_type(conf);
+            if (!srs_config_ingest_is_hls(type) && !srs_config_ingest_is_flv(type)) {
+                continue;
+            }
+            
+            std::vector<SrsConfDirective*> engines = get_transcode_engines(conf);
+            for (int k = 0; k < (int)engines.size(); k++) {
+                SrsConfDirective* engine = engines.at(k);
+                if (!get_engine_enabled(engine)) {
+                    continue;
+                }
+                
+                std::string vcodec = get_engine_vcodec(engine);
+                std::string acodec = get_engine_acodec(engine);
+                if ((!vcodec.empty() && vcodec != "copy") || (!acodec.empty() && acodec != "copy")) {
+                    return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "ingest id=%s type=%s of %s not support transcode, vcodec=%s, acodec=%s",
+                        conf->arg0().c_str(), type.c_str(), vhost->arg0().c_str(), vcodec.c_str(), acodec.c_str());
+                }
+            }
+        }
+    }
     
     ////////////////////////////////////////////////////////////////////////
     // check chunk size
@@ -4136,6 +4369,69 @@ bool SrsConfig::auto_reload_for_docker()
     return SRS_CONF_PERFER_TRUE(conf->arg0());
 }
 
+srs_utime_t SrsConfig::get_source_idle_timeout()
+{
+    static srs_utime_t DEFAULT = 30 * SRS_UTIME_SECONDS;
+    
+    SrsConfDirective* conf = root->get("source_idle_timeout");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atol(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
+int SrsConfig::get_stack_size(string role)
+{
+    static int DEFAULT = 0;
+    
+    SrsConfDirective* conf = root->get("stack");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get(role);
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return ::atoi(conf->arg0().c_str()) * 1024;
+}
+
+int SrsConfig::get_stack_pool()
+{
+    static int DEFAULT = 0;
+    
+    SrsConfDirective* conf = root->get("stack");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("pool");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return ::atoi(conf->arg0().c_str());
+}
+
+bool SrsConfig::get_stack_guard()
+{
+    static bool DEFAULT = true;
+    
+    SrsConfDirective* conf = root->get("stack");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("guard");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return SRS_CONF_PERFER_TRUE(conf->arg0());
+}
+
 vector<SrsConfDirective*> SrsConfig::get_stream_casters()
 {
     srs_assert(root);
@@ -4251,6 +4547,22 @@ int SrsConfig::get_stream_caster_rtp_port_max(SrsConfDirective* conf)
     return ::atoi(conf->arg0().c_str());
 }
 
+srs_utime_t SrsConfig::get_stream_caster_rtp_latency(SrsConfDirective* conf)
+{
+    static srs_utime_t DEFAULT = 300 * SRS_UTIME_MILLISECONDS;
+    
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("rtp_latency");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atoi(conf->arg0().c_str()) * SRS_UTIME_MILLISECONDS);
+}
+
 SrsConfDirective* SrsConfig::get_vhost(string vhost, bool try_default_vhost)
 {
     srs_assert(root);
@@ -4466,6 +4778,72 @@ srs_utime_t SrsConfig::get_queue_length(string vhost)
     return srs_utime_t(::atoi(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
 }
 
+bool SrsConfig::get_frame_drop(string vhost)
+{
+    static bool DEFAULT = false;
+    
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("play");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("frame_drop");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return SRS_CONF_PERFER_TRUE(conf->arg0());
+}
+
+int SrsConfig::get_notsent_lowat(string vhost)
+{
+    static int DEFAULT = 0;
+    
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("play");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("notsent_lowat");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return ::atoi(conf->arg0().c_str());
+}
+
+bool SrsConfig::get_pacing(string vhost)
+{
+    static bool DEFAULT = false;
+    
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("play");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("pacing");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
 bool SrsConfig::get_refer_enabled(string vhost)
 {
     static bool DEFAULT = false;
@@ -4971,6 +5349,57 @@ SrsConfDirective* SrsConfig::get_vhost_on_hls_notify(string vhost)
     return conf->get("on_hls_notify");
 }
 
+srs_utime_t SrsConfig::get_vhost_hooks_timeout(string vhost)
+{
+    static srs_utime_t DEFAULT = 30 * SRS_UTIME_SECONDS;
+    
+    SrsConfDirective* conf = get_vhost_http_hooks(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("timeout");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
+int SrsConfig::get_vhost_hooks_async_workers(string vhost)
+{
+    static int DEFAULT = 1;
+    
+    SrsConfDirective* conf = get_vhost_http_hooks(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("async_workers");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return ::atoi(conf->arg0().c_str());
+}
+
+srs_utime_t SrsConfig::get_vhost_hooks_on_play_cache(string vhost)
+{
+    static srs_utime_t DEFAULT = 0;
+    
+    SrsConfDirective* conf = get_vhost_http_hooks(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("on_play_cache");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
 bool SrsConfig::get_bw_check_enabled(string vhost)
 {
     static bool DEFAULT = false;
@@ -5146,6 +5575,50 @@ string SrsConfig::get_vhost_edge_transform_vhost(string vhost)
     return conf->arg0();
 }
 
+string SrsConfig::get_vhost_edge_origin_lb(string vhost)
+{
+    static string DEFAULT = "round_robin";
+    
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("cluster");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("origin_lb");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return conf->arg0();
+}
+
+double SrsConfig::get_vhost_edge_origin_lb_factor(string vhost)
+{
+    static double DEFAULT = 1.25;
+    
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("cluster");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("origin_lb_factor");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return ::atof(conf->arg0().c_str());
+}
+
 bool SrsConfig::get_vhost_origin_cluster(string vhost)
 {
     static bool DEFAULT = false;
@@ -5711,6 +6184,105 @@ vector<SrsConfDirective*> SrsConfig::get_exec_publishs(string vhost)
     return eps;
 }
 
+SrsConfDirective* SrsConfig::get_abr(string vhost)
+{
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return NULL;
+    }
+    
+    return conf->get("abr");
+}
+
+bool SrsConfig::get_abr_enabled(string vhost)
+{
+    static bool DEFAULT = false;
+    
+    SrsConfDirective* conf = get_abr(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("enabled");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+vector<string> SrsConfig::get_abr_renditions(string vhost)
+{
+    vector<string> renditions;
+    
+    SrsConfDirective* conf = get_abr(vhost);
+    if (!conf) {
+        return renditions;
+    }
+    
+    conf = conf->get("renditions");
+    if (!conf) {
+        return renditions;
+    }
+    
+    for (int i = 0; i < (int)conf->args.size(); i++) {
+        renditions.push_back(conf->args.at(i));
+    }
+    
+    return renditions;
+}
+
+srs_utime_t SrsConfig::get_abr_down_queue(string vhost)
+{
+    static srs_utime_t DEFAULT = 3 * SRS_UTIME_SECONDS;
+    
+    SrsConfDirective* conf = get_abr(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("down_queue");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
+srs_utime_t SrsConfig::get_abr_up_queue(string vhost)
+{
+    static srs_utime_t DEFAULT = 500 * SRS_UTIME_MILLISECONDS;
+    
+    SrsConfDirective* conf = get_abr(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("up_queue");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
+srs_utime_t SrsConfig::get_abr_up_hold(string vhost)
+{
+    static srs_utime_t DEFAULT = 10 * SRS_UTIME_SECONDS;
+    
+    SrsConfDirective* conf = get_abr(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("up_hold");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
 vector<SrsConfDirective*> SrsConfig::get_ingesters(string vhost)
 {
     vector<SrsConfDirective*> integers;
@@ -5815,6 +6387,27 @@ string SrsConfig::get_ingest_input_url(SrsConfDirective* conf)
     return conf->arg0();
 }
 
+int SrsConfig::get_ingest_input_prefetch(SrsConfDirective* conf)
+{
+    static int DEFAULT = 3;
+    
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("input");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("prefetch");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return ::atoi(conf->arg0().c_str());
+}
+
 bool SrsConfig::get_log_tank_file()
 {
     static bool DEFAULT = true;
@@ -6655,6 +7248,23 @@ bool SrsConfig::get_http_api_crossdomain()
     return SRS_CONF_PERFER_TRUE(conf->arg0());
 }
 
+bool SrsConfig::get_http_api_profiler()
+{
+    static bool DEFAULT = false;
+    
+    SrsConfDirective* conf = root->get("http_api");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("profiler");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
 bool SrsConfig::get_raw_api()
 {
     static bool DEFAULT = false;
@@ -7074,3 +7684,37 @@ SrsConfDirective* SrsConfig::get_stats_disk_device()
     
     return conf;
 }
+
+string SrsConfig::get_stats_shm()
+{
+    static string DEFAULT = "";
+    
+    SrsConfDirective* conf = get_stats();
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("shm");
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    return conf->arg0();
+}
+
+bool SrsConfig::get_stats_latency()
+{
+    static bool DEFAULT = false;
+    
+    SrsConfDirective* conf = get_stats();
+    if (!conf) {
+        return DEFAULT;
+    }
+    
+    conf = conf->get("latency");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
@@ -29,6 +29,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <list>
 #include <sstream>
 #include <algorithm>
 
@@ -46,6 +47,7 @@ class SrsConfig;
 class SrsRequest;
 class SrsJsonArray;
 class SrsConfDirective;
+class SrsReloadSubscription;
 
 /**
  * whether the two vector actual equals, for instance,
@@ -114,6 +116,8 @@ extern bool srs_config_hls_is_on_error_ignore(std::string strategy);
 extern bool srs_config_hls_is_on_error_continue(std::string strategy);
 extern bool srs_config_ingest_is_file(std::string type);
 extern bool srs_config_ingest_is_stream(std::string type);
+extern bool srs_config_ingest_is_hls(std::string type);
+extern bool srs_config_ingest_is_flv(std::string type);
 extern bool srs_config_dvr_is_plan_segment(std::string plan);
 extern bool srs_config_dvr_is_plan_session(std::string plan);
 extern bool srs_stream_caster_is_udp(std::string caster);
@@ -302,6 +306,11 @@ protected:
 private:
     // The reload subscribers, when reload, callback all handlers.
     std::vector<ISrsReloadHandler*> subscribes;
+    // The reload subscribers of vhost, indexed by vhost and section,
+    // when reload, only callback the handlers of the changed section of vhost.
+    std::map<std::string, std::map<int, std::list<ISrsReloadHandler*> > > vhost_subscribes;
+    // The subscription of each vhost handler, to unsubscribe it.
+    std::map<ISrsReloadHandler*, SrsReloadSubscription*> subscriptions;
 public:
     SrsConfig();
     virtual ~SrsConfig();
@@ -314,8 +323,18 @@ public:
     // For reload handler to register itself,
     // when config service do the reload, callback the handler.
     virtual void subscribe(ISrsReloadHandler* handler);
+    // For reload handler of vhost to register itself, for example, the stream source,
+    // when the sections of vhost changed, callback the handler.
+    // @param sections The sections to subscribe, the SrsReloadSection set.
+    // @remark Subscribe again to change the vhost or sections.
+    virtual void subscribe(ISrsReloadHandler* handler, std::string vhost, int sections);
     // For reload handler to unregister itself.
     virtual void unsubscribe(ISrsReloadHandler* handler);
+private:
+    // Get the handlers to callback when section of vhost changed,
+    // the global handlers and the handlers of vhost which subscribe the section.
+    virtual std::vector<ISrsReloadHandler*> get_subscribes(std::string vhost, SrsReloadSection section);
+public:
     // Reload  the config file.
     // @remark, user can test the config before reload it.
     virtual srs_error_t reload();
@@ -482,6 +501,16 @@ public:
     virtual bool inotify_auto_reload();
     // Whether enable auto reload config for docker.
     virtual bool auto_reload_for_docker();
+    // Get the idle timeout to cleanup the source without publisher and players.
+    // @remark Never cleanup when zero.
+    virtual srs_utime_t get_source_idle_timeout();
+    // Get the stack size in bytes of coroutines for the role, connection, receiver or worker.
+    // @remark Use the default stack size of ST when zero.
+    virtual int get_stack_size(std::string role);
+    // Get the max number of free stacks to reuse, unlimited when zero.
+    virtual int get_stack_pool();
+    // Whether protect the stacks by guard pages.
+    virtual bool get_stack_guard();
 // stream_caster section
 public:
     // Get all stream_caster in config file.
@@ -498,6 +527,8 @@ public:
     virtual int get_stream_caster_rtp_port_min(SrsConfDirective* conf);
     // Get the max udp port for rtp of stream caster rtsp.
     virtual int get_stream_caster_rtp_port_max(SrsConfDirective* conf);
+    // Get the max time to wait for the lost rtp packets of stream caster rtsp.
+    virtual srs_utime_t get_stream_caster_rtp_latency(SrsConfDirective* conf);
 // vhost specified section
 public:
     // Get the vhost directive by vhost name.
@@ -547,6 +578,15 @@ public:
     // when exceed the queue length, drop packet util I frame.
     // @remark, default 10s.
     virtual srs_utime_t get_queue_length(std::string vhost);
+    // Whether drop the video frames gradually for the congested player.
+    // @remark, default true.
+    virtual bool get_frame_drop(std::string vhost);
+    // Get the TCP_NOTSENT_LOWAT in bytes for player, to limit the unsent bytes in kernel.
+    // @remark, default 0, disabled.
+    virtual int get_notsent_lowat(std::string vhost);
+    // Whether pace the messages to player at the delivery rate of TCP.
+    // @remark, default false.
+    virtual bool get_pacing(std::string vhost);
     // Whether the refer hotlink-denial enabled.
     virtual bool get_refer_enabled(std::string vhost);
     // Get the refer hotlink-denial for all type.
@@ -638,6 +678,12 @@ public:
     // Get the on_hls_notify callbacks of vhost.
     // @return the on_hls_notify callback directive, the args is the url to callback.
     virtual SrsConfDirective* get_vhost_on_hls_notify(std::string vhost);
+    // Get the timeout of each http hook request, in srs_utime_t.
+    virtual srs_utime_t get_vhost_hooks_timeout(std::string vhost);
+    // Get the max number of async hooks(on_dvr, on_hls and on_hls_notify) to call concurrently for each stream.
+    virtual int get_vhost_hooks_async_workers(std::string vhost);
+    // Get the duration to cache the allowed on_play, 0 to disable, in srs_utime_t.
+    virtual srs_utime_t get_vhost_hooks_on_play_cache(std::string vhost);
 // bwct(bandwidth check tool) section
 public:
     // Whether bw check enabled for vhost.
@@ -676,6 +722,11 @@ public:
     // Get the transformed vhost for edge,
     // @see https://github.com/ossrs/srs/issues/372
     virtual std::string get_vhost_edge_transform_vhost(std::string vhost);
+    // Get the load balance algorithm to select origin for edge,
+    // round_robin or consistent_hash.
+    virtual std::string get_vhost_edge_origin_lb(std::string vhost);
+    // Get the load factor of consistent hash for edge, 0 to disable the bounded load.
+    virtual double get_vhost_edge_origin_lb_factor(std::string vhost);
     // Whether enable the origin cluster.
     // @see https://github.com/ossrs/srs/wiki/v3_EN_OriginCluster
     virtual bool get_vhost_origin_cluster(std::string vhost);
@@ -770,6 +821,21 @@ public:
     virtual bool get_exec_enabled(std::string vhost);
     // Get all exec publish directives of vhost.
     virtual std::vector<SrsConfDirective*> get_exec_publishs(std::string vhost);
+// vhost abr section
+private:
+    // Get the abr directive of vhost.
+    virtual SrsConfDirective* get_abr(std::string vhost);
+public:
+    // Whether the ABR of players is enabled of vhost.
+    virtual bool get_abr_enabled(std::string vhost);
+    // Get the lower renditions of stream, from the highest to the lowest quality.
+    virtual std::vector<std::string> get_abr_renditions(std::string vhost);
+    // Get the depth of queue to switch down, in srs_utime_t.
+    virtual srs_utime_t get_abr_down_queue(std::string vhost);
+    // Get the depth of queue to switch up, in srs_utime_t.
+    virtual srs_utime_t get_abr_up_queue(std::string vhost);
+    // Get the time the queue keeps below up_queue before switching up, in srs_utime_t.
+    virtual srs_utime_t get_abr_up_hold(std::string vhost);
     // vhost ingest section
 public:
     // Get the ingest directives of vhost.
@@ -780,10 +846,12 @@ public:
     virtual bool get_ingest_enabled(SrsConfDirective* conf);
     // Get the ingest ffmpeg tool
     virtual std::string get_ingest_ffmpeg(SrsConfDirective* conf);
-    // Get the ingest input type, file or stream.
+    // Get the ingest input type, file, stream, hls or flv.
     virtual std::string get_ingest_input_type(SrsConfDirective* conf);
     // Get the ingest input url.
     virtual std::string get_ingest_input_url(SrsConfDirective* conf);
+    // Get the max number of segments to fetch concurrently, for hls input.
+    virtual int get_ingest_input_prefetch(SrsConfDirective* conf);
 // log section
 public:
     // Whether log to file.
@@ -917,6 +985,8 @@ public:
     virtual std::string get_http_api_listen();
     // Whether enable crossdomain for http api.
     virtual bool get_http_api_crossdomain();
+    // Whether enable the cpu profiler by /api/v1/profiles.
+    virtual bool get_http_api_profiler();
     // Whether enable the HTTP RAW API.
     virtual bool get_raw_api();
     // Whether allow rpc reload.
@@ -985,6 +1055,11 @@ public:
     // The device name configed in args of directive.
     // @return the disk device name to stat. NULL if not configed.
     virtual SrsConfDirective* get_stats_disk_device();
+    // Get the file of shared memory segment to publish the statistic, for external readers.
+    // @return the path of segment, for example, /dev/shm/srs.stat, empty if disabled.
+    virtual std::string get_stats_shm();
+    // Whether trace the latency of messages from publisher to players, by stages.
+    virtual bool get_stats_latency();
 };
 
 #endif
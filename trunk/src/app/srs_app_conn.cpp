@@ -24,13 +24,68 @@
 #include <srs_app_conn.hpp>
 
 #include <netinet/tcp.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/sockios.h>
+#endif
 using namespace std;
 
 #include <srs_kernel_log.hpp>
 #include <srs_kernel_error.hpp>
 #include <srs_app_utility.hpp>
+#include <srs_app_config.hpp>
 #include <srs_kernel_utility.hpp>
 
+#ifdef __linux__
+// The tcp_info of linux 4.9+, for glibc only defines the fields util tcpi_total_retrans.
+struct SrsLinuxTcpInfo
+{
+    struct tcp_info base;
+    uint64_t tcpi_pacing_rate;
+    uint64_t tcpi_max_pacing_rate;
+    uint64_t tcpi_bytes_acked;
+    uint64_t tcpi_bytes_received;
+    uint32_t tcpi_segs_out;
+    uint32_t tcpi_segs_in;
+    uint32_t tcpi_notsent_bytes;
+    uint32_t tcpi_min_rtt;
+    uint32_t tcpi_data_segs_in;
+    uint32_t tcpi_data_segs_out;
+    uint64_t tcpi_delivery_rate;
+};
+#endif
+
+// The gain of pacing rate, to probe more bandwidth like BBR.
+#define SRS_PACING_GAIN 1.25
+// The interval to sample the TCP_INFO for pacing.
+#define SRS_PACING_SAMPLE (100 * SRS_UTIME_MILLISECONDS)
+// The minimal delay to sleep for pacing.
+#define SRS_PACING_MIN_DELAY (1 * SRS_UTIME_MILLISECONDS)
+
+SrsTcpInfo::SrsTcpInfo()
+{
+    rtt = rttvar = 0;
+    cwnd = mss = retrans = notsent = 0;
+    delivery_rate = pacing_rate = 0;
+}
+
+SrsTcpInfo::~SrsTcpInfo()
+{
+}
+
+uint64_t SrsTcpInfo::bandwidth()
+{
+    // The bandwidth-delay product is cwnd*mss, so the bandwidth is BDP/rtt.
+    uint64_t v = 0;
+    if (rtt > 0) {
+        v = (uint64_t)cwnd * mss * SRS_UTIME_SECONDS / rtt;
+    }
+    
+    // The delivery rate is limited by the stream when app-limited, so use the larger one.
+    return srs_max(v, delivery_rate);
+}
+
 SrsConnection::SrsConnection(IConnectionManager* cm, srs_netfd_t c, string cip)
 {
     manager = cm;
@@ -43,7 +98,9 @@ SrsConnection::SrsConnection(IConnectionManager* cm, srs_netfd_t c, string cip)
     kbps = new SrsKbps(clk);
     kbps->set_io(skt, skt);
     
-    trd = new SrsSTCoroutine("conn", this);
+    SrsSTCoroutine* coroutine = new SrsSTCoroutine("conn", this);
+    coroutine->set_stack_size(_srs_config->get_stack_size("connection"));
+    trd = coroutine;
 }
 
 SrsConnection::~SrsConnection()
@@ -166,6 +223,86 @@ srs_error_t SrsConnection::set_socket_buffer(srs_utime_t buffer_v)
     return err;
 }
 
+int SrsConnection::get_send_occupancy()
+{
+#ifdef SIOCOUTQ
+    int fd = srs_netfd_fileno(stfd);
+    
+    // The bytes in socket send queue, which is not sent or not acked.
+    int nb_queued = 0;
+    if (ioctl(fd, SIOCOUTQ, &nb_queued) != 0) {
+        return 0;
+    }
+    
+    int nb_buffer = 0;
+    socklen_t nb_v = sizeof(int);
+    if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &nb_buffer, &nb_v) != 0 || nb_buffer <= 0) {
+        return 0;
+    }
+    
+    // The SO_SNDBUF is doubled by kernel for bookkeeping overhead, so the payload is about the half.
+    return srs_min(100, nb_queued * 100 / srs_max(1, nb_buffer / 2));
+#else
+    return 0;
+#endif
+}
+
+srs_error_t SrsConnection::set_notsent_lowat(int v)
+{
+    srs_error_t err = srs_success;
+    
+#ifdef TCP_NOTSENT_LOWAT
+    int fd = srs_netfd_fileno(stfd);
+    socklen_t nb_v = sizeof(int);
+    
+    int ov = 0;
+    getsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &ov, &nb_v);
+    
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &v, nb_v) < 0) {
+        return srs_error_new(ERROR_SOCKET_NOTSENT_LOWAT, "setsockopt fd=%d, v=%d", fd, v);
+    }
+    
+    srs_trace("set fd=%d, TCP_NOTSENT_LOWAT=%d=>%d", fd, ov, v);
+#else
+    srs_warn("ignore TCP_NOTSENT_LOWAT=%d, not supported", v);
+#endif
+    
+    return err;
+}
+
+srs_error_t SrsConnection::get_tcp_info(SrsTcpInfo* info)
+{
+    srs_error_t err = srs_success;
+    
+#ifdef __linux__
+    int fd = srs_netfd_fileno(stfd);
+    
+    // The kernel fills the fields it supports, so zero the others.
+    SrsLinuxTcpInfo ti;
+    memset(&ti, 0, sizeof(SrsLinuxTcpInfo));
+    
+    socklen_t nb_ti = sizeof(SrsLinuxTcpInfo);
+    if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &ti, &nb_ti) != 0) {
+        return srs_error_new(ERROR_SOCKET_TCP_INFO, "getsockopt fd=%d", fd);
+    }
+    
+    // The rtt of kernel is in microseconds, the same to srs_utime_t.
+    info->rtt = (srs_utime_t)ti.base.tcpi_rtt;
+    info->rttvar = (srs_utime_t)ti.base.tcpi_rttvar;
+    info->cwnd = ti.base.tcpi_snd_cwnd;
+    info->mss = ti.base.tcpi_snd_mss;
+    info->retrans = ti.base.tcpi_total_retrans;
+    info->notsent = ti.tcpi_notsent_bytes;
+    info->delivery_rate = ti.tcpi_delivery_rate;
+    // The pacing rate is ~0 when not paced by kernel.
+    info->pacing_rate = (ti.tcpi_pacing_rate == (uint64_t)-1)? 0 : ti.tcpi_pacing_rate;
+#else
+    (void)info;
+#endif
+    
+    return err;
+}
+
 srs_error_t SrsConnection::cycle()
 {
     srs_error_t err = do_cycle();
@@ -202,9 +339,73 @@ string SrsConnection::remote_ip() {
     return ip;
 }
 
+SrsKbps* SrsConnection::get_kbps()
+{
+    return kbps;
+}
+
 void SrsConnection::expire()
 {
     trd->interrupt();
 }
 
+SrsTcpPacer::SrsTcpPacer(SrsConnection* c)
+{
+    conn = c;
+    enabled = false;
+    rate = 0;
+    sample_at = deliver_at = 0;
+}
+
+SrsTcpPacer::~SrsTcpPacer()
+{
+}
+
+void SrsTcpPacer::set_enabled(bool v)
+{
+    enabled = v;
+}
 
+uint64_t SrsTcpPacer::get_rate()
+{
+    return rate;
+}
+
+srs_error_t SrsTcpPacer::on_sent(int64_t nb_bytes)
+{
+    srs_error_t err = srs_success;
+    
+    if (!enabled || nb_bytes <= 0) {
+        return err;
+    }
+    
+    srs_utime_t now = srs_update_system_time();
+    
+    // Update the rate by the metrics of TCP.
+    if (now - sample_at >= SRS_PACING_SAMPLE) {
+        sample_at = now;
+        
+        SrsTcpInfo info;
+        if ((err = conn->get_tcp_info(&info)) != srs_success) {
+            return srs_error_wrap(err, "tcp info");
+        }
+        rate = (uint64_t)(info.bandwidth() * SRS_PACING_GAIN);
+    }
+    
+    if (rate <= 0) {
+        return err;
+    }
+    
+    // Never accumulate the credit when idle, for it's a burst.
+    if (deliver_at < now) {
+        deliver_at = now;
+    }
+    deliver_at += (srs_utime_t)(nb_bytes * SRS_UTIME_SECONDS / rate);
+    
+    srs_utime_t delay = deliver_at - now;
+    if (delay >= SRS_PACING_MIN_DELAY) {
+        srs_usleep(delay);
+    }
+    
+    return err;
+}
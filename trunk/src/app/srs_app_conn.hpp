@@ -36,6 +36,31 @@
 
 class SrsWallClock;
 
+// The metrics of TCP connection, sampled from TCP_INFO.
+struct SrsTcpInfo
+{
+public:
+    // The smoothed rtt and its variance.
+    srs_utime_t rtt;
+    srs_utime_t rttvar;
+    // The congestion window in segments, and the size of segment in bytes.
+    uint32_t cwnd;
+    uint32_t mss;
+    // The total retransmitted segments.
+    uint32_t retrans;
+    // The bytes in kernel which are not sent, 0 if not supported.
+    uint32_t notsent;
+    // The delivery rate and pacing rate in bytes per second, 0 if not supported.
+    uint64_t delivery_rate;
+    uint64_t pacing_rate;
+public:
+    SrsTcpInfo();
+    virtual ~SrsTcpInfo();
+public:
+    // Estimate the bandwidth in bytes per second, by the delivery rate or cwnd/rtt.
+    virtual uint64_t bandwidth();
+};
+
 // The basic connection of SRS,
 // all connections accept from listener must extends from this base class,
 // server will add the connection to manager, and delete it when remove.
@@ -84,6 +109,12 @@ public:
     virtual srs_error_t set_tcp_nodelay(bool v);
     // Set socket option SO_SNDBUF in srs_utime_t.
     virtual srs_error_t set_socket_buffer(srs_utime_t buffer_v);
+    // Get the occupancy in percent of socket send buffer, 0 if not supported.
+    virtual int get_send_occupancy();
+    // Set socket option TCP_NOTSENT_LOWAT in bytes, to limit the unsent bytes in kernel.
+    virtual srs_error_t set_notsent_lowat(int v);
+    // Sample the metrics of TCP from TCP_INFO.
+    virtual srs_error_t get_tcp_info(SrsTcpInfo* info);
 // Interface ISrsOneCycleThreadHandler
 public:
     // The thread cycle function,
@@ -95,6 +126,8 @@ public:
     virtual int srs_id();
     // Get the remote ip of peer.
     virtual std::string remote_ip();
+    // Get the kbps of connection, to measure the throughput.
+    virtual SrsKbps* get_kbps();
     // Set connection to expired.
     virtual void expire();
 protected:
@@ -102,4 +135,27 @@ protected:
     virtual srs_error_t do_cycle() = 0;
 };
 
+// The pacer to send the merged messages at the measured delivery rate of TCP,
+// to avoid the bursts which fill the queue of bottleneck and increase the latency.
+class SrsTcpPacer
+{
+private:
+    SrsConnection* conn;
+    bool enabled;
+    // The rate to pace in bytes per second, 0 to disable.
+    uint64_t rate;
+    srs_utime_t sample_at;
+    // The time when all sent bytes are delivered at the rate.
+    srs_utime_t deliver_at;
+public:
+    SrsTcpPacer(SrsConnection* c);
+    virtual ~SrsTcpPacer();
+public:
+    virtual void set_enabled(bool v);
+    // Get the rate to pace in bytes per second.
+    virtual uint64_t get_rate();
+    // When sent bytes, sleep when send faster than the delivery rate.
+    virtual srs_error_t on_sent(int64_t nb_bytes);
+};
+
 #endif
@@ -52,8 +52,6 @@ SrsDvrSegmenter::SrsDvrSegmenter()
     fragment = new SrsFragment();
     fs = new SrsFileWriter();
     jitter_algorithm = SrsRtmpJitterAlgorithmOFF;
-    
-    _srs_config->subscribe(this);
 }
 
 SrsDvrSegmenter::~SrsDvrSegmenter()
@@ -70,6 +68,8 @@ srs_error_t SrsDvrSegmenter::initialize(SrsDvrPlan* p, SrsRequest* r)
     req = r;
     plan = p;
     
+    _srs_config->subscribe(this, req->vhost, SrsReloadVhostDvr);
+    
     jitter_algorithm = (SrsRtmpJitterAlgorithm)_srs_config->get_dvr_time_jitter(req->vhost);
     wait_keyframe = _srs_config->get_dvr_wait_keyframe(req->vhost);
     
@@ -616,6 +616,7 @@ srs_error_t SrsDvrPlan::on_publish()
 {
     srs_error_t err = srs_success;
 
+    async->set_concurrency(_srs_config->get_vhost_hooks_async_workers(req->vhost));
     if ((err = async->start()) != srs_success) {
         return srs_error_wrap(err, "async");
     }
@@ -925,8 +926,6 @@ SrsDvr::SrsDvr()
     plan = NULL;
     req = NULL;
     actived = false;
-    
-    _srs_config->subscribe(this);
 }
 
 SrsDvr::~SrsDvr()
@@ -943,6 +942,8 @@ srs_error_t SrsDvr::initialize(SrsOriginHub* h, SrsRequest* r)
     req = r;
     hub = h;
     
+    _srs_config->subscribe(this, req->vhost, SrsReloadVhostDvrApply);
+    
     SrsConfDirective* conf = _srs_config->get_dvr_apply(r->vhost);
     actived = srs_config_apply_filter(conf, r);
     
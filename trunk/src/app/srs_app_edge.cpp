@@ -53,6 +53,19 @@ using namespace std;
 // when edge error, wait for quit
 #define SRS_EDGE_FORWARDER_TIMEOUT (150 * SRS_UTIME_MILLISECONDS)
 
+SrsLbServerTable* _srs_edge_origins = new SrsLbServerTable();
+
+// Create the load balancer to select origin for the stream of edge.
+ISrsLbBalancer* srs_edge_create_lb(SrsRequest* req)
+{
+    if (_srs_config->get_vhost_edge_origin_lb(req->vhost) == "consistent_hash") {
+        double factor = _srs_config->get_vhost_edge_origin_lb_factor(req->vhost);
+        return new SrsLbConsistentHash(_srs_edge_origins, req->get_stream_url(), factor);
+    }
+    
+    return new SrsLbRoundRobin();
+}
+
 SrsEdgeUpstream::SrsEdgeUpstream()
 {
 }
@@ -72,7 +85,7 @@ SrsEdgeRtmpUpstream::~SrsEdgeRtmpUpstream()
     close();
 }
 
-srs_error_t SrsEdgeRtmpUpstream::connect(SrsRequest* r, SrsLbRoundRobin* lb)
+srs_error_t SrsEdgeRtmpUpstream::connect(SrsRequest* r, ISrsLbBalancer* lb)
 {
     srs_error_t err = srs_success;
     
@@ -122,6 +135,10 @@ srs_error_t SrsEdgeRtmpUpstream::connect(SrsRequest* r, SrsLbRoundRobin* lb)
     sdk = new SrsSimpleRtmpClient(url, cto, sto);
     
     if ((err = sdk->connect()) != srs_success) {
+        // Only feedback the origin selected by balancer, ignore the redirect one.
+        if (redirect.empty()) {
+            lb->on_failure();
+        }
         return srs_error_wrap(err, "edge pull %s failed, cto=%dms, sto=%dms.", url.c_str(), srsu2msi(cto), srsu2msi(sto));
     }
     
@@ -129,6 +146,10 @@ srs_error_t SrsEdgeRtmpUpstream::connect(SrsRequest* r, SrsLbRoundRobin* lb)
         return srs_error_wrap(err, "edge pull %s stream failed", url.c_str());
     }
     
+    if (redirect.empty()) {
+        lb->on_success();
+    }
+    
     return err;
 }
 
@@ -189,6 +210,9 @@ srs_error_t SrsEdgeIngester::initialize(SrsSource* s, SrsPlayEdge* e, SrsRequest
     edge = e;
     req = r;
     
+    srs_freep(lb);
+    lb = srs_edge_create_lb(req);
+    
     return srs_success;
 }
 
@@ -214,6 +238,7 @@ void SrsEdgeIngester::stop()
 {
     trd->stop();
     upstream->close();
+    lb->release();
     
     // notice to unpublish.
     if (source) {
@@ -467,6 +492,9 @@ srs_error_t SrsEdgeForwarder::initialize(SrsSource* s, SrsPublishEdge* e, SrsReq
     edge = e;
     req = r;
     
+    srs_freep(lb);
+    lb = srs_edge_create_lb(req);
+    
     return srs_success;
 }
 
@@ -502,12 +530,14 @@ srs_error_t SrsEdgeForwarder::start()
     sdk = new SrsSimpleRtmpClient(url, cto, sto);
     
     if ((err = sdk->connect()) != srs_success) {
+        lb->on_failure();
         return srs_error_wrap(err, "sdk connect %s failed, cto=%dms, sto=%dms.", url.c_str(), srsu2msi(cto), srsu2msi(sto));
     }
     
     if ((err = sdk->publish(_srs_config->get_chunk_size(req->vhost))) != srs_success) {
         return srs_error_wrap(err, "sdk publish");
     }
+    lb->on_success();
     
     srs_freep(trd);
     trd = new SrsSTCoroutine("edge-fwr", this, _srs_context->get_id());
@@ -525,6 +555,7 @@ void SrsEdgeForwarder::stop()
     trd->stop();
     queue->clear();
     srs_freep(sdk);
+    lb->release();
 }
 
 // when error, edge ingester sleep for a while and retry.
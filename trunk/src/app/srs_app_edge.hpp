@@ -42,11 +42,15 @@ class SrsCommonMessage;
 class SrsMessageQueue;
 class ISrsProtocolReadWriter;
 class SrsKbps;
-class SrsLbRoundRobin;
+class ISrsLbBalancer;
+class SrsLbServerTable;
 class SrsTcpClient;
 class SrsSimpleRtmpClient;
 class SrsPacket;
 
+// The health and load of origin servers, shared by all edge streams.
+extern SrsLbServerTable* _srs_edge_origins;
+
 // The state of edge, auto machine
 enum SrsEdgeState
 {
@@ -75,7 +79,7 @@ public:
     SrsEdgeUpstream();
     virtual ~SrsEdgeUpstream();
 public:
-    virtual srs_error_t connect(SrsRequest* r, SrsLbRoundRobin* lb) = 0;
+    virtual srs_error_t connect(SrsRequest* r, ISrsLbBalancer* lb) = 0;
     virtual srs_error_t recv_message(SrsCommonMessage** pmsg) = 0;
     virtual srs_error_t decode_message(SrsCommonMessage* msg, SrsPacket** ppacket) = 0;
     virtual void close() = 0;
@@ -101,7 +105,7 @@ public:
     SrsEdgeRtmpUpstream(std::string r);
     virtual ~SrsEdgeRtmpUpstream();
 public:
-    virtual srs_error_t connect(SrsRequest* r, SrsLbRoundRobin* lb);
+    virtual srs_error_t connect(SrsRequest* r, ISrsLbBalancer* lb);
     virtual srs_error_t recv_message(SrsCommonMessage** pmsg);
     virtual srs_error_t decode_message(SrsCommonMessage* msg, SrsPacket** ppacket);
     virtual void close();
@@ -119,7 +123,7 @@ private:
     SrsPlayEdge* edge;
     SrsRequest* req;
     SrsCoroutine* trd;
-    SrsLbRoundRobin* lb;
+    ISrsLbBalancer* lb;
     SrsEdgeUpstream* upstream;
 public:
     SrsEdgeIngester();
@@ -148,7 +152,7 @@ private:
     SrsRequest* req;
     SrsCoroutine* trd;
     SrsSimpleRtmpClient* sdk;
-    SrsLbRoundRobin* lb;
+    ISrsLbBalancer* lb;
     // we must ensure one thread one fd principle,
     // that is, a fd must be write/read by the one thread.
     // The publish service thread will proxy(msg), and the edge forward thread
@@ -202,6 +202,7 @@ SrsHlsMuxer::SrsHlsMuxer()
     max_td = 0;
     _sequence_no = 0;
     current = NULL;
+    writer = NULL;
     hls_keys = false;
     hls_fragments_per_key = 0;
     async = new SrsAsyncCallWorker();
@@ -219,6 +220,7 @@ SrsHlsMuxer::~SrsHlsMuxer()
     srs_freep(async);
     srs_freep(context);
     srs_freep(writer);
+    srs_freep(segments);
 }
 
 void SrsHlsMuxer::dispose()
@@ -276,6 +278,7 @@ srs_error_t SrsHlsMuxer::on_publish(SrsRequest* req)
 {
     srs_error_t err = srs_success;
 
+    async->set_concurrency(_srs_config->get_vhost_hooks_async_workers(req->vhost));
     if ((err = async->start()) != srs_success) {
         return srs_error_wrap(err, "async start");
     }
@@ -1148,6 +1151,15 @@ srs_error_t SrsHls::cycle()
     return err;
 }
 
+bool SrsHls::disposing()
+{
+    if (!disposable || !req) {
+        return false;
+    }
+    
+    return _srs_config->get_hls_dispose(req->vhost) > 0;
+}
+
 srs_error_t SrsHls::initialize(SrsOriginHub* h, SrsRequest* r)
 {
     srs_error_t err = srs_success;
@@ -303,6 +303,8 @@ public:
 public:
     virtual void dispose();
     virtual srs_error_t cycle();
+    // Whether the hls files are waiting for hls_dispose to cleanup.
+    virtual bool disposing();
 public:
     // Initialize the hls by handler and source.
     virtual srs_error_t initialize(SrsOriginHub* h, SrsRequest* r);
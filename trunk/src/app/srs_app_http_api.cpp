@@ -46,6 +46,12 @@ using namespace std;
 #include <srs_protocol_amf0.hpp>
 #include <srs_protocol_utility.hpp>
 #include <srs_app_coworkers.hpp>
+#include <srs_app_edge.hpp>
+#include <srs_kernel_balance.hpp>
+#include <srs_app_http_hooks.hpp>
+#include <srs_app_http_client.hpp>
+#include <srs_app_async_call.hpp>
+#include <srs_app_profiler.hpp>
 
 srs_error_t srs_api_response_jsonp(ISrsHttpResponseWriter* w, string callback, string data)
 {
@@ -264,6 +270,9 @@ srs_error_t SrsGoApiV1::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r
     urls->set("clients", SrsJsonAny::str("manage all clients or specified client, default query top 10 clients"));
     urls->set("raw", SrsJsonAny::str("raw api for srs, support CUID srs for instance the config"));
     urls->set("clusters", SrsJsonAny::str("origin cluster server API"));
+    urls->set("origins", SrsJsonAny::str("the load and health of origins selected by edge"));
+    urls->set("hooks", SrsJsonAny::str("the connections, queues and cache of http hooks"));
+    urls->set("profiles", SrsJsonAny::str("sample the cpu for seconds at frequency, response folded stacks for flame graph"));
     
     SrsJsonObject* tests = SrsJsonAny::object();
     obj->set("tests", tests);
@@ -838,6 +847,11 @@ srs_error_t SrsGoApiClients::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessa
             return srs_api_response_code(w, r, ERROR_RTMP_CLIENT_NOT_FOUND);
         }
         
+        // The client without connection, for example, the ingest puller, is not able to kickoff.
+        if (!client->conn) {
+            return srs_api_response_code(w, r, ERROR_RTMP_CLIENT_NOT_FOUND);
+        }
+        
         client->conn->expire();
         srs_warn("kickoff client id=%d ok", cid);
     } else {
@@ -1288,6 +1302,150 @@ srs_error_t SrsGoApiClusters::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
     return srs_api_response(w, r, obj->dumps());
 }
 
+SrsGoApiOrigins::SrsGoApiOrigins()
+{
+}
+
+SrsGoApiOrigins::~SrsGoApiOrigins()
+{
+}
+
+srs_error_t SrsGoApiOrigins::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    SrsStatistic* stat = SrsStatistic::instance();
+    
+    SrsJsonObject* obj = SrsJsonAny::object();
+    SrsAutoFree(SrsJsonObject, obj);
+    
+    obj->set("code", SrsJsonAny::integer(ERROR_SUCCESS));
+    obj->set("server", SrsJsonAny::integer(stat->server_id()));
+    
+    SrsJsonArray* data = SrsJsonAny::array();
+    obj->set("origins", data);
+    
+    srs_utime_t now = srs_get_system_time();
+    vector<SrsLbServer*> servers = _srs_edge_origins->list();
+    for (int i = 0; i < (int)servers.size(); i++) {
+        SrsLbServer* s = servers.at(i);
+        
+        SrsJsonObject* origin = SrsJsonAny::object();
+        data->append(origin);
+        
+        origin->set("server", SrsJsonAny::str(s->server.c_str()));
+        origin->set("healthy", SrsJsonAny::boolean(s->healthy(now)));
+        origin->set("load", SrsJsonAny::integer(s->load));
+        origin->set("failures", SrsJsonAny::integer(s->failures));
+        origin->set("selected", SrsJsonAny::integer(s->nn_selected));
+        origin->set("total_failures", SrsJsonAny::integer(s->nn_failures));
+        origin->set("ejected", SrsJsonAny::integer(s->nn_ejected));
+    }
+    
+    return srs_api_response(w, r, obj->dumps());
+}
+
+SrsGoApiHooks::SrsGoApiHooks()
+{
+}
+
+SrsGoApiHooks::~SrsGoApiHooks()
+{
+}
+
+srs_error_t SrsGoApiHooks::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    SrsStatistic* stat = SrsStatistic::instance();
+    
+    SrsJsonObject* obj = SrsJsonAny::object();
+    SrsAutoFree(SrsJsonObject, obj);
+    
+    obj->set("code", SrsJsonAny::integer(ERROR_SUCCESS));
+    obj->set("server", SrsJsonAny::integer(stat->server_id()));
+    
+    SrsJsonObject* data = SrsJsonAny::object();
+    obj->set("hooks", data);
+    
+    data->set("requests", SrsJsonAny::integer(_srs_hooks_stat->nn_requests));
+    data->set("errors", SrsJsonAny::integer(_srs_hooks_stat->nn_errors));
+    data->set("retries", SrsJsonAny::integer(_srs_hooks_stat->nn_retries));
+    
+    SrsJsonObject* pool = SrsJsonAny::object();
+    data->set("pool", pool);
+    
+    pool->set("created", SrsJsonAny::integer(_srs_hooks_pool->nn_created));
+    pool->set("reused", SrsJsonAny::integer(_srs_hooks_pool->nn_reused));
+    pool->set("idle", SrsJsonAny::integer(_srs_hooks_pool->nn_idle()));
+    
+    SrsJsonObject* async = SrsJsonAny::object();
+    data->set("async", async);
+    
+    async->set("queued", SrsJsonAny::integer(_srs_async_stat->nn_queued));
+    async->set("running", SrsJsonAny::integer(_srs_async_stat->nn_running));
+    async->set("max_queued", SrsJsonAny::integer(_srs_async_stat->max_queued));
+    async->set("executed", SrsJsonAny::integer(_srs_async_stat->nn_executed));
+    async->set("failed", SrsJsonAny::integer(_srs_async_stat->nn_failed));
+    
+    SrsJsonObject* cache = SrsJsonAny::object();
+    data->set("on_play_cache", cache);
+    
+    cache->set("hits", SrsJsonAny::integer(_srs_hooks_stat->nn_cache_hits));
+    cache->set("size", SrsJsonAny::integer(_srs_hooks_cache->size()));
+    
+    return srs_api_response(w, r, obj->dumps());
+}
+
+SrsGoApiProfiles::SrsGoApiProfiles()
+{
+}
+
+SrsGoApiProfiles::~SrsGoApiProfiles()
+{
+}
+
+srs_error_t SrsGoApiProfiles::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    srs_error_t err = srs_success;
+    
+    if (!_srs_config->get_http_api_profiler()) {
+        return srs_api_response_code(w, r, ERROR_SYSTEM_PROFILER_DISABLED);
+    }
+    
+    // @param seconds the duration to sample, default to 10s.
+    // @param frequency the samples per second of cpu time, default to 99Hz, to avoid lockstep with timers.
+    int seconds = 10;
+    if (!r->query_get("seconds").empty()) {
+        seconds = ::atoi(r->query_get("seconds").c_str());
+    }
+    
+    int frequency = 99;
+    if (!r->query_get("frequency").empty()) {
+        frequency = ::atoi(r->query_get("frequency").c_str());
+    }
+    
+    if ((err = _srs_cpu_profiler->start(frequency, seconds)) != srs_success) {
+        return srs_api_response_code(w, r, srs_error_wrap(err, "start profiler"));
+    }
+    srs_trace("profiler start, frequency=%dHz, seconds=%d", frequency, seconds);
+    
+    // Other coroutines are running and sampled, while we are sleeping.
+    srs_usleep(seconds * SRS_UTIME_SECONDS);
+    _srs_cpu_profiler->stop();
+    
+    string folded;
+    _srs_cpu_profiler->dumps(folded);
+    srs_trace("profiler done, samples=%d, dropped=%d, folded=%dB",
+        _srs_cpu_profiler->nn_samples(), _srs_cpu_profiler->nn_dropped(), (int)folded.length());
+    
+    SrsHttpHeader* h = w->header();
+    h->set_content_length(folded.length());
+    h->set_content_type("text/plain; charset=utf-8");
+    
+    if ((err = w->write((char*)folded.data(), (int)folded.length())) != srs_success) {
+        return srs_error_wrap(err, "write folded");
+    }
+    
+    return err;
+}
+
 SrsGoApiError::SrsGoApiError()
 {
 }
@@ -201,6 +201,33 @@ public:
     virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
 };
 
+class SrsGoApiOrigins : public ISrsHttpHandler
+{
+public:
+    SrsGoApiOrigins();
+    virtual ~SrsGoApiOrigins();
+public:
+    virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+};
+
+class SrsGoApiHooks : public ISrsHttpHandler
+{
+public:
+    SrsGoApiHooks();
+    virtual ~SrsGoApiHooks();
+public:
+    virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+};
+
+class SrsGoApiProfiles : public ISrsHttpHandler
+{
+public:
+    SrsGoApiProfiles();
+    virtual ~SrsGoApiProfiles();
+public:
+    virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+};
+
 class SrsGoApiError : public ISrsHttpHandler
 {
 public:
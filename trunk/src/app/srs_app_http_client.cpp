@@ -23,3 +23,111 @@
 
 #include <srs_app_http_client.hpp>
 
+
+#include <srs_kernel_utility.hpp>
+#include <srs_kernel_error.hpp>
+
+using namespace std;
+
+SrsHttpIdleClient::SrsHttpIdleClient(SrsHttpClient* c, srs_utime_t e)
+{
+    client = c;
+    expired = e;
+}
+
+SrsHttpIdleClient::~SrsHttpIdleClient()
+{
+    srs_freep(client);
+}
+
+SrsHttpClientPool::SrsHttpClientPool(int idle, srs_utime_t timeout)
+{
+    max_idle = idle;
+    idle_timeout = timeout;
+    
+    nn_created = 0;
+    nn_reused = 0;
+}
+
+SrsHttpClientPool::~SrsHttpClientPool()
+{
+    map<string, vector<SrsHttpIdleClient*> >::iterator it;
+    for (it = clients.begin(); it != clients.end(); ++it) {
+        vector<SrsHttpIdleClient*>& arr = it->second;
+        for (int i = 0; i < (int)arr.size(); i++) {
+            SrsHttpIdleClient* ic = arr.at(i);
+            srs_freep(ic);
+        }
+    }
+    clients.clear();
+}
+
+srs_error_t SrsHttpClientPool::fetch(string host, int port, srs_utime_t tm, SrsHttpClient** pclient, bool* preused)
+{
+    srs_error_t err = srs_success;
+    
+    srs_utime_t now = srs_get_system_time();
+    vector<SrsHttpIdleClient*>& arr = clients[key_of(host, port, tm)];
+    
+    // Use the most recently used client, which is less likely closed by upstream.
+    while (!arr.empty()) {
+        SrsHttpIdleClient* ic = arr.back();
+        arr.pop_back();
+        
+        // Drop the client expired, or closed by upstream when idle.
+        if (ic->expired < now || ic->client->is_stale()) {
+            srs_freep(ic);
+            continue;
+        }
+        
+        *pclient = ic->client;
+        *preused = true;
+        
+        ic->client = NULL;
+        srs_freep(ic);
+        
+        nn_reused++;
+        return err;
+    }
+    
+    SrsHttpClient* client = new SrsHttpClient();
+    if ((err = client->initialize(host, port, tm)) != srs_success) {
+        srs_freep(client);
+        return srs_error_wrap(err, "init client %s:%d", host.c_str(), port);
+    }
+    
+    *pclient = client;
+    *preused = false;
+    
+    nn_created++;
+    return err;
+}
+
+void SrsHttpClientPool::giveback(string host, int port, srs_utime_t tm, SrsHttpClient* client, bool reusable)
+{
+    vector<SrsHttpIdleClient*>& arr = clients[key_of(host, port, tm)];
+    
+    if (!reusable || (int)arr.size() >= max_idle) {
+        srs_freep(client);
+        return;
+    }
+    
+    arr.push_back(new SrsHttpIdleClient(client, srs_get_system_time() + idle_timeout));
+}
+
+int SrsHttpClientPool::nn_idle()
+{
+    int nn = 0;
+    
+    map<string, vector<SrsHttpIdleClient*> >::iterator it;
+    for (it = clients.begin(); it != clients.end(); ++it) {
+        nn += (int)it->second.size();
+    }
+    
+    return nn;
+}
+
+string SrsHttpClientPool::key_of(string host, int port, srs_utime_t tm)
+{
+    return host + ":" + srs_int2str(port) + "/" + srs_int2str(srsu2ms(tm));
+}
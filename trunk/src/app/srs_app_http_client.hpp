@@ -26,7 +26,54 @@
 
 #include <srs_core.hpp>
 
+#include <string>
+#include <vector>
+#include <map>
+
 #include <srs_service_http_client.hpp>
 
+// The idle client in pool, with the time to expire.
+class SrsHttpIdleClient
+{
+public:
+    SrsHttpClient* client;
+    srs_utime_t expired;
+public:
+    SrsHttpIdleClient(SrsHttpClient* c, srs_utime_t e);
+    virtual ~SrsHttpIdleClient();
+};
+
+// The pool of keep-alive HTTP clients, indexed by the upstream host:port,
+// to reuse the TCP connection for requests to the same upstream, for example, http hooks.
+// @remark The fetched client is exclusively owned by user, until giveback to pool.
+class SrsHttpClientPool
+{
+private:
+    // The max idle clients for each upstream.
+    int max_idle;
+    // The duration to keep the idle client.
+    srs_utime_t idle_timeout;
+    std::map<std::string, std::vector<SrsHttpIdleClient*> > clients;
+public:
+    // The number of new and reused clients.
+    uint64_t nn_created;
+    uint64_t nn_reused;
+public:
+    SrsHttpClientPool(int idle, srs_utime_t timeout);
+    virtual ~SrsHttpClientPool();
+public:
+    // Fetch a client for upstream host:port with timeout tm, reuse the idle one if possible.
+    // @param preused Output whether the client is reused, user may retry by a new one when failed.
+    // @remark User must giveback the client.
+    virtual srs_error_t fetch(std::string host, int port, srs_utime_t tm, SrsHttpClient** pclient, bool* preused);
+    // Giveback the client to pool, which is freed if not reusable or pool is full.
+    // @param reusable Whether the client is keep-alive, and the response is consumed.
+    virtual void giveback(std::string host, int port, srs_utime_t tm, SrsHttpClient* client, bool reusable);
+    // Get the number of idle clients of all upstreams.
+    virtual int nn_idle();
+private:
+    virtual std::string key_of(std::string host, int port, srs_utime_t tm);
+};
+
 #endif
 
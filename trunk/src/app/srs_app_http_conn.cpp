@@ -74,7 +74,7 @@ SrsHttpConn::~SrsHttpConn()
 
 void SrsHttpConn::remark(int64_t* in, int64_t* out)
 {
-    // TODO: FIXME: implements it
+    kbps->remark(in, out);
 }
 
 srs_error_t SrsHttpConn::do_cycle()
@@ -233,12 +233,8 @@ srs_error_t SrsResponseOnlyHttpConn::on_got_http_message(ISrsHttpMessage* msg)
     
     ISrsHttpResponseReader* br = msg->body_reader();
 
-    // when not specified the content length, ignore.
-    if (msg->content_length() == -1) {
-        return err;
-    }
-
-    // drop all request body.
+    // drop all request body, the chunked body included, or it's parsed as the next request of keep-alive,
+    // while the reader is eof at once when no content length and not chunked.
     char body[4096];
     while (!br->eof()) {
         if ((err = br->read(body, 4096, NULL)) != srs_success) {
@@ -313,3 +309,8 @@ void SrsHttpServer::http_unmount(SrsSource* s, SrsRequest* r)
     http_stream->http_unmount(s, r);
 }
 
+void SrsHttpServer::http_destroy(SrsSource* s, SrsRequest* r)
+{
+    http_stream->http_destroy(s, r);
+}
+
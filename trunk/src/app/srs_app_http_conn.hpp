@@ -124,6 +124,7 @@ public:
 public:
     virtual srs_error_t http_mount(SrsSource* s, SrsRequest* r);
     virtual void http_unmount(SrsSource* s, SrsRequest* r);
+    virtual void http_destroy(SrsSource* s, SrsRequest* r);
 };
 
 #endif
@@ -48,6 +48,81 @@ using namespace std;
 // the timeout for hls notify, in srs_utime_t.
 #define SRS_HLS_NOTIFY_TIMEOUT (10 * SRS_UTIME_SECONDS)
 
+// The max idle connections for each hook server.
+#define SRS_HTTP_HOOKS_MAX_IDLE 32
+// The duration to keep the idle connection to hook server.
+#define SRS_HTTP_HOOKS_IDLE_TIMEOUT (30 * SRS_UTIME_SECONDS)
+// The max entries of on_play cache.
+#define SRS_HTTP_HOOKS_CACHE_MAX 100000
+
+SrsHttpHooksStat::SrsHttpHooksStat()
+{
+    nn_requests = 0;
+    nn_errors = 0;
+    nn_retries = 0;
+    nn_cache_hits = 0;
+}
+
+SrsHttpHooksStat::~SrsHttpHooksStat()
+{
+}
+
+SrsHttpHooksCache::SrsHttpHooksCache(int max)
+{
+    max_entries = max;
+}
+
+SrsHttpHooksCache::~SrsHttpHooksCache()
+{
+}
+
+bool SrsHttpHooksCache::hit(string key)
+{
+    map<string, srs_utime_t>::iterator it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+    
+    if (it->second < srs_get_system_time()) {
+        entries.erase(it);
+        return false;
+    }
+    
+    return true;
+}
+
+void SrsHttpHooksCache::update(string key, srs_utime_t ttl)
+{
+    srs_utime_t now = srs_get_system_time();
+    
+    // Remove the expired entries when full, or clear all if still full.
+    if ((int)entries.size() >= max_entries) {
+        map<string, srs_utime_t>::iterator it;
+        for (it = entries.begin(); it != entries.end();) {
+            if (it->second < now) {
+                entries.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+        
+        if ((int)entries.size() >= max_entries) {
+            entries.clear();
+        }
+    }
+    
+    entries[key] = now + ttl;
+}
+
+int SrsHttpHooksCache::size()
+{
+    return (int)entries.size();
+}
+
+SrsHttpHooksStat* _srs_hooks_stat = new SrsHttpHooksStat();
+SrsHttpHooksCache* _srs_hooks_cache = new SrsHttpHooksCache(SRS_HTTP_HOOKS_CACHE_MAX);
+SrsHttpClientPool* _srs_hooks_pool = new SrsHttpClientPool(SRS_HTTP_HOOKS_MAX_IDLE, SRS_HTTP_HOOKS_IDLE_TIMEOUT);
+
 SrsHttpHooks::SrsHttpHooks()
 {
 }
@@ -77,8 +152,8 @@ srs_error_t SrsHttpHooks::on_connect(string url, SrsRequest* req)
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         return srs_error_wrap(err, "http: on_connect failed, client_id=%d, url=%s, request=%s, response=%s, code=%d",
             client_id, url.c_str(), data.c_str(), res.c_str(), status_code);
     }
@@ -110,8 +185,8 @@ void SrsHttpHooks::on_close(string url, SrsRequest* req, int64_t send_bytes, int
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         int ret = srs_error_code(err);
         srs_freep(err);
         srs_warn("http: ignore on_close failed, client_id=%d, url=%s, request=%s, response=%s, code=%d, ret=%d",
@@ -147,8 +222,8 @@ srs_error_t SrsHttpHooks::on_publish(string url, SrsRequest* req)
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         return srs_error_wrap(err, "http: on_publish failed, client_id=%d, url=%s, request=%s, response=%s, code=%d",
             client_id, url.c_str(), data.c_str(), res.c_str(), status_code);
     }
@@ -180,8 +255,8 @@ void SrsHttpHooks::on_unpublish(string url, SrsRequest* req)
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         int ret = srs_error_code(err);
         srs_freep(err);
         srs_warn("http: ignore on_unpublish failed, client_id=%d, url=%s, request=%s, response=%s, status=%d, ret=%d",
@@ -213,16 +288,29 @@ srs_error_t SrsHttpHooks::on_play(string url, SrsRequest* req)
     obj->set("param", SrsJsonAny::str(req->param.c_str()));
     obj->set("pageUrl", SrsJsonAny::str(req->pageUrl.c_str()));
     
+    // The allowed client to play the same stream, ignore the client_id which changes for each connection.
+    srs_utime_t ttl = _srs_config->get_vhost_hooks_on_play_cache(req->vhost);
+    string key = url + " " + req->ip + " " + req->get_stream_url() + req->param + " " + req->pageUrl;
+    if (ttl > 0 && _srs_hooks_cache->hit(key)) {
+        _srs_hooks_stat->nn_cache_hits++;
+        srs_trace("http: on_play ok by cache, client_id=%d, url=%s, key=%s", client_id, url.c_str(), key.c_str());
+        return err;
+    }
+    
     std::string data = obj->dumps();
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         return srs_error_wrap(err, "http: on_play failed, client_id=%d, url=%s, request=%s, response=%s, status=%d",
             client_id, url.c_str(), data.c_str(), res.c_str(), status_code);
     }
     
+    if (ttl > 0) {
+        _srs_hooks_cache->update(key, ttl);
+    }
+    
     srs_trace("http: on_play ok, client_id=%d, url=%s, request=%s, response=%s",
         client_id, url.c_str(), data.c_str(), res.c_str());
     
@@ -250,8 +338,8 @@ void SrsHttpHooks::on_stop(string url, SrsRequest* req)
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         int ret = srs_error_code(err);
         srs_freep(err);
         srs_warn("http: ignore on_stop failed, client_id=%d, url=%s, request=%s, response=%s, code=%d, ret=%d",
@@ -289,8 +377,8 @@ srs_error_t SrsHttpHooks::on_dvr(int cid, string url, SrsRequest* req, string fi
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         return srs_error_wrap(err, "http post on_dvr uri failed, client_id=%d, url=%s, request=%s, response=%s, code=%d",
             client_id, url.c_str(), data.c_str(), res.c_str(), status_code);
     }
@@ -336,8 +424,8 @@ srs_error_t SrsHttpHooks::on_hls(int cid, string url, SrsRequest* req, string fi
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, data, status_code, res)) != srs_success) {
+    srs_utime_t tm = _srs_config->get_vhost_hooks_timeout(req->vhost);
+    if ((err = do_post(url, data, tm, status_code, res)) != srs_success) {
         return srs_error_wrap(err, "http: post %s with %s, status=%d, res=%s", url.c_str(), data.c_str(), status_code, res.c_str());
     }
     
@@ -370,8 +458,9 @@ srs_error_t SrsHttpHooks::on_hls_notify(int cid, std::string url, SrsRequest* re
         return srs_error_wrap(err, "http: init url=%s", url.c_str());
     }
     
-    SrsHttpClient http;
-    if ((err = http.initialize(uri.get_host(), uri.get_port(), SRS_HLS_NOTIFY_TIMEOUT)) != srs_success) {
+    bool reused = false;
+    SrsHttpClient* http = NULL;
+    if ((err = _srs_hooks_pool->fetch(uri.get_host(), uri.get_port(), SRS_HLS_NOTIFY_TIMEOUT, &http, &reused)) != srs_success) {
         return srs_error_wrap(err, "http: init client for %s", url.c_str());
     }
     
@@ -385,8 +474,12 @@ srs_error_t SrsHttpHooks::on_hls_notify(int cid, std::string url, SrsRequest* re
     }
     srs_info("GET %s", path.c_str());
     
+    _srs_hooks_stat->nn_requests++;
+    
     ISrsHttpMessage* msg = NULL;
-    if ((err = http.get(path.c_str(), "", &msg)) != srs_success) {
+    if ((err = http->get(path.c_str(), "", &msg)) != srs_success) {
+        _srs_hooks_stat->nn_errors++;
+        _srs_hooks_pool->giveback(uri.get_host(), uri.get_port(), SRS_HLS_NOTIFY_TIMEOUT, http, false);
         return srs_error_wrap(err, "http: get %s", url.c_str());
     }
     SrsAutoFree(ISrsHttpMessage, msg);
@@ -405,6 +498,10 @@ srs_error_t SrsHttpHooks::on_hls_notify(int cid, std::string url, SrsRequest* re
         nb_read += (int)nb_bytes;
     }
     
+    // Reuse the connection only when the response is consumed.
+    bool reusable = (err == srs_success && br->eof() && msg->is_keep_alive());
+    _srs_hooks_pool->giveback(uri.get_host(), uri.get_port(), SRS_HLS_NOTIFY_TIMEOUT, http, reusable);
+    
     int spenttime = (int)(srsu2ms(srs_update_system_time()) - starttime);
     srs_trace("http hook on_hls_notify success. client_id=%d, url=%s, code=%d, spent=%dms, read=%dB, err=%s",
         client_id, url.c_str(), msg->status_code(), spenttime, nb_read, srs_error_desc(err).c_str());
@@ -421,8 +518,7 @@ srs_error_t SrsHttpHooks::discover_co_workers(string url, string& host, int& por
     std::string res;
     int status_code;
     
-    SrsHttpClient http;
-    if ((err = do_post(&http, url, "", status_code, res)) != srs_success) {
+    if ((err = do_post(url, "", SRS_HTTP_CLIENT_TIMEOUT, status_code, res)) != srs_success) {
         return srs_error_wrap(err, "http: post %s, status=%d, res=%s", url.c_str(), status_code, res.c_str());
     }
     
@@ -469,7 +565,7 @@ srs_error_t SrsHttpHooks::discover_co_workers(string url, string& host, int& por
     return err;
 }
 
-srs_error_t SrsHttpHooks::do_post(SrsHttpClient* hc, std::string url, std::string req, int& code, string& res)
+srs_error_t SrsHttpHooks::do_post(std::string url, std::string req, srs_utime_t tm, int& code, string& res)
 {
     srs_error_t err = srs_success;
     
@@ -478,23 +574,47 @@ srs_error_t SrsHttpHooks::do_post(SrsHttpClient* hc, std::string url, std::strin
         return srs_error_wrap(err, "http: post failed. url=%s", url.c_str());
     }
     
-    if ((err = hc->initialize(uri.get_host(), uri.get_port())) != srs_success) {
-        return srs_error_wrap(err, "http: init client");
-    }
-    
     string path = uri.get_path();
     if (!uri.get_query().empty()) {
         path += "?" + uri.get_query();
     }
     
+    _srs_hooks_stat->nn_requests++;
+    
+    bool reused = false;
+    SrsHttpClient* hc = NULL;
     ISrsHttpMessage* msg = NULL;
-    if ((err = hc->post(path, req, &msg)) != srs_success) {
-        return srs_error_wrap(err, "http: client post");
+    for (int retry = 0; ; retry++) {
+        if ((err = _srs_hooks_pool->fetch(uri.get_host(), uri.get_port(), tm, &hc, &reused)) != srs_success) {
+            return srs_error_wrap(err, "http: init client");
+        }
+        
+        if ((err = hc->post(path, req, &msg)) == srs_success) {
+            break;
+        }
+        _srs_hooks_pool->giveback(uri.get_host(), uri.get_port(), tm, hc, false);
+        
+        // The hooks such as on_connect and on_publish are not idempotent, so we only retry once when the
+        // reused keep-alive connection fails to write the request, which means the server has reset it
+        // and never got the request. The idle connection closed by server is dropped by the pool.
+        if (retry > 0 || !reused || srs_error_code(err) != ERROR_SOCKET_WRITE) {
+            _srs_hooks_stat->nn_errors++;
+            return srs_error_wrap(err, "http: client post");
+        }
+        
+        srs_freep(err);
+        _srs_hooks_stat->nn_retries++;
     }
-    SrsAutoFree(ISrsHttpMessage, msg);
     
     code = msg->status_code();
-    if ((err = msg->body_read_all(res)) != srs_success) {
+    err = msg->body_read_all(res);
+    
+    // Keep the connection alive for the next hook, when the response is consumed.
+    bool reusable = (err == srs_success && msg->is_keep_alive());
+    srs_freep(msg);
+    _srs_hooks_pool->giveback(uri.get_host(), uri.get_port(), tm, hc, reusable);
+    
+    if (err != srs_success) {
         return srs_error_wrap(err, "http: body read");
     }
     
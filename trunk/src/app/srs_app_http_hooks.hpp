@@ -27,12 +27,54 @@
 #include <srs_core.hpp>
 
 #include <string>
+#include <map>
 
 class SrsHttpUri;
 class SrsStSocket;
 class SrsRequest;
 class SrsHttpParser;
 class SrsHttpClient;
+class SrsHttpClientPool;
+
+// The statistic of http hooks, for http api.
+class SrsHttpHooksStat
+{
+public:
+    // The total number of hook requests.
+    uint64_t nn_requests;
+    // The number of requests failed for network error.
+    uint64_t nn_errors;
+    // The number of requests retried, when the idle keep-alive connection is closed.
+    uint64_t nn_retries;
+    // The number of on_play allowed by cache.
+    uint64_t nn_cache_hits;
+public:
+    SrsHttpHooksStat();
+    virtual ~SrsHttpHooksStat();
+};
+
+// The cache for allowed on_play hooks, to avoid calling hook server when client replays.
+class SrsHttpHooksCache
+{
+private:
+    // The key to expired time.
+    std::map<std::string, srs_utime_t> entries;
+    int max_entries;
+public:
+    SrsHttpHooksCache(int max);
+    virtual ~SrsHttpHooksCache();
+public:
+    // Whether the key is in cache and not expired.
+    virtual bool hit(std::string key);
+    // Update the key, expire after ttl.
+    virtual void update(std::string key, srs_utime_t ttl);
+    virtual int size();
+};
+
+extern SrsHttpHooksStat* _srs_hooks_stat;
+extern SrsHttpHooksCache* _srs_hooks_cache;
+// The keep-alive connections to hook servers, shared by all hooks.
+extern SrsHttpClientPool* _srs_hooks_pool;
 
 // the http hooks, http callback api,
 // for some event, such as on_connect, call
@@ -97,7 +139,8 @@ public:
     // Discover co-workers for origin cluster.
     static srs_error_t discover_co_workers(std::string url, std::string& host, int& port);
 private:
-    static srs_error_t do_post(SrsHttpClient* hc, std::string url, std::string req, int& code, std::string& res);
+    // Post req to url with timeout tm, over the keep-alive connection in pool.
+    static srs_error_t do_post(std::string url, std::string req, srs_utime_t tm, int& code, std::string& res);
 };
 
 #endif
@@ -55,6 +55,7 @@ using namespace std;
 #include <srs_app_statistic.hpp>
 #include <srs_app_recv_thread.hpp>
 #include <srs_app_http_hooks.hpp>
+#include <srs_app_abr.hpp>
 
 SrsBufferCache::SrsBufferCache(SrsSource* s, SrsRequest* r)
 {
@@ -318,31 +319,32 @@ srs_error_t SrsFlvStreamEncoder::write_tags(SrsSharedPtrMessage** msgs, int coun
 {
     srs_error_t err = srs_success;
 
-    // For https://github.com/ossrs/srs/issues/939
+    if ((err = write_header(msgs, count))  != srs_success) {
+        return srs_error_wrap(err, "write header");
+    }
+
+    // Drop data if no A+V.
     if (!header_written) {
-        bool has_video = false;
-        bool has_audio = false;
-
-        for (int i = 0; i < count && (!has_video || !has_audio); i++) {
-            SrsSharedPtrMessage* msg = msgs[i];
-            if (msg->is_video()) {
-                has_video = true;
-            } else if (msg->is_audio()) {
-                has_audio = true;
-            }
-        }
+        return err;
+    }
 
-        // Drop data if no A+V.
-        if (!has_video && !has_audio) {
-            return err;
-        }
+    return enc->write_tags(msgs, count);
+}
 
-        if ((err = write_header(has_video, has_audio))  != srs_success) {
-            return srs_error_wrap(err, "write header");
-        }
+srs_error_t SrsFlvStreamEncoder::write_encoded_tags(SrsSharedPtrMessage** msgs, int count)
+{
+    srs_error_t err = srs_success;
+
+    if ((err = write_header(msgs, count))  != srs_success) {
+        return srs_error_wrap(err, "write header");
     }
 
-    return enc->write_tags(msgs, count);
+    // Drop data if no A+V.
+    if (!header_written) {
+        return err;
+    }
+
+    return enc->write_encoded_tags(msgs, count);
 }
 
 srs_error_t SrsFlvStreamEncoder::write_header(bool has_video, bool has_audio)
@@ -362,6 +364,35 @@ srs_error_t SrsFlvStreamEncoder::write_header(bool has_video, bool has_audio)
     return err;
 }
 
+srs_error_t SrsFlvStreamEncoder::write_header(SrsSharedPtrMessage** msgs, int count)
+{
+    srs_error_t err = srs_success;
+
+    // For https://github.com/ossrs/srs/issues/939
+    if (header_written) {
+        return err;
+    }
+
+    bool has_video = false;
+    bool has_audio = false;
+
+    for (int i = 0; i < count && (!has_video || !has_audio); i++) {
+        SrsSharedPtrMessage* msg = msgs[i];
+        if (msg->is_video()) {
+            has_video = true;
+        } else if (msg->is_audio()) {
+            has_audio = true;
+        }
+    }
+
+    // Ignore if no A+V.
+    if (!has_video && !has_audio) {
+        return err;
+    }
+
+    return write_header(has_video, has_audio);
+}
+
 SrsAacStreamEncoder::SrsAacStreamEncoder()
 {
     enc = new SrsAacTransmuxer();
@@ -537,6 +568,9 @@ srs_error_t SrsLiveStream::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage
 {
     srs_error_t err = srs_success;
     
+    // Never retire the source when serving it.
+    SrsSourceRef source_ref(source);
+    
     if ((err = http_hooks_on_play(r)) != srs_success) {
         return srs_error_wrap(err, "http hook");
     }
@@ -580,14 +614,6 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
     // Enter chunked mode, because we didn't set the content-length.
     w->write_header(SRS_CONSTS_HTTP_OK);
     
-    // create consumer of souce, ignore gop cache, use the audio gop cache.
-    SrsConsumer* consumer = NULL;
-    if ((err = source->create_consumer(NULL, consumer, true, true, !enc->has_cache())) != srs_success) {
-        return srs_error_wrap(err, "create consumer");
-    }
-    SrsAutoFree(SrsConsumer, consumer);
-    srs_verbose("http: consumer created success.");
-    
     SrsPithyPrint* pprint = SrsPithyPrint::create_http_stream();
     SrsAutoFree(SrsPithyPrint, pprint);
     
@@ -610,6 +636,37 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
         return srs_error_wrap(err, "init encoder");
     }
     
+    SrsFlvStreamEncoder* ffe = dynamic_cast<SrsFlvStreamEncoder*>(enc);
+    
+    // create consumer of souce, ignore gop cache, use the audio gop cache.
+    // For FLV, the caches are pre-encoded by source, to send in a burst.
+    SrsConsumer* consumer = NULL;
+    std::vector<SrsSharedPtrMessage*> burst;
+    if (ffe) {
+        err = source->create_consumer(NULL, consumer, SrsBurstFormatFlv, 0, 0, burst);
+    } else {
+        err = source->create_consumer(NULL, consumer, true, true, !enc->has_cache());
+    }
+    if (err != srs_success) {
+        return srs_error_wrap(err, "create consumer");
+    }
+    SrsAutoFree(SrsConsumer, consumer);
+    srs_verbose("http: consumer created success.");
+    
+    if (!burst.empty()) {
+        err = ffe->write_encoded_tags(&burst[0], (int)burst.size());
+        
+        // free the messages.
+        for (int i = 0; i < (int)burst.size(); i++) {
+            SrsSharedPtrMessage* msg = burst[i];
+            srs_freep(msg);
+        }
+        
+        if (err != srs_success) {
+            return srs_error_wrap(err, "send burst");
+        }
+    }
+    
     // if gop cache enabled for encoder, dump to consumer.
     if (enc->has_cache()) {
         if ((err = enc->dump_cache(consumer, source->jitter())) != srs_success) {
@@ -617,8 +674,6 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
         }
     }
     
-    SrsFlvStreamEncoder* ffe = dynamic_cast<SrsFlvStreamEncoder*>(enc);
-    
     // Set the socket options for transport.
     bool tcp_nodelay = _srs_config->get_tcp_nodelay(req->vhost);
     if (tcp_nodelay) {
@@ -631,7 +686,23 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
     if ((err = hc->set_socket_buffer(mw_sleep)) != srs_success) {
         return srs_error_wrap(err, "set mw_sleep %" PRId64, mw_sleep);
     }
-
+    
+    // Limit the unsent bytes in kernel, and pace the messages at the delivery rate.
+    int notsent_lowat = _srs_config->get_notsent_lowat(req->vhost);
+    if (notsent_lowat > 0 && (err = hc->set_notsent_lowat(notsent_lowat)) != srs_success) {
+        return srs_error_wrap(err, "set notsent lowat");
+    }
+    SrsTcpPacer pacer(hc);
+    pacer.set_enabled(_srs_config->get_pacing(req->vhost));
+    // Trace the latency of messages, when traced by publisher.
+    SrsLatencyTracer tracer(_srs_context->get_id());
+
+    // Switch the consumer between the renditions of stream, for ABR.
+    SrsAbrSwitcher abr(hc);
+    if ((err = abr.initialize(req, source, consumer)) != srs_success) {
+        return srs_error_wrap(err, "init abr");
+    }
+    
     SrsHttpRecvThread* trd = new SrsHttpRecvThread(hc);
     SrsAutoFree(SrsHttpRecvThread, trd);
     
@@ -652,6 +723,15 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
         }
 
         pprint->elapse();
+        
+        // Switch the rendition by the depth of queue and throughput.
+        if ((err = abr.cycle()) != srs_success) {
+            return srs_error_wrap(err, "abr");
+        }
+        
+        // Drop the video frames by the occupancy of socket send buffer.
+        SrsFrameDropper* dropper = consumer->get_dropper();
+        dropper->set_occupancy(hc->get_send_occupancy());
 
         // get messages from consumer.
         // each msg in msgs.msgs must be free, for the SrsMessageArray never free them.
@@ -668,20 +748,31 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
         }
         
         if (pprint->can_print()) {
-            srs_trace("-> " SRS_CONSTS_LOG_HTTP_STREAM " http: got %d msgs, age=%d, min=%d, mw=%d",
-                count, pprint->age(), SRS_PERF_MW_MIN_MSGS, srsu2msi(mw_sleep));
+            srs_trace("-> " SRS_CONSTS_LOG_HTTP_STREAM " http: got %d msgs, age=%d, min=%d, mw=%d, drop=%d,%d,%d",
+                count, pprint->age(), SRS_PERF_MW_MIN_MSGS, srsu2msi(mw_sleep),
+                (int)dropper->nn_bframes, (int)dropper->nn_nonrefs, (int)dropper->nn_gop_frames);
+            
+            if ((err = dropper->report(req)) != srs_success) {
+                return srs_error_wrap(err, "report drop");
+            }
         }
         
         // sendout all messages.
+        tracer.on_dump(msgs.msgs, count);
         if (ffe) {
             err = ffe->write_tags(msgs.msgs, count);
         } else {
             err = streaming_send_messages(enc, msgs.msgs, count);
         }
+        if (err == srs_success) {
+            tracer.on_sent();
+        }
 
         // free the messages.
+        int64_t nb_bytes = 0;
         for (int i = 0; i < count; i++) {
             SrsSharedPtrMessage* msg = msgs.msgs[i];
+            nb_bytes += msg->size;
             srs_freep(msg);
         }
         
@@ -689,6 +780,10 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
         if (err != srs_success) {
             return srs_error_wrap(err, "send messages");
         }
+        
+        if ((err = pacer.on_sent(nb_bytes)) != srs_success) {
+            return srs_error_wrap(err, "pacing");
+        }
     }
 
     // Here, the entry is disabled by encoder un-publishing or reloading,
@@ -963,6 +1058,39 @@ void SrsHttpStreamServer::http_unmount(SrsSource* s, SrsRequest* r)
     entry->stream->entry->enabled = false;
 }
 
+void SrsHttpStreamServer::http_destroy(SrsSource* s, SrsRequest* r)
+{
+    std::string sid = r->get_stream_url();
+    
+    std::map<std::string, SrsLiveEntry*>::iterator it = sflvs.find(sid);
+    if (it == sflvs.end()) {
+        return;
+    }
+    
+    // Remove the entry before free it, because stop the cache coroutine
+    // might switch to other coroutines, which might mount the stream again.
+    SrsLiveEntry* entry = it->second;
+    sflvs.erase(it);
+    
+    // The template should never refer to the retired source.
+    if (tflvs.find(r->vhost) != tflvs.end()) {
+        SrsLiveEntry* tmpl = tflvs[r->vhost];
+        if (tmpl->source == s) {
+            tmpl->source = NULL;
+        }
+    }
+    
+    // The mux owns and frees the stream handler, and the source never retires when
+    // serving by any http connection, so it's safe to free the stream.
+    mux.unhandle(entry->mount, entry->stream);
+    entry->stream = NULL;
+    
+    srs_freep(entry->cache);
+    srs_freep(entry);
+    
+    srs_trace("http: unmount flv stream for sid=%s, total=%d", sid.c_str(), (int)sflvs.size());
+}
+
 srs_error_t SrsHttpStreamServer::on_reload_vhost_added(string vhost)
 {
     srs_error_t err = srs_success;
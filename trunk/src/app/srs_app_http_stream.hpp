@@ -99,8 +99,11 @@ public:
 public:
     // Write the tags in a time.
     virtual srs_error_t write_tags(SrsSharedPtrMessage** msgs, int count);
+    // Write the tags pre-encoded by source, for example, the burst of gop cache.
+    virtual srs_error_t write_encoded_tags(SrsSharedPtrMessage** msgs, int count);
 private:
     virtual srs_error_t write_header(bool has_video = true, bool has_audio = true);
+    virtual srs_error_t write_header(SrsSharedPtrMessage** msgs, int count);
 };
 
 // Transmux RTMP to HTTP TS Streaming.
@@ -250,6 +253,8 @@ public:
     // HTTP flv/ts/mp3/aac stream
     virtual srs_error_t http_mount(SrsSource* s, SrsRequest* r);
     virtual void http_unmount(SrsSource* s, SrsRequest* r);
+    // Remove the stream from mux and free it, when source is retired.
+    virtual void http_destroy(SrsSource* s, SrsRequest* r);
 // Interface ISrsReloadHandler.
 public:
     virtual srs_error_t on_reload_vhost_added(std::string vhost);
@@ -34,6 +34,17 @@ using namespace std;
 #include <srs_kernel_utility.hpp>
 #include <srs_app_utility.hpp>
 #include <srs_protocol_utility.hpp>
+#include <srs_rtmp_stack.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_app_ingest_pull.hpp>
+
+ISrsIngesterWorker::ISrsIngesterWorker()
+{
+}
+
+ISrsIngesterWorker::~ISrsIngesterWorker()
+{
+}
 
 SrsIngesterFFMPEG::SrsIngesterFFMPEG()
 {
@@ -102,10 +113,79 @@ void SrsIngesterFFMPEG::fast_kill()
     ffmpeg->fast_kill();
 }
 
-SrsIngester::SrsIngester()
+SrsIngesterPuller::SrsIngesterPuller()
+{
+    puller = NULL;
+}
+
+SrsIngesterPuller::~SrsIngesterPuller()
+{
+    srs_freep(puller);
+}
+
+srs_error_t SrsIngesterPuller::initialize(SrsIngestPuller* p, string v, string i)
+{
+    srs_error_t err = srs_success;
+    
+    puller = p;
+    vhost = v;
+    id = i;
+    starttime = srs_get_system_time();
+    
+    return err;
+}
+
+string SrsIngesterPuller::uri()
+{
+    return vhost + "/" + id;
+}
+
+srs_utime_t SrsIngesterPuller::alive()
+{
+    return srs_get_system_time() - starttime;
+}
+
+bool SrsIngesterPuller::equals(string v)
+{
+    return vhost == v;
+}
+
+bool SrsIngesterPuller::equals(string v, string i)
+{
+    return vhost == v && id == i;
+}
+
+srs_error_t SrsIngesterPuller::start()
+{
+    return puller->start();
+}
+
+void SrsIngesterPuller::stop()
+{
+    puller->stop();
+}
+
+srs_error_t SrsIngesterPuller::cycle()
+{
+    // The puller retry in its coroutine, never fail.
+    return srs_success;
+}
+
+void SrsIngesterPuller::fast_stop()
+{
+    // Stop the puller to unpublish the stream, which is fast for no process.
+    puller->stop();
+}
+
+void SrsIngesterPuller::fast_kill()
+{
+}
+
+SrsIngester::SrsIngester(ISrsSourceHandler* h)
 {
     _srs_config->subscribe(this);
     
+    handler = h;
     expired = false;
     disposed = false;
     
@@ -168,9 +248,9 @@ void SrsIngester::stop()
 
 void SrsIngester::fast_stop()
 {
-    std::vector<SrsIngesterFFMPEG*>::iterator it;
+    std::vector<ISrsIngesterWorker*>::iterator it;
     for (it = ingesters.begin(); it != ingesters.end(); ++it) {
-        SrsIngesterFFMPEG* ingester = *it;
+        ISrsIngesterWorker* ingester = *it;
         ingester->fast_stop();
     }
     
@@ -181,9 +261,9 @@ void SrsIngester::fast_stop()
 
 void SrsIngester::fast_kill()
 {
-    std::vector<SrsIngesterFFMPEG*>::iterator it;
+    std::vector<ISrsIngesterWorker*>::iterator it;
     for (it = ingesters.begin(); it != ingesters.end(); ++it) {
-        SrsIngesterFFMPEG* ingester = *it;
+        ISrsIngesterWorker* ingester = *it;
         ingester->fast_kill();
     }
 
@@ -237,9 +317,9 @@ srs_error_t SrsIngester::do_cycle()
     }
     
     // cycle exists ingesters.
-    std::vector<SrsIngesterFFMPEG*>::iterator it;
+    std::vector<ISrsIngesterWorker*>::iterator it;
     for (it = ingesters.begin(); it != ingesters.end(); ++it) {
-        SrsIngesterFFMPEG* ingester = *it;
+        ISrsIngesterWorker* ingester = *it;
         
         // start all ffmpegs.
         if ((err = ingester->start()) != srs_success) {
@@ -260,10 +340,10 @@ srs_error_t SrsIngester::do_cycle()
 
 void SrsIngester::clear_engines()
 {
-    std::vector<SrsIngesterFFMPEG*>::iterator it;
+    std::vector<ISrsIngesterWorker*>::iterator it;
     
     for (it = ingesters.begin(); it != ingesters.end(); ++it) {
-        SrsIngesterFFMPEG* ingester = *it;
+        ISrsIngesterWorker* ingester = *it;
         srs_freep(ingester);
     }
     
@@ -318,6 +398,12 @@ srs_error_t SrsIngester::parse_engines(SrsConfDirective* vhost, SrsConfDirective
         return err;
     }
     
+    // For hls/flv, pull by builtin puller without ffmpeg.
+    std::string input_type = _srs_config->get_ingest_input_type(ingest);
+    if (srs_config_ingest_is_hls(input_type) || srs_config_ingest_is_flv(input_type)) {
+        return parse_pullers(vhost, ingest);
+    }
+    
     std::string ffmpeg_bin = _srs_config->get_ingest_ffmpeg(ingest);
     if (ffmpeg_bin.empty()) {
         return srs_error_new(ERROR_ENCODER_PARSE, "parse ffmpeg");
@@ -365,7 +451,69 @@ srs_error_t SrsIngester::parse_engines(SrsConfDirective* vhost, SrsConfDirective
     return err;
 }
 
-srs_error_t SrsIngester::initialize_ffmpeg(SrsFFMPEG* ffmpeg, SrsConfDirective* vhost, SrsConfDirective* ingest, SrsConfDirective* engine)
+srs_error_t SrsIngester::parse_pullers(SrsConfDirective* vhost, SrsConfDirective* ingest)
+{
+    srs_error_t err = srs_success;
+    
+    std::string input_type = _srs_config->get_ingest_input_type(ingest);
+    std::string input_url = _srs_config->get_ingest_input_url(ingest);
+    if (input_url.empty()) {
+        return srs_error_new(ERROR_ENCODER_NO_INPUT, "empty intput url, ingest=%s", ingest->arg0().c_str());
+    }
+    
+    // The engine specifies the output stream, which is required.
+    std::vector<SrsConfDirective*> engines = _srs_config->get_transcode_engines(ingest);
+    if (engines.empty()) {
+        return srs_error_new(ERROR_ENCODER_NO_OUTPUT, "no engine for output, ingest=%s", ingest->arg0().c_str());
+    }
+    
+    for (int i = 0; i < (int)engines.size(); i++) {
+        SrsConfDirective* engine = engines[i];
+        std::string output;
+        if ((err = parse_output(vhost, ingest, engine, output)) != srs_success) {
+            return srs_error_wrap(err, "parse output");
+        }
+        
+        // Publish to the stream of output in current vhost.
+        SrsRequest* req = new SrsRequest();
+        SrsAutoFree(SrsRequest, req);
+        
+        std::string vhost2;
+        srs_parse_rtmp_url(output, req->tcUrl, req->stream);
+        srs_discovery_tc_url(req->tcUrl, req->schema, req->host, vhost2, req->app, req->stream, req->port, req->param);
+        req->vhost = vhost->arg0();
+        req->strip();
+        
+        // The ingest is published by server itself, as the ffmpeg over RTMP from localhost.
+        req->ip = "127.0.0.1";
+        
+        SrsIngestPuller* puller = NULL;
+        if (srs_config_ingest_is_hls(input_type)) {
+            puller = new SrsHlsPuller(handler, _srs_config->get_ingest_input_prefetch(ingest));
+        } else {
+            puller = new SrsFlvPuller(handler);
+        }
+        
+        if ((err = puller->initialize(input_url, req)) != srs_success) {
+            srs_freep(puller);
+            return srs_error_wrap(err, "init puller");
+        }
+        
+        SrsIngesterPuller* ingester = new SrsIngesterPuller();
+        if ((err = ingester->initialize(puller, vhost->arg0(), ingest->arg0())) != srs_success) {
+            srs_freep(ingester);
+            return srs_error_wrap(err, "init ingester");
+        }
+        
+        ingesters.push_back(ingester);
+        srs_trace("parse success, ingest=%s, vhost=%s, %s %s to %s", ingest->arg0().c_str(), vhost->arg0().c_str(),
+            input_type.c_str(), input_url.c_str(), req->get_stream_url().c_str());
+    }
+    
+    return err;
+}
+
+srs_error_t SrsIngester::parse_output(SrsConfDirective* vhost, SrsConfDirective* ingest, SrsConfDirective* engine, string& output)
 {
     srs_error_t err = srs_success;
     
@@ -379,7 +527,7 @@ srs_error_t SrsIngester::initialize_ffmpeg(SrsFFMPEG* ffmpeg, SrsConfDirective*
         srs_parse_endpoint(ep, ip, port);
     }
     
-    std::string output = _srs_config->get_engine_output(engine);
+    output = _srs_config->get_engine_output(engine);
     // output stream, to other/self server
     // ie. rtmp://localhost:1935/live/livestream_sd
     output = srs_string_replace(output, "[vhost]", vhost->arg0());
@@ -389,6 +537,18 @@ srs_error_t SrsIngester::initialize_ffmpeg(SrsFFMPEG* ffmpeg, SrsConfDirective*
         return srs_error_new(ERROR_ENCODER_NO_OUTPUT, "empty output url, ingest=%s", ingest->arg0().c_str());
     }
     
+    return err;
+}
+
+srs_error_t SrsIngester::initialize_ffmpeg(SrsFFMPEG* ffmpeg, SrsConfDirective* vhost, SrsConfDirective* ingest, SrsConfDirective* engine)
+{
+    srs_error_t err = srs_success;
+    
+    std::string output;
+    if ((err = parse_output(vhost, ingest, engine, output)) != srs_success) {
+        return srs_error_wrap(err, "parse output");
+    }
+    
     // find the app and stream in rtmp url
     std::string app, stream;
     if (true) {
@@ -485,7 +645,7 @@ void SrsIngester::show_ingest_log_message()
     
     // random choose one ingester to report.
     int index = rand() % (int)ingesters.size();
-    SrsIngesterFFMPEG* ingester = ingesters.at(index);
+    ISrsIngesterWorker* ingester = ingesters.at(index);
     
     // reportable
     if (pprint->can_print()) {
@@ -498,10 +658,10 @@ srs_error_t SrsIngester::on_reload_vhost_removed(string vhost)
 {
     srs_error_t err = srs_success;
     
-    std::vector<SrsIngesterFFMPEG*>::iterator it;
+    std::vector<ISrsIngesterWorker*>::iterator it;
     
     for (it = ingesters.begin(); it != ingesters.end();) {
-        SrsIngesterFFMPEG* ingester = *it;
+        ISrsIngesterWorker* ingester = *it;
         
         if (!ingester->equals(vhost)) {
             ++it;
@@ -540,10 +700,10 @@ srs_error_t SrsIngester::on_reload_ingest_removed(string vhost, string ingest_id
 {
     srs_error_t err = srs_success;
     
-    std::vector<SrsIngesterFFMPEG*>::iterator it;
+    std::vector<ISrsIngesterWorker*>::iterator it;
     
     for (it = ingesters.begin(); it != ingesters.end();) {
-        SrsIngesterFFMPEG* ingester = *it;
+        ISrsIngesterWorker* ingester = *it;
         
         if (!ingester->equals(vhost, ingest_id)) {
             ++it;
@@ -34,9 +34,32 @@
 class SrsFFMPEG;
 class SrsConfDirective;
 class SrsPithyPrint;
+class ISrsSourceHandler;
+class SrsIngestPuller;
+
+// The worker of ingester, the ffmpeg process or the builtin puller.
+class ISrsIngesterWorker
+{
+public:
+    ISrsIngesterWorker();
+    virtual ~ISrsIngesterWorker();
+public:
+    // The ingest uri, [vhost]/[ingest id]
+    virtual std::string uri() = 0;
+    // The alive in srs_utime_t.
+    virtual srs_utime_t alive() = 0;
+    virtual bool equals(std::string v, std::string i) = 0;
+    virtual bool equals(std::string v) = 0;
+public:
+    virtual srs_error_t start() = 0;
+    virtual void stop() = 0;
+    virtual srs_error_t cycle() = 0;
+    virtual void fast_stop() = 0;
+    virtual void fast_kill() = 0;
+};
 
 // Ingester ffmpeg object.
-class SrsIngesterFFMPEG
+class SrsIngesterFFMPEG : public ISrsIngesterWorker
 {
 private:
     std::string vhost;
@@ -63,13 +86,41 @@ public:
     virtual void fast_kill();
 };
 
+// Ingester builtin puller, for hls or http-flv input, deliver to source without ffmpeg.
+class SrsIngesterPuller : public ISrsIngesterWorker
+{
+private:
+    std::string vhost;
+    std::string id;
+    SrsIngestPuller* puller;
+    srs_utime_t starttime;
+public:
+    SrsIngesterPuller();
+    virtual ~SrsIngesterPuller();
+public:
+    virtual srs_error_t initialize(SrsIngestPuller* p, std::string v, std::string i);
+    virtual std::string uri();
+    virtual srs_utime_t alive();
+    virtual bool equals(std::string v, std::string i);
+    virtual bool equals(std::string v);
+public:
+    virtual srs_error_t start();
+    virtual void stop();
+    virtual srs_error_t cycle();
+    virtual void fast_stop();
+    virtual void fast_kill();
+};
+
 // Ingest file/stream/device,
 // encode with FFMPEG(optional),
 // push to SRS(or any RTMP server) over RTMP.
+// Ingest hls/flv by builtin puller, deliver to source directly.
 class SrsIngester : public ISrsCoroutineHandler, public ISrsReloadHandler
 {
 private:
-    std::vector<SrsIngesterFFMPEG*> ingesters;
+    std::vector<ISrsIngesterWorker*> ingesters;
+    // The handler for source of builtin puller.
+    ISrsSourceHandler* handler;
 private:
     SrsCoroutine* trd;
     SrsPithyPrint* pprint;
@@ -79,7 +130,7 @@ private:
     // Whether already disposed.
     bool disposed;
 public:
-    SrsIngester();
+    SrsIngester(ISrsSourceHandler* h);
     virtual ~SrsIngester();
 public:
     virtual void dispose();
@@ -101,6 +152,8 @@ private:
     virtual srs_error_t parse();
     virtual srs_error_t parse_ingesters(SrsConfDirective* vhost);
     virtual srs_error_t parse_engines(SrsConfDirective* vhost, SrsConfDirective* ingest);
+    virtual srs_error_t parse_pullers(SrsConfDirective* vhost, SrsConfDirective* ingest);
+    virtual srs_error_t parse_output(SrsConfDirective* vhost, SrsConfDirective* ingest, SrsConfDirective* engine, std::string& output);
     virtual srs_error_t initialize_ffmpeg(SrsFFMPEG* ffmpeg, SrsConfDirective* vhost, SrsConfDirective* ingest, SrsConfDirective* engine);
     virtual void show_ingest_log_message();
 // Interface ISrsReloadHandler.
@@ -0,0 +1,1225 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <srs_app_ingest_pull.hpp>
+
+#include <stdlib.h>
+using namespace std;
+
+#include <srs_kernel_error.hpp>
+#include <srs_kernel_log.hpp>
+#include <srs_kernel_buffer.hpp>
+#include <srs_kernel_stream.hpp>
+#include <srs_kernel_codec.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_raw_avc.hpp>
+#include <srs_rtmp_stack.hpp>
+#include <srs_protocol_utility.hpp>
+#include <srs_service_utility.hpp>
+#include <srs_http_stack.hpp>
+#include <srs_app_source.hpp>
+#include <srs_app_pithy_print.hpp>
+#include <srs_app_http_client.hpp>
+#include <srs_app_caster_flv.hpp>
+#include <srs_app_config.hpp>
+#include <srs_app_security.hpp>
+#include <srs_app_http_hooks.hpp>
+#include <srs_app_statistic.hpp>
+
+// The stream id of messages delivered to source, as RTMP publisher.
+#define SRS_INGEST_PULL_SID 1
+
+// When error, puller sleep for a while and retry.
+#define SRS_INGEST_PULL_CIMS (3 * SRS_UTIME_SECONDS)
+
+// The timeout to fetch the m3u8, segments and flv from upstream.
+#define SRS_INGEST_PULL_TIMEOUT (10 * SRS_UTIME_SECONDS)
+
+// The duration to keep the idle connections to upstream.
+#define SRS_HLS_PULL_IDLE_TIMEOUT (30 * SRS_UTIME_SECONDS)
+
+SrsIngestPublisher::SrsIngestPublisher(ISrsSourceHandler* h)
+{
+    req = NULL;
+    handler = h;
+    source = NULL;
+    edge = false;
+    cid = 0;
+    security = new SrsSecurity();
+    
+    avc = new SrsRawH264Stream();
+    aac = new SrsRawAacStream();
+    h264_sps_pps_sent = false;
+}
+
+SrsIngestPublisher::~SrsIngestPublisher()
+{
+    unpublish();
+    
+    srs_freep(avc);
+    srs_freep(aac);
+    srs_freep(req);
+    srs_freep(security);
+}
+
+srs_error_t SrsIngestPublisher::initialize(SrsRequest* r)
+{
+    srs_freep(req);
+    req = r->copy();
+    
+    return srs_success;
+}
+
+string SrsIngestPublisher::url()
+{
+    return req? req->get_stream_url() : "";
+}
+
+srs_error_t SrsIngestPublisher::publish()
+{
+    srs_error_t err = srs_success;
+    
+    if ((err = security->check(SrsRtmpConnFMLEPublish, req->ip, req)) != srs_success) {
+        return srs_error_wrap(err, "security check");
+    }
+    
+    if ((err = http_hooks_on_publish()) != srs_success) {
+        return srs_error_wrap(err, "callback on publish");
+    }
+    
+    // There is no context switch until published, so the source never retires.
+    if ((err = acquire_publish()) != srs_success) {
+        http_hooks_on_unpublish();
+        return srs_error_wrap(err, "acquire publish");
+    }
+    
+    // The sequence headers must be delivered again for the new publish.
+    h264_sps = h264_pps = "";
+    h264_sps_pps_sent = false;
+    aac_specific_config = "";
+    
+    srs_trace("ingest: publish %s, edge=%d", req->get_stream_url().c_str(), edge);
+    
+    return err;
+}
+
+void SrsIngestPublisher::unpublish()
+{
+    if (!source) {
+        return;
+    }
+    
+    release_publish();
+    http_hooks_on_unpublish();
+    
+    srs_trace("ingest: unpublish %s", req->get_stream_url().c_str());
+}
+
+srs_error_t SrsIngestPublisher::on_flv_tag(char type, uint32_t timestamp, char* data, int size)
+{
+    srs_error_t err = srs_success;
+    
+    srs_assert(source);
+    
+    SrsCommonMessage* msg = NULL;
+    if ((err = srs_rtmp_create_msg(type, timestamp, data, size, SRS_INGEST_PULL_SID, &msg)) != srs_success) {
+        return srs_error_wrap(err, "create message");
+    }
+    SrsAutoFree(SrsCommonMessage, msg);
+    
+    // Update the stat for video fps.
+    if (msg->header.is_video()) {
+        SrsStatistic* stat = SrsStatistic::instance();
+        if ((err = stat->on_video_frames(req, 1)) != srs_success) {
+            return srs_error_wrap(err, "stat video frames");
+        }
+    }
+    
+    // for edge, directly proxy message to origin.
+    if (edge) {
+        if ((err = source->on_edge_proxy_publish(msg)) != srs_success) {
+            return srs_error_wrap(err, "proxy publish");
+        }
+        return err;
+    }
+    
+    if (msg->header.is_audio()) {
+        if ((err = source->on_audio(msg)) != srs_success) {
+            return srs_error_wrap(err, "consume audio");
+        }
+        return err;
+    }
+    
+    if (msg->header.is_video()) {
+        if ((err = source->on_video(msg)) != srs_success) {
+            return srs_error_wrap(err, "consume video");
+        }
+        return err;
+    }
+    
+    if (msg->header.is_amf0_data()) {
+        SrsOnMetaDataPacket metadata;
+        SrsBuffer stream(msg->payload, msg->size);
+        if ((err = metadata.decode(&stream)) != srs_success) {
+            return srs_error_wrap(err, "decode metadata");
+        }
+        
+        if ((err = source->on_meta_data(msg, &metadata)) != srs_success) {
+            return srs_error_wrap(err, "consume metadata");
+        }
+    }
+    
+    return err;
+}
+
+srs_error_t SrsIngestPublisher::acquire_publish()
+{
+    srs_error_t err = srs_success;
+    
+    SrsSource* s = NULL;
+    if ((err = _srs_sources->fetch_or_create(req, handler, &s)) != srs_success) {
+        return srs_error_wrap(err, "create source");
+    }
+    
+    edge = _srs_config->get_vhost_is_edge(req->vhost);
+    if (!s->can_publish(edge)) {
+        return srs_error_new(ERROR_SYSTEM_STREAM_BUSY, "stream %s is busy", req->get_stream_url().c_str());
+    }
+    
+    // when edge, ignore the publish event, directly proxy it.
+    source = s;
+    if (edge) {
+        err = s->on_edge_start_publish();
+    } else {
+        err = s->on_publish();
+    }
+    
+    // The publish state might change even failed, so we must cleanup it.
+    if (err != srs_success) {
+        release_publish();
+        return srs_error_wrap(err, "source publish");
+    }
+    
+    // There is no connection to kickoff or sample kbps for the client.
+    cid = _srs_context->get_id();
+    SrsStatistic* stat = SrsStatistic::instance();
+    if ((err = stat->on_client(cid, req, NULL, SrsRtmpConnFMLEPublish)) != srs_success) {
+        release_publish();
+        return srs_error_wrap(err, "stat client");
+    }
+    
+    return err;
+}
+
+void SrsIngestPublisher::release_publish()
+{
+    // when edge, notice edge to change state.
+    // when origin, notice all service to unpublish.
+    if (edge) {
+        source->on_edge_proxy_unpublish();
+    } else {
+        source->on_unpublish();
+    }
+    source = NULL;
+    
+    SrsStatistic::instance()->on_disconnect(cid);
+}
+
+srs_error_t SrsIngestPublisher::http_hooks_on_publish()
+{
+    srs_error_t err = srs_success;
+    
+    if (!_srs_config->get_vhost_http_hooks_enabled(req->vhost)) {
+        return err;
+    }
+    
+    // the http hooks will cause context switch,
+    // so we must copy all hooks for the on_connect may freed.
+    // @see https://github.com/ossrs/srs/issues/475
+    vector<string> hooks;
+    
+    if (true) {
+        SrsConfDirective* conf = _srs_config->get_vhost_on_publish(req->vhost);
+        
+        if (!conf) {
+            return err;
+        }
+        
+        hooks = conf->args;
+    }
+    
+    for (int i = 0; i < (int)hooks.size(); i++) {
+        std::string url = hooks.at(i);
+        if ((err = SrsHttpHooks::on_publish(url, req)) != srs_success) {
+            return srs_error_wrap(err, "on_publish %s", url.c_str());
+        }
+    }
+    
+    return err;
+}
+
+void SrsIngestPublisher::http_hooks_on_unpublish()
+{
+    if (!_srs_config->get_vhost_http_hooks_enabled(req->vhost)) {
+        return;
+    }
+    
+    // the http hooks will cause context switch,
+    // so we must copy all hooks for the on_connect may freed.
+    // @see https://github.com/ossrs/srs/issues/475
+    vector<string> hooks;
+    
+    if (true) {
+        SrsConfDirective* conf = _srs_config->get_vhost_on_unpublish(req->vhost);
+        
+        if (!conf) {
+            return;
+        }
+        
+        hooks = conf->args;
+    }
+    
+    for (int i = 0; i < (int)hooks.size(); i++) {
+        std::string url = hooks.at(i);
+        SrsHttpHooks::on_unpublish(url, req);
+    }
+}
+
+srs_error_t SrsIngestPublisher::on_ts_message(SrsTsMessage* msg)
+{
+    srs_error_t err = srs_success;
+    
+    // When the audio SID is private stream 1, we use common audio.
+    // @see https://github.com/ossrs/srs/issues/740
+    if (msg->channel->apply == SrsTsPidApplyAudio && msg->sid == SrsTsPESStreamIdPrivateStream1) {
+        msg->sid = SrsTsPESStreamIdAudioCommon;
+    }
+    
+    // when not audio/video, or not adts/annexb format, donot support.
+    if (msg->stream_number() != 0) {
+        return srs_error_new(ERROR_STREAM_CASTER_TS_ES, "ts: unsupported stream format, sid=%#x(%s-%d)",
+            msg->sid, msg->is_audio()? "A":msg->is_video()? "V":"N", msg->stream_number());
+    }
+    
+    // parse the stream.
+    SrsBuffer avs(msg->payload->bytes(), msg->payload->length());
+    
+    if (msg->channel->stream == SrsTsStreamVideoH264) {
+        if ((err = on_ts_video(msg, &avs)) != srs_success) {
+            return srs_error_wrap(err, "ts: consume video");
+        }
+    } else if (msg->channel->stream == SrsTsStreamAudioAAC) {
+        if ((err = on_ts_audio(msg, &avs)) != srs_success) {
+            return srs_error_wrap(err, "ts: consume audio");
+        }
+    } else {
+        return srs_error_new(ERROR_STREAM_CASTER_TS_CODEC, "ts: unsupported stream codec=%d", msg->channel->stream);
+    }
+    
+    return err;
+}
+
+srs_error_t SrsIngestPublisher::on_ts_video(SrsTsMessage* msg, SrsBuffer* avs)
+{
+    srs_error_t err = srs_success;
+    
+    // ts tbn to flv tbn.
+    uint32_t dts = (uint32_t)(msg->dts / 90);
+    uint32_t pts = (uint32_t)(msg->pts / 90);
+    
+    // All ibp frames of a ts message are delivered as a flv message.
+    std::string ibps;
+    SrsVideoAvcFrameType frame_type = SrsVideoAvcFrameTypeInterFrame;
+    
+    SrsAnnexbNalu nalus[SRS_AVC_MAX_NALUS];
+    while (!avs->empty()) {
+        int nb_nalus = 0;
+        if ((err = avc->annexb_split(avs, nalus, SRS_AVC_MAX_NALUS, &nb_nalus)) != srs_success) {
+            return srs_error_wrap(err, "split annexb");
+        }
+        
+        for (int i = 0; i < nb_nalus; i++) {
+            char* frame = nalus[i].bytes;
+            int frame_size = nalus[i].size;
+            
+            if (frame_size <= 0) {
+                continue;
+            }
+            
+            // 5bits, 7.3.1 NAL unit syntax,
+            // ISO_IEC_14496-10-AVC-2003.pdf, page 44.
+            //  7: SPS, 8: PPS, 5: I Frame, 1: P Frame
+            SrsAvcNaluType nal_unit_type = (SrsAvcNaluType)(frame[0] & 0x1f);
+            
+            if (nal_unit_type == SrsAvcNaluTypeAccessUnitDelimiter) {
+                continue;
+            }
+            
+            if (avc->is_sps(frame, frame_size)) {
+                std::string sps;
+                if ((err = avc->sps_demux(frame, frame_size, sps)) != srs_success) {
+                    return srs_error_wrap(err, "demux sps");
+                }
+                
+                if (h264_sps != sps) {
+                    h264_sps = sps;
+                    h264_sps_pps_sent = false;
+                }
+                continue;
+            }
+            
+            if (avc->is_pps(frame, frame_size)) {
+                std::string pps;
+                if ((err = avc->pps_demux(frame, frame_size, pps)) != srs_success) {
+                    return srs_error_wrap(err, "demux pps");
+                }
+                
+                if (h264_pps != pps) {
+                    h264_pps = pps;
+                    h264_sps_pps_sent = false;
+                }
+                continue;
+            }
+            
+            if (nal_unit_type == SrsAvcNaluTypeIDR) {
+                frame_type = SrsVideoAvcFrameTypeKeyFrame;
+            }
+            
+            std::string ibp;
+            if ((err = avc->mux_ipb_frame(frame, frame_size, ibp)) != srs_success) {
+                return srs_error_wrap(err, "mux frame");
+            }
+            ibps.append(ibp);
+        }
+    }
+    
+    // Update the sequence header when sps or pps changed.
+    if ((err = write_h264_sps_pps(dts, pts)) != srs_success) {
+        return srs_error_wrap(err, "write sps/pps");
+    }
+    
+    // Drop the frames before sps/pps, which is not decodable.
+    // @see https://github.com/ossrs/srs/issues/203
+    if (ibps.empty() || !h264_sps_pps_sent) {
+        return err;
+    }
+    
+    char* flv = NULL;
+    int nb_flv = 0;
+    if ((err = avc->mux_avc2flv(ibps, frame_type, SrsVideoAvcFrameTraitNALU, dts, pts, &flv, &nb_flv)) != srs_success) {
+        return srs_error_wrap(err, "mux avc to flv");
+    }
+    
+    // the timestamp in rtmp message header is dts.
+    return on_flv_tag(SrsFrameTypeVideo, dts, flv, nb_flv);
+}
+
+srs_error_t SrsIngestPublisher::write_h264_sps_pps(uint32_t dts, uint32_t pts)
+{
+    srs_error_t err = srs_success;
+    
+    if (h264_sps_pps_sent || h264_sps.empty() || h264_pps.empty()) {
+        return err;
+    }
+    
+    // h264 raw to h264 packet.
+    std::string sh;
+    if ((err = avc->mux_sequence_header(h264_sps, h264_pps, dts, pts, sh)) != srs_success) {
+        return srs_error_wrap(err, "mux sequence header");
+    }
+    
+    // h264 packet to flv packet.
+    char* flv = NULL;
+    int nb_flv = 0;
+    if ((err = avc->mux_avc2flv(sh, SrsVideoAvcFrameTypeKeyFrame, SrsVideoAvcFrameTraitSequenceHeader, dts, pts, &flv, &nb_flv)) != srs_success) {
+        return srs_error_wrap(err, "avc to flv");
+    }
+    
+    if ((err = on_flv_tag(SrsFrameTypeVideo, dts, flv, nb_flv)) != srs_success) {
+        return srs_error_wrap(err, "write packet");
+    }
+    h264_sps_pps_sent = true;
+    
+    return err;
+}
+
+srs_error_t SrsIngestPublisher::on_ts_audio(SrsTsMessage* msg, SrsBuffer* avs)
+{
+    srs_error_t err = srs_success;
+    
+    // ts tbn to flv tbn.
+    uint32_t dts = (uint32_t)(msg->dts / 90);
+    
+    // The aac frames in a PES share the dts, each frame is 1024 samples.
+    for (int nb_frames = 0; !avs->empty(); nb_frames++) {
+        char* frame = NULL;
+        int frame_size = 0;
+        SrsRawAacStreamCodec codec;
+        if ((err = aac->adts_demux(avs, &frame, &frame_size, codec)) != srs_success) {
+            return srs_error_wrap(err, "demux adts");
+        }
+        
+        // ignore invalid frame,
+        //  * atleast 1bytes for aac to decode the data.
+        if (frame_size <= 0) {
+            continue;
+        }
+        
+        uint32_t frame_dts = dts;
+        int srate = srs_aac_srates[codec.sampling_frequency_index & 0x0f];
+        if (srate > 0) {
+            frame_dts += (uint32_t)(nb_frames * 1024 * 1000 / srate);
+        }
+        
+        // generate sh.
+        if (aac_specific_config.empty()) {
+            std::string sh;
+            if ((err = aac->mux_sequence_header(&codec, sh)) != srs_success) {
+                return srs_error_wrap(err, "mux sequence header");
+            }
+            aac_specific_config = sh;
+            
+            codec.aac_packet_type = 0;
+            
+            if ((err = write_audio_raw_frame((char*)sh.data(), (int)sh.length(), &codec, frame_dts)) != srs_success) {
+                return srs_error_wrap(err, "write raw audio frame");
+            }
+        }
+        
+        // audio raw data.
+        codec.aac_packet_type = 1;
+        if ((err = write_audio_raw_frame(frame, frame_size, &codec, frame_dts)) != srs_success) {
+            return srs_error_wrap(err, "write audio raw frame");
+        }
+    }
+    
+    return err;
+}
+
+srs_error_t SrsIngestPublisher::write_audio_raw_frame(char* frame, int frame_size, SrsRawAacStreamCodec* codec, uint32_t dts)
+{
+    srs_error_t err = srs_success;
+    
+    char* data = NULL;
+    int size = 0;
+    if ((err = aac->mux_aac2flv(frame, frame_size, codec, dts, &data, &size)) != srs_success) {
+        return srs_error_wrap(err, "mux aac to flv");
+    }
+    
+    return on_flv_tag(SrsFrameTypeAudio, dts, data, size);
+}
+
+SrsIngestPuller::SrsIngestPuller(ISrsSourceHandler* h)
+{
+    publisher = new SrsIngestPublisher(h);
+    pprint = SrsPithyPrint::create_ingester();
+    trd = NULL;
+}
+
+SrsIngestPuller::~SrsIngestPuller()
+{
+    srs_freep(trd);
+    srs_freep(publisher);
+    srs_freep(pprint);
+}
+
+srs_error_t SrsIngestPuller::initialize(string u, SrsRequest* r)
+{
+    srs_error_t err = srs_success;
+    
+    input = u;
+    
+    if ((err = publisher->initialize(r)) != srs_success) {
+        return srs_error_wrap(err, "init publisher");
+    }
+    
+    return err;
+}
+
+srs_error_t SrsIngestPuller::start()
+{
+    srs_error_t err = srs_success;
+    
+    if (trd) {
+        return err;
+    }
+    
+    // Each puller has its own id, which is the client id of the publisher for statistic.
+    trd = new SrsSTCoroutine("ingest-pull", this);
+    if ((err = trd->start()) != srs_success) {
+        return srs_error_wrap(err, "start coroutine");
+    }
+    
+    return err;
+}
+
+void SrsIngestPuller::stop()
+{
+    srs_freep(trd);
+}
+
+srs_error_t SrsIngestPuller::cycle()
+{
+    srs_error_t err = srs_success;
+    
+    while (true) {
+        if ((err = trd->pull()) != srs_success) {
+            return srs_error_wrap(err, "ingest puller");
+        }
+        
+        if ((err = pull()) != srs_success) {
+            srs_warn("Ingester: Ignore error, input=%s, %s", input.c_str(), srs_error_desc(err).c_str());
+            srs_freep(err);
+        }
+        
+        srs_usleep(SRS_INGEST_PULL_CIMS);
+    }
+    
+    return err;
+}
+
+srs_error_t SrsIngestPuller::pull()
+{
+    srs_error_t err = srs_success;
+    
+    if ((err = publisher->publish()) != srs_success) {
+        return srs_error_wrap(err, "publish");
+    }
+    
+    err = do_pull();
+    publisher->unpublish();
+    
+    if (err != srs_success) {
+        return srs_error_wrap(err, "pull %s", input.c_str());
+    }
+    
+    return err;
+}
+
+SrsHlsPullSegment::SrsHlsPullSegment()
+{
+    duration = 0;
+    sequence = 0;
+    fetching = fetched = failed = false;
+}
+
+SrsHlsPullSegment::~SrsHlsPullSegment()
+{
+}
+
+bool SrsHlsPullSegment::done()
+{
+    return fetched || failed;
+}
+
+SrsHlsPullPlaylist::SrsHlsPullPlaylist()
+{
+    target_duration = 0;
+    media_sequence = 0;
+    endlist = false;
+}
+
+SrsHlsPullPlaylist::~SrsHlsPullPlaylist()
+{
+    std::vector<SrsHlsPullSegment*>::iterator it;
+    for (it = segments.begin(); it != segments.end(); ++it) {
+        SrsHlsPullSegment* segment = *it;
+        srs_freep(segment);
+    }
+    segments.clear();
+}
+
+srs_error_t SrsHlsPullPlaylist::parse(string url, string body)
+{
+    srs_error_t err = srs_success;
+    
+    if (!srs_string_starts_with(body, "#EXTM3U")) {
+        return srs_error_new(ERROR_HLS_M3U8_INVALID, "no #EXTM3U of %s", url.c_str());
+    }
+    
+    // The next uri line is a variant stream or segment.
+    bool expect_variant = false;
+    bool expect_segment = false;
+    srs_utime_t duration = 0;
+    
+    size_t pos = 0;
+    while (pos < body.length()) {
+        size_t end = body.find("\n", pos);
+        if (end == string::npos) {
+            end = body.length();
+        }
+        
+        string line = body.substr(pos, end - pos);
+        pos = end + 1;
+        
+        line = srs_string_trim_end(srs_string_trim_start(line, " \t\r"), " \t\r");
+        if (line.empty()) {
+            continue;
+        }
+        
+        // #EXT-X-TARGETDURATION:10
+        if (srs_string_starts_with(line, "#EXT-X-TARGETDURATION:")) {
+            double td = ::atof(line.substr(string("#EXT-X-TARGETDURATION:").length()).c_str());
+            target_duration = (srs_utime_t)(td * SRS_UTIME_SECONDS);
+            continue;
+        }
+        
+        // #EXT-X-MEDIA-SEQUENCE:100
+        if (srs_string_starts_with(line, "#EXT-X-MEDIA-SEQUENCE:")) {
+            media_sequence = ::atoll(line.substr(string("#EXT-X-MEDIA-SEQUENCE:").length()).c_str());
+            continue;
+        }
+        
+        if (line == "#EXT-X-ENDLIST") {
+            endlist = true;
+            continue;
+        }
+        
+        // #EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=73207,CODECS="mp4a.40.2"
+        if (srs_string_starts_with(line, "#EXT-X-STREAM-INF:")) {
+            expect_variant = true;
+            continue;
+        }
+        
+        // #EXTINF:11.401,
+        if (srs_string_starts_with(line, "#EXTINF:")) {
+            string v = line.substr(string("#EXTINF:").length());
+            if ((end = v.find(",")) != string::npos) {
+                v = v.substr(0, end);
+            }
+            duration = (srs_utime_t)(::atof(v.c_str()) * SRS_UTIME_SECONDS);
+            expect_segment = true;
+            continue;
+        }
+        
+        // Ignore other tags and comments.
+        if (srs_string_starts_with(line, "#")) {
+            continue;
+        }
+        
+        if (expect_variant) {
+            expect_variant = false;
+            if (variant.empty()) {
+                variant = resolve(url, line);
+            }
+            continue;
+        }
+        
+        if (expect_segment) {
+            expect_segment = false;
+            
+            SrsHlsPullSegment* segment = new SrsHlsPullSegment();
+            segment->url = resolve(url, line);
+            segment->duration = duration;
+            segment->sequence = media_sequence + (int64_t)segments.size();
+            segments.push_back(segment);
+        }
+    }
+    
+    return err;
+}
+
+string SrsHlsPullPlaylist::resolve(string base, string u)
+{
+    if (srs_string_is_http(u)) {
+        return u;
+    }
+    
+    // Ignore the query of base url.
+    size_t pos = base.find("?");
+    if (pos != string::npos) {
+        base = base.substr(0, pos);
+    }
+    
+    // The absolute path, resolved by the schema and host of base url.
+    if (srs_string_starts_with(u, "/")) {
+        if ((pos = base.find("://")) != string::npos && (pos = base.find("/", pos + 3)) != string::npos) {
+            return base.substr(0, pos) + u;
+        }
+        return base + u;
+    }
+    
+    return srs_path_dirname(base) + "/" + u;
+}
+
+SrsHlsFetcher::SrsHlsFetcher(SrsHlsPuller* p)
+{
+    puller = p;
+    trd = new SrsDummyCoroutine();
+}
+
+SrsHlsFetcher::~SrsHlsFetcher()
+{
+    srs_freep(trd);
+}
+
+srs_error_t SrsHlsFetcher::start()
+{
+    srs_error_t err = srs_success;
+    
+    srs_freep(trd);
+    trd = new SrsSTCoroutine("hls-fetch", this, _srs_context->get_id());
+    if ((err = trd->start()) != srs_success) {
+        return srs_error_wrap(err, "start coroutine");
+    }
+    
+    return err;
+}
+
+void SrsHlsFetcher::stop()
+{
+    trd->stop();
+}
+
+srs_error_t SrsHlsFetcher::cycle()
+{
+    srs_error_t err = srs_success;
+    
+    while (true) {
+        if ((err = trd->pull()) != srs_success) {
+            return srs_error_wrap(err, "hls fetcher");
+        }
+        
+        SrsHlsPullSegment* segment = puller->acquire();
+        if (!segment) {
+            srs_cond_wait(puller->fetch_cond);
+            continue;
+        }
+        
+        puller->fetch_segment(segment);
+    }
+    
+    return err;
+}
+
+SrsHlsPuller::SrsHlsPuller(ISrsSourceHandler* h, int p) : SrsIngestPuller(h)
+{
+    prefetch = srs_max(1, p);
+    pool = new SrsHttpClientPool(prefetch + 1, SRS_HLS_PULL_IDLE_TIMEOUT);
+    fetch_cond = srs_cond_new();
+    ready_cond = srs_cond_new();
+    
+    next_sequence = -1;
+    endlist = false;
+    context = new SrsTsContext();
+    
+    nn_fetched = nn_failed = 0;
+}
+
+SrsHlsPuller::~SrsHlsPuller()
+{
+    // Stop the coroutine which use the fetchers and segments.
+    stop();
+    clear();
+    
+    srs_freep(context);
+    srs_freep(pool);
+    srs_cond_destroy(fetch_cond);
+    srs_cond_destroy(ready_cond);
+}
+
+srs_error_t SrsHlsPuller::do_pull()
+{
+    srs_error_t err = srs_success;
+    
+    m3u8 = input;
+    
+    for (int i = 0; i < prefetch && err == srs_success; i++) {
+        SrsHlsFetcher* fetcher = new SrsHlsFetcher(this);
+        fetchers.push_back(fetcher);
+        
+        if ((err = fetcher->start()) != srs_success) {
+            err = srs_error_wrap(err, "start fetcher");
+        }
+    }
+    
+    if (err == srs_success) {
+        err = do_pull_segments();
+    }
+    
+    // Stop the fetchers before the segments are freed.
+    clear();
+    
+    return err;
+}
+
+srs_error_t SrsHlsPuller::do_pull_segments()
+{
+    srs_error_t err = srs_success;
+    
+    srs_utime_t next_reload = 0;
+    while (true) {
+        if ((err = trd->pull()) != srs_success) {
+            return srs_error_wrap(err, "hls puller");
+        }
+        
+        pprint->elapse();
+        
+        if (!endlist && srs_update_system_time() >= next_reload) {
+            srs_utime_t interval = 0;
+            if ((err = reload(&interval)) != srs_success) {
+                return srs_error_wrap(err, "reload %s", m3u8.c_str());
+            }
+            next_reload = srs_update_system_time() + interval;
+        }
+        
+        // Consume the segments in order, util the first one not fetched.
+        while (!segments.empty() && segments.front()->done()) {
+            SrsHlsPullSegment* segment = segments.front();
+            segments.pop_front();
+            
+            // The prefetch window moves, notify fetchers for the next segment.
+            srs_cond_signal(fetch_cond);
+            
+            consume(segment);
+            srs_freep(segment);
+        }
+        
+        // The VoD or stream is finished, and all segments are consumed.
+        if (endlist && segments.empty()) {
+            srs_trace("hls: pull %s finished, fetched=%d, failed=%d", m3u8.c_str(), (int)nn_fetched, (int)nn_failed);
+            return err;
+        }
+        
+        if (pprint->can_print()) {
+            srs_trace("<- " SRS_CONSTS_LOG_INGESTER " hls: pull %s time=%dms, segments=%d, next=%" PRId64 ", fetched=%d, failed=%d, conns=%d/%d",
+                m3u8.c_str(), srsu2msi(pprint->age()), (int)segments.size(), next_sequence, (int)nn_fetched, (int)nn_failed,
+                (int)pool->nn_created, (int)pool->nn_reused);
+        }
+        
+        // Wait for segment fetched, or util reload the m3u8.
+        srs_utime_t timeout = next_reload - srs_update_system_time();
+        if (endlist) {
+            timeout = SRS_INGEST_PULL_TIMEOUT;
+        }
+        if (timeout > 0) {
+            srs_cond_timedwait(ready_cond, timeout);
+        }
+    }
+    
+    return err;
+}
+
+srs_error_t SrsHlsPuller::reload(srs_utime_t* pinterval)
+{
+    srs_error_t err = srs_success;
+    
+    std::string body;
+    if ((err = http_get(m3u8, body)) != srs_success) {
+        return srs_error_wrap(err, "get m3u8");
+    }
+    
+    SrsHlsPullPlaylist playlist;
+    if ((err = playlist.parse(m3u8, body)) != srs_success) {
+        return srs_error_wrap(err, "parse m3u8");
+    }
+    
+    // For master playlist, pull the first variant stream.
+    if (playlist.segments.empty() && !playlist.variant.empty()) {
+        srs_trace("hls: pull variant %s of %s", playlist.variant.c_str(), m3u8.c_str());
+        m3u8 = playlist.variant;
+        *pinterval = 0;
+        return err;
+    }
+    
+    int nn = update(&playlist);
+    endlist = playlist.endlist;
+    
+    // Reload after the duration of last segment when changed, or half the target duration.
+    // @see https://tools.ietf.org/html/rfc8216#section-6.3.4
+    srs_utime_t td = playlist.target_duration;
+    if (td <= 0) {
+        td = SRS_UTIME_SECONDS;
+    }
+    if (nn > 0) {
+        *pinterval = segments.back()->duration;
+    }
+    if (nn <= 0 || *pinterval <= 0) {
+        *pinterval = td / 2;
+    }
+    
+    return err;
+}
+
+int SrsHlsPuller::update(SrsHlsPullPlaylist* playlist)
+{
+    if (playlist->segments.empty()) {
+        return 0;
+    }
+    
+    // For fresh playlist, start from the last segment, the live edge.
+    // When sequence goes back, the upstream is restarted, start from the live edge again.
+    int64_t last = playlist->segments.back()->sequence;
+    if (next_sequence < 0 || last + (int64_t)playlist->segments.size() < next_sequence) {
+        if (next_sequence >= 0) {
+            srs_warn("hls: sequence reset from %" PRId64 " to %" PRId64 ", m3u8=%s", next_sequence, last, m3u8.c_str());
+        }
+        next_sequence = last;
+    }
+    
+    int nn = 0;
+    std::vector<SrsHlsPullSegment*>::iterator it;
+    for (it = playlist->segments.begin(); it != playlist->segments.end(); ++it) {
+        SrsHlsPullSegment* s = *it;
+        if (s->sequence < next_sequence) {
+            continue;
+        }
+        
+        SrsHlsPullSegment* segment = new SrsHlsPullSegment();
+        segment->url = s->url;
+        segment->duration = s->duration;
+        segment->sequence = s->sequence;
+        segments.push_back(segment);
+        next_sequence = segment->sequence + 1;
+        nn++;
+        
+        srs_cond_signal(fetch_cond);
+    }
+    
+    return nn;
+}
+
+SrsHlsPullSegment* SrsHlsPuller::acquire()
+{
+    for (int i = 0; i < (int)segments.size() && i < prefetch; i++) {
+        SrsHlsPullSegment* segment = segments.at(i);
+        if (!segment->fetching && !segment->done()) {
+            segment->fetching = true;
+            return segment;
+        }
+    }
+    
+    return NULL;
+}
+
+void SrsHlsPuller::fetch_segment(SrsHlsPullSegment* segment)
+{
+    srs_error_t err = http_get(segment->url, segment->body);
+    segment->fetching = false;
+    
+    if (err != srs_success) {
+        srs_warn("hls: skip segment %s, %s", segment->url.c_str(), srs_error_desc(err).c_str());
+        srs_freep(err);
+        segment->failed = true;
+        nn_failed++;
+    } else {
+        segment->fetched = true;
+        nn_fetched++;
+    }
+    
+    srs_cond_signal(ready_cond);
+}
+
+void SrsHlsPuller::consume(SrsHlsPullSegment* segment)
+{
+    srs_error_t err = srs_success;
+    
+    if (segment->failed) {
+        return;
+    }
+    
+    char* body = (char*)segment->body.data();
+    int nb_packets = (int)segment->body.length() / SRS_TS_PACKET_SIZE;
+    for (int i = 0; i < nb_packets; i++) {
+        SrsBuffer stream(body + i * SRS_TS_PACKET_SIZE, SRS_TS_PACKET_SIZE);
+        
+        // Skip the corrupt segment, or the unsupported codec.
+        if ((err = context->decode(&stream, publisher)) != srs_success) {
+            srs_warn("hls: ignore segment %s, %s", segment->url.c_str(), srs_error_desc(err).c_str());
+            srs_freep(err);
+            return;
+        }
+    }
+}
+
+srs_error_t SrsHlsPuller::http_get(string url, string& body)
+{
+    srs_error_t err = srs_success;
+    
+    SrsHttpUri uri;
+    if ((err = uri.initialize(url)) != srs_success) {
+        return srs_error_wrap(err, "parse url %s", url.c_str());
+    }
+    
+    string path = uri.get_path();
+    if (!uri.get_query().empty()) {
+        path += "?" + uri.get_query();
+    }
+    
+    bool reused = false;
+    SrsHttpClient* hc = NULL;
+    ISrsHttpMessage* msg = NULL;
+    while (true) {
+        if ((err = pool->fetch(uri.get_host(), uri.get_port(), SRS_INGEST_PULL_TIMEOUT, &hc, &reused)) != srs_success) {
+            return srs_error_wrap(err, "http: init client");
+        }
+        
+        if ((err = hc->get(path, "", &msg)) == srs_success) {
+            break;
+        }
+        pool->giveback(uri.get_host(), uri.get_port(), SRS_INGEST_PULL_TIMEOUT, hc, false);
+        
+        if (!reused) {
+            return srs_error_wrap(err, "http: get %s", url.c_str());
+        }
+        
+        // Retry by a new connection, for the idle keep-alive connection maybe closed by server.
+        srs_freep(err);
+    }
+    
+    int code = msg->status_code();
+    err = msg->body_read_all(body);
+    
+    // Keep the connection alive for the next segment, when the response is consumed.
+    bool reusable = (err == srs_success && msg->is_keep_alive());
+    srs_freep(msg);
+    pool->giveback(uri.get_host(), uri.get_port(), SRS_INGEST_PULL_TIMEOUT, hc, reusable);
+    
+    if (err != srs_success) {
+        return srs_error_wrap(err, "http: read body of %s", url.c_str());
+    }
+    
+    if (code != SRS_CONSTS_HTTP_OK) {
+        return srs_error_new(ERROR_HTTP_STATUS_INVALID, "http: status %d of %s", code, url.c_str());
+    }
+    
+    return err;
+}
+
+void SrsHlsPuller::clear()
+{
+    std::vector<SrsHlsFetcher*>::iterator it;
+    for (it = fetchers.begin(); it != fetchers.end(); ++it) {
+        SrsHlsFetcher* fetcher = *it;
+        fetcher->stop();
+        srs_freep(fetcher);
+    }
+    fetchers.clear();
+    
+    std::deque<SrsHlsPullSegment*>::iterator it2;
+    for (it2 = segments.begin(); it2 != segments.end(); ++it2) {
+        SrsHlsPullSegment* segment = *it2;
+        srs_freep(segment);
+    }
+    segments.clear();
+    
+    // Restart from the live edge, with a fresh ts context.
+    next_sequence = -1;
+    endlist = false;
+    srs_freep(context);
+    context = new SrsTsContext();
+}
+
+SrsFlvPuller::SrsFlvPuller(ISrsSourceHandler* h) : SrsIngestPuller(h)
+{
+}
+
+SrsFlvPuller::~SrsFlvPuller()
+{
+    stop();
+}
+
+srs_error_t SrsFlvPuller::do_pull()
+{
+    srs_error_t err = srs_success;
+    
+    SrsHttpUri uri;
+    if ((err = uri.initialize(input)) != srs_success) {
+        return srs_error_wrap(err, "parse url %s", input.c_str());
+    }
+    
+    string path = uri.get_path();
+    if (!uri.get_query().empty()) {
+        path += "?" + uri.get_query();
+    }
+    
+    SrsHttpClient hc;
+    if ((err = hc.initialize(uri.get_host(), uri.get_port(), SRS_INGEST_PULL_TIMEOUT)) != srs_success) {
+        return srs_error_wrap(err, "http: init client");
+    }
+    
+    ISrsHttpMessage* msg = NULL;
+    if ((err = hc.get(path, "", &msg)) != srs_success) {
+        return srs_error_wrap(err, "http: get %s", input.c_str());
+    }
+    SrsAutoFree(ISrsHttpMessage, msg);
+    
+    if (msg->status_code() != SRS_CONSTS_HTTP_OK) {
+        return srs_error_new(ERROR_HTTP_STATUS_INVALID, "http: status %d of %s", msg->status_code(), input.c_str());
+    }
+    
+    SrsHttpFileReader reader(msg->body_reader());
+    SrsFlvDecoder dec;
+    if ((err = dec.initialize(&reader)) != srs_success) {
+        return srs_error_wrap(err, "init decoder");
+    }
+    
+    char header[9];
+    if ((err = dec.read_header(header)) != srs_success) {
+        return srs_error_wrap(err, "read header");
+    }
+    
+    char pps[4];
+    if ((err = dec.read_previous_tag_size(pps)) != srs_success) {
+        return srs_error_wrap(err, "read pts");
+    }
+    
+    while (true) {
+        if ((err = trd->pull()) != srs_success) {
+            return srs_error_wrap(err, "flv puller");
+        }
+        
+        pprint->elapse();
+        
+        char type;
+        int32_t size;
+        uint32_t time;
+        if ((err = dec.read_tag_header(&type, &size, &time)) != srs_success) {
+            return srs_error_wrap(err, "read tag header");
+        }
+        
+        char* data = new char[size];
+        if ((err = dec.read_tag_data(data, size)) != srs_success) {
+            srs_freepa(data);
+            return srs_error_wrap(err, "read tag data");
+        }
+        
+        if ((err = publisher->on_flv_tag(type, time, data, size)) != srs_success) {
+            return srs_error_wrap(err, "deliver tag");
+        }
+        
+        if ((err = dec.read_previous_tag_size(pps)) != srs_success) {
+            return srs_error_wrap(err, "read pts");
+        }
+        
+        if (pprint->can_print()) {
+            srs_trace("<- " SRS_CONSTS_LOG_INGESTER " flv: pull %s time=%dms, type=%d, dts=%d, size=%d",
+                input.c_str(), srsu2msi(pprint->age()), type, time, size);
+        }
+    }
+    
+    return err;
+}
+
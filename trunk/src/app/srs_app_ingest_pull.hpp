@@ -0,0 +1,244 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SRS_APP_INGEST_PULL_HPP
+#define SRS_APP_INGEST_PULL_HPP
+
+#include <srs_core.hpp>
+
+#include <string>
+#include <deque>
+#include <vector>
+
+#include <srs_app_st.hpp>
+#include <srs_kernel_ts.hpp>
+#include <srs_service_st.hpp>
+
+class SrsRequest;
+class SrsSource;
+class ISrsSourceHandler;
+class SrsBuffer;
+class SrsRawH264Stream;
+class SrsRawAacStream;
+struct SrsRawAacStreamCodec;
+class SrsHttpClientPool;
+class SrsPithyPrint;
+class SrsHlsPuller;
+class SrsSecurity;
+
+// Deliver the frames pulled by ingester to the source directly, without RTMP loopback.
+// @remark It's published as a RTMP publisher from localhost, which checks the security, calls the http
+//       hooks, proxies to origin for edge and updates the statistic, except the kbps of client.
+class SrsIngestPublisher : public ISrsTsHandler
+{
+private:
+    SrsRequest* req;
+    ISrsSourceHandler* handler;
+    // The source to deliver frames to, NULL when not publishing.
+    SrsSource* source;
+    // Whether the vhost is edge, which proxies the stream to origin.
+    bool edge;
+    // The client id for statistic, which is the id of publishing coroutine.
+    int cid;
+    SrsSecurity* security;
+private:
+    SrsRawH264Stream* avc;
+    std::string h264_sps;
+    std::string h264_pps;
+    bool h264_sps_pps_sent;
+private:
+    SrsRawAacStream* aac;
+    std::string aac_specific_config;
+public:
+    SrsIngestPublisher(ISrsSourceHandler* h);
+    virtual ~SrsIngestPublisher();
+public:
+    // Initialize the publisher for stream r, which is copied.
+    virtual srs_error_t initialize(SrsRequest* r);
+    virtual std::string url();
+    // Acquire the source and start to publish, or fail when stream is busy.
+    virtual srs_error_t publish();
+    virtual void unpublish();
+    // Deliver a FLV tag to source, the data is freed by publisher.
+    virtual srs_error_t on_flv_tag(char type, uint32_t timestamp, char* data, int size);
+private:
+    virtual srs_error_t acquire_publish();
+    virtual void release_publish();
+    virtual srs_error_t http_hooks_on_publish();
+    virtual void http_hooks_on_unpublish();
+// Interface ISrsTsHandler
+public:
+    virtual srs_error_t on_ts_message(SrsTsMessage* msg);
+private:
+    virtual srs_error_t on_ts_video(SrsTsMessage* msg, SrsBuffer* avs);
+    virtual srs_error_t write_h264_sps_pps(uint32_t dts, uint32_t pts);
+    virtual srs_error_t on_ts_audio(SrsTsMessage* msg, SrsBuffer* avs);
+    virtual srs_error_t write_audio_raw_frame(char* frame, int frame_size, SrsRawAacStreamCodec* codec, uint32_t dts);
+};
+
+// The puller to ingest the live stream over HTTP, which delivers the frames to source by publisher.
+class SrsIngestPuller : public ISrsCoroutineHandler
+{
+protected:
+    std::string input;
+    SrsIngestPublisher* publisher;
+    SrsPithyPrint* pprint;
+    // NULL when not started.
+    SrsCoroutine* trd;
+public:
+    SrsIngestPuller(ISrsSourceHandler* h);
+    virtual ~SrsIngestPuller();
+public:
+    // Initialize the puller to pull from input url u, and publish as stream r.
+    virtual srs_error_t initialize(std::string u, SrsRequest* r);
+    // Start the coroutine to pull, ignore if already started.
+    virtual srs_error_t start();
+    virtual void stop();
+// Interface ISrsCoroutineHandler
+public:
+    virtual srs_error_t cycle();
+protected:
+    virtual srs_error_t pull();
+    // Pull the stream util error or finished.
+    virtual srs_error_t do_pull() = 0;
+};
+
+// The HLS segment to prefetch, which is consumed in order of sequence.
+class SrsHlsPullSegment
+{
+public:
+    // The absolute url of segment.
+    std::string url;
+    srs_utime_t duration;
+    int64_t sequence;
+public:
+    // Whether the segment is being fetched by a fetcher.
+    bool fetching;
+    // Whether the segment is fetched, or failed and should be skipped.
+    bool fetched;
+    bool failed;
+    std::string body;
+public:
+    SrsHlsPullSegment();
+    virtual ~SrsHlsPullSegment();
+public:
+    // Whether the segment is ready to consume, fetched or failed.
+    virtual bool done();
+};
+
+// The m3u8 playlist of live HLS.
+class SrsHlsPullPlaylist
+{
+public:
+    srs_utime_t target_duration;
+    int64_t media_sequence;
+    bool endlist;
+    // The absolute url of the first variant stream, for master playlist.
+    std::string variant;
+    std::vector<SrsHlsPullSegment*> segments;
+public:
+    SrsHlsPullPlaylist();
+    virtual ~SrsHlsPullPlaylist();
+public:
+    // Parse the body of m3u8 from url, the relative url of segments is resolved by it.
+    virtual srs_error_t parse(std::string url, std::string body);
+private:
+    virtual std::string resolve(std::string base, std::string u);
+};
+
+// The fetcher to download segments of HLS puller, over keep-alive connection.
+class SrsHlsFetcher : public ISrsCoroutineHandler
+{
+private:
+    SrsHlsPuller* puller;
+    SrsCoroutine* trd;
+public:
+    SrsHlsFetcher(SrsHlsPuller* p);
+    virtual ~SrsHlsFetcher();
+public:
+    virtual srs_error_t start();
+    virtual void stop();
+// Interface ISrsCoroutineHandler
+public:
+    virtual srs_error_t cycle();
+};
+
+// Pull the live HLS, by fetching the next segments concurrently with bounded parallelism,
+// then demux the ts in order and deliver to source.
+class SrsHlsPuller : public SrsIngestPuller
+{
+    friend class SrsHlsFetcher;
+private:
+    // The max number of segments to fetch concurrently.
+    int prefetch;
+    // The url of m3u8, updated to the variant for master playlist.
+    std::string m3u8;
+    // The keep-alive connections to upstream, shared by fetchers.
+    SrsHttpClientPool* pool;
+    std::vector<SrsHlsFetcher*> fetchers;
+    // Wakeup the fetchers when segments to fetch, and the puller when segment fetched.
+    srs_cond_t fetch_cond;
+    srs_cond_t ready_cond;
+private:
+    // The segments to fetch and consume, in order of sequence.
+    std::deque<SrsHlsPullSegment*> segments;
+    // The sequence of next segment to queue, -1 for fresh playlist.
+    int64_t next_sequence;
+    bool endlist;
+    SrsTsContext* context;
+public:
+    // The number of fetched and failed segments.
+    uint64_t nn_fetched;
+    uint64_t nn_failed;
+public:
+    SrsHlsPuller(ISrsSourceHandler* h, int p);
+    virtual ~SrsHlsPuller();
+protected:
+    virtual srs_error_t do_pull();
+private:
+    virtual srs_error_t do_pull_segments();
+    // Refresh the m3u8, and get the interval to reload it.
+    virtual srs_error_t reload(srs_utime_t* pinterval);
+    // Queue the new segments of playlist, return the number of queued segments.
+    virtual int update(SrsHlsPullPlaylist* playlist);
+    // Acquire a segment to fetch in the prefetch window, NULL if none.
+    virtual SrsHlsPullSegment* acquire();
+    virtual void fetch_segment(SrsHlsPullSegment* segment);
+    // Demux the ts segment and deliver to source, skip the segment when corrupt.
+    virtual void consume(SrsHlsPullSegment* segment);
+    virtual srs_error_t http_get(std::string url, std::string& body);
+    virtual void clear();
+};
+
+// Pull the live HTTP-FLV and deliver the tags to source.
+class SrsFlvPuller : public SrsIngestPuller
+{
+public:
+    SrsFlvPuller(ISrsSourceHandler* h);
+    virtual ~SrsFlvPuller();
+protected:
+    virtual srs_error_t do_pull();
+};
+
+#endif
+
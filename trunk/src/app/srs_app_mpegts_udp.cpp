@@ -58,9 +58,9 @@ SrsMpegtsQueue::SrsMpegtsQueue()
 
 SrsMpegtsQueue::~SrsMpegtsQueue()
 {
-    std::map<int64_t, SrsSharedPtrMessage*>::iterator it;
+    std::vector<SrsSharedPtrMessage*>::iterator it;
     for (it = msgs.begin(); it != msgs.end(); ++it) {
-        SrsSharedPtrMessage* msg = it->second;
+        SrsSharedPtrMessage* msg = *it;
         srs_freep(msg);
     }
     msgs.clear();
@@ -71,8 +71,11 @@ srs_error_t SrsMpegtsQueue::push(SrsSharedPtrMessage* msg)
     srs_error_t err = srs_success;
     
     // TODO: FIXME: use right way.
+    bool exists = false;
+    std::vector<SrsSharedPtrMessage*>::iterator it;
     for (int i = 0; i < 10; i++) {
-        if (msgs.find(msg->timestamp) == msgs.end()) {
+        it = find(msg->timestamp, &exists);
+        if (!exists) {
             break;
         }
         
@@ -94,7 +97,7 @@ srs_error_t SrsMpegtsQueue::push(SrsSharedPtrMessage* msg)
         nb_videos++;
     }
     
-    msgs[msg->timestamp] = msg;
+    msgs.insert(it, msg);
     
     return err;
 }
@@ -107,8 +110,8 @@ SrsSharedPtrMessage* SrsMpegtsQueue::dequeue()
     bool av_overflow = nb_videos > 100 || nb_audios > 300;
     
     if (av_ok || av_overflow) {
-        std::map<int64_t, SrsSharedPtrMessage*>::iterator it = msgs.begin();
-        SrsSharedPtrMessage* msg = it->second;
+        std::vector<SrsSharedPtrMessage*>::iterator it = msgs.begin();
+        SrsSharedPtrMessage* msg = *it;
         msgs.erase(it);
         
         if (msg->is_audio()) {
@@ -125,6 +128,18 @@ SrsSharedPtrMessage* SrsMpegtsQueue::dequeue()
     return NULL;
 }
 
+std::vector<SrsSharedPtrMessage*>::iterator SrsMpegtsQueue::find(int64_t timestamp, bool* pexists)
+{
+    // search from the back, for the msgs are almost in order.
+    std::vector<SrsSharedPtrMessage*>::iterator it = msgs.end();
+    while (it != msgs.begin() && (*(it - 1))->timestamp > timestamp) {
+        --it;
+    }
+    
+    *pexists = it != msgs.begin() && (*(it - 1))->timestamp == timestamp;
+    return it;
+}
+
 SrsMpegtsOverUdp::SrsMpegtsOverUdp(SrsConfDirective* c)
 {
     context = new SrsTsContext();
@@ -235,11 +250,10 @@ srs_error_t SrsMpegtsOverUdp::on_udp_bytes(string host, int port, char* buf, int
     for (int i = 0; i < nb_packet; i++) {
         char* p = buffer->bytes() + (i * SRS_TS_PACKET_SIZE);
         
-        SrsBuffer* stream = new SrsBuffer(p, SRS_TS_PACKET_SIZE);
-        SrsAutoFree(SrsBuffer, stream);
+        SrsBuffer stream(p, SRS_TS_PACKET_SIZE);
         
         // process each ts packet
-        if ((err = context->decode(stream, this)) != srs_success) {
+        if ((err = context->decode(&stream, this)) != srs_success) {
             srs_warn("parse ts packet err=%s", srs_error_desc(err).c_str());
             srs_error_reset(err);
             continue;
@@ -354,66 +368,71 @@ srs_error_t SrsMpegtsOverUdp::on_ts_video(SrsTsMessage* msg, SrsBuffer* avs)
     uint32_t pts = (uint32_t)(msg->dts / 90);
     
     // send each frame.
+    SrsAnnexbNalu nalus[SRS_AVC_MAX_NALUS];
     while (!avs->empty()) {
-        char* frame = NULL;
-        int frame_size = 0;
-        if ((err = avc->annexb_demux(avs, &frame, &frame_size)) != srs_success) {
-            return srs_error_wrap(err, "demux annexb");
-        }
-        
-        // 5bits, 7.3.1 NAL unit syntax,
-        // ISO_IEC_14496-10-AVC-2003.pdf, page 44.
-        //  7: SPS, 8: PPS, 5: I Frame, 1: P Frame
-        SrsAvcNaluType nal_unit_type = (SrsAvcNaluType)(frame[0] & 0x1f);
-        
-        // ignore the nalu type sps(7), pps(8), aud(9)
-        if (nal_unit_type == SrsAvcNaluTypeAccessUnitDelimiter) {
-            continue;
+        int nb_nalus = 0;
+        if ((err = avc->annexb_split(avs, nalus, SRS_AVC_MAX_NALUS, &nb_nalus)) != srs_success) {
+            return srs_error_wrap(err, "split annexb");
         }
         
-        // for sps
-        if (avc->is_sps(frame, frame_size)) {
-            std::string sps;
-            if ((err = avc->sps_demux(frame, frame_size, sps)) != srs_success) {
-                return srs_error_wrap(err, "demux sps");
-            }
+        for (int i = 0; i < nb_nalus; i++) {
+            char* frame = nalus[i].bytes;
+            int frame_size = nalus[i].size;
+            
+            // 5bits, 7.3.1 NAL unit syntax,
+            // ISO_IEC_14496-10-AVC-2003.pdf, page 44.
+            //  7: SPS, 8: PPS, 5: I Frame, 1: P Frame
+            SrsAvcNaluType nal_unit_type = (SrsAvcNaluType)(frame[0] & 0x1f);
             
-            if (h264_sps == sps) {
+            // ignore the nalu type sps(7), pps(8), aud(9)
+            if (nal_unit_type == SrsAvcNaluTypeAccessUnitDelimiter) {
                 continue;
             }
-            h264_sps_changed = true;
-            h264_sps = sps;
             
-            if ((err = write_h264_sps_pps(dts, pts)) != srs_success) {
-                return srs_error_wrap(err, "write sps/pps");
-            }
-            continue;
-        }
-        
-        // for pps
-        if (avc->is_pps(frame, frame_size)) {
-            std::string pps;
-            if ((err = avc->pps_demux(frame, frame_size, pps)) != srs_success) {
-                return srs_error_wrap(err, "demux pps");
+            // for sps
+            if (avc->is_sps(frame, frame_size)) {
+                std::string sps;
+                if ((err = avc->sps_demux(frame, frame_size, sps)) != srs_success) {
+                    return srs_error_wrap(err, "demux sps");
+                }
+                
+                if (h264_sps == sps) {
+                    continue;
+                }
+                h264_sps_changed = true;
+                h264_sps = sps;
+                
+                if ((err = write_h264_sps_pps(dts, pts)) != srs_success) {
+                    return srs_error_wrap(err, "write sps/pps");
+                }
+                continue;
             }
             
-            if (h264_pps == pps) {
+            // for pps
+            if (avc->is_pps(frame, frame_size)) {
+                std::string pps;
+                if ((err = avc->pps_demux(frame, frame_size, pps)) != srs_success) {
+                    return srs_error_wrap(err, "demux pps");
+                }
+                
+                if (h264_pps == pps) {
+                    continue;
+                }
+                h264_pps_changed = true;
+                h264_pps = pps;
+                
+                if ((err = write_h264_sps_pps(dts, pts)) != srs_success) {
+                    return srs_error_wrap(err, "write sps/pps");
+                }
                 continue;
             }
-            h264_pps_changed = true;
-            h264_pps = pps;
             
-            if ((err = write_h264_sps_pps(dts, pts)) != srs_success) {
-                return srs_error_wrap(err, "write sps/pps");
+            // ibp frame.
+            // TODO: FIXME: we should group all frames to a rtmp/flv message from one ts message.
+            srs_info("mpegts: demux avc ibp frame size=%d, dts=%d", frame_size, dts);
+            if ((err = write_h264_ipb_frame(frame, frame_size, dts, pts)) != srs_success) {
+                return srs_error_wrap(err, "write frame");
             }
-            continue;
-        }
-        
-        // ibp frame.
-        // TODO: FIXME: we should group all frames to a rtmp/flv message from one ts message.
-        srs_info("mpegts: demux avc ibp frame size=%d, dts=%d", frame_size, dts);
-        if ((err = write_h264_ipb_frame(frame, frame_size, dts, pts)) != srs_success) {
-            return srs_error_wrap(err, "write frame");
         }
     }
     
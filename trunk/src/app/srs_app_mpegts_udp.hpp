@@ -29,6 +29,7 @@
 struct sockaddr;
 #include <string>
 #include <map>
+#include <vector>
 
 class SrsBuffer;
 class SrsTsContext;
@@ -54,8 +55,9 @@ class SrsSimpleRtmpClient;
 class SrsMpegtsQueue
 {
 private:
-    // The key: dts, value: msg.
-    std::map<int64_t, SrsSharedPtrMessage*> msgs;
+    // The msgs sorted by dts, which is unique.
+    // @remark Use vector for the msgs are almost in order, never allocate when queue is stable.
+    std::vector<SrsSharedPtrMessage*> msgs;
     int nb_audios;
     int nb_videos;
 public:
@@ -64,6 +66,10 @@ public:
 public:
     virtual srs_error_t push(SrsSharedPtrMessage* msg);
     virtual SrsSharedPtrMessage* dequeue();
+private:
+    // Find the position to insert msg of timestamp.
+    // @param pexists output whether the timestamp exists.
+    virtual std::vector<SrsSharedPtrMessage*>::iterator find(int64_t timestamp, bool* pexists);
 };
 
 // The mpegts over udp stream caster.
@@ -0,0 +1,386 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <srs_app_profiler.hpp>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(__x86_64__)
+#include <pthread.h>
+#include <ucontext.h>
+#else
+#include <execinfo.h>
+#endif
+#ifndef SRS_AUTO_OSX
+#include <sys/syscall.h>
+#endif
+#include <map>
+using namespace std;
+
+#include <srs_kernel_error.hpp>
+#include <srs_kernel_log.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_service_log.hpp>
+#include <srs_service_st.hpp>
+
+#if !defined(SRS_AUTO_OSX) && !defined(sigev_notify_thread_id)
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+SrsCpuProfiler* _srs_cpu_profiler = new SrsCpuProfiler();
+
+// The profiler which is sampling, for the signal handler.
+static SrsCpuProfiler* _srs_cpu_profiling = NULL;
+
+#if defined(__linux__) && defined(__x86_64__)
+// The stack of main thread, for the primordial coroutine. It's got when profiler starts, because the
+// pthread_getattr_np is not async-signal-safe.
+static uintptr_t _srs_profiler_main_bottom = 0;
+static uintptr_t _srs_profiler_main_top = 0;
+#endif
+
+int srs_profiler_backtrace(void* context, void** frames, int max)
+{
+#if defined(__linux__) && defined(__x86_64__)
+    ucontext_t* uc = (ucontext_t*)context;
+    uintptr_t pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    uintptr_t sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+    uintptr_t fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    
+    int depth = 0;
+    frames[depth++] = (void*)pc;
+    
+    // The frames are in the stack of current coroutine, or the main thread for the primordial one.
+    uintptr_t bottom = _srs_profiler_main_bottom;
+    uintptr_t top = _srs_profiler_main_top;
+    char* stk_bottom = NULL;
+    char* stk_top = NULL;
+    if (srs_thread_stack(&stk_bottom, &stk_top)) {
+        bottom = (uintptr_t)stk_bottom;
+        top = (uintptr_t)stk_top;
+    }
+    
+    // The sp is out of the stack when switching coroutines, so the stack is unknown.
+    if (sp < bottom || sp >= top) {
+        return depth;
+    }
+    
+    // The fp is a GPR if the function omits the frame pointer, for example, in libc, so we check it
+    // carefully, and stop at the first one out of the stack.
+    while (depth < max) {
+        if (fp < sp || fp + 2 * sizeof(uintptr_t) > top || (fp & (sizeof(uintptr_t) - 1)) != 0) {
+            break;
+        }
+        
+        uintptr_t* frame = (uintptr_t*)fp;
+        uintptr_t next = frame[0];
+        uintptr_t ra = frame[1];
+        if (!ra) {
+            break;
+        }
+        frames[depth++] = (void*)ra;
+        
+        // The stack grows down, so the caller's frame is always higher.
+        if (next <= fp) {
+            break;
+        }
+        sp = fp + 2 * sizeof(uintptr_t);
+        fp = next;
+    }
+    
+    return depth;
+#else
+    // Note that the frames of signal handler are also in the stack.
+    return backtrace(frames, max);
+#endif
+}
+
+string srs_profiler_symbol(void* address)
+{
+    char buf[64];
+    
+    Dl_info info;
+    if (!dladdr(address, &info)) {
+        snprintf(buf, sizeof(buf), "0x%lx", (unsigned long)address);
+        return buf;
+    }
+    
+    if (!info.dli_sname) {
+        string module = info.dli_fname? srs_path_basename(info.dli_fname) : "unknown";
+        snprintf(buf, sizeof(buf), "+0x%lx", (unsigned long)((char*)address - (char*)info.dli_fbase));
+        return module + buf;
+    }
+    
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+    if (status != 0 || !demangled) {
+        return info.dli_sname;
+    }
+    
+    string name = demangled;
+    free(demangled);
+    
+    // Remove the parameters, for example, SrsRtmpConn::do_playing(SrsSource*, ...) const
+    if (srs_string_ends_with(name, " const")) {
+        name = name.substr(0, name.length() - 6);
+    }
+    if (srs_string_ends_with(name, ")")) {
+        int depth = 0;
+        for (int i = (int)name.length() - 1; i > 0; i--) {
+            if (name.at(i) == ')') {
+                depth++;
+            } else if (name.at(i) == '(' && --depth == 0) {
+                name = name.substr(0, i);
+                break;
+            }
+        }
+    }
+    
+    return name;
+}
+
+SrsCpuProfiler::SrsCpuProfiler()
+{
+    started = false;
+    samples = NULL;
+    capacity = 0;
+    nb_samples = 0;
+    nb_dropped = 0;
+}
+
+SrsCpuProfiler::~SrsCpuProfiler()
+{
+    stop();
+    srs_freepa(samples);
+}
+
+srs_error_t SrsCpuProfiler::start(int frequency, int seconds)
+{
+    srs_error_t err = srs_success;
+    
+    if (started || _srs_cpu_profiling) {
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "profiler is running");
+    }
+    
+    if (frequency <= 0 || frequency > SRS_PROFILER_MAX_FREQUENCY || seconds <= 0 || seconds > SRS_PROFILER_MAX_SECONDS) {
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "invalid frequency=%d, seconds=%d", frequency, seconds);
+    }
+    
+    // Install the handler once and never restore it, because a pending SIGPROF terminates the process
+    // if the default action is restored.
+    struct sigaction sa;
+    if (sigaction(SIGPROF, NULL, &sa) == -1) {
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "query SIGPROF");
+    }
+    
+    bool installed = (sa.sa_flags & SA_SIGINFO) && sa.sa_sigaction == SrsCpuProfiler::on_signal;
+    if (!installed && sa.sa_handler != SIG_DFL && sa.sa_handler != SIG_IGN) {
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "SIGPROF is used by others, such as gprof or gperftools");
+    }
+    
+    if (!installed) {
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = SrsCpuProfiler::on_signal;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGPROF, &sa, NULL) == -1) {
+            return srs_error_new(ERROR_SYSTEM_PROFILER, "install SIGPROF");
+        }
+    }
+    
+#if defined(__linux__) && defined(__x86_64__)
+    // The bounds of main thread, the stack walk stops at once if failed.
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        void* addr = NULL;
+        size_t size = 0;
+        if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+            _srs_profiler_main_bottom = (uintptr_t)addr;
+            _srs_profiler_main_top = (uintptr_t)addr + size;
+        }
+        pthread_attr_destroy(&attr);
+    }
+#endif
+
+    // Allocate the samples, with a second for the jitter of timer.
+    srs_freepa(samples);
+    capacity = frequency * (seconds + 1);
+    samples = new SrsProfileSample[capacity];
+    nb_samples = 0;
+    nb_dropped = 0;
+    _srs_cpu_profiling = this;
+    
+    long interval = 1000000000L / frequency;
+#ifndef SRS_AUTO_OSX
+    // Only sample the main thread by its cpu time, because SIGPROF of process is delivered to any thread.
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &timer) == -1) {
+        _srs_cpu_profiling = NULL;
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "create timer");
+    }
+    
+    struct itimerspec its;
+    its.it_interval.tv_sec = interval / 1000000000L;
+    its.it_interval.tv_nsec = interval % 1000000000L;
+    its.it_value = its.it_interval;
+    if (timer_settime(timer, 0, &its, NULL) == -1) {
+        timer_delete(timer);
+        _srs_cpu_profiling = NULL;
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "start timer");
+    }
+#else
+    owner = pthread_self();
+    
+    struct itimerval itv;
+    itv.it_interval.tv_sec = interval / 1000000000L;
+    itv.it_interval.tv_usec = (interval % 1000000000L) / 1000;
+    itv.it_value = itv.it_interval;
+    if (setitimer(ITIMER_PROF, &itv, NULL) == -1) {
+        _srs_cpu_profiling = NULL;
+        return srs_error_new(ERROR_SYSTEM_PROFILER, "start timer");
+    }
+#endif
+    
+    started = true;
+    
+    return err;
+}
+
+void SrsCpuProfiler::stop()
+{
+    if (!started) {
+        return;
+    }
+    
+#ifndef SRS_AUTO_OSX
+    timer_delete(timer);
+#else
+    struct itimerval itv;
+    memset(&itv, 0, sizeof(itv));
+    setitimer(ITIMER_PROF, &itv, NULL);
+#endif
+    
+    _srs_cpu_profiling = NULL;
+    started = false;
+}
+
+bool SrsCpuProfiler::is_started()
+{
+    return started;
+}
+
+int SrsCpuProfiler::nn_samples()
+{
+    return nb_samples;
+}
+
+int SrsCpuProfiler::nn_dropped()
+{
+    return nb_dropped;
+}
+
+void SrsCpuProfiler::dumps(string& folded)
+{
+    // The symbols of address, to avoid dladdr for each frame.
+    map<void*, string> symbols;
+    // The stacks and the count of samples, sorted by stack.
+    map<string, int> stacks;
+    
+    for (int i = 0; i < nb_samples; i++) {
+        SrsProfileSample* s = &samples[i];
+        
+        string stack = "cid-" + srs_int2str(s->cid);
+        for (int j = s->depth - 1; j >= 0; j--) {
+            // The return address is the next instruction of call, which maybe another function.
+            void* address = s->frames[j];
+            if (j > 0) {
+                address = (char*)address - 1;
+            }
+            
+            map<void*, string>::iterator it = symbols.find(address);
+            if (it == symbols.end()) {
+                it = symbols.insert(make_pair(address, srs_profiler_symbol(address))).first;
+            }
+            
+            // The coroutine starts from _st_thread_main, and the frames above it are garbage of stack.
+            if (it->second == "_st_thread_main") {
+                stack = "cid-" + srs_int2str(s->cid);
+            }
+            
+            stack += ";" + it->second;
+        }
+        
+        stacks[stack]++;
+    }
+    
+    for (map<string, int>::iterator it = stacks.begin(); it != stacks.end(); ++it) {
+        folded += it->first + " " + srs_int2str(it->second) + "\n";
+    }
+}
+
+void SrsCpuProfiler::on_signal(int /*signo*/, siginfo_t* /*info*/, void* context)
+{
+    // The handler interrupts the main thread anywhere, so keep the errno.
+    int saved = errno;
+    
+    SrsCpuProfiler* profiler = _srs_cpu_profiling;
+    if (profiler) {
+        profiler->sample(context);
+    }
+    
+    errno = saved;
+}
+
+void SrsCpuProfiler::sample(void* context)
+{
+#ifdef SRS_AUTO_OSX
+    if (!pthread_equal(pthread_self(), owner)) {
+        nb_dropped++;
+        return;
+    }
+#endif
+    
+    int index = nb_samples;
+    if (index >= capacity) {
+        nb_dropped++;
+        return;
+    }
+    
+    SrsProfileSample* s = &samples[index];
+    s->cid = SrsThreadContext::peek_id();
+    s->depth = srs_profiler_backtrace(context, s->frames, SRS_PROFILER_MAX_DEPTH);
+    
+    nb_samples = index + 1;
+}
+
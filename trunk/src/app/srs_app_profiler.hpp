@@ -0,0 +1,101 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SRS_APP_PROFILER_HPP
+#define SRS_APP_PROFILER_HPP
+
+#include <srs_core.hpp>
+
+#include <signal.h>
+#include <time.h>
+#ifdef SRS_AUTO_OSX
+#include <pthread.h>
+#endif
+#include <string>
+
+// The sampling cpu profiler, always compiled and triggered by HTTP API, to find the hot spots of a
+// server carrying traffic, without rebuilding with --with-gprof or --with-gcp and restart.
+//
+// When started, the main thread receives SIGPROF at the frequency of its cpu time, and the handler
+// saves the stack and the cid of current coroutine into the preallocated samples. When stopped, the
+// samples are symbolized and folded for flamegraph.pl, for example:
+//      cid-105;SrsRtmpConn::do_playing;SrsRtmpServer::send_and_free_messages;writev 12
+// where the stack walks the frame pointers on x86_64 linux, otherwise uses backtrace.
+// @remark The SIGPROF conflicts with gprof and gperftools, so we fail if its handler is used.
+// @remark We only sample the main thread, which runs the coroutines, not the worker threads.
+#define SRS_PROFILER_MAX_DEPTH 48
+// The limits of frequency in Hz and duration in seconds of a profile.
+#define SRS_PROFILER_MAX_FREQUENCY 1000
+#define SRS_PROFILER_MAX_SECONDS 60
+
+// A sample of stack, the frames[0] is the pc, others are the return addresses.
+struct SrsProfileSample
+{
+    int cid;
+    int depth;
+    void* frames[SRS_PROFILER_MAX_DEPTH];
+};
+
+class SrsCpuProfiler
+{
+private:
+    bool started;
+#ifndef SRS_AUTO_OSX
+    timer_t timer;
+#else
+    pthread_t owner;
+#endif
+    // The samples are written by the signal handler, so never realloc when started.
+    SrsProfileSample* samples;
+    int capacity;
+    volatile int nb_samples;
+    // The number of samples dropped, because the samples are full or not from the main thread.
+    volatile int nb_dropped;
+public:
+    SrsCpuProfiler();
+    virtual ~SrsCpuProfiler();
+public:
+    // Start to sample at frequency in Hz, for at most the samples of seconds.
+    virtual srs_error_t start(int frequency, int seconds);
+    virtual void stop();
+    virtual bool is_started();
+    virtual int nn_samples();
+    virtual int nn_dropped();
+    // Dumps the samples as folded stacks, one stack per line with the count of samples.
+    virtual void dumps(std::string& folded);
+private:
+    static void on_signal(int signo, siginfo_t* info, void* context);
+    virtual void sample(void* context);
+};
+
+// Walk the stack from the signal context, return the depth.
+extern int srs_profiler_backtrace(void* context, void** frames, int max);
+
+// Get the symbol of address, such as SrsRtmpConn::do_playing, or the module and offset if no symbol.
+extern std::string srs_profiler_symbol(void* address);
+
+// The global cpu profiler.
+extern SrsCpuProfiler* _srs_cpu_profiler;
+
+#endif
+
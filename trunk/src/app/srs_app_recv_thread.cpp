@@ -62,6 +62,7 @@ SrsRecvThread::SrsRecvThread(ISrsMessagePumper* p, SrsRtmpServer* r, srs_utime_t
     pumper = p;
     timeout = tm;
     _parent_cid = parent_cid;
+    stack_size = _srs_config->get_stack_size("receiver");
     trd = new SrsDummyCoroutine();
 }
 
@@ -75,12 +76,19 @@ int SrsRecvThread::cid()
     return trd->cid();
 }
 
+void SrsRecvThread::set_stack_size(int v)
+{
+    stack_size = v;
+}
+
 srs_error_t SrsRecvThread::start()
 {
     srs_error_t err = srs_success;
     
     srs_freep(trd);
-    trd = new SrsSTCoroutine("recv", this, _parent_cid);
+    SrsSTCoroutine* coroutine = new SrsSTCoroutine("recv", this, _parent_cid);
+    coroutine->set_stack_size(stack_size);
+    trd = coroutine;
     
     if ((err = trd->start()) != srs_success) {
         return srs_error_wrap(err, "recv thread");
@@ -297,8 +305,13 @@ SrsPublishRecvThread::SrsPublishRecvThread(SrsRtmpServer* rtmp_sdk, SrsRequest*
     mr_sleep = _srs_config->get_mr_sleep(req->vhost);
     
     realtime = _srs_config->get_realtime_enabled(req->vhost);
+    latency = _srs_config->get_stats_latency();
     
-    _srs_config->subscribe(this);
+    // The publisher is handled in the recv thread, through the source to the HLS, DVR and forwarders,
+    // so it needs the stack of connection, not the small stack of receiver.
+    trd.set_stack_size(_srs_config->get_stack_size("connection"));
+    
+    _srs_config->subscribe(this, req->vhost, SrsReloadVhostPublish | SrsReloadVhostRealtime);
 }
 
 SrsPublishRecvThread::~SrsPublishRecvThread()
@@ -377,6 +390,11 @@ srs_error_t SrsPublishRecvThread::consume(SrsCommonMessage* msg)
     
     _nb_msgs++;
     
+    // The ingest time to trace the latency, carried by the shared message.
+    if (latency) {
+        msg->ingest_time = srs_update_system_time();
+    }
+    
     if (msg->header.is_video()) {
         video_frames++;
     }
@@ -565,7 +583,9 @@ void SrsPublishRecvThread::set_socket_buffer(srs_utime_t sleep_v)
 SrsHttpRecvThread::SrsHttpRecvThread(SrsResponseOnlyHttpConn* c)
 {
     conn = c;
-    trd = new SrsSTCoroutine("http-receive", this, _srs_context->get_id());
+    SrsSTCoroutine* coroutine = new SrsSTCoroutine("http-receive", this, _srs_context->get_id());
+    coroutine->set_stack_size(_srs_config->get_stack_size("receiver"));
+    trd = coroutine;
 }
 
 SrsHttpRecvThread::~SrsHttpRecvThread()
@@ -83,6 +83,8 @@ protected:
     int _parent_cid;
     // The recv timeout in srs_utime_t.
     srs_utime_t timeout;
+    // The stack size in bytes of coroutine, 0 to use the default of ST.
+    int stack_size;
 public:
     // Constructor.
     // @param tm The receive timeout in srs_utime_t.
@@ -90,6 +92,9 @@ public:
     virtual ~SrsRecvThread();
 public:
     virtual int cid();
+    // Set the stack size in bytes, which must be set before start.
+    // @remark The default is the stack size of receiver.
+    virtual void set_stack_size(int v);
 public:
     virtual srs_error_t start();
     virtual void stop();
@@ -158,6 +163,8 @@ private:
     // For realtime
     // @see https://github.com/ossrs/srs/issues/257
     bool realtime;
+    // Whether trace the latency of messages, from ingest to egress.
+    bool latency;
     // The recv thread error code.
     srs_error_t recv_error;
     SrsRtmpConn* _conn;
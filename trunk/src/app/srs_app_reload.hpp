@@ -28,6 +28,30 @@
 
 #include <string>
 
+// The sections of vhost to reload, a handler of vhost could subscribe some of them,
+// and will only be notified when the subscribed section of the vhost changed.
+enum SrsReloadSection
+{
+    SrsReloadVhostAdded = 0x01,
+    SrsReloadVhostRemoved = 0x02,
+    SrsReloadVhostPlay = 0x04,
+    SrsReloadVhostForward = 0x08,
+    SrsReloadVhostDash = 0x10,
+    SrsReloadVhostHls = 0x20,
+    SrsReloadVhostHds = 0x40,
+    SrsReloadVhostDvr = 0x80,
+    SrsReloadVhostDvrApply = 0x100,
+    SrsReloadVhostPublish = 0x200,
+    SrsReloadVhostTcpNodelay = 0x400,
+    SrsReloadVhostRealtime = 0x800,
+    SrsReloadVhostChunkSize = 0x1000,
+    SrsReloadVhostTranscode = 0x2000,
+    SrsReloadVhostExec = 0x4000,
+    SrsReloadVhostHttpStatic = 0x8000,
+    SrsReloadVhostHttpRemux = 0x10000,
+    SrsReloadVhostIngest = 0x20000,
+};
+
 // The handler for config reload.
 // When reload callback, the config is updated yet.
 //
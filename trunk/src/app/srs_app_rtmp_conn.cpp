@@ -55,6 +55,7 @@ using namespace std;
 #include <srs_app_statistic.hpp>
 #include <srs_protocol_utility.hpp>
 #include <srs_protocol_json.hpp>
+#include <srs_app_abr.hpp>
 
 // the timeout in srs_utime_t to wait encoder to republish
 // if timeout, close the connection.
@@ -121,8 +122,6 @@ SrsRtmpConn::SrsRtmpConn(SrsServer* svr, srs_netfd_t c, string cip) : SrsConnect
     send_min_interval = 0;
     tcp_nodelay = false;
     info = new SrsClientInfo();
-    
-    _srs_config->subscribe(this);
 }
 
 SrsRtmpConn::~SrsRtmpConn()
@@ -461,6 +460,10 @@ srs_error_t SrsRtmpConn::stream_service_cycle()
     if ((err = check_vhost(true)) != srs_success) {
         return srs_error_wrap(err, "check vhost");
     }
+    
+    // Only reload the sections of vhost which is connected.
+    _srs_config->subscribe(this, req->vhost, SrsReloadVhostRemoved | SrsReloadVhostPlay
+        | SrsReloadVhostTcpNodelay | SrsReloadVhostRealtime | SrsReloadVhostPublish);
 
     srs_trace("connected stream, tcUrl=%s, pageUrl=%s, swfUrl=%s, schema=%s, vhost=%s, port=%d, app=%s, stream=%s, param=%s, args=%s",
         req->tcUrl.c_str(), req->pageUrl.c_str(), req->swfUrl.c_str(), req->schema.c_str(), req->vhost.c_str(), req->port,
@@ -500,6 +503,9 @@ srs_error_t SrsRtmpConn::stream_service_cycle()
     }
     srs_assert(source != NULL);
     
+    // Never retire the source when serving it.
+    SrsSourceRef source_ref(source);
+    
     // update the statistic when source disconveried.
     SrsStatistic* stat = SrsStatistic::instance();
     if ((err = stat->on_client(_srs_context->get_id(), req, this, info->type)) != srs_success) {
@@ -644,9 +650,16 @@ srs_error_t SrsRtmpConn::playing(SrsSource* source)
     // Set the socket options for transport.
     set_sock_options();
     
-    // Create a consumer of source.
+    // Create a consumer of source, and the caches are pre-encoded chunks to send in a burst,
+    // except the duration of play is specified, which is collected for each message.
     SrsConsumer* consumer = NULL;
-    if ((err = source->create_consumer(this, consumer)) != srs_success) {
+    std::vector<SrsSharedPtrMessage*> burst;
+    if (req->duration > 0) {
+        err = source->create_consumer(this, consumer);
+    } else {
+        err = source->create_consumer(this, consumer, SrsBurstFormatRtmp, info->res->stream_id, rtmp->get_chunk_size(), burst);
+    }
+    if (err != srs_success) {
         return srs_error_wrap(err, "rtmp: create consumer");
     }
     SrsAutoFree(SrsConsumer, consumer);
@@ -656,12 +669,29 @@ srs_error_t SrsRtmpConn::playing(SrsSource* source)
     SrsQueueRecvThread trd(consumer, rtmp, SRS_PERF_MW_SLEEP, _srs_context->get_id());
     
     if ((err = trd.start()) != srs_success) {
+        for (int i = 0; i < (int)burst.size(); i++) {
+            SrsSharedPtrMessage* msg = burst[i];
+            srs_freep(msg);
+        }
         return srs_error_wrap(err, "rtmp: start receive thread");
     }
     
+    // Sendout the caches in a burst, all messages are freed by send_and_free_chunks().
+    if (!burst.empty() && (err = rtmp->send_and_free_chunks(&burst[0], (int)burst.size())) != srs_success) {
+        trd.stop();
+        return srs_error_wrap(err, "rtmp: send burst %d messages", (int)burst.size());
+    }
+    
+    // Switch the consumer between the renditions of stream, for ABR.
+    SrsAbrSwitcher abr(this);
+    if ((err = abr.initialize(req, source, consumer)) != srs_success) {
+        trd.stop();
+        return srs_error_wrap(err, "rtmp: init abr");
+    }
+    
     // Deliver packets to peer.
     wakable = consumer;
-    err = do_playing(source, consumer, &trd);
+    err = do_playing(source, consumer, &trd, &abr);
     wakable = NULL;
     
     trd.stop();
@@ -674,7 +704,7 @@ srs_error_t SrsRtmpConn::playing(SrsSource* source)
     return err;
 }
 
-srs_error_t SrsRtmpConn::do_playing(SrsSource* source, SrsConsumer* consumer, SrsQueueRecvThread* rtrd)
+srs_error_t SrsRtmpConn::do_playing(SrsSource* source, SrsConsumer* consumer, SrsQueueRecvThread* rtrd, SrsAbrSwitcher* abr)
 {
     srs_error_t err = srs_success;
     
@@ -698,9 +728,19 @@ srs_error_t SrsRtmpConn::do_playing(SrsSource* source, SrsConsumer* consumer, Sr
     change_mw_sleep(_srs_config->get_mw_sleep(req->vhost));
     // initialize the send_min_interval
     send_min_interval = _srs_config->get_send_min_interval(req->vhost);
+    // limit the unsent bytes in kernel, and pace the messages at the delivery rate.
+    int notsent_lowat = _srs_config->get_notsent_lowat(req->vhost);
+    if (notsent_lowat > 0 && (err = set_notsent_lowat(notsent_lowat)) != srs_success) {
+        return srs_error_wrap(err, "rtmp: set notsent lowat");
+    }
+    SrsTcpPacer pacer(this);
+    pacer.set_enabled(_srs_config->get_pacing(req->vhost));
+    // trace the latency of messages, when traced by publisher.
+    SrsLatencyTracer tracer(_srs_context->get_id());
     
-    srs_trace("start play smi=%dms, mw_sleep=%d, mw_enabled=%d, realtime=%d, tcp_nodelay=%d",
-        srsu2msi(send_min_interval), srsu2msi(mw_sleep), mw_enabled, realtime, tcp_nodelay);
+    srs_trace("start play smi=%dms, mw_sleep=%d, mw_enabled=%d, realtime=%d, tcp_nodelay=%d, lowat=%d, pacing=%d",
+        srsu2msi(send_min_interval), srsu2msi(mw_sleep), mw_enabled, realtime, tcp_nodelay, notsent_lowat,
+        _srs_config->get_pacing(req->vhost));
     
     while (true) {
         // when source is set to expired, disconnect it.
@@ -726,6 +766,15 @@ srs_error_t SrsRtmpConn::do_playing(SrsSource* source, SrsConsumer* consumer, Sr
             return srs_error_wrap(err, "rtmp: recv thread");
         }
         
+        // Switch the rendition by the depth of queue and throughput.
+        if ((err = abr->cycle()) != srs_success) {
+            return srs_error_wrap(err, "rtmp: abr");
+        }
+        
+        // Drop the video frames by the occupancy of socket send buffer.
+        SrsFrameDropper* dropper = consumer->get_dropper();
+        dropper->set_occupancy(get_send_occupancy());
+        
 #ifdef SRS_PERF_QUEUE_COND_WAIT
         // wait for message to incoming.
         // @see https://github.com/ossrs/srs/issues/251
@@ -750,9 +799,14 @@ srs_error_t SrsRtmpConn::do_playing(SrsSource* source, SrsConsumer* consumer, Sr
         // reportable
         if (pprint->can_print()) {
             kbps->sample();
-            srs_trace("-> " SRS_CONSTS_LOG_PLAY " time=%d, msgs=%d, okbps=%d,%d,%d, ikbps=%d,%d,%d, mw=%d",
+            srs_trace("-> " SRS_CONSTS_LOG_PLAY " time=%d, msgs=%d, okbps=%d,%d,%d, ikbps=%d,%d,%d, mw=%d, drop=%d,%d,%d",
                 (int)pprint->age(), count, kbps->get_send_kbps(), kbps->get_send_kbps_30s(), kbps->get_send_kbps_5m(),
-                kbps->get_recv_kbps(), kbps->get_recv_kbps_30s(), kbps->get_recv_kbps_5m(), srsu2msi(mw_sleep));
+                kbps->get_recv_kbps(), kbps->get_recv_kbps_30s(), kbps->get_recv_kbps_5m(), srsu2msi(mw_sleep),
+                (int)dropper->nn_bframes, (int)dropper->nn_nonrefs, (int)dropper->nn_gop_frames);
+            
+            if ((err = dropper->report(req)) != srs_success) {
+                return srs_error_wrap(err, "rtmp: report drop");
+            }
         }
         
         if (count <= 0) {
@@ -779,11 +833,23 @@ srs_error_t SrsRtmpConn::do_playing(SrsSource* source, SrsConsumer* consumer, Sr
             }
         }
         
+        // the bytes to pace, for messages are freed when sent.
+        int64_t nb_bytes = 0;
+        for (int i = 0; i < count; i++) {
+            nb_bytes += msgs.msgs[i]->size;
+        }
+        tracer.on_dump(msgs.msgs, count);
+        
         // sendout messages, all messages are freed by send_and_free_messages().
         // no need to assert msg, for the rtmp will assert it.
         if (count > 0 && (err = rtmp->send_and_free_messages(msgs.msgs, count, info->res->stream_id)) != srs_success) {
             return srs_error_wrap(err, "rtmp: send %d messages", count);
         }
+        tracer.on_sent();
+        
+        if ((err = pacer.on_sent(nb_bytes)) != srs_success) {
+            return srs_error_wrap(err, "rtmp: pacing");
+        }
         
         // if duration specified, and exceed it, stop play live.
         // @see: https://github.com/ossrs/srs/issues/45
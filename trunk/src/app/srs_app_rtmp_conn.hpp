@@ -50,6 +50,7 @@ class SrsRtmpClient;
 class SrsSharedPtrMessage;
 class SrsQueueRecvThread;
 class SrsPublishRecvThread;
+class SrsAbrSwitcher;
 class SrsSecurity;
 class ISrsWakable;
 class SrsCommonMessage;
@@ -141,7 +142,7 @@ private:
     virtual srs_error_t stream_service_cycle();
     virtual srs_error_t check_vhost(bool try_default_vhost);
     virtual srs_error_t playing(SrsSource* source);
-    virtual srs_error_t do_playing(SrsSource* source, SrsConsumer* consumer, SrsQueueRecvThread* trd);
+    virtual srs_error_t do_playing(SrsSource* source, SrsConsumer* consumer, SrsQueueRecvThread* trd, SrsAbrSwitcher* abr);
     virtual srs_error_t publishing(SrsSource* source);
     virtual srs_error_t do_publishing(SrsSource* source, SrsPublishRecvThread* trd);
     virtual srs_error_t acquire_publish(SrsSource* source);
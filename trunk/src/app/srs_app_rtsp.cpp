@@ -46,21 +46,29 @@ using namespace std;
 #include <srs_protocol_utility.hpp>
 #include <srs_protocol_format.hpp>
 
-SrsRtpConn::SrsRtpConn(SrsRtspConn* r, int p, int sid)
+// The max number of rtp packets to reorder, about 1s for 4Mbps video.
+#define SRS_RTP_JITTER_CAPACITY 512
+
+SrsRtpConn::SrsRtpConn(SrsRtspConn* r, int p, int sid, srs_utime_t latency)
 {
     rtsp = r;
     _port = p;
     stream_id = sid;
     // TODO: support listen at <[ip:]port>
-    listener = new SrsUdpListener(this, srs_any_address_for_listener(), p);
-    cache = new SrsRtpPacket();
+    listener = NULL;
+    if (p > 0) {
+        listener = new SrsUdpListener(this, srs_any_address_for_listener(), p);
+    }
+    jitter = new SrsRtpJitterBuffer(SRS_RTP_JITTER_CAPACITY, latency);
+    assembler = new SrsRtpFrameAssembler();
     pprint = SrsPithyPrint::create_caster();
 }
 
 SrsRtpConn::~SrsRtpConn()
 {
     srs_freep(listener);
-    srs_freep(cache);
+    srs_freep(jitter);
+    srs_freep(assembler);
     srs_freep(pprint);
 }
 
@@ -71,60 +79,75 @@ int SrsRtpConn::port()
 
 srs_error_t SrsRtpConn::listen()
 {
+    // rtp over rtsp(tcp), never listen.
+    if (!listener) {
+        return srs_success;
+    }
+    
     return listener->listen();
 }
 
-srs_error_t SrsRtpConn::on_udp_packet(const sockaddr* from, const int fromlen, char* buf, int nb_buf)
+srs_error_t SrsRtpConn::on_rtp(char* buf, int nb_buf)
 {
     srs_error_t err = srs_success;
     
     pprint->elapse();
     
-    if (true) {
-        SrsBuffer stream(buf, nb_buf);
-        
-        SrsRtpPacket pkt;
-        if ((err = pkt.decode(&stream)) != srs_success) {
-            return srs_error_wrap(err, "decode");
-        }
+    // decode to a reused packet.
+    SrsRtpPacket* pkt = jitter->alloc();
+    
+    SrsBuffer stream(buf, nb_buf);
+    if ((err = pkt->decode(&stream)) != srs_success) {
+        jitter->recycle(pkt);
+        return srs_error_wrap(err, "decode");
+    }
+    
+    // reorder the packets, deliver the packets in order.
+    srs_utime_t now = srs_get_system_time();
+    jitter->push(pkt, now);
+    
+    while ((pkt = jitter->pop(now)) != NULL) {
+        err = consume(pkt);
+        jitter->recycle(pkt);
         
-        if (pkt.chunked) {
-            if (!cache) {
-                cache = new SrsRtpPacket();
-            }
-            cache->copy(&pkt);
-            cache->payload->append(pkt.payload->bytes(), pkt.payload->length());
-            if (!cache->completed && pprint->can_print()) {
-                srs_trace("<- " SRS_CONSTS_LOG_STREAM_CASTER " rtsp: rtp chunked %dB, age=%d, vt=%d/%u, sts=%u/%#x/%#x, paylod=%dB",
-                          nb_buf, pprint->age(), cache->version, cache->payload_type, cache->sequence_number, cache->timestamp, cache->ssrc,
-                          cache->payload->length()
-                          );
-                return err;
-            }
-        } else {
-            srs_freep(cache);
-            cache = new SrsRtpPacket();
-            cache->reap(&pkt);
+        if (err != srs_success) {
+            return srs_error_wrap(err, "consume");
         }
     }
     
+    return err;
+}
+
+srs_error_t SrsRtpConn::consume(SrsRtpPacket* pkt)
+{
+    srs_error_t err = srs_success;
+    
+    SrsRtpPacket* msg = assembler->assemble(pkt);
+    if (!msg) {
+        return err;
+    }
+    
     if (pprint->can_print()) {
-        srs_trace("<- " SRS_CONSTS_LOG_STREAM_CASTER " rtsp: rtp #%d %dB, age=%d, vt=%d/%u, sts=%u/%u/%#x, paylod=%dB, chunked=%d",
-                  stream_id, nb_buf, pprint->age(), cache->version, cache->payload_type, cache->sequence_number, cache->timestamp, cache->ssrc,
-                  cache->payload->length(), cache->chunked
+        srs_trace("<- " SRS_CONSTS_LOG_STREAM_CASTER " rtsp: rtp #%d, age=%d, vt=%d/%u, sts=%u/%u/%#x, paylod=%dB, chunked=%d, "
+                  "recv=%" PRId64 ", lost=%" PRId64 ", reorder=%" PRId64 ", drop=%" PRId64 "/%" PRId64 ", jitter=%d",
+                  stream_id, pprint->age(), msg->version, msg->payload_type, msg->sequence_number, msg->timestamp, msg->ssrc,
+                  msg->payload->length(), msg->chunked, jitter->nn_received, jitter->nn_lost, jitter->nn_reordered,
+                  jitter->nn_dropped, assembler->nn_dropped, jitter->size()
                   );
     }
     
-    // always free it.
-    SrsAutoFree(SrsRtpPacket, cache);
-    
-    if ((err = rtsp->on_rtp_packet(cache, stream_id)) != srs_success) {
+    if ((err = rtsp->on_rtp_packet(msg, stream_id)) != srs_success) {
         return srs_error_wrap(err, "process rtp packet");
     }
     
     return err;
 }
 
+srs_error_t SrsRtpConn::on_udp_packet(const sockaddr* from, const int fromlen, char* buf, int nb_buf)
+{
+    return on_rtp(buf, nb_buf);
+}
+
 SrsRtspAudioCache::SrsRtspAudioCache()
 {
     dts = 0;
@@ -175,18 +198,21 @@ srs_error_t SrsRtspJitter::correct(int64_t& ts)
     return err;
 }
 
-SrsRtspConn::SrsRtspConn(SrsRtspCaster* c, srs_netfd_t fd, std::string o)
+SrsRtspConn::SrsRtspConn(SrsRtspCaster* c, srs_netfd_t fd, std::string o, srs_utime_t l)
 {
     output_template = o;
     
     session = "";
     video_rtp = NULL;
     audio_rtp = NULL;
+    video_interleaved = -1;
+    audio_interleaved = -1;
     
+    rtp_latency = l;
     caster = c;
     stfd = fd;
     skt = new SrsStSocket();
-    rtsp = new SrsRtspStack(skt);
+    rtsp = new SrsRtspStack(skt, this);
     trd = new SrsSTCoroutine("rtsp", this);
     
     req = NULL;
@@ -300,27 +326,37 @@ srs_error_t SrsRtspConn::do_cycle()
             }
         } else if (req->is_setup()) {
             srs_assert(req->transport);
+            
+            // rtp over rtsp(tcp), use the channel of client, or by the stream id.
+            bool interleaved = req->transport->lower_transport == "TCP";
+            int channel = req->transport->interleaved_min;
+            if (interleaved && channel < 0) {
+                channel = (req->stream_id == video_id)? 0 : 2;
+            }
+            
             int lpm = 0;
-            if ((err = caster->alloc_port(&lpm)) != srs_success) {
+            if (!interleaved && (err = caster->alloc_port(&lpm)) != srs_success) {
                 return srs_error_wrap(err, "alloc port");
             }
             
             SrsRtpConn* rtp = NULL;
             if (req->stream_id == video_id) {
                 srs_freep(video_rtp);
-                rtp = video_rtp = new SrsRtpConn(this, lpm, video_id);
+                rtp = video_rtp = new SrsRtpConn(this, lpm, video_id, rtp_latency);
+                video_interleaved = interleaved? channel : -1;
             } else {
                 srs_freep(audio_rtp);
-                rtp = audio_rtp = new SrsRtpConn(this, lpm, audio_id);
+                rtp = audio_rtp = new SrsRtpConn(this, lpm, audio_id, rtp_latency);
+                audio_interleaved = interleaved? channel : -1;
             }
             if ((err = rtp->listen()) != srs_success) {
                 return srs_error_wrap(err, "rtp listen");
             }
-            srs_trace("rtsp: #%d %s over %s/%s/%s %s client-port=%d-%d, server-port=%d-%d",
+            srs_trace("rtsp: #%d %s over %s/%s/%s %s client-port=%d-%d, server-port=%d-%d, interleaved=%d",
                 req->stream_id, (req->stream_id == video_id)? "Video":"Audio",
                 req->transport->transport.c_str(), req->transport->profile.c_str(), req->transport->lower_transport.c_str(),
                 req->transport->cast_type.c_str(), req->transport->client_port_min, req->transport->client_port_max,
-                lpm, lpm + 1);
+                lpm, lpm + 1, interleaved? channel : -1);
             
             // create session.
             if (session.empty()) {
@@ -332,6 +368,10 @@ srs_error_t SrsRtspConn::do_cycle()
             res->client_port_max = req->transport->client_port_max;
             res->local_port_min = lpm;
             res->local_port_max = lpm + 1;
+            if (interleaved) {
+                res->interleaved_min = channel;
+                res->interleaved_max = channel + 1;
+            }
             res->session = session;
             if ((err = rtsp->send_message(res)) != srs_success) {
                 return srs_error_wrap(err, "response setup");
@@ -381,6 +421,20 @@ srs_error_t SrsRtspConn::on_rtp_packet(SrsRtpPacket* pkt, int stream_id)
     return err;
 }
 
+srs_error_t SrsRtspConn::on_interleaved(int channel, char* data, int size)
+{
+    // the rtcp over odd channel is ignored.
+    if (video_rtp && channel == video_interleaved) {
+        return video_rtp->on_rtp(data, size);
+    }
+    
+    if (audio_rtp && channel == audio_interleaved) {
+        return audio_rtp->on_rtp(data, size);
+    }
+    
+    return srs_success;
+}
+
 srs_error_t SrsRtspConn::cycle()
 {
     // serve the rtsp client.
@@ -395,11 +449,11 @@ srs_error_t SrsRtspConn::cycle()
         srs_freep(err);
     }
     
-    if (video_rtp) {
+    if (video_rtp && video_rtp->port() > 0) {
         caster->free_port(video_rtp->port(), video_rtp->port() + 1);
     }
     
-    if (audio_rtp) {
+    if (audio_rtp && audio_rtp->port() > 0) {
         caster->free_port(audio_rtp->port(), audio_rtp->port() + 1);
     }
     
@@ -433,13 +487,10 @@ srs_error_t SrsRtspConn::on_rtp_audio(SrsRtpPacket* pkt, int64_t dts)
         return srs_error_wrap(err, "kickoff audio cache");
     }
     
-    // cache current audio to kickoff.
+    // cache current audio to kickoff, swap the kicked off cache to the packet to reuse.
     acache->dts = dts;
-    acache->audio = pkt->audio;
-    acache->payload = pkt->payload;
-    
-    pkt->audio = NULL;
-    pkt->payload = NULL;
+    std::swap(acache->audio, pkt->audio);
+    std::swap(acache->payload, pkt->payload);
     
     return err;
 }
@@ -449,7 +500,7 @@ srs_error_t SrsRtspConn::kickoff_audio_cache(SrsRtpPacket* pkt, int64_t dts)
     srs_error_t err = srs_success;
     
     // nothing to kick off.
-    if (!acache->payload) {
+    if (!acache->audio || !acache->audio->nb_samples) {
         return err;
     }
     
@@ -466,9 +517,10 @@ srs_error_t SrsRtspConn::kickoff_audio_cache(SrsRtpPacket* pkt, int64_t dts)
         }
     }
     
+    // reuse the cache, the payload holds the bytes of samples.
     acache->dts = 0;
-    srs_freep(acache->audio);
-    srs_freep(acache->payload);
+    acache->audio->nb_samples = 0;
+    acache->payload->erase(acache->payload->length());
     
     return err;
 }
@@ -680,6 +732,7 @@ SrsRtspCaster::SrsRtspCaster(SrsConfDirective* c)
     output = _srs_config->get_stream_caster_output(c);
     local_port_min = _srs_config->get_stream_caster_rtp_port_min(c);
     local_port_max = _srs_config->get_stream_caster_rtp_port_max(c);
+    rtp_latency = _srs_config->get_stream_caster_rtp_latency(c);
 }
 
 SrsRtspCaster::~SrsRtspCaster()
@@ -723,7 +776,7 @@ srs_error_t SrsRtspCaster::on_tcp_client(srs_netfd_t stfd)
 {
     srs_error_t err = srs_success;
     
-    SrsRtspConn* conn = new SrsRtspConn(this, stfd, output);
+    SrsRtspConn* conn = new SrsRtspConn(this, stfd, output, rtp_latency);
     
     if ((err = conn->serve()) != srs_success) {
         srs_freep(conn);
@@ -33,6 +33,7 @@
 #include <srs_app_st.hpp>
 #include <srs_app_thread.hpp>
 #include <srs_app_listener.hpp>
+#include <srs_rtsp_stack.hpp>
 
 class SrsStSocket;
 class SrsRtspConn;
@@ -40,6 +41,8 @@ class SrsRtspStack;
 class SrsRtspCaster;
 class SrsConfDirective;
 class SrsRtpPacket;
+class SrsRtpJitterBuffer;
+class SrsRtpFrameAssembler;
 class SrsRequest;
 class SrsStSocket;
 class SrsRtmpClient;
@@ -59,15 +62,24 @@ private:
     SrsPithyPrint* pprint;
     SrsUdpListener* listener;
     SrsRtspConn* rtsp;
-    SrsRtpPacket* cache;
+    // To reorder the rtp packets, and reuse them.
+    SrsRtpJitterBuffer* jitter;
+    // To assemble the chunked packets, such as H.264 FU-A.
+    SrsRtpFrameAssembler* assembler;
     int stream_id;
     int _port;
 public:
-    SrsRtpConn(SrsRtspConn* r, int p, int sid);
+    // @param p The udp port to listen, 0 for rtp over rtsp(tcp) which never listen.
+    // @param latency The max time to wait for the lost packets.
+    SrsRtpConn(SrsRtspConn* r, int p, int sid, srs_utime_t latency);
     virtual ~SrsRtpConn();
 public:
     virtual int port();
     virtual srs_error_t listen();
+    // When got a rtp packet, from udp or interleaved in rtsp.
+    virtual srs_error_t on_rtp(char* buf, int nb_buf);
+private:
+    virtual srs_error_t consume(SrsRtpPacket* pkt);
 // Interface ISrsUdpHandler
 public:
     virtual srs_error_t on_udp_packet(const sockaddr* from, const int fromlen, char* buf, int nb_buf);
@@ -100,7 +112,7 @@ public:
 };
 
 // The rtsp connection serve the fd.
-class SrsRtspConn : public ISrsCoroutineHandler
+class SrsRtspConn : public ISrsCoroutineHandler, public ISrsRtspInterleavedHandler
 {
 private:
     std::string output_template;
@@ -112,13 +124,17 @@ private:
     int video_id;
     std::string video_codec;
     SrsRtpConn* video_rtp;
+    // The rtp channel for rtp over rtsp(tcp), -1 for udp.
+    int video_interleaved;
     // audio stream.
     int audio_id;
     std::string audio_codec;
     int audio_sample_rate;
     int audio_channel;
     SrsRtpConn* audio_rtp;
+    int audio_interleaved;
 private:
+    srs_utime_t rtp_latency;
     srs_netfd_t stfd;
     SrsStSocket* skt;
     SrsRtspStack* rtsp;
@@ -139,7 +155,7 @@ private:
     std::string aac_specific_config;
     SrsRtspAudioCache* acache;
 public:
-    SrsRtspConn(SrsRtspCaster* c, srs_netfd_t fd, std::string o);
+    SrsRtspConn(SrsRtspCaster* c, srs_netfd_t fd, std::string o, srs_utime_t l);
     virtual ~SrsRtspConn();
 public:
     virtual srs_error_t serve();
@@ -148,6 +164,9 @@ private:
 // internal methods
 public:
     virtual srs_error_t on_rtp_packet(SrsRtpPacket* pkt, int stream_id);
+// Interface ISrsRtspInterleavedHandler
+public:
+    virtual srs_error_t on_interleaved(int channel, char* data, int size);
 // Interface ISrsOneCycleThreadHandler
 public:
     virtual srs_error_t cycle();
@@ -175,6 +194,7 @@ private:
     std::string output;
     int local_port_min;
     int local_port_max;
+    srs_utime_t rtp_latency;
     // The key: port, value: whether used.
     std::map<int, bool> used_ports;
 private:
@@ -30,6 +30,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <algorithm>
+#include <st.h>
 #ifndef SRS_AUTO_OSX
 #include <sys/inotify.h>
 #endif
@@ -49,6 +50,7 @@ using namespace std;
 #include <srs_app_mpegts_udp.hpp>
 #include <srs_app_rtsp.hpp>
 #include <srs_app_statistic.hpp>
+#include <srs_app_shm_stat.hpp>
 #include <srs_app_caster_flv.hpp>
 #include <srs_core_mem_watch.hpp>
 #include <srs_kernel_consts.hpp>
@@ -634,7 +636,8 @@ SrsServer::SrsServer()
     http_api_mux = new SrsHttpServeMux();
     http_server = new SrsHttpServer(this);
     http_heartbeat = new SrsHttpHeartbeat();
-    ingester = new SrsIngester();
+    ingester = new SrsIngester(this);
+    shm_stat = NULL;
 }
 
 SrsServer::~SrsServer()
@@ -680,6 +683,9 @@ void SrsServer::dispose()
     // dispose the source for hls and dvr.
     _srs_sources->dispose();
     
+    // Remove the segment of statistic.
+    srs_freep(shm_stat);
+    
     // @remark don't dispose all connections, for too slow.
     
 #ifdef SRS_AUTO_MEM_WATCH
@@ -724,6 +730,9 @@ void SrsServer::gracefully_dispose()
     _srs_sources->dispose();
     srs_trace("source disposed");
 
+    // Remove the segment of statistic.
+    srs_freep(shm_stat);
+
 #ifdef SRS_AUTO_MEM_WATCH
     srs_memory_report();
 #endif
@@ -770,11 +779,20 @@ srs_error_t SrsServer::initialize_st()
         return srs_error_wrap(err, "initialize st failed");
     }
 
+    // The stacks of coroutines, reused by the free list.
+    st_set_stack_pool(_srs_config->get_stack_pool());
+    bool guard = _srs_config->get_stack_guard();
+    st_set_stack_guard(guard);
+    srs_trace("st stack connection=%d, receiver=%d, worker=%d, pool=%d, guard=%d",
+        _srs_config->get_stack_size("connection"), _srs_config->get_stack_size("receiver"),
+        _srs_config->get_stack_size("worker"), _srs_config->get_stack_pool(), guard);
+
     // @remark, st alloc segment use mmap, which only support 32757 threads,
     // if need to support more, for instance, 100k threads, define the macro MALLOC_STACK.
+    // @remark Without the guard pages, the stacks are merged to less mappings.
     // TODO: FIXME: maybe can use "sysctl vm.max_map_count" to refine.
 #define __MMAP_MAX_CONNECTIONS 32756
-    if (_srs_config->get_max_connections() > __MMAP_MAX_CONNECTIONS) {
+    if (guard && _srs_config->get_max_connections() > __MMAP_MAX_CONNECTIONS) {
         srs_error("st mmap for stack allocation must <= %d threads, "
                   "@see Makefile of st for MALLOC_STACK, please build st manually by "
                   "\"make EXTRA_CFLAGS=-DMALLOC_STACK linux-debug\"", __MMAP_MAX_CONNECTIONS);
@@ -955,6 +973,15 @@ srs_error_t SrsServer::http_handle()
     if ((err = http_api_mux->handle("/api/v1/clusters", new SrsGoApiClusters())) != srs_success) {
         return srs_error_wrap(err, "handle raw");
     }
+    if ((err = http_api_mux->handle("/api/v1/origins", new SrsGoApiOrigins())) != srs_success) {
+        return srs_error_wrap(err, "handle origins");
+    }
+    if ((err = http_api_mux->handle("/api/v1/hooks", new SrsGoApiHooks())) != srs_success) {
+        return srs_error_wrap(err, "handle hooks");
+    }
+    if ((err = http_api_mux->handle("/api/v1/profiles", new SrsGoApiProfiles())) != srs_success) {
+        return srs_error_wrap(err, "handle profiles");
+    }
     
     // test the request info.
     if ((err = http_api_mux->handle("/api/v1/tests/requests", new SrsGoApiRequests())) != srs_success) {
@@ -1005,6 +1032,15 @@ srs_error_t SrsServer::cycle()
         return srs_error_wrap(err, "start inotify");
     }
 
+    // Publish the statistic to shared memory, for external readers.
+    string shm = _srs_config->get_stats_shm();
+    if (!shm.empty()) {
+        shm_stat = new SrsShmStatistic();
+        if ((err = shm_stat->initialize(shm, SrsStatistic::instance()->server_id())) != srs_success) {
+            return srs_error_wrap(err, "shm stat");
+        }
+    }
+
     // Do server main cycle.
      err = do_cycle();
     
@@ -1224,6 +1260,10 @@ srs_error_t SrsServer::do_cycle()
                 srs_info("update network server kbps info.");
                 resample_kbps();
             }
+            if (shm_stat) {
+                srs_info("update statistic in shared memory.");
+                SrsStatistic::instance()->dumps_shm(shm_stat);
+            }
             if (_srs_config->get_heartbeat_enabled()) {
                 if ((i % heartbeat_max_resolution) == 0) {
                     srs_info("do http heartbeat, for internal server to report.");
@@ -1625,3 +1665,8 @@ void SrsServer::on_unpublish(SrsSource* s, SrsRequest* r)
     coworkers->on_unpublish(s, r);
 }
 
+void SrsServer::on_retire(SrsSource* s, SrsRequest* r)
+{
+    http_server->http_destroy(s, r);
+}
+
@@ -51,6 +51,7 @@ class SrsUdpListener;
 class SrsTcpListener;
 class SrsAppCasterFlv;
 class SrsCoroutineManager;
+class SrsShmStatistic;
 
 // The listener type for server to identify the connection,
 // that is, use different type to process the connection.
@@ -227,6 +228,8 @@ private:
     SrsHttpHeartbeat* http_heartbeat;
     SrsIngester* ingester;
     SrsCoroutineManager* conn_manager;
+    // The statistic in shared memory, NULL if disabled.
+    SrsShmStatistic* shm_stat;
 private:
     // The pid file fd, lock the file write when server is running.
     // @remark the init.d script should cleanup the pid file, when stop service,
@@ -337,6 +340,7 @@ public:
 public:
     virtual srs_error_t on_publish(SrsSource* s, SrsRequest* r);
     virtual void on_unpublish(SrsSource* s, SrsRequest* r);
+    virtual void on_retire(SrsSource* s, SrsRequest* r);
 };
 
 #endif
@@ -0,0 +1,322 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <srs_app_shm_stat.hpp>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+#include <srs_kernel_error.hpp>
+#include <srs_kernel_log.hpp>
+#include <srs_kernel_utility.hpp>
+
+// The layout is stable, so make sure the compiler never changes the size of structures.
+typedef char srs_shm_stat_header_check[sizeof(SrsShmStatHeader) == 64 ? 1 : -1];
+typedef char srs_shm_stat_server_check[sizeof(SrsShmStatServer) == 64 ? 1 : -1];
+typedef char srs_shm_stat_vhost_check[sizeof(SrsShmStatVhost) == 192 ? 1 : -1];
+typedef char srs_shm_stat_stream_check[sizeof(SrsShmStatStream) == 512 ? 1 : -1];
+
+// The max retries of reader, when the writer is always updating the slot.
+#define SRS_SHM_STAT_READ_RETRIES 16
+
+void srs_shm_stat_write_begin(uint32_t* seq)
+{
+    uint32_t v = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    __atomic_store_n(seq, v + 1, __ATOMIC_RELAXED);
+    // The fields must never be visible before the seq is odd.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void srs_shm_stat_write_end(uint32_t* seq)
+{
+    uint32_t v = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    __atomic_store_n(seq, v + 1, __ATOMIC_RELEASE);
+}
+
+bool srs_shm_stat_read(const void* slot, void* copy, int size)
+{
+    const uint32_t* seq = (const uint32_t*)slot;
+    
+    for (int i = 0; i < SRS_SHM_STAT_READ_RETRIES; i++) {
+        uint32_t v = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        if ((v & 0x01) != 0) {
+            continue;
+        }
+        
+        memcpy(copy, slot, size);
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(seq, __ATOMIC_RELAXED) == v) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+SrsShmStatSlots::SrsShmStatSlots(int m)
+{
+    max = m;
+    nn_used = 0;
+    round = 0;
+}
+
+SrsShmStatSlots::~SrsShmStatSlots()
+{
+}
+
+int SrsShmStatSlots::get(int64_t id)
+{
+    std::map<int64_t, std::pair<int, int64_t> >::iterator it = slots.find(id);
+    if (it != slots.end()) {
+        it->second.second = round;
+        return it->second.first;
+    }
+    
+    int index = -1;
+    if (!frees.empty()) {
+        index = frees.back();
+        frees.pop_back();
+    } else if (nn_used < max) {
+        index = nn_used++;
+    } else {
+        return -1;
+    }
+    
+    slots[id] = std::make_pair(index, round);
+    return index;
+}
+
+void SrsShmStatSlots::sweep(std::vector<int>& freed)
+{
+    std::map<int64_t, std::pair<int, int64_t> >::iterator it;
+    for (it = slots.begin(); it != slots.end();) {
+        if (it->second.second == round) {
+            ++it;
+            continue;
+        }
+        
+        frees.push_back(it->second.first);
+        freed.push_back(it->second.first);
+        slots.erase(it++);
+    }
+    
+    round++;
+}
+
+int SrsShmStatSlots::size()
+{
+    return nn_used;
+}
+
+SrsShmStatistic::SrsShmStatistic()
+{
+    owner = false;
+    fd = -1;
+    data = NULL;
+    size = sizeof(SrsShmStatHeader) + sizeof(SrsShmStatServer)
+        + SRS_SHM_STAT_MAX_VHOSTS * sizeof(SrsShmStatVhost)
+        + SRS_SHM_STAT_MAX_STREAMS * sizeof(SrsShmStatStream);
+    vhost_slots = new SrsShmStatSlots(SRS_SHM_STAT_MAX_VHOSTS);
+    stream_slots = new SrsShmStatSlots(SRS_SHM_STAT_MAX_STREAMS);
+}
+
+SrsShmStatistic::~SrsShmStatistic()
+{
+    if (data) {
+        ::munmap(data, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    
+    // Remove the segment, so the reader never gets the stale statistic.
+    if (owner) {
+        ::unlink(path.c_str());
+    }
+    
+    srs_freep(vhost_slots);
+    srs_freep(stream_slots);
+}
+
+srs_error_t SrsShmStatistic::initialize(string p, int64_t server_id)
+{
+    srs_error_t err = srs_success;
+    
+    path = p;
+    
+    // Always create a new file, because the reader may still map the old one of previous server.
+    ::unlink(path.c_str());
+    if ((fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) < 0) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "open %s", path.c_str());
+    }
+    owner = true;
+    
+    if (::ftruncate(fd, size) < 0) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "truncate %s to %d", path.c_str(), size);
+    }
+    
+    if ((err = map(true)) != srs_success) {
+        return srs_error_wrap(err, "map");
+    }
+    
+    // The file is zero filled, so all slots are unused.
+    SrsShmStatHeader* h = header();
+    h->version = SRS_SHM_STAT_VERSION;
+    h->header_size = sizeof(SrsShmStatHeader);
+    h->server_size = sizeof(SrsShmStatServer);
+    h->vhost_size = sizeof(SrsShmStatVhost);
+    h->stream_size = sizeof(SrsShmStatStream);
+    h->max_vhosts = SRS_SHM_STAT_MAX_VHOSTS;
+    h->max_streams = SRS_SHM_STAT_MAX_STREAMS;
+    h->server_id = server_id;
+    h->pid = (int32_t)::getpid();
+    h->create_ms = srsu2ms(srs_get_system_time());
+    
+    // Write the magic at last, the reader should check it before others.
+    __atomic_store_n(&h->magic, SRS_SHM_STAT_MAGIC, __ATOMIC_RELEASE);
+    
+    srs_trace("shm stat: segment %s, size=%d, vhosts=%d, streams=%d", path.c_str(), size,
+        SRS_SHM_STAT_MAX_VHOSTS, SRS_SHM_STAT_MAX_STREAMS);
+    
+    return err;
+}
+
+srs_error_t SrsShmStatistic::open(string p)
+{
+    srs_error_t err = srs_success;
+    
+    path = p;
+    
+    if ((fd = ::open(path.c_str(), O_RDONLY)) < 0) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "open %s", path.c_str());
+    }
+    
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || st.st_size < size) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "invalid size of %s, expect %d", path.c_str(), size);
+    }
+    
+    if ((err = map(false)) != srs_success) {
+        return srs_error_wrap(err, "map");
+    }
+    
+    SrsShmStatHeader* h = header();
+    if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != SRS_SHM_STAT_MAGIC || h->version != SRS_SHM_STAT_VERSION) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "invalid magic=%#x, version=%d", h->magic, h->version);
+    }
+    if (h->header_size != sizeof(SrsShmStatHeader) || h->server_size != sizeof(SrsShmStatServer)
+        || h->vhost_size != sizeof(SrsShmStatVhost) || h->stream_size != sizeof(SrsShmStatStream)
+        || h->max_vhosts != SRS_SHM_STAT_MAX_VHOSTS || h->max_streams != SRS_SHM_STAT_MAX_STREAMS) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "invalid layout");
+    }
+    
+    return err;
+}
+
+SrsShmStatHeader* SrsShmStatistic::header()
+{
+    return (SrsShmStatHeader*)data;
+}
+
+SrsShmStatServer* SrsShmStatistic::server()
+{
+    return (SrsShmStatServer*)(data + sizeof(SrsShmStatHeader));
+}
+
+SrsShmStatVhost* SrsShmStatistic::vhost_at(int index)
+{
+    if (index < 0 || index >= SRS_SHM_STAT_MAX_VHOSTS) {
+        return NULL;
+    }
+    
+    SrsShmStatVhost* vhosts = (SrsShmStatVhost*)(data + sizeof(SrsShmStatHeader) + sizeof(SrsShmStatServer));
+    return vhosts + index;
+}
+
+SrsShmStatStream* SrsShmStatistic::stream_at(int index)
+{
+    if (index < 0 || index >= SRS_SHM_STAT_MAX_STREAMS) {
+        return NULL;
+    }
+    
+    SrsShmStatStream* streams = (SrsShmStatStream*)(data + sizeof(SrsShmStatHeader) + sizeof(SrsShmStatServer)
+        + SRS_SHM_STAT_MAX_VHOSTS * sizeof(SrsShmStatVhost));
+    return streams + index;
+}
+
+SrsShmStatVhost* SrsShmStatistic::vhost_slot(int64_t id)
+{
+    return vhost_at(vhost_slots->get(id));
+}
+
+SrsShmStatStream* SrsShmStatistic::stream_slot(int64_t id)
+{
+    return stream_at(stream_slots->get(id));
+}
+
+void SrsShmStatistic::sweep()
+{
+    std::vector<int> freed;
+    
+    vhost_slots->sweep(freed);
+    for (int i = 0; i < (int)freed.size(); i++) {
+        SrsShmStatVhost* v = vhost_at(freed[i]);
+        srs_shm_stat_write_begin(&v->seq);
+        v->used = 0;
+        srs_shm_stat_write_end(&v->seq);
+    }
+    
+    freed.clear();
+    stream_slots->sweep(freed);
+    for (int i = 0; i < (int)freed.size(); i++) {
+        SrsShmStatStream* v = stream_at(freed[i]);
+        srs_shm_stat_write_begin(&v->seq);
+        v->used = 0;
+        srs_shm_stat_write_end(&v->seq);
+    }
+    
+    SrsShmStatServer* s = server();
+    srs_shm_stat_write_begin(&s->seq);
+    s->nb_vhost_slots = vhost_slots->size();
+    s->nb_stream_slots = stream_slots->size();
+    srs_shm_stat_write_end(&s->seq);
+}
+
+srs_error_t SrsShmStatistic::map(bool writable)
+{
+    int prot = writable? PROT_READ | PROT_WRITE : PROT_READ;
+    
+    void* p = ::mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        return srs_error_new(ERROR_SYSTEM_SHM_STAT, "mmap %s, size=%d", path.c_str(), size);
+    }
+    
+    data = (char*)p;
+    return srs_success;
+}
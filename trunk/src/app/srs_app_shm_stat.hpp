@@ -0,0 +1,229 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef SRS_APP_SHM_STAT_HPP
+#define SRS_APP_SHM_STAT_HPP
+
+#include <srs_core.hpp>
+
+#include <string>
+#include <map>
+#include <vector>
+
+// The statistic plane in shared memory, for external readers such as a sidecar exporter, to scrape the
+// statistic at high frequency without the HTTP API, which competes with the media in the ST scheduler.
+//
+// The layout of segment, all fields are native endian and never moved in a version:
+//      SrsShmStatHeader, 64B, the fixed header of segment.
+//      SrsShmStatServer, 64B, the summary of server.
+//      SrsShmStatVhost[max_vhosts], 192B each.
+//      SrsShmStatStream[max_streams], 512B each.
+// New fields only take the reserved bytes, otherwise the version is increased.
+//
+// Each of server, vhost and stream is protected by a seqlock, which is the first field seq. The writer
+// makes seq odd before updating and even after, so the reader should:
+//      1. Load seq with acquire, retry if it's odd.
+//      2. Copy the slot.
+//      3. Load seq again after an acquire fence, retry if it changed.
+// The srs_shm_stat_read is an implementation, and the slot is unused when its used is 0.
+//
+// Each vhost and stream keeps its slot for its lifetime, so the reader is able to track it by the index.
+// The slot of a removed one is freed and reused later, with a different id. The reader should scan the
+// slots before nb_vhost_slots and nb_stream_slots of server, and skip the unused ones.
+#define SRS_SHM_STAT_MAGIC 0x53525353 // SRSS
+#define SRS_SHM_STAT_VERSION 1
+#define SRS_SHM_STAT_MAX_VHOSTS 64
+#define SRS_SHM_STAT_MAX_STREAMS 4096
+
+// The header of segment, written once when created.
+struct SrsShmStatHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    // The size of structures, for reader to check the layout.
+    uint32_t header_size;
+    uint32_t server_size;
+    uint32_t vhost_size;
+    uint32_t stream_size;
+    // The number of slots for vhosts and streams.
+    uint32_t max_vhosts;
+    uint32_t max_streams;
+    // The server id, changed when server restart, see SrsStatistic::server_id.
+    int64_t server_id;
+    int32_t pid;
+    int32_t reserved0;
+    // The time in ms when segment created.
+    int64_t create_ms;
+    char reserved[8];
+};
+
+struct SrsShmStatServer
+{
+    uint32_t seq;
+    uint32_t reserved0;
+    // The time in ms when the statistic updated.
+    int64_t update_ms;
+    int64_t recv_bytes;
+    int64_t send_bytes;
+    int32_t recv_kbps_30s;
+    int32_t send_kbps_30s;
+    // The number of vhosts, streams and clients, where the vhosts and streams may exceed the slots.
+    int32_t nb_vhosts;
+    int32_t nb_streams;
+    int32_t nb_clients;
+    // The number of slots ever used, the slots after them are never used.
+    int32_t nb_vhost_slots;
+    int32_t nb_stream_slots;
+    char reserved[4];
+};
+
+struct SrsShmStatVhost
+{
+    uint32_t seq;
+    uint32_t used;
+    int64_t id;
+    // The name of vhost, truncated and terminated by NULL.
+    char name[128];
+    int32_t nb_streams;
+    int32_t nb_clients;
+    int64_t recv_bytes;
+    int64_t send_bytes;
+    int32_t recv_kbps_30s;
+    int32_t send_kbps_30s;
+    char reserved[16];
+};
+
+struct SrsShmStatStream
+{
+    uint32_t seq;
+    uint32_t used;
+    int64_t id;
+    // The id of vhost, see SrsShmStatVhost::id.
+    int64_t vhost_id;
+    // The app and stream name, truncated and terminated by NULL.
+    char app[128];
+    char stream[128];
+    // Whether publishing, and the cid of publisher.
+    int32_t active;
+    int32_t cid;
+    int32_t nb_clients;
+    int32_t reserved0;
+    int64_t nb_frames;
+    int64_t nb_drop_bframes;
+    int64_t nb_drop_nonrefs;
+    int64_t nb_drop_gop_frames;
+    int64_t recv_bytes;
+    int64_t send_bytes;
+    int32_t recv_kbps_30s;
+    int32_t send_kbps_30s;
+    // The video info, the codec is SrsVideoCodecId, the profile and level is SrsAvcProfile and SrsAvcLevel.
+    int32_t has_video;
+    int32_t vcodec;
+    int32_t avc_profile;
+    int32_t avc_level;
+    int32_t width;
+    int32_t height;
+    // The audio info, the codec is SrsAudioCodecId, the sample rate in Hz, the object is SrsAacObjectType.
+    int32_t has_audio;
+    int32_t acodec;
+    int32_t sample_rate;
+    int32_t channels;
+    int32_t aac_object;
+    char reserved[116];
+};
+
+// Start and finish the update of slot by writer, see the seqlock of layout.
+extern void srs_shm_stat_write_begin(uint32_t* seq);
+extern void srs_shm_stat_write_end(uint32_t* seq);
+// Copy the slot of size bytes by reader, which starts by seq.
+// @return false if the writer is updating the slot, so it's not copied.
+extern bool srs_shm_stat_read(const void* slot, void* copy, int size);
+
+// The slots of vhosts or streams, which are allocated by id, and freed to reuse by sweep.
+class SrsShmStatSlots
+{
+private:
+    int max;
+    // The number of slots ever used, the slots from it are never used.
+    int nn_used;
+    // The round of sweep, to find the ids which are not touched.
+    int64_t round;
+    // The index of slot and the round when it's touched, by id.
+    std::map<int64_t, std::pair<int, int64_t> > slots;
+    // The freed slots, which are reused before the never used slots.
+    std::vector<int> frees;
+public:
+    SrsShmStatSlots(int m);
+    virtual ~SrsShmStatSlots();
+public:
+    // Get the index of slot for id, allocate one if new, and mark it touched in this round.
+    // @return -1 if no free slot.
+    virtual int get(int64_t id);
+    // Free the slots which are not touched in this round, and start a new round.
+    // @param freed Append the index of freed slots.
+    virtual void sweep(std::vector<int>& freed);
+    // The number of slots ever used.
+    virtual int size();
+};
+
+// The segment of statistic, mapped from a file, for example, in /dev/shm which is memory.
+class SrsShmStatistic
+{
+private:
+    std::string path;
+    // Whether the segment is created by us, which is removed when disposed.
+    bool owner;
+    int fd;
+    char* data;
+    int size;
+    // The slots of writer, each vhost and stream keeps its slot for its lifetime.
+    SrsShmStatSlots* vhost_slots;
+    SrsShmStatSlots* stream_slots;
+public:
+    SrsShmStatistic();
+    virtual ~SrsShmStatistic();
+public:
+    // Create the segment for writer, truncate the file to size of layout and write the header.
+    virtual srs_error_t initialize(std::string p, int64_t server_id);
+    // Open an existing segment for reader, and check the layout.
+    virtual srs_error_t open(std::string p);
+public:
+    virtual SrsShmStatHeader* header();
+    virtual SrsShmStatServer* server();
+    // Get the slot at index, NULL if exceed the max slots.
+    virtual SrsShmStatVhost* vhost_at(int index);
+    virtual SrsShmStatStream* stream_at(int index);
+public:
+    // Get the slot of vhost or stream by id for writer, allocate one if new.
+    // @return NULL if no free slot.
+    virtual SrsShmStatVhost* vhost_slot(int64_t id);
+    virtual SrsShmStatStream* stream_slot(int64_t id);
+    // Free the slots of the vhosts and streams which are not got since the last sweep, mark them unused
+    // and update the number of slots in server.
+    virtual void sweep();
+private:
+    virtual srs_error_t map(bool writable);
+};
+
+#endif
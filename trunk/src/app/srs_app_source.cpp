@@ -61,9 +61,6 @@ using namespace std;
 // when got these videos or audios, pure audio or video, mix ok.
 #define SRS_MIX_CORRECT_PURE_AV 10
 
-// the time to cleanup source.
-#define SRS_SOURCE_CLEANUP (30 * SRS_UTIME_SECONDS)
-
 int _srs_time_jitter_string2int(std::string time_jitter)
 {
     if (time_jitter == "full") {
@@ -150,6 +147,12 @@ int64_t SrsRtmpJitter::get_time()
     return last_pkt_correct_time;
 }
 
+void SrsRtmpJitter::assign(SrsRtmpJitter* from)
+{
+    last_pkt_time = from->last_pkt_time;
+    last_pkt_correct_time = from->last_pkt_correct_time;
+}
+
 #ifdef SRS_PERF_QUEUE_FAST_VECTOR
 SrsFastVector::SrsFastVector()
 {
@@ -345,6 +348,23 @@ srs_error_t SrsMessageQueue::dump_packets(SrsConsumer* consumer, bool atc, SrsRt
     return err;
 }
 
+int64_t SrsMessageQueue::find_keyframe(int64_t after)
+{
+    for (int i = 0; i < (int)msgs.size(); i++) {
+        SrsSharedPtrMessage* msg = msgs.at(i);
+        
+        if (!msg->is_video() || msg->timestamp <= after) {
+            continue;
+        }
+        
+        if (SrsFlvVideo::keyframe(msg->payload, msg->size) && !SrsFlvVideo::sh(msg->payload, msg->size)) {
+            return msg->timestamp;
+        }
+    }
+    
+    return -1;
+}
+
 void SrsMessageQueue::shrink()
 {
     SrsSharedPtrMessage* video_sh = NULL;
@@ -414,6 +434,205 @@ ISrsWakable::~ISrsWakable()
 {
 }
 
+// The occupancy in percent of socket send buffer, to raise the step to drop frames.
+#define SRS_DROP_OCCUPANCY 90
+
+SrsFrameDropper::SrsFrameDropper()
+{
+    enabled = false;
+    level = SrsDropLevelNone;
+    occupancy = 0;
+    wait_keyframe = false;
+    nalu_length = 4;
+    
+    nn_bframes = nn_nonrefs = nn_gop_frames = 0;
+    reported_bframes = reported_nonrefs = reported_gop_frames = 0;
+}
+
+SrsFrameDropper::~SrsFrameDropper()
+{
+}
+
+void SrsFrameDropper::set_enabled(bool v)
+{
+    enabled = v;
+}
+
+void SrsFrameDropper::set_occupancy(int v)
+{
+    occupancy = v;
+}
+
+SrsDropLevel SrsFrameDropper::current()
+{
+    return level;
+}
+
+void SrsFrameDropper::update(srs_utime_t depth, srs_utime_t max_size)
+{
+    if (!enabled || max_size <= 0) {
+        level = SrsDropLevelNone;
+        return;
+    }
+    
+    // The steps are at 25%, 50% and 75% of queue.
+    int v = (int)(depth * 4 / max_size);
+    
+    // The socket is also congested, raise a step.
+    if (occupancy >= SRS_DROP_OCCUPANCY) {
+        v++;
+    }
+    
+    level = (SrsDropLevel)srs_min(v, (int)SrsDropLevelGop);
+}
+
+bool SrsFrameDropper::drop(SrsSharedPtrMessage* msg)
+{
+    if (!msg->is_video()) {
+        return false;
+    }
+    
+    char* data = msg->payload;
+    int size = msg->size;
+    
+    if (SrsFlvVideo::sh(data, size)) {
+        // The lengthSizeMinusOne of AVCDecoderConfigurationRecord, ISO_IEC_14496-15-AVC-format-2012.pdf, page 16.
+        if (SrsFlvVideo::h264(data, size) && size > 9) {
+            nalu_length = (data[9] & 0x03) + 1;
+        }
+        return false;
+    }
+    
+    // Always restart at the keyframe.
+    if (SrsFlvVideo::keyframe(data, size)) {
+        wait_keyframe = false;
+        return false;
+    }
+    
+    // Never decode the frames util the next keyframe, when any reference frame dropped.
+    if (wait_keyframe || level >= SrsDropLevelGop) {
+        wait_keyframe = true;
+        nn_gop_frames++;
+        return true;
+    }
+    
+    if (level == SrsDropLevelNone) {
+        return false;
+    }
+    
+    bool nonref = false, bframe = false;
+    parse(msg, nonref, bframe);
+    
+    if (bframe) {
+        nn_bframes++;
+        return true;
+    }
+    
+    if (nonref && level >= SrsDropLevelNonRef) {
+        nn_nonrefs++;
+        return true;
+    }
+    
+    return false;
+}
+
+srs_error_t SrsFrameDropper::report(SrsRequest* req)
+{
+    srs_error_t err = srs_success;
+    
+    int bframes = (int)(nn_bframes - reported_bframes);
+    int nonrefs = (int)(nn_nonrefs - reported_nonrefs);
+    int gop_frames = (int)(nn_gop_frames - reported_gop_frames);
+    if (!bframes && !nonrefs && !gop_frames) {
+        return err;
+    }
+    
+    SrsStatistic* stat = SrsStatistic::instance();
+    if ((err = stat->on_frames_dropped(req, bframes, nonrefs, gop_frames)) != srs_success) {
+        return srs_error_wrap(err, "stat dropped frames");
+    }
+    
+    reported_bframes = nn_bframes;
+    reported_nonrefs = nn_nonrefs;
+    reported_gop_frames = nn_gop_frames;
+    
+    return err;
+}
+
+void SrsFrameDropper::parse(SrsSharedPtrMessage* msg, bool& nonref, bool& bframe)
+{
+    char* data = msg->payload;
+    int size = msg->size;
+    
+    // The AVC/HEVC NALUs, the frame type is disposable for H.263.
+    bool h264 = SrsFlvVideo::h264(data, size);
+    if (!h264 && !SrsFlvVideo::hevc(data, size)) {
+        nonref = bframe = size > 0 && ((data[0] >> 4) & 0x0f) == SrsVideoAvcFrameTypeDisposableInterFrame;
+        return;
+    }
+    if (size <= 5 || data[1] != SrsVideoAvcFrameTraitNALU) {
+        return;
+    }
+    
+    // The frame is B-frame or non-reference only when all slices are.
+    bool has_slice = false;
+    nonref = bframe = true;
+    
+    char* p = data + 5;
+    char* end = data + size;
+    while (p + nalu_length <= end) {
+        int nb_nalu = 0;
+        for (int i = 0; i < nalu_length; i++) {
+            nb_nalu = (nb_nalu << 8) | (uint8_t)p[i];
+        }
+        p += nalu_length;
+        
+        if (nb_nalu <= 0 || p + nb_nalu > end) {
+            break;
+        }
+        
+        uint8_t header = (uint8_t)p[0];
+        if (h264) {
+            SrsAvcNaluType type = (SrsAvcNaluType)(header & 0x1f);
+            if (type == SrsAvcNaluTypeNonIDR || type == SrsAvcNaluTypeIDR) {
+                has_slice = true;
+                nonref = nonref && ((header >> 5) & 0x03) == 0;
+                
+                // The first_mb_in_slice and slice_type, ISO_IEC_14496-10-AVC-2003.pdf, page 36.
+                int32_t first_mb = 0, slice_type = 0;
+                SrsBuffer buf(p + 1, nb_nalu - 1);
+                SrsBitBuffer bb(&buf);
+                
+                srs_error_t err = srs_success;
+                if ((err = srs_avc_nalu_read_uev(&bb, first_mb)) != srs_success
+                    || (err = srs_avc_nalu_read_uev(&bb, slice_type)) != srs_success) {
+                    srs_error_reset(err);
+                    bframe = false;
+                } else {
+                    bframe = bframe && (slice_type % 5) == 1;
+                }
+            }
+        } else {
+            // The sub-layer non-reference pictures are the even types of VCL, which are used as
+            // B-frames for the slice type is not parsed, ITU-T-H.265-2013.pdf, page 61.
+            int type = (header >> 1) & 0x3f;
+            if (type < 32) {
+                has_slice = true;
+                nonref = nonref && type <= 14 && (type % 2) == 0;
+            }
+        }
+        
+        p += nb_nalu;
+    }
+    
+    if (!has_slice) {
+        nonref = bframe = false;
+    }
+    
+    // Only drop the B-frames which are never referenced.
+    bframe = bframe && nonref;
+}
+
 SrsConsumer::SrsConsumer(SrsSource* s, SrsConnection* c)
 {
     source = s;
@@ -422,6 +641,9 @@ SrsConsumer::SrsConsumer(SrsSource* s, SrsConnection* c)
     jitter = new SrsRtmpJitter();
     queue = new SrsMessageQueue();
     should_update_source_id = false;
+    cut_time = -1;
+    queue_size = 0;
+    dropper = new SrsFrameDropper();
     
 #ifdef SRS_PERF_QUEUE_COND_WAIT
     mw_wait = srs_cond_new();
@@ -436,15 +658,27 @@ SrsConsumer::~SrsConsumer()
     source->on_consumer_destroy(this);
     srs_freep(jitter);
     srs_freep(queue);
+    srs_freep(dropper);
     
 #ifdef SRS_PERF_QUEUE_COND_WAIT
     srs_cond_destroy(mw_wait);
 #endif
 }
 
-void SrsConsumer::set_queue_size(srs_utime_t queue_size)
+void SrsConsumer::set_queue_size(srs_utime_t v)
+{
+    queue_size = v;
+    queue->set_queue_size(v);
+}
+
+void SrsConsumer::set_frame_drop(bool v)
+{
+    dropper->set_enabled(v);
+}
+
+SrsFrameDropper* SrsConsumer::get_dropper()
 {
-    queue->set_queue_size(queue_size);
+    return dropper;
 }
 
 void SrsConsumer::update_source_id()
@@ -469,6 +703,26 @@ srs_error_t SrsConsumer::enqueue(SrsSharedPtrMessage* shared_msg, bool atc, SrsR
         }
     }
     
+    // For ABR, the messages after cut is replaced by another rendition.
+    if (cut_time >= 0 && msg->timestamp >= cut_time) {
+        srs_freep(msg);
+        // Never block the play loop, which does the switch.
+        wakeup();
+        return err;
+    }
+    
+    // Drop the video frames when congested, by the depth of queue.
+    dropper->update(queue->duration(), queue_size);
+    if (dropper->drop(msg)) {
+        srs_freep(msg);
+        return err;
+    }
+    
+    // For latency, the time is updated when the message entered the source.
+    if (msg->ingest_time() > 0) {
+        msg->enqueue_time = srs_get_system_time();
+    }
+    
     if ((err = queue->enqueue(msg, NULL)) != srs_success) {
         return srs_error_wrap(err, "enqueue message");
     }
@@ -500,6 +754,118 @@ srs_error_t SrsConsumer::enqueue(SrsSharedPtrMessage* shared_msg, bool atc, SrsR
     return err;
 }
 
+void SrsConsumer::update_jitter(SrsRtmpJitter* from)
+{
+    jitter->assign(from);
+}
+
+srs_utime_t SrsConsumer::duration()
+{
+    return queue->duration();
+}
+
+void SrsConsumer::follow(SrsConsumer* from)
+{
+    jitter->assign(from->jitter);
+}
+
+int64_t SrsConsumer::find_keyframe(int64_t after)
+{
+    return queue->find_keyframe(after);
+}
+
+void SrsConsumer::set_cut_time(int64_t time)
+{
+    cut_time = time;
+}
+
+srs_error_t SrsConsumer::splice(SrsConsumer* from, int64_t time)
+{
+    srs_error_t err = srs_success;
+    
+    int nb_msgs = from->queue->size();
+    if (nb_msgs <= 0) {
+        return err;
+    }
+    
+    SrsSharedPtrMessage** msgs = new SrsSharedPtrMessage*[nb_msgs];
+    SrsAutoFreeA(SrsSharedPtrMessage*, msgs);
+    
+    int count = 0;
+    if ((err = from->queue->dump_packets(nb_msgs, msgs, count)) != srs_success) {
+        return srs_error_wrap(err, "dump packets");
+    }
+    
+    // The metadata and sequence headers before the keyframe, sent at the time of keyframe.
+    SrsSharedPtrMessage* meta = NULL;
+    SrsSharedPtrMessage* vsh = NULL;
+    SrsSharedPtrMessage* ash = NULL;
+    
+    int i = 0;
+    for (; i < count; i++) {
+        SrsSharedPtrMessage* msg = msgs[i];
+        
+        if (msg->is_video() && SrsFlvVideo::sh(msg->payload, msg->size)) {
+            srs_freep(vsh);
+            vsh = msg;
+        } else if (msg->is_audio() && SrsFlvAudio::sh(msg->payload, msg->size)) {
+            srs_freep(ash);
+            ash = msg;
+        } else if (!msg->is_av()) {
+            srs_freep(meta);
+            meta = msg;
+        } else if (msg->is_video() && msg->timestamp >= time && SrsFlvVideo::keyframe(msg->payload, msg->size)) {
+            break;
+        } else {
+            srs_freep(msg);
+        }
+    }
+    
+    // Keep playing the current rendition when keyframe not found.
+    if (i >= count) {
+        srs_freep(meta);
+        srs_freep(vsh);
+        srs_freep(ash);
+        return err;
+    }
+    
+    std::vector<SrsSharedPtrMessage*> spliced;
+    SrsSharedPtrMessage* headers[] = {meta, vsh, ash};
+    for (int j = 0; j < 3; j++) {
+        if (headers[j]) {
+            headers[j]->timestamp = time;
+            spliced.push_back(headers[j]);
+        }
+    }
+    spliced.insert(spliced.end(), msgs + i, msgs + count);
+    
+    for (int j = 0; j < (int)spliced.size(); j++) {
+        SrsSharedPtrMessage* msg = spliced.at(j);
+        if ((err = queue->enqueue(msg, NULL)) != srs_success) {
+            for (j++; j < (int)spliced.size(); j++) {
+                srs_freep(spliced[j]);
+            }
+            return srs_error_wrap(err, "enqueue message");
+        }
+    }
+    
+    // Continue the timestamp of rendition, and never drop its messages.
+    jitter->assign(from->jitter);
+    cut_time = -1;
+    
+    return err;
+}
+
+void SrsConsumer::switch_source(SrsSource* s)
+{
+    source->on_consumer_destroy(this);
+    
+    source = s;
+    source->on_consumer_switch(this);
+    
+    should_update_source_id = true;
+}
+
 srs_error_t SrsConsumer::dump_packets(SrsMessageArray* msgs, int& count)
 {
     srs_error_t err = srs_success;
@@ -584,6 +950,7 @@ SrsGopCache::SrsGopCache()
     cached_video_count = 0;
     enable_gop_cache = true;
     audio_after_last_video_count = 0;
+    _generation = 0;
 }
 
 SrsGopCache::~SrsGopCache()
@@ -675,6 +1042,7 @@ void SrsGopCache::clear()
     
     cached_video_count = 0;
     audio_after_last_video_count = 0;
+    _generation++;
 }
 
 srs_error_t SrsGopCache::dump(SrsConsumer* consumer, bool atc, SrsRtmpJitterAlgorithm jitter_algorithm)
@@ -715,6 +1083,21 @@ bool SrsGopCache::pure_audio()
     return cached_video_count == 0;
 }
 
+int SrsGopCache::size()
+{
+    return (int)gop_cache.size();
+}
+
+SrsSharedPtrMessage* SrsGopCache::at(int index)
+{
+    return gop_cache.at(index);
+}
+
+int64_t SrsGopCache::generation()
+{
+    return _generation;
+}
+
 ISrsSourceHandler::ISrsSourceHandler()
 {
 }
@@ -829,8 +1212,6 @@ SrsOriginHub::SrsOriginHub()
 #endif
     ng_exec = new SrsNgExec();
     format = new SrsRtmpFormat();
-    
-    _srs_config->subscribe(this);
 }
 
 SrsOriginHub::~SrsOriginHub()
@@ -864,6 +1245,9 @@ srs_error_t SrsOriginHub::initialize(SrsSource* s, SrsRequest* r)
     req = r;
     source = s;
     
+    _srs_config->subscribe(this, req->vhost, SrsReloadVhostForward | SrsReloadVhostDash | SrsReloadVhostHls
+        | SrsReloadVhostHds | SrsReloadVhostDvr | SrsReloadVhostTranscode | SrsReloadVhostExec);
+    
     if ((err = format->initialize()) != srs_success) {
         return srs_error_wrap(err, "format initialize");
     }
@@ -908,6 +1292,11 @@ bool SrsOriginHub::active()
     return is_active;
 }
 
+bool SrsOriginHub::disposing()
+{
+    return hls->disposing();
+}
+
 srs_error_t SrsOriginHub::on_meta_data(SrsSharedPtrMessage* shared_metadata, SrsOnMetaDataPacket* packet)
 {
     srs_error_t err = srs_success;
@@ -1509,6 +1898,7 @@ SrsMetaCache::SrsMetaCache()
     previous_video = previous_audio = NULL;
     vformat = new SrsRtmpFormat();
     aformat = new SrsRtmpFormat();
+    _generation = 0;
 }
 
 SrsMetaCache::~SrsMetaCache()
@@ -1528,6 +1918,7 @@ void SrsMetaCache::clear()
     srs_freep(meta);
     srs_freep(video);
     srs_freep(audio);
+    _generation++;
 }
 
 SrsSharedPtrMessage* SrsMetaCache::data()
@@ -1600,7 +1991,31 @@ void SrsMetaCache::update_previous_ash()
     previous_audio = audio? audio->copy() : NULL;
 }
 
-srs_error_t SrsMetaCache::update_data(SrsMessageHeader* header, SrsOnMetaDataPacket* metadata, bool& updated)
+// Whether the payload is onMetaData(object) only, which is same to the encoded SrsOnMetaDataPacket.
+bool srs_metadata_is_encoded(SrsCommonMessage* msg)
+{
+    if (!msg->header.is_amf0_data() || msg->size <= 0) {
+        return false;
+    }
+    
+    SrsBuffer stream(msg->payload, msg->size);
+    
+    string name;
+    srs_error_t err = srs_amf0_read_string(&stream, name);
+    if (err != srs_success || name != SRS_CONSTS_RTMP_ON_METADATA || !srs_amf0_is_object(&stream)) {
+        srs_freep(err);
+        return false;
+    }
+    
+    if ((err = srs_amf0_skip_any(&stream)) != srs_success) {
+        srs_freep(err);
+        return false;
+    }
+    
+    return stream.empty();
+}
+
+srs_error_t SrsMetaCache::update_data(SrsCommonMessage* msg, SrsOnMetaDataPacket* metadata, bool& updated)
 {
     updated = false;
     
@@ -1608,6 +2023,17 @@ srs_error_t SrsMetaCache::update_data(SrsMessageHeader* header, SrsOnMetaDataPac
     
     SrsAmf0Any* prop = NULL;
     
+    // The metadata is not modified when it's already processed by SRS, for example, the edge
+    // or the forward from SRS origin, so we use the payload to avoid encoding it again.
+    bool modified = true;
+    if (metadata->metadata->get_property("duration") == NULL) {
+        SrsAmf0Any* server = metadata->metadata->ensure_property_string("server");
+        SrsAmf0Any* version = metadata->metadata->ensure_property_string("server_version");
+        modified = !server || server->to_str() != RTMP_SIG_SRS_SERVER
+            || !version || version->to_str() != RTMP_SIG_SRS_VERSION
+            || !srs_metadata_is_encoded(msg);
+    }
+    
     // when exists the duration, remove it to make ExoPlayer happy.
     if (metadata->metadata->get_property("duration") != NULL) {
         metadata->metadata->remove("duration");
@@ -1639,7 +2065,11 @@ srs_error_t SrsMetaCache::update_data(SrsMessageHeader* header, SrsOnMetaDataPac
     // encode the metadata to payload
     int size = 0;
     char* payload = NULL;
-    if ((err = metadata->encode(size, payload)) != srs_success) {
+    if (!modified) {
+        size = msg->size;
+        payload = new char[size];
+        memcpy(payload, msg->payload, size);
+    } else if ((err = metadata->encode(size, payload)) != srs_success) {
         return srs_error_wrap(err, "encode metadata");
     }
     
@@ -1652,10 +2082,11 @@ srs_error_t SrsMetaCache::update_data(SrsMessageHeader* header, SrsOnMetaDataPac
     srs_freep(meta);
     meta = new SrsSharedPtrMessage();
     updated = true;
+    _generation++;
     
     // dump message to shared ptr message.
     // the payload/size managed by cache_metadata, user should not free it.
-    if ((err = meta->create(header, payload, size)) != srs_success) {
+    if ((err = meta->create(&msg->header, payload, size)) != srs_success) {
         return srs_error_wrap(err, "create metadata");
     }
     
@@ -1667,6 +2098,7 @@ srs_error_t SrsMetaCache::update_ash(SrsSharedPtrMessage* msg)
     srs_freep(audio);
     audio = msg->copy();
     update_previous_ash();
+    _generation++;
     return aformat->on_audio(msg);
 }
 
@@ -1675,9 +2107,182 @@ srs_error_t SrsMetaCache::update_vsh(SrsSharedPtrMessage* msg)
     srs_freep(video);
     video = msg->copy();
     update_previous_vsh();
+    _generation++;
     return vformat->on_video(msg);
 }
 
+int64_t SrsMetaCache::generation()
+{
+    return _generation;
+}
+
+SrsBurstCache::SrsBurstCache(SrsBurstFormat f)
+{
+    format = f;
+    jitter = new SrsRtmpJitter();
+    ag = SrsRtmpJitterAlgorithmOFF;
+    chunk_size = stream_id = 0;
+    flv = new SrsFlvTransmuxer();
+    meta_generation = gop_generation = -1;
+    nb_gop = 0;
+}
+
+SrsBurstCache::~SrsBurstCache()
+{
+    clear();
+    srs_freep(jitter);
+    srs_freep(flv);
+}
+
+srs_error_t SrsBurstCache::dumps(SrsMetaCache* meta, SrsGopCache* gop, SrsRtmpJitterAlgorithm ag, int sid, int size,
+    SrsConsumer* consumer, std::vector<SrsSharedPtrMessage*>& burst)
+{
+    srs_error_t err = srs_success;
+    
+    // The RTMP chunks depends on the chunk size and stream id.
+    if (format != SrsBurstFormatRtmp) {
+        sid = size = 0;
+    }
+    
+    // Reset the cache when meta or gop changed, or the encoding changed.
+    if (meta_generation != meta->generation() || gop_generation != gop->generation()
+        || this->ag != ag || stream_id != sid || chunk_size != size) {
+        clear();
+        
+        this->ag = ag;
+        stream_id = sid;
+        chunk_size = size;
+        meta_generation = meta->generation();
+        gop_generation = gop->generation();
+        
+        // Encode the metadata and sequence header, in the order of SrsMetaCache::dumps.
+        SrsSharedPtrMessage* msgs[] = {meta->data(), meta->ash(), meta->vsh()};
+        for (int i = 0; i < 3; i++) {
+            if (msgs[i] && (err = encode(msgs[i])) != srs_success) {
+                return srs_error_wrap(err, "encode meta");
+            }
+        }
+    }
+    
+    // Encode the messages appended to gop since last dumps.
+    for (; nb_gop < gop->size(); nb_gop++) {
+        if ((err = encode(gop->at(nb_gop))) != srs_success) {
+            return srs_error_wrap(err, "encode gop");
+        }
+    }
+    
+    std::vector<SrsSharedPtrMessage*>::iterator it;
+    for (it = msgs.begin(); it != msgs.end(); ++it) {
+        SrsSharedPtrMessage* msg = *it;
+        burst.push_back(msg->copy());
+    }
+    consumer->update_jitter(jitter);
+    
+    return err;
+}
+
+int SrsBurstCache::size()
+{
+    return (int)msgs.size();
+}
+
+void SrsBurstCache::clear()
+{
+    std::vector<SrsSharedPtrMessage*>::iterator it;
+    for (it = msgs.begin(); it != msgs.end(); ++it) {
+        SrsSharedPtrMessage* msg = *it;
+        srs_freep(msg);
+    }
+    msgs.clear();
+    
+    srs_freep(jitter);
+    jitter = new SrsRtmpJitter();
+    nb_gop = 0;
+}
+
+srs_error_t SrsBurstCache::encode(SrsSharedPtrMessage* shared_msg)
+{
+    srs_error_t err = srs_success;
+    
+    SrsSharedPtrMessage* msg = shared_msg->copy();
+    SrsAutoFree(SrsSharedPtrMessage, msg);
+    
+    if ((err = jitter->correct(msg, ag)) != srs_success) {
+        return srs_error_wrap(err, "jitter");
+    }
+    
+    // Ignore the empty message, which is never sent.
+    if (!msg->payload || msg->size <= 0) {
+        return err;
+    }
+    
+    SrsSharedPtrMessage* encoded = NULL;
+    if (format == SrsBurstFormatRtmp) {
+        encoded = encode_chunks(msg);
+    } else {
+        encoded = encode_tag(msg);
+    }
+    msgs.push_back(encoded);
+    
+    return err;
+}
+
+SrsSharedPtrMessage* SrsBurstCache::encode_chunks(SrsSharedPtrMessage* msg)
+{
+    // Use the same chunk stream and stream id as SrsProtocol::send_and_free_messages.
+    msg->check(stream_id);
+    
+    int nb_chunks = (msg->size + chunk_size - 1) / chunk_size;
+    int nb_data = msg->size + SRS_CONSTS_RTMP_MAX_FMT0_HEADER_SIZE + nb_chunks * SRS_CONSTS_RTMP_MAX_FMT3_HEADER_SIZE;
+    char* data = new char[nb_data];
+    
+    char* p = data;
+    char* payload = msg->payload;
+    char* pend = msg->payload + msg->size;
+    while (payload < pend) {
+        int nbh = msg->chunk_header(p, nb_data - (int)(p - data), payload == msg->payload);
+        srs_assert(nbh > 0);
+        p += nbh;
+        
+        int payload_size = srs_min(chunk_size, (int)(pend - payload));
+        memcpy(p, payload, payload_size);
+        p += payload_size;
+        payload += payload_size;
+    }
+    
+    return create_encoded(msg, data, (int)(p - data));
+}
+
+SrsSharedPtrMessage* SrsBurstCache::encode_tag(SrsSharedPtrMessage* msg)
+{
+    int nb_data = SrsFlvTransmuxer::size_tag(msg->size);
+    char* data = new char[nb_data];
+    
+    flv->encode_tag(msg, data);
+    
+    return create_encoded(msg, data, nb_data);
+}
+
+SrsSharedPtrMessage* SrsBurstCache::create_encoded(SrsSharedPtrMessage* msg, char* data, int size)
+{
+    // Keep the type and timestamp, for player to know whether there is audio or video.
+    SrsMessageHeader header;
+    if (msg->is_audio()) {
+        header.initialize_audio(size, (uint32_t)msg->timestamp, msg->stream_id);
+    } else if (msg->is_video()) {
+        header.initialize_video(size, (uint32_t)msg->timestamp, msg->stream_id);
+    } else {
+        header.initialize_amf0_script(size, msg->stream_id);
+    }
+    
+    // Never fail for the size is positive.
+    SrsSharedPtrMessage* encoded = new SrsSharedPtrMessage();
+    srs_error_t err = encoded->create(&header, data, size);
+    srs_assert(err == srs_success);
+    
+    return encoded;
+}
+
 SrsSourceManager* _srs_sources = new SrsSourceManager();
 
 SrsSourceManager::SrsSourceManager()
@@ -1769,43 +2374,54 @@ srs_error_t SrsSourceManager::do_cycle()
 {
     srs_error_t err = srs_success;
     
+    // The sources to retire, which are removed from pool.
+    // @see https://github.com/ossrs/srs/issues/713
+    // @see https://github.com/ossrs/srs/issues/714
+    std::vector<SrsSource*> retired;
+    
     std::map<std::string, SrsSource*>::iterator it;
     for (it = pool.begin(); it != pool.end();) {
         SrsSource* source = it->second;
         
         // Do cycle source to cleanup components, such as hls dispose.
         if ((err = source->cycle()) != srs_success) {
-            return srs_error_wrap(err, "source=%d/%d cycle", source->source_id(), source->pre_source_id());
+            err = srs_error_wrap(err, "source=%d/%d cycle", source->source_id(), source->pre_source_id());
+            break;
         }
         
-        // TODO: FIXME: support source cleanup.
-        // @see https://github.com/ossrs/srs/issues/713
-        // @see https://github.com/ossrs/srs/issues/714
-#if 0
-        // When source expired, remove it.
+        // When source expired, remove it from pool, then free it when all sources are iterated,
+        // because the retire might switch to other coroutines which fetch or create source.
         if (source->expired()) {
-            int cid = source->source_id();
-            if (cid == -1 && source->pre_source_id() > 0) {
-                cid = source->pre_source_id();
-            }
-            if (cid > 0) {
-                _srs_context->set_id(cid);
-            }
-            srs_trace("cleanup die source, total=%d", (int)pool.size());
-            
-            srs_freep(source);
+            retired.push_back(source);
             pool.erase(it++);
         } else {
             ++it;
         }
-#else
-        ++it;
-#endif
+    }
+    
+    for (int i = 0; i < (int)retired.size(); i++) {
+        SrsSource* source = retired.at(i);
+        retire(source);
     }
     
     return err;
 }
 
+void SrsSourceManager::retire(SrsSource* source)
+{
+    int cid = source->source_id();
+    if (cid == -1 && source->pre_source_id() > 0) {
+        cid = source->pre_source_id();
+    }
+    if (cid > 0) {
+        _srs_context->set_id(cid);
+    }
+    srs_trace("cleanup die source, total=%d", (int)pool.size());
+    
+    source->on_retire();
+    srs_freep(source);
+}
+
 void SrsSourceManager::destroy()
 {
     std::map<std::string, SrsSource*>::iterator it;
@@ -1826,17 +2442,19 @@ SrsSource::SrsSource()
     _can_publish = true;
     _pre_source_id = _source_id = -1;
     die_at = 0;
+    nn_refs = 0;
     
     play_edge = new SrsPlayEdge();
     publish_edge = new SrsPublishEdge();
     gop_cache = new SrsGopCache();
     hub = new SrsOriginHub();
     meta = new SrsMetaCache();
+    rtmp_burst = new SrsBurstCache(SrsBurstFormatRtmp);
+    flv_burst = new SrsBurstCache(SrsBurstFormatFlv);
     
     is_monotonically_increase = false;
     last_packet_time = 0;
     
-    _srs_config->subscribe(this);
     atc = false;
 }
 
@@ -1850,6 +2468,8 @@ SrsSource::~SrsSource()
     
     srs_freep(hub);
     srs_freep(meta);
+    srs_freep(rtmp_burst);
+    srs_freep(flv_burst);
     srs_freep(mix_queue);
     
     srs_freep(play_edge);
@@ -1883,6 +2503,11 @@ bool SrsSource::expired()
         return false;
     }
     
+    // still serving by connections?
+    if (nn_refs > 0) {
+        return false;
+    }
+    
     // still publishing?
     if (!_can_publish || !publish_edge->can_publish()) {
         return false;
@@ -1893,14 +2518,47 @@ bool SrsSource::expired()
         return false;
     }
     
+    // still waiting for hls dispose?
+    if (hub->disposing()) {
+        return false;
+    }
+    
+    // disabled, never cleanup.
+    srs_utime_t idle_timeout = _srs_config->get_source_idle_timeout();
+    if (idle_timeout <= 0) {
+        return false;
+    }
+    
     srs_utime_t now = srs_get_system_time();
-    if (now > die_at + SRS_SOURCE_CLEANUP) {
+    if (now > die_at + idle_timeout) {
         return true;
     }
     
     return false;
 }
 
+void SrsSource::acquire()
+{
+    nn_refs++;
+}
+
+void SrsSource::release()
+{
+    srs_assert(nn_refs > 0);
+    
+    // The source might be created but never consumed or published,
+    // so start to count the idle time when the last connection is done.
+    if (--nn_refs == 0) {
+        die_at = srs_get_system_time();
+    }
+}
+
+void SrsSource::on_retire()
+{
+    srs_assert(handler);
+    handler->on_retire(this, req);
+}
+
 srs_error_t SrsSource::initialize(SrsRequest* r, ISrsSourceHandler* h)
 {
     srs_error_t err = srs_success;
@@ -1912,6 +2570,8 @@ srs_error_t SrsSource::initialize(SrsRequest* r, ISrsSourceHandler* h)
     req = r->copy();
     atc = _srs_config->get_atc(req->vhost);
     
+    _srs_config->subscribe(this, req->vhost, SrsReloadVhostPlay);
+    
     if ((err = hub->initialize(this, req)) != srs_success) {
         return srs_error_wrap(err, "hub");
     }
@@ -1979,6 +2639,7 @@ srs_error_t SrsSource::on_reload_vhost_play(string vhost)
     // queue length
     if (true) {
         srs_utime_t v = _srs_config->get_queue_length(req->vhost);
+        bool fd = _srs_config->get_frame_drop(req->vhost);
         
         if (true) {
             std::vector<SrsConsumer*>::iterator it;
@@ -1986,9 +2647,10 @@ srs_error_t SrsSource::on_reload_vhost_play(string vhost)
             for (it = consumers.begin(); it != consumers.end(); ++it) {
                 SrsConsumer* consumer = *it;
                 consumer->set_queue_size(v);
+                consumer->set_frame_drop(fd);
             }
             
-            srs_trace("consumers reload queue size success.");
+            srs_trace("consumers reload queue size success, frame_drop=%d.", fd);
         }
         
         // TODO: FIXME: https://github.com/ossrs/srs/issues/742#issuecomment-273656897
@@ -2087,7 +2749,7 @@ srs_error_t SrsSource::on_meta_data(SrsCommonMessage* msg, SrsOnMetaDataPacket*
     
     // Update the meta cache.
     bool updated = false;
-    if ((err = meta->update_data(&msg->header, metadata, updated)) != srs_success) {
+    if ((err = meta->update_data(msg, metadata, updated)) != srs_success) {
         return srs_error_wrap(err, "update metadata");
     }
     if (!updated) {
@@ -2165,6 +2827,8 @@ srs_error_t SrsSource::on_audio_imp(SrsSharedPtrMessage* msg)
 {
     srs_error_t err = srs_success;
     
+    srs_utime_t hub_time = trace_ingest(msg);
+    
     bool is_aac_sequence_header = SrsFlvAudio::sh(msg->payload, msg->size);
     bool is_sequence_header = is_aac_sequence_header;
     
@@ -2191,6 +2855,7 @@ srs_error_t SrsSource::on_audio_imp(SrsSharedPtrMessage* msg)
     if ((err = hub->on_audio(msg)) != srs_success) {
         return srs_error_wrap(err, "consume audio");
     }
+    trace_hub(hub_time);
     
     // cache the sequence header of aac, or first packet of mp3.
     // for example, the mp3 is used for hls to write the "right" audio codec.
@@ -2285,6 +2950,8 @@ srs_error_t SrsSource::on_video_imp(SrsSharedPtrMessage* msg)
 {
     srs_error_t err = srs_success;
     
+    srs_utime_t hub_time = trace_ingest(msg);
+    
     bool is_sequence_header = SrsFlvVideo::sh(msg->payload, msg->size);
     
     // whether consumer should drop for the duplicated sequence header.
@@ -2316,6 +2983,7 @@ srs_error_t SrsSource::on_video_imp(SrsSharedPtrMessage* msg)
             }
         }
     }
+    trace_hub(hub_time);
     
     // when sequence header, donot push to gop cache and adjust the timestamp.
     if (is_sequence_header) {
@@ -2340,6 +3008,29 @@ srs_error_t SrsSource::on_video_imp(SrsSharedPtrMessage* msg)
     return err;
 }
 
+srs_utime_t SrsSource::trace_ingest(SrsSharedPtrMessage* msg)
+{
+    if (msg->ingest_time() <= 0) {
+        return 0;
+    }
+    
+    srs_utime_t now = srs_update_system_time();
+    srs_utime_t v = now - msg->ingest_time();
+    SrsStatistic::instance()->on_latency(_source_id, SrsLatencyStageIngest, &v, 1);
+    
+    return now;
+}
+
+void SrsSource::trace_hub(srs_utime_t hub_time)
+{
+    if (hub_time <= 0) {
+        return;
+    }
+    
+    srs_utime_t v = srs_update_system_time() - hub_time;
+    SrsStatistic::instance()->on_latency(_source_id, SrsLatencyStageHub, &v, 1);
+}
+
 srs_error_t SrsSource::on_aggregate(SrsCommonMessage* msg)
 {
     srs_error_t err = srs_success;
@@ -2518,6 +3209,7 @@ srs_error_t SrsSource::create_consumer(SrsConnection* conn, SrsConsumer*& consum
 
     srs_utime_t queue_size = _srs_config->get_queue_length(req->vhost);
     consumer->set_queue_size(queue_size);
+    consumer->set_frame_drop(_srs_config->get_frame_drop(req->vhost));
 
     // if atc, update the sequence header to gop cache time.
     if (atc && !gop_cache->empty()) {
@@ -2563,6 +3255,30 @@ srs_error_t SrsSource::create_consumer(SrsConnection* conn, SrsConsumer*& consum
     return err;
 }
 
+srs_error_t SrsSource::create_consumer(SrsConnection* conn, SrsConsumer*& consumer, SrsBurstFormat format, int sid, int size,
+    std::vector<SrsSharedPtrMessage*>& burst)
+{
+    srs_error_t err = srs_success;
+    
+    // For atc, the timestamp of sequence header is updated to gop cache,
+    // so we dumps the caches to consumer.
+    if (atc || !hub->active()) {
+        return create_consumer(conn, consumer);
+    }
+    
+    if ((err = create_consumer(conn, consumer, false, false, false)) != srs_success) {
+        return srs_error_wrap(err, "create consumer");
+    }
+    
+    SrsBurstCache* cache = (format == SrsBurstFormatRtmp)? rtmp_burst : flv_burst;
+    if ((err = cache->dumps(meta, gop_cache, jitter_algorithm, sid, size, consumer, burst)) != srs_success) {
+        return srs_error_wrap(err, "burst dumps");
+    }
+    srs_trace("dispatch burst success. count=%d, gop=%d, time=%d", (int)burst.size(), gop_cache->size(), consumer->get_time());
+    
+    return err;
+}
+
 void SrsSource::on_consumer_destroy(SrsConsumer* consumer)
 {
     std::vector<SrsConsumer*>::iterator it;
@@ -2577,6 +3293,11 @@ void SrsSource::on_consumer_destroy(SrsConsumer* consumer)
     }
 }
 
+void SrsSource::on_consumer_switch(SrsConsumer* consumer)
+{
+    consumers.push_back(consumer);
+}
+
 void SrsSource::set_cache(bool enabled)
 {
     gop_cache->set(enabled);
@@ -2608,3 +3329,14 @@ string SrsSource::get_curr_origin()
     return play_edge->get_curr_origin();
 }
 
+SrsSourceRef::SrsSourceRef(SrsSource* s)
+{
+    source = s;
+    source->acquire();
+}
+
+SrsSourceRef::~SrsSourceRef()
+{
+    source->release();
+}
+
@@ -58,6 +58,7 @@ class SrsDvr;
 class SrsDash;
 class SrsEncoder;
 class SrsBuffer;
+class SrsFlvTransmuxer;
 #ifdef SRS_AUTO_HDS
 class SrsHds;
 #endif
@@ -89,6 +90,8 @@ public:
     virtual srs_error_t correct(SrsSharedPtrMessage* msg, SrsRtmpJitterAlgorithm ag);
     // Get current client time, the last packet time.
     virtual int64_t get_time();
+    // Continue from the state of another jitter.
+    virtual void assign(SrsRtmpJitter* from);
 };
 
 #ifdef SRS_PERF_QUEUE_FAST_VECTOR
@@ -158,6 +161,9 @@ public:
     // Dumps packets to consumer, use specified args.
     // @remark the atc/tba/tbv/ag are same to SrsConsumer.enqueue().
     virtual srs_error_t dump_packets(SrsConsumer* consumer, bool atc, SrsRtmpJitterAlgorithm ag);
+    // Find the first video keyframe in queue, whose timestamp is larger than the time in ms.
+    // @return The timestamp of keyframe in ms, -1 if not found.
+    virtual int64_t find_keyframe(int64_t after);
 private:
     // Remove a gop from the front.
     // if no iframe found, clear it.
@@ -167,6 +173,63 @@ public:
     virtual void clear();
 };
 
+// The steps to drop the video frames for congested player, the audio is always kept.
+enum SrsDropLevel
+{
+    // Deliver all frames.
+    SrsDropLevelNone = 0,
+    // Drop the B-frames which are never referenced.
+    SrsDropLevelBFrame,
+    // Drop all frames which are never referenced.
+    SrsDropLevelNonRef,
+    // Drop all frames util the next keyframe.
+    SrsDropLevelGop,
+};
+
+// The graduated policy to drop video frames for a slow player, by the depth of queue to send and the
+// occupancy of socket send buffer, so the player keeps playing at a reduced frame rate instead of stalling.
+class SrsFrameDropper
+{
+private:
+    bool enabled;
+    SrsDropLevel level;
+    // The occupancy in percent of socket send buffer, sampled by the play loop.
+    int occupancy;
+    // Whether drop all video frames util the next keyframe.
+    bool wait_keyframe;
+    // The size of NALU length in bytes, parsed from the sequence header.
+    int nalu_length;
+public:
+    // The number of dropped frames for each step.
+    int64_t nn_bframes;
+    int64_t nn_nonrefs;
+    // The frames dropped util the next keyframe, not the number of GOPs.
+    int64_t nn_gop_frames;
+private:
+    // The number of dropped frames which are reported to stat.
+    int64_t reported_bframes;
+    int64_t reported_nonrefs;
+    int64_t reported_gop_frames;
+public:
+    SrsFrameDropper();
+    virtual ~SrsFrameDropper();
+public:
+    virtual void set_enabled(bool v);
+    // Set the occupancy in percent of socket send buffer.
+    virtual void set_occupancy(int v);
+    // Get the current step to drop frames.
+    virtual SrsDropLevel current();
+    // Update the step by the depth of queue and the max queue size.
+    virtual void update(srs_utime_t depth, srs_utime_t max_size);
+    // Whether drop the message, the audio and sequence headers are never dropped.
+    virtual bool drop(SrsSharedPtrMessage* msg);
+    // Report the dropped frames since the last report to the stat of stream.
+    virtual srs_error_t report(SrsRequest* req);
+private:
+    // Parse the video frame, whether it's never referenced, and whether it's a B-frame.
+    virtual void parse(SrsSharedPtrMessage* msg, bool& nonref, bool& bframe);
+};
+
 // The wakable used for some object
 // which is waiting on cond.
 class ISrsWakable
@@ -193,6 +256,11 @@ private:
     bool paused;
     // when source id changed, notice all consumers
     bool should_update_source_id;
+    // For ABR, drop the messages at or after this time in ms, to switch to another rendition; -1 to disable.
+    int64_t cut_time;
+    // The max duration of queue, and drop the video frames when congested.
+    srs_utime_t queue_size;
+    SrsFrameDropper* dropper;
 #ifdef SRS_PERF_QUEUE_COND_WAIT
     // The cond wait for mw.
     // @see https://github.com/ossrs/srs/issues/251
@@ -206,7 +274,11 @@ public:
     virtual ~SrsConsumer();
 public:
     // Set the size of queue.
-    virtual void set_queue_size(srs_utime_t queue_size);
+    virtual void set_queue_size(srs_utime_t v);
+    // Set whether drop the video frames when congested.
+    virtual void set_frame_drop(bool v);
+    // Get the dropper of video frames, to set the occupancy and report the stat.
+    virtual SrsFrameDropper* get_dropper();
     // when source id changed, notice client to print.
     virtual void update_source_id();
 public:
@@ -217,6 +289,23 @@ public:
     // @param whether atc, donot use jitter correct if true.
     // @param ag the algorithm of time jitter.
     virtual srs_error_t enqueue(SrsSharedPtrMessage* shared_msg, bool atc, SrsRtmpJitterAlgorithm ag);
+    // Continue the timestamp of the jitter, when the caches are sent in a burst.
+    virtual void update_jitter(SrsRtmpJitter* from);
+    // Get the duration of messages in queue, that is the depth of queue to send.
+    virtual srs_utime_t duration();
+// For ABR, to switch the consumer to another rendition at keyframe, see SrsAbrSwitcher.
+public:
+    // Continue the timestamp of the consumer, for the consumer of rendition to switch to.
+    virtual void follow(SrsConsumer* from);
+    // Find the first video keyframe in queue after the time in ms, -1 if not found.
+    virtual int64_t find_keyframe(int64_t after);
+    // Drop the messages at or after the time in ms, -1 to disable.
+    virtual void set_cut_time(int64_t time);
+    // Move messages from the consumer of rendition, which start at the keyframe of time in ms,
+    // while the last metadata and sequence headers before it are kept.
+    virtual srs_error_t splice(SrsConsumer* from, int64_t time);
+    // Move the consumer to the source of rendition, without dumping any cache.
+    virtual void switch_source(SrsSource* s);
     // Get packets in consumer queue.
     // @param msgs the msgs array to dump packets to send.
     // @param count the count in array, intput and output param.
@@ -263,6 +352,8 @@ private:
     int audio_after_last_video_count;
     // cached gop.
     std::vector<SrsSharedPtrMessage*> gop_cache;
+    // The generation of gop, increase when cleared.
+    int64_t _generation;
 public:
     SrsGopCache();
     virtual ~SrsGopCache();
@@ -290,6 +381,11 @@ public:
     // whether current stream is pure audio,
     // when no video in gop cache, the stream is pure audio right now.
     virtual bool pure_audio();
+    // Get the cached messages in gop.
+    virtual int size();
+    virtual SrsSharedPtrMessage* at(int index);
+    // The generation of gop, the cached messages are only appended in a generation.
+    virtual int64_t generation();
 };
 
 // The handler to handle the event of srs source.
@@ -305,6 +401,8 @@ public:
     virtual srs_error_t on_publish(SrsSource* s, SrsRequest* r) = 0;
     // when stream stop publish, unmount stream.
     virtual void on_unpublish(SrsSource* s, SrsRequest* r) = 0;
+    // when source is idle and retired, destroy the mounted stream.
+    virtual void on_retire(SrsSource* s, SrsRequest* r) = 0;
 };
 
 // The mix queue to correct the timestamp for mix_correct algorithm.
@@ -366,6 +464,9 @@ public:
     virtual srs_error_t cycle();
     // Whether the stream hub is active, or stream is publishing.
     virtual bool active();
+    // Whether the hub still has resource to dispose in cycle,
+    // For example, the hls files waiting for hls_dispose.
+    virtual bool disposing();
 public:
     // When got a parsed metadata.
     virtual srs_error_t on_meta_data(SrsSharedPtrMessage* shared_metadata, SrsOnMetaDataPacket* packet);
@@ -414,6 +515,8 @@ private:
     // The format for sequence header.
     SrsRtmpFormat* vformat;
     SrsRtmpFormat* aformat;
+    // The generation of meta, increase when metadata or sequence header changed.
+    int64_t _generation;
 public:
     SrsMetaCache();
     virtual ~SrsMetaCache();
@@ -444,11 +547,62 @@ public:
     virtual void update_previous_ash();
 public:
     // Update the cached metadata by packet.
-    virtual srs_error_t update_data(SrsMessageHeader* header, SrsOnMetaDataPacket* metadata, bool& updated);
+    // @remark The payload of msg is copied when metadata is not modified, for example, from SRS origin.
+    virtual srs_error_t update_data(SrsCommonMessage* msg, SrsOnMetaDataPacket* metadata, bool& updated);
     // Update the cached audio sequence header.
     virtual srs_error_t update_ash(SrsSharedPtrMessage* msg);
     // Update the cached video sequence header.
     virtual srs_error_t update_vsh(SrsSharedPtrMessage* msg);
+    // The generation of meta, to know whether metadata or sequence header changed.
+    virtual int64_t generation();
+};
+
+// The format of messages in burst.
+enum SrsBurstFormat
+{
+    SrsBurstFormatRtmp = 0x01,
+    SrsBurstFormatFlv,
+};
+
+// The pre-encoded metadata, sequence header and gop cache, in RTMP chunks or FLV tags,
+// which is encoded once in a gop and sent by each new player in a burst.
+// @remark The timestamp is corrected by a jitter, as a new consumer does.
+class SrsBurstCache
+{
+private:
+    SrsBurstFormat format;
+    // The jitter for the cached messages, from a new consumer.
+    SrsRtmpJitter* jitter;
+    SrsRtmpJitterAlgorithm ag;
+    // For RTMP, the chunks are encoded in chunk size and stream id of player.
+    int chunk_size;
+    int stream_id;
+    // For FLV, to encode the tags.
+    SrsFlvTransmuxer* flv;
+    // The generation of meta and gop, clear the cache when changed.
+    int64_t meta_generation;
+    int64_t gop_generation;
+    // The number of messages of gop encoded, the meta is encoded first.
+    int nb_gop;
+    // The encoded messages, each is a RTMP message in chunks, or a FLV tag with previous tag size.
+    std::vector<SrsSharedPtrMessage*> msgs;
+public:
+    SrsBurstCache(SrsBurstFormat f);
+    virtual ~SrsBurstCache();
+public:
+    // Encode the caches if changed, then dump the encoded messages to burst,
+    // and update the jitter of consumer to continue the timestamp.
+    // @param burst Output the copy of encoded messages, user should free them.
+    virtual srs_error_t dumps(SrsMetaCache* meta, SrsGopCache* gop, SrsRtmpJitterAlgorithm ag, int sid, int size,
+        SrsConsumer* consumer, std::vector<SrsSharedPtrMessage*>& burst);
+    // Get the number of encoded messages.
+    virtual int size();
+private:
+    virtual void clear();
+    virtual srs_error_t encode(SrsSharedPtrMessage* msg);
+    virtual SrsSharedPtrMessage* encode_chunks(SrsSharedPtrMessage* msg);
+    virtual SrsSharedPtrMessage* encode_tag(SrsSharedPtrMessage* msg);
+    virtual SrsSharedPtrMessage* create_encoded(SrsSharedPtrMessage* msg, char* data, int size);
 };
 
 // The source manager to create and refresh all stream sources.
@@ -466,7 +620,6 @@ public:
     // @param h the event handler for source.
     // @param pps the matched source, if success never be NULL.
     virtual srs_error_t fetch_or_create(SrsRequest* r, ISrsSourceHandler* h, SrsSource** pps);
-private:
     // Get the exists source, NULL when not exists.
     // update the request and return the exists source.
     virtual SrsSource* fetch(SrsRequest* r);
@@ -476,6 +629,8 @@ public:
     virtual srs_error_t cycle();
 private:
     virtual srs_error_t do_cycle();
+    // Notify and free the source which is expired and removed from pool.
+    virtual void retire(SrsSource* source);
 public:
     // when system exit, destroy the sources,
     // For gmc to analysis mem leaks.
@@ -527,12 +682,18 @@ private:
     SrsOriginHub* hub;
     // The metadata cache.
     SrsMetaCache* meta;
+    // The pre-encoded caches for player to send in a burst.
+    SrsBurstCache* rtmp_burst;
+    SrsBurstCache* flv_burst;
 private:
     // Whether source is avaiable for publishing.
     bool _can_publish;
     // The last die time, when all consumers quit and no publisher,
     // We will remove the source when source die.
     srs_utime_t die_at;
+    // The number of connections serving the source, which may switch to other
+    // coroutines before creating consumer, so we never remove the source when referenced.
+    int nn_refs;
 public:
     SrsSource();
     virtual ~SrsSource();
@@ -541,6 +702,11 @@ public:
     virtual srs_error_t cycle();
     // Remove source when expired.
     virtual bool expired();
+    // Reference the source when serving it, and release when done.
+    virtual void acquire();
+    virtual void release();
+    // When source is retired by manager, notify the handler.
+    virtual void on_retire();
 public:
     // Initialize the hls with handlers.
     virtual srs_error_t initialize(SrsRequest* r, ISrsSourceHandler* h);
@@ -569,6 +735,10 @@ public:
     virtual srs_error_t on_video(SrsCommonMessage* video);
 private:
     virtual srs_error_t on_video_imp(SrsSharedPtrMessage* video);
+    // Trace the latency of ingest stage, return the start time of hub stage, 0 if not traced.
+    virtual srs_utime_t trace_ingest(SrsSharedPtrMessage* msg);
+    // Trace the latency of hub stage, which starts at hub_time.
+    virtual void trace_hub(srs_utime_t hub_time);
 public:
     virtual srs_error_t on_aggregate(SrsCommonMessage* msg);
     // Publish stream event notify.
@@ -583,7 +753,15 @@ public:
     // @param dm, whether dumps the metadata.
     // @param dg, whether dumps the gop cache.
     virtual srs_error_t create_consumer(SrsConnection* conn, SrsConsumer*& consumer, bool ds = true, bool dm = true, bool dg = true);
+    // Create consumer and dumps the pre-encoded caches in a burst.
+    // @param sid, size, the stream id and chunk size for RTMP.
+    // @param burst, output the encoded messages to send, user should free them.
+    // @remark The burst is empty when caches are dumped to consumer, for example, atc.
+    virtual srs_error_t create_consumer(SrsConnection* conn, SrsConsumer*& consumer, SrsBurstFormat format, int sid, int size,
+        std::vector<SrsSharedPtrMessage*>& burst);
     virtual void on_consumer_destroy(SrsConsumer* consumer);
+    // For ABR, when the consumer switched to this source from another rendition.
+    virtual void on_consumer_switch(SrsConsumer* consumer);
     virtual void set_cache(bool enabled);
     virtual SrsRtmpJitterAlgorithm jitter();
 public:
@@ -597,4 +775,14 @@ public:
     virtual std::string get_curr_origin();
 };
 
+// Reference the source in scope, for example, the connection which serves the source.
+class SrsSourceRef
+{
+private:
+    SrsSource* source;
+public:
+    SrsSourceRef(SrsSource* s);
+    virtual ~SrsSourceRef();
+};
+
 #endif
@@ -86,6 +86,7 @@ SrsSTCoroutine::SrsSTCoroutine(string n, ISrsCoroutineHandler* h, int cid)
     name = n;
     handler = h;
     context = cid;
+    stack_size = 0;
     trd = NULL;
     trd_err = srs_success;
     started = interrupted = disposed = cycle_done = false;
@@ -98,6 +99,11 @@ SrsSTCoroutine::~SrsSTCoroutine()
     srs_freep(trd_err);
 }
 
+void SrsSTCoroutine::set_stack_size(int v)
+{
+    stack_size = v;
+}
+
 srs_error_t SrsSTCoroutine::start()
 {
     srs_error_t err = srs_success;
@@ -116,7 +122,7 @@ srs_error_t SrsSTCoroutine::start()
         return err;
     }
     
-    if ((trd = (srs_thread_t)_pfn_st_thread_create(pfn, this, 1, 0)) == NULL) {
+    if ((trd = (srs_thread_t)_pfn_st_thread_create(pfn, this, 1, stack_size)) == NULL) {
         err = srs_error_new(ERROR_ST_CREATE_CYCLE_THREAD, "create failed");
         
         srs_freep(trd_err);
@@ -122,6 +122,7 @@ private:
 private:
     srs_thread_t trd;
     int context;
+    int stack_size;
     srs_error_t trd_err;
 private:
     bool started;
@@ -135,6 +136,9 @@ public:
     SrsSTCoroutine(std::string n, ISrsCoroutineHandler* h, int cid = 0);
     virtual ~SrsSTCoroutine();
 public:
+    // Set the stack size in bytes, use the default stack of ST when zero.
+    // @remark Should set it before start.
+    virtual void set_stack_size(int v);
     // Start the thread.
     // @remark Should never start it when stopped or terminated.
     virtual srs_error_t start();
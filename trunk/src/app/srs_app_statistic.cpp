@@ -24,6 +24,7 @@
 #include <srs_app_statistic.hpp>
 
 #include <unistd.h>
+#include <string.h>
 #include <sstream>
 using namespace std;
 
@@ -34,6 +35,8 @@ using namespace std;
 #include <srs_app_config.hpp>
 #include <srs_kernel_utility.hpp>
 #include <srs_protocol_amf0.hpp>
+#include <srs_app_shm_stat.hpp>
+#include <srs_kernel_flv.hpp>
 
 int64_t srs_gvid = 0;
 
@@ -45,6 +48,124 @@ int64_t srs_generate_id()
     return srs_gvid++;
 }
 
+// Get the index of bucket for latency v.
+int srs_latency_bucket(srs_utime_t v)
+{
+    if (v < (1 << SRS_LATENCY_SUB_BITS)) {
+        return (int)srs_max(0, v);
+    }
+    
+    v = srs_min(v, (srs_utime_t)0xffffffff);
+    int shift = 63 - __builtin_clzll((uint64_t)v) - SRS_LATENCY_SUB_BITS;
+    int sub = (int)(v >> shift) & ((1 << SRS_LATENCY_SUB_BITS) - 1);
+    return ((shift + 1) << SRS_LATENCY_SUB_BITS) + sub;
+}
+
+// Get the upper of bucket at index.
+srs_utime_t srs_latency_bucket_upper(int index)
+{
+    if (index < (1 << SRS_LATENCY_SUB_BITS)) {
+        return index;
+    }
+    
+    int shift = (index >> SRS_LATENCY_SUB_BITS) - 1;
+    int sub = index & ((1 << SRS_LATENCY_SUB_BITS) - 1);
+    srs_utime_t lower = (srs_utime_t)((1 << SRS_LATENCY_SUB_BITS) + sub) << shift;
+    return lower + ((srs_utime_t)1 << shift) - 1;
+}
+
+SrsLatencyHistogram::SrsLatencyHistogram()
+{
+    memset(buckets, 0, sizeof(buckets));
+    nn_samples = 0;
+    sum = max = 0;
+}
+
+SrsLatencyHistogram::~SrsLatencyHistogram()
+{
+}
+
+void SrsLatencyHistogram::update(srs_utime_t v)
+{
+    buckets[srs_latency_bucket(v)]++;
+    nn_samples++;
+    sum += v;
+    max = srs_max(max, v);
+}
+
+uint64_t SrsLatencyHistogram::count()
+{
+    return nn_samples;
+}
+
+srs_utime_t SrsLatencyHistogram::average()
+{
+    return nn_samples? sum / (srs_utime_t)nn_samples : 0;
+}
+
+srs_utime_t SrsLatencyHistogram::maximum()
+{
+    return max;
+}
+
+srs_utime_t SrsLatencyHistogram::percentile(double p)
+{
+    if (!nn_samples) {
+        return 0;
+    }
+    
+    uint64_t target = (uint64_t)(p * nn_samples / 100.0 + 0.5);
+    target = srs_max(1, srs_min(target, nn_samples));
+    
+    // The last bucket is for all huge values, so never use its upper.
+    uint64_t nn = 0;
+    for (int i = 0; i < SRS_LATENCY_BUCKETS - 1; i++) {
+        if ((nn += buckets[i]) >= target) {
+            return srs_min(srs_latency_bucket_upper(i), max);
+        }
+    }
+    
+    return max;
+}
+
+srs_error_t SrsLatencyHistogram::dumps(SrsJsonObject* obj)
+{
+    obj->set("count", SrsJsonAny::integer(nn_samples));
+    obj->set("avg", SrsJsonAny::number(average() / 1000.0));
+    obj->set("p50", SrsJsonAny::number(percentile(50) / 1000.0));
+    obj->set("p90", SrsJsonAny::number(percentile(90) / 1000.0));
+    obj->set("p99", SrsJsonAny::number(percentile(99) / 1000.0));
+    obj->set("max", SrsJsonAny::number(max / 1000.0));
+    
+    return srs_success;
+}
+
+SrsStatisticLatency::SrsStatisticLatency()
+{
+}
+
+SrsStatisticLatency::~SrsStatisticLatency()
+{
+}
+
+srs_error_t SrsStatisticLatency::dumps(SrsJsonObject* obj)
+{
+    srs_error_t err = srs_success;
+    
+    static const char* names[] = {"ingest", "hub", "queue", "send", "total"};
+    
+    for (int i = 0; i < SrsLatencyStageMax; i++) {
+        SrsJsonObject* stage = SrsJsonAny::object();
+        obj->set(names[i], stage);
+        
+        if ((err = stages[i].dumps(stage)) != srs_success) {
+            return srs_error_wrap(err, "dump %s", names[i]);
+        }
+    }
+    
+    return err;
+}
+
 SrsStatisticVhost::SrsStatisticVhost()
 {
     id = srs_generate_id();
@@ -55,12 +176,14 @@ SrsStatisticVhost::SrsStatisticVhost()
     
     nb_clients = 0;
     nb_streams = 0;
+    latency = NULL;
 }
 
 SrsStatisticVhost::~SrsStatisticVhost()
 {
     srs_freep(kbps);
     srs_freep(clk);
+    srs_freep(latency);
 }
 
 srs_error_t SrsStatisticVhost::dumps(SrsJsonObject* obj)
@@ -84,6 +207,15 @@ srs_error_t SrsStatisticVhost::dumps(SrsJsonObject* obj)
     
     okbps->set("recv_30s", SrsJsonAny::integer(kbps->get_recv_kbps_30s()));
     okbps->set("send_30s", SrsJsonAny::integer(kbps->get_send_kbps_30s()));
+
+    if (latency) {
+        SrsJsonObject* olatency = SrsJsonAny::object();
+        obj->set("latency", olatency);
+        
+        if ((err = latency->dumps(olatency)) != srs_success) {
+            return srs_error_wrap(err, "dump latency");
+        }
+    }
     
     SrsJsonObject* hls = SrsJsonAny::object();
     obj->set("hls", hls);
@@ -122,12 +254,15 @@ SrsStatisticStream::SrsStatisticStream()
     
     nb_clients = 0;
     nb_frames = 0;
+    nb_drop_bframes = nb_drop_nonrefs = nb_drop_gop_frames = 0;
+    latency = NULL;
 }
 
 SrsStatisticStream::~SrsStatisticStream()
 {
     srs_freep(kbps);
     srs_freep(clk);
+    srs_freep(latency);
 }
 
 srs_error_t SrsStatisticStream::dumps(SrsJsonObject* obj)
@@ -144,11 +279,27 @@ srs_error_t SrsStatisticStream::dumps(SrsJsonObject* obj)
     obj->set("send_bytes", SrsJsonAny::integer(kbps->get_send_bytes()));
     obj->set("recv_bytes", SrsJsonAny::integer(kbps->get_recv_bytes()));
     
+    SrsJsonObject* drops = SrsJsonAny::object();
+    obj->set("drops", drops);
+    
+    drops->set("bframes", SrsJsonAny::integer(nb_drop_bframes));
+    drops->set("nonrefs", SrsJsonAny::integer(nb_drop_nonrefs));
+    drops->set("gop_frames", SrsJsonAny::integer(nb_drop_gop_frames));
+    
     SrsJsonObject* okbps = SrsJsonAny::object();
     obj->set("kbps", okbps);
     
     okbps->set("recv_30s", SrsJsonAny::integer(kbps->get_recv_kbps_30s()));
     okbps->set("send_30s", SrsJsonAny::integer(kbps->get_send_kbps_30s()));
+
+    if (latency) {
+        SrsJsonObject* olatency = SrsJsonAny::object();
+        obj->set("latency", olatency);
+        
+        if ((err = latency->dumps(olatency)) != srs_success) {
+            return srs_error_wrap(err, "dump latency");
+        }
+    }
     
     SrsJsonObject* publish = SrsJsonAny::object();
     obj->set("publish", publish);
@@ -209,6 +360,7 @@ SrsStatisticClient::SrsStatisticClient()
     req = NULL;
     type = SrsRtmpConnUnknown;
     create = srs_get_system_time();
+    send_lag = -1;
 }
 
 SrsStatisticClient::~SrsStatisticClient()
@@ -230,6 +382,28 @@ srs_error_t SrsStatisticClient::dumps(SrsJsonObject* obj)
     obj->set("type", SrsJsonAny::str(srs_client_type_string(type).c_str()));
     obj->set("publish", SrsJsonAny::boolean(srs_client_type_is_publish(type)));
     obj->set("alive", SrsJsonAny::number(srsu2ms(srs_get_system_time() - create) / 1000.0));
+    if (send_lag >= 0) {
+        obj->set("send_lag", SrsJsonAny::number(send_lag / 1000.0));
+    }
+    
+    // The metrics of TCP, ignore when not available.
+    SrsTcpInfo info;
+    if (!conn || (err = conn->get_tcp_info(&info)) != srs_success) {
+        srs_freep(err);
+        return srs_success;
+    }
+    
+    SrsJsonObject* tcp = SrsJsonAny::object();
+    obj->set("tcp", tcp);
+    
+    tcp->set("rtt", SrsJsonAny::number(info.rtt / 1000.0));
+    tcp->set("rttvar", SrsJsonAny::number(info.rttvar / 1000.0));
+    tcp->set("cwnd", SrsJsonAny::integer(info.cwnd));
+    tcp->set("mss", SrsJsonAny::integer(info.mss));
+    tcp->set("retrans", SrsJsonAny::integer(info.retrans));
+    tcp->set("notsent", SrsJsonAny::integer(info.notsent));
+    tcp->set("delivery_kbps", SrsJsonAny::integer(info.delivery_rate * 8 / 1000));
+    tcp->set("pacing_kbps", SrsJsonAny::integer(info.pacing_rate * 8 / 1000));
     
     return err;
 }
@@ -372,6 +546,20 @@ srs_error_t SrsStatistic::on_video_frames(SrsRequest* req, int nb_frames)
     return err;
 }
 
+srs_error_t SrsStatistic::on_frames_dropped(SrsRequest* req, int bframes, int nonrefs, int gop_frames)
+{
+    srs_error_t err = srs_success;
+    
+    SrsStatisticVhost* vhost = create_vhost(req);
+    SrsStatisticStream* stream = create_stream(vhost, req);
+    
+    stream->nb_drop_bframes += bframes;
+    stream->nb_drop_nonrefs += nonrefs;
+    stream->nb_drop_gop_frames += gop_frames;
+    
+    return err;
+}
+
 void SrsStatistic::on_stream_publish(SrsRequest* req, int cid)
 {
     SrsStatisticVhost* vhost = create_vhost(req);
@@ -403,6 +591,36 @@ void SrsStatistic::on_stream_close(SrsRequest* req)
     }
 }
 
+void SrsStatistic::on_latency(int cid, SrsLatencyStage stage, srs_utime_t* values, int nb_values)
+{
+    std::map<int, SrsStatisticClient*>::iterator it = clients.find(cid);
+    if (it == clients.end() || nb_values <= 0) {
+        return;
+    }
+    
+    SrsStatisticClient* client = it->second;
+    SrsStatisticStream* stream = client->stream;
+    SrsStatisticVhost* vhost = stream->vhost;
+    
+    if (!stream->latency) {
+        stream->latency = new SrsStatisticLatency();
+    }
+    if (!vhost->latency) {
+        vhost->latency = new SrsStatisticLatency();
+    }
+    
+    SrsLatencyHistogram* s = &stream->latency->stages[stage];
+    SrsLatencyHistogram* v = &vhost->latency->stages[stage];
+    for (int i = 0; i < nb_values; i++) {
+        s->update(values[i]);
+        v->update(values[i]);
+    }
+    
+    if (stage == SrsLatencyStageTotal) {
+        client->send_lag = values[nb_values - 1];
+    }
+}
+
 srs_error_t SrsStatistic::on_client(int id, SrsRequest* req, SrsConnection* conn, SrsRtmpConnType type)
 {
     srs_error_t err = srs_success;
@@ -556,6 +774,103 @@ srs_error_t SrsStatistic::dumps_clients(SrsJsonArray* arr, int start, int count)
     return err;
 }
 
+void srs_shm_stat_copy(char* dst, int size, const std::string& src)
+{
+    int nn = srs_min(size - 1, (int)src.length());
+    memcpy(dst, src.data(), nn);
+    memset(dst + nn, 0, size - nn);
+}
+
+void SrsStatistic::dumps_shm(SrsShmStatistic* shm)
+{
+    if (true) {
+        SrsShmStatServer* s = shm->server();
+        srs_shm_stat_write_begin(&s->seq);
+        
+        s->update_ms = srsu2ms(srs_get_system_time());
+        s->recv_bytes = kbps->get_recv_bytes();
+        s->send_bytes = kbps->get_send_bytes();
+        s->recv_kbps_30s = kbps->get_recv_kbps_30s();
+        s->send_kbps_30s = kbps->get_send_kbps_30s();
+        s->nb_vhosts = (int32_t)vhosts.size();
+        s->nb_streams = (int32_t)streams.size();
+        s->nb_clients = (int32_t)clients.size();
+        
+        srs_shm_stat_write_end(&s->seq);
+    }
+    
+    // Each vhost and stream keeps its slot, the slots of removed ones are freed by sweep.
+    if (true) {
+        std::map<int64_t, SrsStatisticVhost*>::iterator it;
+        for (it = vhosts.begin(); it != vhosts.end(); it++) {
+            SrsStatisticVhost* vhost = it->second;
+            SrsShmStatVhost* v = shm->vhost_slot(vhost->id);
+            if (!v) {
+                continue;
+            }
+            srs_shm_stat_write_begin(&v->seq);
+            
+            v->used = 1;
+            v->id = vhost->id;
+            srs_shm_stat_copy(v->name, sizeof(v->name), vhost->vhost);
+            v->nb_streams = vhost->nb_streams;
+            v->nb_clients = vhost->nb_clients;
+            v->recv_bytes = vhost->kbps->get_recv_bytes();
+            v->send_bytes = vhost->kbps->get_send_bytes();
+            v->recv_kbps_30s = vhost->kbps->get_recv_kbps_30s();
+            v->send_kbps_30s = vhost->kbps->get_send_kbps_30s();
+            
+            srs_shm_stat_write_end(&v->seq);
+        }
+    }
+    
+    if (true) {
+        std::map<int64_t, SrsStatisticStream*>::iterator it;
+        for (it = streams.begin(); it != streams.end(); it++) {
+            SrsStatisticStream* stream = it->second;
+            SrsShmStatStream* v = shm->stream_slot(stream->id);
+            if (!v) {
+                continue;
+            }
+            srs_shm_stat_write_begin(&v->seq);
+            
+            v->used = 1;
+            v->id = stream->id;
+            v->vhost_id = stream->vhost->id;
+            srs_shm_stat_copy(v->app, sizeof(v->app), stream->app);
+            srs_shm_stat_copy(v->stream, sizeof(v->stream), stream->stream);
+            v->active = stream->active;
+            v->cid = stream->connection_cid;
+            v->nb_clients = stream->nb_clients;
+            v->nb_frames = stream->nb_frames;
+            v->nb_drop_bframes = stream->nb_drop_bframes;
+            v->nb_drop_nonrefs = stream->nb_drop_nonrefs;
+            v->nb_drop_gop_frames = stream->nb_drop_gop_frames;
+            v->recv_bytes = stream->kbps->get_recv_bytes();
+            v->send_bytes = stream->kbps->get_send_bytes();
+            v->recv_kbps_30s = stream->kbps->get_recv_kbps_30s();
+            v->send_kbps_30s = stream->kbps->get_send_kbps_30s();
+            
+            v->has_video = stream->has_video;
+            v->vcodec = stream->vcodec;
+            v->avc_profile = stream->avc_profile;
+            v->avc_level = stream->avc_level;
+            v->width = stream->width;
+            v->height = stream->height;
+            
+            v->has_audio = stream->has_audio;
+            v->acodec = stream->acodec;
+            v->sample_rate = stream->has_audio? srs_flv_srates[stream->asample_rate] : 0;
+            v->channels = stream->has_audio? stream->asound_type + 1 : 0;
+            v->aac_object = stream->aac_object;
+            
+            srs_shm_stat_write_end(&v->seq);
+        }
+    }
+    
+    shm->sweep();
+}
+
 SrsStatisticVhost* SrsStatistic::create_vhost(SrsRequest* req)
 {
     SrsStatisticVhost* vhost = NULL;
@@ -597,3 +912,60 @@ SrsStatisticStream* SrsStatistic::create_stream(SrsStatisticVhost* vhost, SrsReq
     return stream;
 }
 
+SrsLatencyTracer::SrsLatencyTracer(int c)
+{
+    cid = c;
+    dump_time = 0;
+}
+
+SrsLatencyTracer::~SrsLatencyTracer()
+{
+}
+
+void SrsLatencyTracer::on_dump(SrsSharedPtrMessage** msgs, int count)
+{
+    dump_time = 0;
+    ingest_times.clear();
+    values.clear();
+    
+    for (int i = 0; i < count; i++) {
+        SrsSharedPtrMessage* msg = msgs[i];
+        if (msg->ingest_time() <= 0) {
+            continue;
+        }
+        
+        if (!dump_time) {
+            dump_time = srs_update_system_time();
+        }
+        
+        ingest_times.push_back(msg->ingest_time());
+        if (msg->enqueue_time > 0) {
+            values.push_back(dump_time - msg->enqueue_time);
+        }
+    }
+    
+    if (!values.empty()) {
+        SrsStatistic::instance()->on_latency(cid, SrsLatencyStageQueue, &values[0], (int)values.size());
+    }
+}
+
+void SrsLatencyTracer::on_sent()
+{
+    if (!dump_time) {
+        return;
+    }
+    
+    SrsStatistic* stat = SrsStatistic::instance();
+    srs_utime_t now = srs_update_system_time();
+    
+    srs_utime_t send = now - dump_time;
+    stat->on_latency(cid, SrsLatencyStageSend, &send, 1);
+    
+    values.clear();
+    for (int i = 0; i < (int)ingest_times.size(); i++) {
+        values.push_back(now - ingest_times.at(i));
+    }
+    stat->on_latency(cid, SrsLatencyStageTotal, &values[0], (int)values.size());
+    
+    dump_time = 0;
+}
@@ -39,6 +39,62 @@ class SrsRequest;
 class SrsConnection;
 class SrsJsonObject;
 class SrsJsonArray;
+class SrsShmStatistic;
+class SrsSharedPtrMessage;
+
+// The stages of latency, from the message received from publisher to sent to player.
+enum SrsLatencyStage
+{
+    // From the message received, to entered the source, by the publisher connection.
+    SrsLatencyStageIngest = 0,
+    // From entered the source, to delivered to the hub and consumers.
+    SrsLatencyStageHub,
+    // From queued in the consumer, to dumped by the player.
+    SrsLatencyStageQueue,
+    // From dumped by the player, to written to the socket.
+    SrsLatencyStageSend,
+    // From the message received, to written to the socket of player.
+    SrsLatencyStageTotal,
+    SrsLatencyStageMax,
+};
+
+// The histogram of latency in HDR style, the buckets are log-linear, each range of power of 2 is
+// divided to 8 sub-buckets, so the relative error is less than 12.5%, and the max value is about 71m.
+#define SRS_LATENCY_SUB_BITS 3
+#define SRS_LATENCY_BUCKETS ((32 - SRS_LATENCY_SUB_BITS + 1) << SRS_LATENCY_SUB_BITS)
+class SrsLatencyHistogram
+{
+private:
+    uint64_t buckets[SRS_LATENCY_BUCKETS];
+    uint64_t nn_samples;
+    srs_utime_t sum;
+    srs_utime_t max;
+public:
+    SrsLatencyHistogram();
+    virtual ~SrsLatencyHistogram();
+public:
+    // Add a sample of latency.
+    virtual void update(srs_utime_t v);
+    virtual uint64_t count();
+    virtual srs_utime_t average();
+    virtual srs_utime_t maximum();
+    // Get the latency at percentile p, in [0, 100], which is the upper of bucket.
+    virtual srs_utime_t percentile(double p);
+public:
+    virtual srs_error_t dumps(SrsJsonObject* obj);
+};
+
+// The latency of all stages, for vhost and stream.
+struct SrsStatisticLatency
+{
+public:
+    SrsLatencyHistogram stages[SrsLatencyStageMax];
+public:
+    SrsStatisticLatency();
+    virtual ~SrsStatisticLatency();
+public:
+    virtual srs_error_t dumps(SrsJsonObject* obj);
+};
 
 struct SrsStatisticVhost
 {
@@ -51,6 +107,8 @@ public:
     // The vhost total kbps.
     SrsKbps* kbps;
     SrsWallClock* clk;
+    // The latency of stages, NULL if not traced.
+    SrsStatisticLatency* latency;
 public:
     SrsStatisticVhost();
     virtual ~SrsStatisticVhost();
@@ -70,10 +128,16 @@ public:
     int connection_cid;
     int nb_clients;
     uint64_t nb_frames;
+    // The number of video frames dropped for congested players, by each step.
+    uint64_t nb_drop_bframes;
+    uint64_t nb_drop_nonrefs;
+    uint64_t nb_drop_gop_frames;
 public:
     // The stream total kbps.
     SrsKbps* kbps;
     SrsWallClock* clk;
+    // The latency of stages, NULL if not traced.
+    SrsStatisticLatency* latency;
 public:
     bool has_video;
     SrsVideoCodecId vcodec;
@@ -115,6 +179,8 @@ public:
     SrsRtmpConnType type;
     int id;
     srs_utime_t create;
+    // The send lag of player, the total latency of the last message sent, -1 if not traced.
+    srs_utime_t send_lag;
 public:
     SrsStatisticClient();
     virtual ~SrsStatisticClient();
@@ -166,12 +232,18 @@ public:
     // When got videos, update the frames.
     // We only stat the total number of video frames.
     virtual srs_error_t on_video_frames(SrsRequest* req, int nb_frames);
+    // When dropped video frames for congested player, update the dropped frames of each step.
+    virtual srs_error_t on_frames_dropped(SrsRequest* req, int bframes, int nonrefs, int gop_frames);
     // When publish stream.
     // @param req the request object of publish connection.
     // @param cid the cid of publish connection.
     virtual void on_stream_publish(SrsRequest* req, int cid);
     // When close stream.
     virtual void on_stream_close(SrsRequest* req);
+    // When traced the latency of stage, for the stream of client.
+    // @param cid The id of client, the publisher for ingest and hub, or the player for others.
+    // @param values The latency of messages.
+    virtual void on_latency(int cid, SrsLatencyStage stage, srs_utime_t* values, int nb_values);
 public:
     // When got a client to publish/play stream,
     // @param id, the client srs id.
@@ -203,9 +275,33 @@ public:
     // @param start the start index, from 0.
     // @param count the max count of clients to dump.
     virtual srs_error_t dumps_clients(SrsJsonArray* arr, int start, int count);
+    // Dumps the server, vhosts and streams to the shared memory segment, by the seqlock of each slot.
+    // @remark The vhosts and streams exceed the slots are ignored.
+    virtual void dumps_shm(SrsShmStatistic* shm);
 private:
     virtual SrsStatisticVhost* create_vhost(SrsRequest* req);
     virtual SrsStatisticStream* create_stream(SrsStatisticVhost* vhost, SrsRequest* req);
 };
 
+// Trace the latency of messages sent to a player, for the queue, send and total stages.
+// @remark Only the messages with ingest time are traced, see SrsSharedPtrMessage::ingest_time.
+class SrsLatencyTracer
+{
+private:
+    int cid;
+    // The time when the messages are dumped from consumer, 0 if not traced.
+    srs_utime_t dump_time;
+    // The ingest time of messages, because the messages maybe freed when sent.
+    std::vector<srs_utime_t> ingest_times;
+    std::vector<srs_utime_t> values;
+public:
+    SrsLatencyTracer(int c);
+    virtual ~SrsLatencyTracer();
+public:
+    // When dumped the messages from consumer, before sending them.
+    virtual void on_dump(SrsSharedPtrMessage** msgs, int count);
+    // When sent the dumped messages.
+    virtual void on_sent();
+};
+
 #endif
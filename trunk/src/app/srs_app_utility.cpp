@@ -35,6 +35,7 @@
 #include <sys/time.h>
 #include <math.h>
 #include <map>
+#include <st.h>
 #ifdef SRS_AUTO_OSX
 #include <sys/sysctl.h>
 #endif
@@ -1221,6 +1222,19 @@ void srs_api_dump_summaries(SrsJsonObject* obj)
     self->set("cpu_percent", SrsJsonAny::number(u->percent));
     self->set("srs_uptime", SrsJsonAny::integer(srs_uptime));
     
+    // The stacks of coroutines.
+    st_stack_stat_t ss;
+    st_stack_stat(&ss);
+    
+    SrsJsonObject* stack = SrsJsonAny::object();
+    self->set("stack", stack);
+    
+    stack->set("stacks", SrsJsonAny::integer(ss.nn_stacks));
+    stack->set("free", SrsJsonAny::integer(ss.nn_free));
+    stack->set("kbyte", SrsJsonAny::integer(ss.nn_bytes / 1024));
+    stack->set("reused", SrsJsonAny::integer(ss.nn_reused));
+    stack->set("unmapped", SrsJsonAny::integer(ss.nn_unmapped));
+    
     // system
     SrsJsonObject* sys = SrsJsonAny::object();
     data->set("system", sys);
@@ -23,8 +23,33 @@
 
 #include <srs_kernel_balance.hpp>
 
+#include <algorithm>
+#include <sstream>
+#include <math.h>
 using namespace std;
 
+#include <srs_kernel_utility.hpp>
+
+ISrsLbBalancer::ISrsLbBalancer()
+{
+}
+
+ISrsLbBalancer::~ISrsLbBalancer()
+{
+}
+
+void ISrsLbBalancer::on_success()
+{
+}
+
+void ISrsLbBalancer::on_failure()
+{
+}
+
+void ISrsLbBalancer::release()
+{
+}
+
 SrsLbRoundRobin::SrsLbRoundRobin()
 {
     index = -1;
@@ -55,3 +80,253 @@ string SrsLbRoundRobin::select(const vector<string>& servers)
     return elem;
 }
 
+
+SrsLbServer::SrsLbServer(string s)
+{
+    server = s;
+    load = 0;
+    failures = 0;
+    ejected_until = 0;
+    
+    nn_selected = 0;
+    nn_failures = 0;
+    nn_ejected = 0;
+}
+
+SrsLbServer::~SrsLbServer()
+{
+}
+
+bool SrsLbServer::healthy(srs_utime_t now)
+{
+    return ejected_until <= now;
+}
+
+SrsLbServerTable::SrsLbServerTable(int failures, srs_utime_t duration)
+{
+    max_failures = failures;
+    eject_duration = duration;
+}
+
+SrsLbServerTable::~SrsLbServerTable()
+{
+    map<string, SrsLbServer*>::iterator it;
+    for (it = servers.begin(); it != servers.end(); ++it) {
+        SrsLbServer* s = it->second;
+        srs_freep(s);
+    }
+    servers.clear();
+}
+
+SrsLbServer* SrsLbServerTable::fetch(string server)
+{
+    map<string, SrsLbServer*>::iterator it = servers.find(server);
+    if (it != servers.end()) {
+        return it->second;
+    }
+    
+    SrsLbServer* s = new SrsLbServer(server);
+    servers[server] = s;
+    return s;
+}
+
+vector<SrsLbServer*> SrsLbServerTable::list()
+{
+    vector<SrsLbServer*> arr;
+    
+    map<string, SrsLbServer*>::iterator it;
+    for (it = servers.begin(); it != servers.end(); ++it) {
+        arr.push_back(it->second);
+    }
+    
+    return arr;
+}
+
+void SrsLbServerTable::acquire(string server)
+{
+    SrsLbServer* s = fetch(server);
+    s->load++;
+    s->nn_selected++;
+}
+
+void SrsLbServerTable::release(string server)
+{
+    SrsLbServer* s = fetch(server);
+    if (s->load > 0) {
+        s->load--;
+    }
+}
+
+void SrsLbServerTable::on_success(string server)
+{
+    SrsLbServer* s = fetch(server);
+    s->failures = 0;
+}
+
+void SrsLbServerTable::on_failure(string server)
+{
+    SrsLbServer* s = fetch(server);
+    s->nn_failures++;
+    
+    // Eject the server for a while, when fail too many times.
+    if (++s->failures >= max_failures) {
+        s->failures = 0;
+        s->nn_ejected++;
+        s->ejected_until = srs_get_system_time() + eject_duration;
+    }
+}
+
+// The FNV-1a hash with murmur3 finalizer, to spread the nodes on ring.
+uint32_t srs_lb_hash(const string& str)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < (int)str.length(); i++) {
+        h ^= (uint8_t)str.at(i);
+        h *= 16777619u;
+    }
+    
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    
+    return h;
+}
+
+SrsLbConsistentHash::SrsLbConsistentHash(SrsLbServerTable* t, string k, double f, int r)
+{
+    table = t;
+    key = k;
+    factor = f;
+    replicas = srs_max(1, r);
+    
+    index = -1;
+    acquired = false;
+}
+
+SrsLbConsistentHash::~SrsLbConsistentHash()
+{
+    release();
+}
+
+uint32_t SrsLbConsistentHash::current()
+{
+    return index;
+}
+
+string SrsLbConsistentHash::selected()
+{
+    return elem;
+}
+
+string SrsLbConsistentHash::select(const vector<string>& candidates)
+{
+    srs_assert(!candidates.empty());
+    
+    // Release the previous server, which should not be counted as load.
+    release();
+    
+    if (candidates != servers) {
+        build_ring(candidates);
+    }
+    
+    srs_utime_t now = srs_get_system_time();
+    int capacity = max_load(now);
+    
+    // Walk the ring clockwise from the hash of key, select the first healthy server which is not overloaded.
+    // If all servers are overloaded, select the first healthy one; if all ejected, use the first one.
+    uint32_t h = srs_lb_hash(key);
+    int pos = (int)(std::lower_bound(ring.begin(), ring.end(), std::make_pair(h, 0)) - ring.begin());
+    
+    int first = -1, first_healthy = -1, found = -1;
+    for (int i = 0; i < (int)ring.size() && found == -1; i++) {
+        int idx = ring.at((pos + i) % ring.size()).second;
+        SrsLbServer* s = table->fetch(servers.at(idx));
+        
+        if (first == -1) {
+            first = idx;
+        }
+        if (!s->healthy(now)) {
+            continue;
+        }
+        if (first_healthy == -1) {
+            first_healthy = idx;
+        }
+        if (capacity <= 0 || s->load < capacity) {
+            found = idx;
+        }
+    }
+    
+    if (found == -1) {
+        found = (first_healthy != -1)? first_healthy : first;
+    }
+    
+    index = found;
+    elem = servers.at(index);
+    
+    table->acquire(elem);
+    acquired = true;
+    
+    return elem;
+}
+
+void SrsLbConsistentHash::on_success()
+{
+    if (!elem.empty()) {
+        table->on_success(elem);
+    }
+}
+
+void SrsLbConsistentHash::on_failure()
+{
+    if (!elem.empty()) {
+        table->on_failure(elem);
+    }
+}
+
+void SrsLbConsistentHash::release()
+{
+    if (acquired) {
+        table->release(elem);
+        acquired = false;
+    }
+}
+
+void SrsLbConsistentHash::build_ring(const vector<string>& candidates)
+{
+    servers = candidates;
+    ring.clear();
+    
+    for (int i = 0; i < (int)servers.size(); i++) {
+        for (int j = 0; j < replicas; j++) {
+            stringstream ss;
+            ss << servers.at(i) << "#" << j;
+            ring.push_back(std::make_pair(srs_lb_hash(ss.str()), i));
+        }
+    }
+    
+    std::sort(ring.begin(), ring.end());
+}
+
+int SrsLbConsistentHash::max_load(srs_utime_t now)
+{
+    if (factor <= 0) {
+        return 0;
+    }
+    
+    int total = 0, healthy = 0;
+    for (int i = 0; i < (int)servers.size(); i++) {
+        SrsLbServer* s = table->fetch(servers.at(i));
+        total += s->load;
+        if (s->healthy(now)) {
+            healthy++;
+        }
+    }
+    
+    // The average load including the stream to select, at least 1.
+    healthy = srs_max(1, healthy);
+    double avg = (double)(total + 1) / healthy;
+    
+    return srs_max(1, (int)::ceil(factor * avg));
+}
@@ -28,12 +28,34 @@
 
 #include <vector>
 #include <string>
+#include <map>
+
+/**
+ * The load balance algorithm to select a server from candidates,
+ * used for edge pull and other multiple server feature.
+ */
+class ISrsLbBalancer
+{
+public:
+    ISrsLbBalancer();
+    virtual ~ISrsLbBalancer();
+public:
+    virtual uint32_t current() = 0;
+    virtual std::string selected() = 0;
+    virtual std::string select(const std::vector<std::string>& servers) = 0;
+public:
+    // Feedback of the selected server, for health-aware balancer.
+    virtual void on_success();
+    virtual void on_failure();
+    // Release the selected server, when stream is not served by it any more.
+    virtual void release();
+};
 
 /**
  * the round-robin load balance algorithm,
  * used for edge pull and other multiple server feature.
  */
-class SrsLbRoundRobin
+class SrsLbRoundRobin : public ISrsLbBalancer
 {
 private:
     // current selected index.
@@ -51,5 +73,98 @@ public:
     virtual std::string select(const std::vector<std::string>& servers);
 };
 
+/**
+ * The health and load of a server, shared by all balancers.
+ */
+class SrsLbServer
+{
+public:
+    std::string server;
+    // The number of streams served by this server now.
+    int load;
+    // The consecutive failures, reset when success.
+    int failures;
+    // When ejected, the server is not selected until this time.
+    srs_utime_t ejected_until;
+public:
+    // The total number of selected, failed and ejected.
+    uint64_t nn_selected;
+    uint64_t nn_failures;
+    uint64_t nn_ejected;
+public:
+    SrsLbServer(std::string s);
+    virtual ~SrsLbServer();
+public:
+    virtual bool healthy(srs_utime_t now);
+};
+
+/**
+ * The table of servers, to share the load and health of servers between balancers,
+ * for example, all edge streams of the process.
+ */
+class SrsLbServerTable
+{
+private:
+    std::map<std::string, SrsLbServer*> servers;
+    // The max consecutive failures before server is ejected.
+    int max_failures;
+    // The duration for a ejected server.
+    srs_utime_t eject_duration;
+public:
+    SrsLbServerTable(int failures = 3, srs_utime_t duration = 30 * SRS_UTIME_SECONDS);
+    virtual ~SrsLbServerTable();
+public:
+    // Fetch the server, create one if not exists.
+    virtual SrsLbServer* fetch(std::string server);
+    // Get all servers, sort by name.
+    virtual std::vector<SrsLbServer*> list();
+    virtual void acquire(std::string server);
+    virtual void release(std::string server);
+    virtual void on_success(std::string server);
+    virtual void on_failure(std::string server);
+};
+
+/**
+ * The consistent hashing with bounded loads algorithm, to select server by key,
+ * so the same stream always goes to the same server, and only the streams of
+ * the ejected server are moved when it fails.
+ * @see https://arxiv.org/abs/1608.01350
+ */
+class SrsLbConsistentHash : public ISrsLbBalancer
+{
+private:
+    // The key to select server, for example, the stream url.
+    std::string key;
+    // The load factor, the max load of server is factor*average, 0 to disable.
+    double factor;
+    // The virtual nodes of each server in ring.
+    int replicas;
+    SrsLbServerTable* table;
+private:
+    // The servers to build the ring, rebuild when changed.
+    std::vector<std::string> servers;
+    // The ring of hash to index of servers, sort by hash.
+    std::vector< std::pair<uint32_t, int> > ring;
+    // Current selected index and server.
+    int index;
+    std::string elem;
+    // Whether the load of elem is acquired.
+    bool acquired;
+public:
+    SrsLbConsistentHash(SrsLbServerTable* t, std::string k, double f = 1.25, int r = 160);
+    virtual ~SrsLbConsistentHash();
+public:
+    virtual uint32_t current();
+    virtual std::string selected();
+    virtual std::string select(const std::vector<std::string>& servers);
+public:
+    virtual void on_success();
+    virtual void on_failure();
+    virtual void release();
+private:
+    virtual void build_ring(const std::vector<std::string>& servers);
+    virtual int max_load(srs_utime_t now);
+};
+
 #endif
 
@@ -565,8 +565,9 @@ srs_error_t SrsFormat::on_audio(int64_t timestamp, char* data, int size)
         return err;
     }
     
-    SrsBuffer* buffer = new SrsBuffer(data, size);
-    SrsAutoFree(SrsBuffer, buffer);
+    // Use the buffer on stack, for it's called for each frame.
+    SrsBuffer stream(data, size);
+    SrsBuffer* buffer = &stream;
     
     // We already checked the size is positive and data is not NULL.
     srs_assert(buffer->require(1));
@@ -609,8 +610,9 @@ srs_error_t SrsFormat::on_video(int64_t timestamp, char* data, int size)
         return err;
     }
     
-    SrsBuffer* buffer = new SrsBuffer(data, size);
-    SrsAutoFree(SrsBuffer, buffer);
+    // Use the buffer on stack, for it's called for each frame.
+    SrsBuffer stream(data, size);
+    SrsBuffer* buffer = &stream;
     
     // We already checked the size is positive and data is not NULL.
     srs_assert(buffer->require(1));
@@ -1109,43 +1111,33 @@ srs_error_t SrsFormat::avc_demux_annexb_format(SrsBuffer* stream)
     // AnnexB
     // B.1.1 Byte stream NAL unit syntax,
     // ISO_IEC_14496-10-AVC-2003.pdf, page 211.
-    while (!stream->empty()) {
-        // find start code
-        int nb_start_code = 0;
-        if (!srs_avc_startswith_annexb(stream, &nb_start_code)) {
-            return err;
-        }
-        
-        // skip the start code.
-        if (nb_start_code > 0) {
-            stream->skip(nb_start_code);
-        }
-        
-        // the NALU start bytes.
-        char* p = stream->data() + stream->pos();
+    char* end = stream->data() + stream->size();
+    int nb_start_code = 0;
+    char* p = srs_avc_find_annexb(stream->data() + stream->pos(), end, &nb_start_code);
+    
+    // Find each NALU by start code in one pass.
+    while (p) {
+        // skip the start code, the NALU start bytes.
+        char* bytes = p + nb_start_code;
         
         // get the last matched NALU
-        while (!stream->empty()) {
-            if (srs_avc_startswith_annexb(stream, NULL)) {
-                break;
-            }
-            
-            stream->skip(1);
-        }
-        
-        char* pp = stream->data() + stream->pos();
+        p = srs_avc_find_annexb(bytes, end, &nb_start_code);
+        char* pp = p? p : end;
         
         // skip the empty.
-        if (pp - p <= 0) {
+        if (pp - bytes <= 0) {
             continue;
         }
         
         // got the NALU.
-        if ((err = video->add_sample(p, (int)(pp - p))) != srs_success) {
+        if ((err = video->add_sample(bytes, (int)(pp - bytes))) != srs_success) {
             return srs_error_wrap(err, "add video frame");
         }
     }
     
+    // consume all bytes.
+    stream->skip(stream->left());
+    
     return err;
 }
 
@@ -1345,8 +1337,8 @@ srs_error_t SrsFormat::audio_aac_sequence_header_demux(char* data, int size)
 {
     srs_error_t err = srs_success;
     
-    SrsBuffer* buffer = new SrsBuffer(data, size);
-    SrsAutoFree(SrsBuffer, buffer);
+    SrsBuffer stream(data, size);
+    SrsBuffer* buffer = &stream;
     
     // only need to decode the first 2bytes:
     //      audioObjectType, aac_profile, 5bits.
@@ -118,6 +118,11 @@
 #define ERROR_SOCKET_SETREUSEADDR           1079
 #define ERROR_SOCKET_SETCLOSEEXEC           1080
 #define ERROR_SOCKET_ACCEPT                 1081
+#define ERROR_SOCKET_NOTSENT_LOWAT          1082
+#define ERROR_SOCKET_TCP_INFO               1083
+#define ERROR_SYSTEM_SHM_STAT               1084
+#define ERROR_SYSTEM_PROFILER               1085
+#define ERROR_SYSTEM_PROFILER_DISABLED      1086
 
 ///////////////////////////////////////////////////////
 // RTMP protocol error.
@@ -287,6 +292,7 @@
 #define ERROR_INOTIFY_CREATE                3092
 #define ERROR_INOTIFY_OPENFD                3093
 #define ERROR_INOTIFY_WATCH                 3094
+#define ERROR_HLS_M3U8_INVALID              3095
 
 ///////////////////////////////////////////////////////
 // HTTP/StreamCaster protocol error.
@@ -157,6 +157,7 @@ SrsCommonMessage::SrsCommonMessage()
 {
     payload = NULL;
     size = 0;
+    ingest_time = 0;
 }
 
 SrsCommonMessage::~SrsCommonMessage()
@@ -204,6 +205,7 @@ SrsSharedPtrMessage::SrsSharedPtrPayload::SrsSharedPtrPayload()
     payload = NULL;
     size = 0;
     shared_count = 0;
+    ingest_time = 0;
 }
 
 SrsSharedPtrMessage::SrsSharedPtrPayload::~SrsSharedPtrPayload()
@@ -216,6 +218,7 @@ SrsSharedPtrMessage::SrsSharedPtrPayload::~SrsSharedPtrPayload()
 
 SrsSharedPtrMessage::SrsSharedPtrMessage() : timestamp(0), stream_id(0), size(0), payload(NULL)
 {
+    enqueue_time = 0;
     ptr = NULL;
 }
 
@@ -244,6 +247,8 @@ srs_error_t SrsSharedPtrMessage::create(SrsCommonMessage* msg)
     msg->payload = NULL;
     msg->size = 0;
     
+    ptr->ingest_time = msg->ingest_time;
+    
     return err;
 }
 
@@ -305,6 +310,11 @@ bool SrsSharedPtrMessage::check(int stream_id)
     return false;
 }
 
+srs_utime_t SrsSharedPtrMessage::ingest_time()
+{
+    return ptr? ptr->ingest_time : 0;
+}
+
 bool SrsSharedPtrMessage::is_av()
 {
     return ptr->header.message_type == RTMP_MSG_AudioMessage
@@ -542,6 +552,47 @@ srs_error_t SrsFlvTransmuxer::write_tags(SrsSharedPtrMessage** msgs, int count)
     return err;
 }
 
+void SrsFlvTransmuxer::encode_tag(SrsSharedPtrMessage* msg, char* data)
+{
+    if (msg->is_audio()) {
+        cache_audio(msg->timestamp, msg->payload, msg->size, data);
+    } else if (msg->is_video()) {
+        cache_video(msg->timestamp, msg->payload, msg->size, data);
+    } else {
+        cache_metadata(SrsFrameTypeScript, msg->payload, msg->size, data);
+    }
+    
+    memcpy(data + SRS_FLV_TAG_HEADER_SIZE, msg->payload, msg->size);
+    cache_pts(SRS_FLV_TAG_HEADER_SIZE + msg->size, data + SRS_FLV_TAG_HEADER_SIZE + msg->size);
+}
+
+srs_error_t SrsFlvTransmuxer::write_encoded_tags(SrsSharedPtrMessage** msgs, int count)
+{
+    srs_error_t err = srs_success;
+    
+    // realloc the iovss.
+    iovec* iovss = iovss_cache;
+    if (nb_iovss_cache < count) {
+        srs_freepa(iovss_cache);
+        
+        nb_iovss_cache = count;
+        iovss = iovss_cache = new iovec[count];
+    }
+    
+    // the tag is encoded, one iovec for each.
+    for (int i = 0; i < count; i++) {
+        SrsSharedPtrMessage* msg = msgs[i];
+        iovss[i].iov_base = msg->payload;
+        iovss[i].iov_len = msg->size;
+    }
+    
+    if ((err = writer->writev(iovss, count, NULL)) != srs_success) {
+        return srs_error_wrap(err, "write flv encoded tags failed");
+    }
+    
+    return err;
+}
+
 void SrsFlvTransmuxer::cache_metadata(char type, char* data, int size, char* cache)
 {
     srs_assert(data);
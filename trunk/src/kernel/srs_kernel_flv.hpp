@@ -216,6 +216,9 @@ public:
     // @remark, not all message payload can be decoded to packet. for example,
     //       video/audio packet use raw bytes, no video/audio packet.
     char* payload;
+public:
+    // The time when the message is received, to trace the latency, 0 if not traced.
+    srs_utime_t ingest_time;
 public:
     SrsCommonMessage();
     virtual ~SrsCommonMessage();
@@ -285,6 +288,9 @@ public:
     // @remark, not all message payload can be decoded to packet. for example,
     //       video/audio packet use raw bytes, no video/audio packet.
     char* payload;
+public:
+    // The time when this copy is queued to consumer, to trace the latency, 0 if not traced.
+    srs_utime_t enqueue_time;
 private:
     class SrsSharedPtrPayload
     {
@@ -298,6 +304,8 @@ private:
         int size;
         // The reference count
         int shared_count;
+        // The time when the message is received, 0 if not traced.
+        srs_utime_t ingest_time;
     public:
         SrsSharedPtrPayload();
         virtual ~SrsSharedPtrPayload();
@@ -327,6 +335,8 @@ public:
     // check perfer cid and stream id.
     // @return whether stream id already set.
     virtual bool check(int stream_id);
+    // Get the time when the message is received, shared by all copies, 0 if not traced.
+    virtual srs_utime_t ingest_time();
 public:
     virtual bool is_av();
     virtual bool is_audio();
@@ -394,6 +404,11 @@ private:
 public:
     // Write the tags in a time.
     virtual srs_error_t write_tags(SrsSharedPtrMessage** msgs, int count);
+    // Encode the message to a tag, including the tag header, body and previous tag size.
+    // @param data, the buffer to write to, whose size must be size_tag(msg->size).
+    virtual void encode_tag(SrsSharedPtrMessage* msg, char* data);
+    // Write the tags encoded by encode_tag in a time.
+    virtual srs_error_t write_encoded_tags(SrsSharedPtrMessage** msgs, int count);
 private:
     virtual void cache_metadata(char type, char* data, int size, char* cache);
     virtual void cache_audio(int64_t timestamp, char* data, int size, char* cache);
@@ -145,6 +145,25 @@ bool SrsTsMessage::fresh()
     return payload->length() == 0;
 }
 
+void SrsTsMessage::reset()
+{
+    dts = pts = 0;
+    sid = (SrsTsPESStreamId)0x00;
+    continuity_counter = 0;
+    PES_packet_length = 0;
+    is_discontinuity = false;
+    
+    start_pts = 0;
+    write_pcr = false;
+    
+    // the payload maybe detached.
+    if (payload) {
+        payload->erase(payload->length());
+    } else {
+        payload = new SrsSimpleStream();
+    }
+}
+
 bool SrsTsMessage::is_audio()
 {
     return ((sid >> 5) & 0x07) == SrsTsPESStreamIdAudioChecker;
@@ -200,10 +219,13 @@ SrsTsContext::SrsTsContext()
     sync_byte = 0x47; // ts default sync byte.
     vcodec = SrsVideoCodecIdReserved;
     acodec = SrsAudioCodecIdReserved1;
+    packet = new SrsTsPacket(this);
 }
 
 SrsTsContext::~SrsTsContext()
 {
+    srs_freep(packet);
+    
     std::map<int, SrsTsChannel*>::iterator it;
     for (it = pids.begin(); it != pids.end(); ++it) {
         SrsTsChannel* channel = it->second;
@@ -269,9 +291,6 @@ srs_error_t SrsTsContext::decode(SrsBuffer* stream, ISrsTsHandler* handler)
     // parse util EOF of stream.
     // for example, parse multiple times for the PES_packet_length(0) packet.
     while (!stream->empty()) {
-        SrsTsPacket* packet = new SrsTsPacket(this);
-        SrsAutoFree(SrsTsPacket, packet);
-        
         SrsTsMessage* msg = NULL;
         if ((err = packet->decode(stream, &msg)) != srs_success) {
             return srs_error_wrap(err, "ts: ts packet decode");
@@ -280,9 +299,20 @@ srs_error_t SrsTsContext::decode(SrsBuffer* stream, ISrsTsHandler* handler)
         if (!msg) {
             continue;
         }
-        SrsAutoFree(SrsTsMessage, msg);
         
-        if ((err = handler->on_ts_message(msg)) != srs_success) {
+        err = handler->on_ts_message(msg);
+        
+        // reuse the message for the next one of channel,
+        // for the channel never decodes util the reaped message handled.
+        SrsTsChannel* channel = msg->channel;
+        if (!channel->msg) {
+            msg->reset();
+            channel->msg = msg;
+        } else {
+            srs_freep(msg);
+        }
+        
+        if (err != srs_success) {
             return srs_error_wrap(err, "ts: handle ts message");
         }
     }
@@ -548,12 +578,20 @@ SrsTsPacket::SrsTsPacket(SrsTsContext* c)
     continuity_counter = 0;
     adaptation_field = NULL;
     payload = NULL;
+    cached_af = NULL;
+    cached_pes = NULL;
 }
 
 SrsTsPacket::~SrsTsPacket()
 {
-    srs_freep(adaptation_field);
-    srs_freep(payload);
+    if (adaptation_field != cached_af) {
+        srs_freep(adaptation_field);
+    }
+    if (payload != cached_pes) {
+        srs_freep(payload);
+    }
+    srs_freep(cached_af);
+    srs_freep(cached_pes);
 }
 
 srs_error_t SrsTsPacket::decode(SrsBuffer* stream, SrsTsMessage** ppmsg)
@@ -562,6 +600,16 @@ srs_error_t SrsTsPacket::decode(SrsBuffer* stream, SrsTsMessage** ppmsg)
     
     int pos = stream->pos();
     
+    // drop the fields of previous packet, keep the cache to reuse.
+    if (adaptation_field != cached_af) {
+        srs_freep(adaptation_field);
+    }
+    if (payload != cached_pes) {
+        srs_freep(payload);
+    }
+    adaptation_field = NULL;
+    payload = NULL;
+    
     // 4B ts packet header.
     if (!stream->require(4)) {
         return srs_error_new(ERROR_STREAM_CASTER_TS_HEADER, "ts: decode packet");
@@ -591,8 +639,10 @@ srs_error_t SrsTsPacket::decode(SrsBuffer* stream, SrsTsMessage** ppmsg)
     
     // optional: adaptation field
     if (adaption_field_control == SrsTsAdaptationFieldTypeAdaptionOnly || adaption_field_control == SrsTsAdaptationFieldTypeBoth) {
-        srs_freep(adaptation_field);
-        adaptation_field = new SrsTsAdaptationField(this);
+        if (!cached_af) {
+            cached_af = new SrsTsAdaptationField(this);
+        }
+        adaptation_field = cached_af;
         
         if ((err = adaptation_field->decode(stream)) != srs_success) {
             return srs_error_wrap(err, "ts: demux af field");
@@ -607,18 +657,18 @@ srs_error_t SrsTsPacket::decode(SrsBuffer* stream, SrsTsMessage** ppmsg)
     if (adaption_field_control == SrsTsAdaptationFieldTypePayloadOnly || adaption_field_control == SrsTsAdaptationFieldTypeBoth) {
         if (pid == SrsTsPidPAT) {
             // 2.4.4.3 Program association Table
-            srs_freep(payload);
             payload = new SrsTsPayloadPAT(this);
         } else {
             SrsTsChannel* channel = context->get(pid);
             if (channel && channel->apply == SrsTsPidApplyPMT) {
                 // 2.4.4.8 Program Map Table
-                srs_freep(payload);
                 payload = new SrsTsPayloadPMT(this);
             } else if (channel && (channel->apply == SrsTsPidApplyVideo || channel->apply == SrsTsPidApplyAudio)) {
                 // 2.4.3.6 PES packet
-                srs_freep(payload);
-                payload = new SrsTsPayloadPES(this);
+                if (!cached_pes) {
+                    cached_pes = new SrsTsPayloadPES(this);
+                }
+                payload = cached_pes;
             } else {
                 // left bytes as reserved.
                 stream->skip(srs_min(stream->left(), nb_payload));
@@ -1318,8 +1368,7 @@ srs_error_t SrsTsPayloadPES::decode(SrsBuffer* stream, SrsTsMessage** ppmsg)
         
         // reparse current msg.
         stream->skip(stream->pos() * -1);
-        srs_freep(msg);
-        channel->msg = NULL;
+        msg->reset();
         return err;
     }
     
@@ -1339,8 +1388,7 @@ srs_error_t SrsTsPayloadPES::decode(SrsBuffer* stream, SrsTsMessage** ppmsg)
             
             // reparse current msg.
             stream->skip(stream->pos() * -1);
-            srs_freep(msg);
-            channel->msg = NULL;
+            msg->reset();
             return err;
         }
     }
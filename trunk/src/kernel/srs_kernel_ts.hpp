@@ -44,6 +44,7 @@ class SrsFormat;
 class SrsSimpleStream;
 class SrsTsAdaptationField;
 class SrsTsPayload;
+class SrsTsPayloadPES;
 class SrsTsMessage;
 class SrsTsPacket;
 class SrsTsContext;
@@ -277,6 +278,8 @@ public:
     virtual bool completed(int8_t payload_unit_start_indicator);
     // Whether the message is fresh.
     virtual bool fresh();
+    // Reset the message to decode the next one, reuse the payload buffer.
+    virtual void reset();
 public:
     // Whether the sid indicates the elementary stream audio.
     virtual bool is_audio();
@@ -318,6 +321,8 @@ private:
     std::map<int, SrsTsChannel*> pids;
     bool pure_audio;
     int8_t sync_byte;
+    // The packet to decode, reused for each ts packet.
+    SrsTsPacket* packet;
     // encoder
 private:
     // when any codec changed, write the PAT/PMT.
@@ -346,6 +351,8 @@ public:
     // The stream contains only one ts packet.
     // @param handler the ts message handler to process the msg.
     // @remark we will consume all bytes in stream.
+    // @remark The packet and message are reused, the message is reset after handled,
+    //       so handler should detach it to keep the payload.
     virtual srs_error_t decode(SrsBuffer* stream, ISrsTsHandler* handler);
     // encode methods
 public:
@@ -442,6 +449,9 @@ public:
 private:
     SrsTsAdaptationField* adaptation_field;
     SrsTsPayload* payload;
+    // The cache to decode, reused when decode packets.
+    SrsTsAdaptationField* cached_af;
+    SrsTsPayloadPES* cached_pes;
 public:
     SrsTsContext* context;
 public:
@@ -36,6 +36,10 @@
 #include <fcntl.h>
 #include <stdlib.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include <vector>
 #include <algorithm>
 using namespace std;
@@ -743,6 +747,105 @@ bool srs_avc_startswith_annexb(SrsBuffer* stream, int* pnb_start_code)
     return false;
 }
 
+char* srs_avc_find_annexb(char* p, char* end, int* pnb_start_code)
+{
+    uint8_t* s = (uint8_t*)p;
+    uint8_t* e = (uint8_t*)end;
+    
+    // Match the 3B "00 00 01" in the block, compare bytes at offset 0, 1 and 2 of each position,
+    // so we get a mask of all matched positions in the block.
+#if defined(__AVX2__)
+    const __m256i zero32 = _mm256_setzero_si256();
+    const __m256i one32 = _mm256_set1_epi8(1);
+    while (e - s >= 34) {
+        __m256i b0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)s), zero32);
+        __m256i b1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + 1)), zero32);
+        __m256i b2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + 2)), one32);
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(b0, b1), b2));
+        if (mask) {
+            s += __builtin_ctz(mask);
+            goto matched;
+        }
+        s += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    {
+        const __m128i zero16 = _mm_setzero_si128();
+        const __m128i one16 = _mm_set1_epi8(1);
+        while (e - s >= 18) {
+            __m128i b0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)s), zero16);
+            __m128i b1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + 1)), zero16);
+            __m128i b2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + 2)), one16);
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(b0, b1), b2));
+            if (mask) {
+                s += __builtin_ctz(mask);
+                goto matched;
+            }
+            s += 16;
+        }
+    }
+#endif
+    
+    // The scalar skip-scan, check the third byte first, which is not 0 or 1 for most positions,
+    // so we are able to skip 3 bytes at once.
+    while (e - s >= 3) {
+        if (s[2] > 1) {
+            s += 3;
+        } else if (s[1]) {
+            s += 2;
+        } else if (s[0] || s[2] != 1) {
+            s++;
+        } else {
+            goto matched;
+        }
+    }
+    
+    return NULL;
+    
+matched:
+    // Include the prefix N[00], which is also the trailing zeros of previous NALU.
+    uint8_t* start = s;
+    while (start > (uint8_t*)p && start[-1] == 0x00) {
+        start--;
+    }
+    
+    if (pnb_start_code) {
+        *pnb_start_code = (int)(s - start) + 3;
+    }
+    return (char*)start;
+}
+
+int srs_avc_split_annexb(char* data, int size, SrsAnnexbNalu* nalus, int max)
+{
+    char* end = data + size;
+    
+    // Must start with the start code.
+    int nb_start_code = 0;
+    char* p = srs_avc_find_annexb(data, end, &nb_start_code);
+    if (p != data) {
+        return -1;
+    }
+    
+    int nn = 0;
+    while (p && nn < max) {
+        char* bytes = p + nb_start_code;
+        
+        // The NALU ends at the next start code, or the end of data.
+        p = srs_avc_find_annexb(bytes, end, &nb_start_code);
+        char* last = p? p : end;
+        
+        // Ignore the empty NALU.
+        if (last > bytes) {
+            nalus[nn].bytes = bytes;
+            nalus[nn].size = (int)(last - bytes);
+            nn++;
+        }
+    }
+    
+    return nn;
+}
+
 bool srs_aac_startswith_adts(SrsBuffer* stream)
 {
     if (!stream) {
@@ -129,6 +129,27 @@ extern std::string srs_path_filext(std::string path);
 // @param pnb_start_code output the size of start code, must >=3. NULL to ignore.
 extern bool srs_avc_startswith_annexb(SrsBuffer* stream, int* pnb_start_code = NULL);
 
+// Find the first avc annexb start code "N[00] 00 00 01" in bytes [p, end), where N>=0.
+// The scanner uses SSE2/AVX2 when available, and falls back to the scalar skip-scan.
+// @param pnb_start_code output the size of start code, must >=3. NULL to ignore.
+// @return the first byte of start code, or NULL if not found.
+extern char* srs_avc_find_annexb(char* p, char* end, int* pnb_start_code = NULL);
+
+// The NALU in annexb stream, the bytes point to the source data, user must manage it.
+struct SrsAnnexbNalu
+{
+    char* bytes;
+    int size;
+};
+
+// The max NALUs to split in one pass, generally more than the NALUs of a frame.
+#define SRS_AVC_MAX_NALUS 64
+
+// Split all NALUs of annexb bytes in one pass, the empty NALUs are ignored.
+// @param nalus the output NALUs, at most max NALUs are written.
+// @return the number of NALUs, or -1 if not start with annexb. Stop when got max NALUs.
+extern int srs_avc_split_annexb(char* data, int size, SrsAnnexbNalu* nalus, int max);
+
 // Whether stream starts with the aac ADTS from ISO_IEC_14496-3-AAC-2001.pdf, page 75, 1.A.2.2 ADTS.
 // The start code must be '1111 1111 1111'B, that is 0xFFF
 extern bool srs_aac_startswith_adts(SrsBuffer* stream);
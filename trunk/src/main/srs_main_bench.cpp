@@ -0,0 +1,1148 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <srs_core.hpp>
+
+#include <srs_kernel_error.hpp>
+#include <srs_service_log.hpp>
+#include <srs_kernel_buffer.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_kernel_codec.hpp>
+#include <srs_kernel_ts.hpp>
+#include <srs_kernel_stream.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_rtmp_stack.hpp>
+#include <srs_protocol_amf0.hpp>
+#include <srs_protocol_io.hpp>
+#include <srs_protocol_json.hpp>
+#include <srs_http_stack.hpp>
+#include <srs_service_http_conn.hpp>
+#include <srs_service_st.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <st.h>
+#include <string>
+using namespace std;
+
+// @global log and context.
+ISrsLog* _srs_log = new SrsConsoleLog(SrsLogLevelError, false);
+ISrsThreadContext* _srs_context = new SrsThreadContext();
+
+// The number and bytes of allocations, counted by the malloc hooks.
+static int64_t _srs_bench_allocs = 0;
+static int64_t _srs_bench_alloc_bytes = 0;
+
+// Hook the malloc of glibc, which is also used by the operator new of libstdc++, to count the
+// allocations of the hot path. Other libc has no counter, the allocs/op is always 0.
+#ifdef __GLIBC__
+extern "C" {
+    extern void* __libc_malloc(size_t size);
+    extern void* __libc_calloc(size_t nmemb, size_t size);
+    extern void* __libc_realloc(void* ptr, size_t size);
+    
+    void* malloc(size_t size)
+    {
+        _srs_bench_allocs++;
+        _srs_bench_alloc_bytes += size;
+        return __libc_malloc(size);
+    }
+    
+    void* calloc(size_t nmemb, size_t size)
+    {
+        _srs_bench_allocs++;
+        _srs_bench_alloc_bytes += nmemb * size;
+        return __libc_calloc(nmemb, size);
+    }
+    
+    void* realloc(void* ptr, size_t size)
+    {
+        _srs_bench_allocs++;
+        _srs_bench_alloc_bytes += size;
+        return __libc_realloc(ptr, size);
+    }
+}
+#endif
+
+// The monotonic clock in ns, because the srs_utime_t is in us.
+int64_t srs_bench_now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// The context of a benchmark, which runs the loop for n times, between start and stop.
+// @remark The setup before start and the cleanup after stop are not counted.
+class SrsBench
+{
+public:
+    int n;
+    // The elapsed time in ns, the allocations between start and stop.
+    int64_t elapsed;
+    int64_t allocs;
+    int64_t alloc_bytes;
+    // The bytes processed by each op, to calculate the MB/s, optional.
+    int64_t bytes;
+private:
+    int64_t starttime;
+    int64_t start_allocs;
+    int64_t start_alloc_bytes;
+public:
+    SrsBench(int v) {
+        n = v;
+        elapsed = allocs = alloc_bytes = bytes = 0;
+        starttime = start_allocs = start_alloc_bytes = 0;
+    }
+public:
+    void start() {
+        start_allocs = _srs_bench_allocs;
+        start_alloc_bytes = _srs_bench_alloc_bytes;
+        starttime = srs_bench_now();
+    }
+    void stop() {
+        elapsed = srs_bench_now() - starttime;
+        allocs = _srs_bench_allocs - start_allocs;
+        alloc_bytes = _srs_bench_alloc_bytes - start_alloc_bytes;
+    }
+};
+
+// The IO for protocol, which reads the data in loop and drops the written data.
+class SrsBenchIO : public ISrsProtocolReadWriter
+{
+private:
+    string data;
+    size_t pos;
+    int64_t rbytes;
+    int64_t sbytes;
+    srs_utime_t rtm;
+    srs_utime_t stm;
+public:
+    SrsBenchIO(string v = "") {
+        data = v;
+        pos = 0;
+        rbytes = sbytes = 0;
+        rtm = stm = SRS_UTIME_NO_TIMEOUT;
+    }
+    virtual ~SrsBenchIO() {
+    }
+// Interface ISrsProtocolReadWriter
+public:
+    virtual srs_error_t read(void* buf, size_t size, ssize_t* nread) {
+        if (data.empty()) {
+            return srs_error_new(ERROR_SOCKET_READ, "no data");
+        }
+        
+        size = srs_min(size, data.length() - pos);
+        memcpy(buf, data.data() + pos, size);
+        if ((pos += size) >= data.length()) {
+            pos = 0;
+        }
+        
+        rbytes += size;
+        if (nread) {
+            *nread = size;
+        }
+        return srs_success;
+    }
+    virtual srs_error_t read_fully(void* buf, size_t size, ssize_t* nread) {
+        srs_error_t err = srs_success;
+        
+        size_t left = size;
+        while (left > 0) {
+            ssize_t nn = 0;
+            if ((err = read((char*)buf + size - left, left, &nn)) != srs_success) {
+                return err;
+            }
+            left -= nn;
+        }
+        
+        if (nread) {
+            *nread = size;
+        }
+        return err;
+    }
+    virtual srs_error_t write(void* /*buf*/, size_t size, ssize_t* nwrite) {
+        sbytes += size;
+        if (nwrite) {
+            *nwrite = size;
+        }
+        return srs_success;
+    }
+    virtual srs_error_t writev(const iovec *iov, int iov_size, ssize_t* nwrite) {
+        ssize_t size = 0;
+        for (int i = 0; i < iov_size; i++) {
+            size += iov[i].iov_len;
+        }
+        return write(NULL, size, nwrite);
+    }
+    virtual void set_recv_timeout(srs_utime_t tm) {
+        rtm = tm;
+    }
+    virtual srs_utime_t get_recv_timeout() {
+        return rtm;
+    }
+    virtual int64_t get_recv_bytes() {
+        return rbytes;
+    }
+    virtual void set_send_timeout(srs_utime_t tm) {
+        stm = tm;
+    }
+    virtual srs_utime_t get_send_timeout() {
+        return stm;
+    }
+    virtual int64_t get_send_bytes() {
+        return sbytes;
+    }
+};
+
+// The IO to capture the written data, to generate the input of decoder.
+class SrsBenchCaptureIO : public SrsBenchIO
+{
+public:
+    string captured;
+public:
+    virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite) {
+        if (buf) {
+            captured.append((char*)buf, size);
+        }
+        return SrsBenchIO::write(buf, size, nwrite);
+    }
+    virtual srs_error_t writev(const iovec *iov, int iov_size, ssize_t* nwrite) {
+        for (int i = 0; i < iov_size; i++) {
+            captured.append((char*)iov[i].iov_base, iov[i].iov_len);
+        }
+        return SrsBenchIO::writev(iov, iov_size, nwrite);
+    }
+};
+
+// The H.264 High 3.1 sequence header, in FLV video tag.
+static uint8_t _srs_bench_avc_sh[] = {
+    0x17, 0x00, 0x00, 0x00, 0x00, 0x01, 0x64, 0x00, 0x1f, 0xff, 0xe1, 0x00, 0x1a,
+    0x67, 0x64, 0x00, 0x1f, 0xac, 0xd9, 0x40, 0x50, 0x05, 0xbb, 0x01, 0x10, 0x00, 0x00, 0x03,
+    0x00, 0x10, 0x00, 0x00, 0x03, 0x03, 0x20, 0xf1, 0x83, 0x19, 0x60,
+    0x01, 0x00, 0x06, 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0
+};
+
+// Generate a FLV video tag of AVC NALUs, with a SEI and a slice of size bytes.
+string srs_bench_avc_frame(int size)
+{
+    string frame("\x27\x01\x00\x00\x00", 5);
+    
+    // The SEI of 18 bytes.
+    frame.append("\x00\x00\x00\x12\x06\x05\x0e", 7);
+    frame.append(14, (char)0x5a);
+    frame.append(1, (char)0x80);
+    
+    // The non-IDR slice.
+    char header[4];
+    SrsBuffer buf(header, 4);
+    buf.write_4bytes(size);
+    frame.append(header, 4);
+    frame.append(1, (char)0x41);
+    frame.append(size - 1, (char)0xa5);
+    
+    return frame;
+}
+
+// Create a shared message of type, with size bytes payload.
+SrsSharedPtrMessage* srs_bench_create_msg(char type, uint32_t time, string payload)
+{
+    SrsMessageHeader h;
+    h.message_type = type;
+    h.timestamp = time;
+    h.stream_id = 1;
+    h.payload_length = (int32_t)payload.length();
+    
+    char* data = new char[payload.length()];
+    memcpy(data, payload.data(), payload.length());
+    
+    SrsSharedPtrMessage* msg = new SrsSharedPtrMessage();
+    if (msg->create(&h, data, (int)payload.length()) != srs_success) {
+        srs_assert(false);
+    }
+    return msg;
+}
+
+// Encode a video message of 4KB to chunks of 60000 bytes, which is the path of player.
+srs_error_t srs_bench_rtmp_encode(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    SrsBenchIO io;
+    SrsProtocol proto(&io);
+    SrsSetChunkSizePacket* pkt = new SrsSetChunkSizePacket();
+    pkt->chunk_size = SRS_CONSTS_RTMP_SRS_CHUNK_SIZE;
+    if ((err = proto.send_and_free_packet(pkt, 0)) != srs_success) {
+        return srs_error_wrap(err, "set chunk size");
+    }
+    
+    SrsSharedPtrMessage* msg = srs_bench_create_msg(RTMP_MSG_VideoMessage, 0, srs_bench_avc_frame(4096));
+    SrsAutoFree(SrsSharedPtrMessage, msg);
+    b->bytes = msg->size;
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        if ((err = proto.send_and_free_message(msg->copy(), 1)) != srs_success) {
+            return srs_error_wrap(err, "send");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Decode the video and audio messages from chunks of 128 bytes, which is the path of publisher.
+srs_error_t srs_bench_rtmp_decode(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    // Encode 5 audio messages for each video message, in default chunk size.
+    SrsBenchCaptureIO capture;
+    if (true) {
+        SrsProtocol proto(&capture);
+        for (int i = 0; i < 8; i++) {
+            SrsSharedPtrMessage* msg = srs_bench_create_msg(RTMP_MSG_VideoMessage, i * 40, srs_bench_avc_frame(4096));
+            if ((err = proto.send_and_free_message(msg, 1)) != srs_success) {
+                return srs_error_wrap(err, "send video");
+            }
+            
+            for (int j = 0; j < 5; j++) {
+                msg = srs_bench_create_msg(RTMP_MSG_AudioMessage, i * 40 + j * 8, string("\xaf\x01", 2) + string(200, (char)0x21));
+                if ((err = proto.send_and_free_message(msg, 1)) != srs_success) {
+                    return srs_error_wrap(err, "send audio");
+                }
+            }
+        }
+    }
+    
+    SrsBenchIO io(capture.captured);
+    SrsProtocol proto(&io);
+    b->bytes = capture.captured.length() / 48;
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        SrsCommonMessage* msg = NULL;
+        if ((err = proto.recv_message(&msg)) != srs_success) {
+            return srs_error_wrap(err, "recv");
+        }
+        srs_freep(msg);
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Encode the message to RTMP chunks in a message, as the burst cache of source does.
+SrsSharedPtrMessage* srs_bench_encode_chunks(SrsSharedPtrMessage* msg, int stream_id, int chunk_size)
+{
+    msg->check(stream_id);
+    
+    int nb_chunks = (msg->size + chunk_size - 1) / chunk_size;
+    char* data = new char[msg->size + SRS_CONSTS_RTMP_MAX_FMT0_HEADER_SIZE + nb_chunks * SRS_CONSTS_RTMP_MAX_FMT3_HEADER_SIZE];
+    
+    char* p = data;
+    for (char* payload = msg->payload; payload < msg->payload + msg->size; payload += chunk_size) {
+        p += msg->chunk_header(p, SRS_CONSTS_RTMP_MAX_FMT0_HEADER_SIZE, payload == msg->payload);
+        
+        int size = srs_min(chunk_size, (int)(msg->payload + msg->size - payload));
+        memcpy(p, payload, size);
+        p += size;
+    }
+    
+    return srs_bench_create_msg(msg->is_video()? RTMP_MSG_VideoMessage : RTMP_MSG_AudioMessage, (uint32_t)msg->timestamp,
+        string(data, p - data));
+}
+
+// Send the gop cache in a burst, which is the start of each player, for a gop of 4s,
+// 25fps video about 8Mbps and 50fps audio, copied from the shared messages.
+// @param encoded Whether the messages are pre-encoded to chunks, or encoded by each player.
+srs_error_t srs_bench_rtmp_send_gop(SrsBench* b, bool encoded)
+{
+    srs_error_t err = srs_success;
+    
+    SrsBenchIO io;
+    SrsProtocol proto(&io);
+    SrsSetChunkSizePacket* pkt = new SrsSetChunkSizePacket();
+    pkt->chunk_size = SRS_CONSTS_RTMP_SRS_CHUNK_SIZE;
+    if ((err = proto.send_and_free_packet(pkt, 0)) != srs_success) {
+        return srs_error_wrap(err, "set chunk size");
+    }
+    
+    std::vector<SrsSharedPtrMessage*> gop;
+    for (int i = 0; i < 100; i++) {
+        gop.push_back(srs_bench_create_msg(RTMP_MSG_VideoMessage, i * 40, srs_bench_avc_frame(40 * 1024)));
+        gop.push_back(srs_bench_create_msg(RTMP_MSG_AudioMessage, i * 40, string("\xaf\x01\x21\x10", 4)));
+        gop.push_back(srs_bench_create_msg(RTMP_MSG_AudioMessage, i * 40 + 20, string("\xaf\x01\x21\x10", 4)));
+    }
+    
+    for (int i = 0; i < (int)gop.size(); i++) {
+        b->bytes += gop[i]->size;
+        
+        if (encoded) {
+            SrsSharedPtrMessage* msg = gop[i];
+            gop[i] = srs_bench_encode_chunks(msg, 1, SRS_CONSTS_RTMP_SRS_CHUNK_SIZE);
+            srs_freep(msg);
+        }
+    }
+    
+    std::vector<SrsSharedPtrMessage*> burst(gop.size());
+    
+    b->start();
+    for (int i = 0; i < b->n && err == srs_success; i++) {
+        for (int j = 0; j < (int)gop.size(); j++) {
+            burst[j] = gop[j]->copy();
+        }
+        
+        if (encoded) {
+            err = proto.send_and_free_chunks(&burst[0], (int)burst.size());
+        } else {
+            err = proto.send_and_free_messages(&burst[0], (int)burst.size(), 1);
+        }
+    }
+    b->stop();
+    
+    for (int i = 0; i < (int)gop.size(); i++) {
+        srs_freep(gop[i]);
+    }
+    
+    if (err != srs_success) {
+        return srs_error_wrap(err, "send gop");
+    }
+    
+    return err;
+}
+
+srs_error_t srs_bench_rtmp_send_gop_messages(SrsBench* b)
+{
+    return srs_bench_rtmp_send_gop(b, false);
+}
+
+srs_error_t srs_bench_rtmp_send_gop_chunks(SrsBench* b)
+{
+    return srs_bench_rtmp_send_gop(b, true);
+}
+
+// Decode the connect app command, which is the AMF0 command of each client.
+srs_error_t srs_bench_amf0_decode(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    SrsConnectAppPacket* pkt = new SrsConnectAppPacket();
+    SrsAutoFree(SrsConnectAppPacket, pkt);
+    
+    pkt->command_object->set("app", SrsAmf0Any::str("live"));
+    pkt->command_object->set("flashVer", SrsAmf0Any::str("WIN 12,0,0,41"));
+    pkt->command_object->set("swfUrl", SrsAmf0Any::str("http://ossrs.net/players/srs_player.swf"));
+    pkt->command_object->set("tcUrl", SrsAmf0Any::str("rtmp://ossrs.net/live?vhost=show.ossrs.net"));
+    pkt->command_object->set("fpad", SrsAmf0Any::boolean(false));
+    pkt->command_object->set("capabilities", SrsAmf0Any::number(239));
+    pkt->command_object->set("audioCodecs", SrsAmf0Any::number(3575));
+    pkt->command_object->set("videoCodecs", SrsAmf0Any::number(252));
+    pkt->command_object->set("videoFunction", SrsAmf0Any::number(1));
+    pkt->command_object->set("pageUrl", SrsAmf0Any::str("http://ossrs.net/players/srs_player.html"));
+    pkt->command_object->set("objectEncoding", SrsAmf0Any::number(0));
+    
+    int size = 0;
+    char* payload = NULL;
+    if ((err = pkt->encode(size, payload)) != srs_success) {
+        return srs_error_wrap(err, "encode");
+    }
+    SrsAutoFreeA(char, payload);
+    b->bytes = size;
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        SrsBuffer buf(payload, size);
+        SrsConnectAppPacket packet;
+        if ((err = packet.decode(&buf)) != srs_success) {
+            return srs_error_wrap(err, "decode");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Write a batch of 16 video and audio tags, which is the path of HTTP-FLV player.
+srs_error_t srs_bench_flv_write_tags(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    SrsBenchIO io;
+    SrsFlvTransmuxer flv;
+    if ((err = flv.initialize(&io)) != srs_success) {
+        return srs_error_wrap(err, "init flv");
+    }
+    
+    SrsSharedPtrMessage* msgs[16];
+    for (int i = 0; i < 16; i++) {
+        if (i % 4 == 0) {
+            msgs[i] = srs_bench_create_msg(RTMP_MSG_VideoMessage, i * 10, srs_bench_avc_frame(4096));
+        } else {
+            msgs[i] = srs_bench_create_msg(RTMP_MSG_AudioMessage, i * 10, string("\xaf\x01", 2) + string(200, (char)0x21));
+        }
+        b->bytes += msgs[i]->size;
+    }
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        if ((err = flv.write_tags(msgs, 16)) != srs_success) {
+            break;
+        }
+    }
+    b->stop();
+    
+    for (int i = 0; i < 16; i++) {
+        srs_freep(msgs[i]);
+    }
+    
+    if (err != srs_success) {
+        return srs_error_wrap(err, "write tags");
+    }
+    return err;
+}
+
+// Packetize a video frame of 4KB to TS packets, which is the path of HLS.
+srs_error_t srs_bench_ts_encode(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    SrsBenchIO io;
+    SrsTsContext ctx;
+    
+    SrsTsMessage* msg = new SrsTsMessage();
+    SrsAutoFree(SrsTsMessage, msg);
+    
+    msg->write_pcr = true;
+    msg->dts = msg->pts = 90000;
+    msg->sid = SrsTsPESStreamIdVideoCommon;
+    
+    string annexb("\x00\x00\x00\x01\x09\xf0", 6);
+    annexb.append("\x00\x00\x00\x01\x41", 5);
+    annexb.append(4096, (char)0xa5);
+    msg->payload->append(annexb.data(), (int)annexb.length());
+    b->bytes = annexb.length();
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        if ((err = ctx.encode(&io, msg, SrsVideoCodecIdAVC, SrsAudioCodecIdAAC)) != srs_success) {
+            return srs_error_wrap(err, "encode");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// The handler of ts messages, which only counts the payload.
+class SrsBenchTsHandler : public ISrsTsHandler
+{
+public:
+    int64_t nb_bytes;
+public:
+    SrsBenchTsHandler() {
+        nb_bytes = 0;
+    }
+    virtual ~SrsBenchTsHandler() {
+    }
+// Interface ISrsTsHandler
+public:
+    virtual srs_error_t on_ts_message(SrsTsMessage* msg) {
+        nb_bytes += msg->payload->length();
+        return srs_success;
+    }
+};
+
+// Decode a 8Mbps ts stream packet by packet, which is the path of mpegts over UDP and HLS ingester.
+srs_error_t srs_bench_ts_decode(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    // About 10s of 25fps video, 40KB for each frame, with an audio frame of 200 bytes.
+    SrsBenchCaptureIO io;
+    if (true) {
+        SrsTsContext ctx;
+        string video = srs_bench_avc_frame(40 * 1024);
+        string audio(200, (char)0x21);
+        
+        for (int i = 0; i < 250; i++) {
+            SrsTsMessage v;
+            v.sid = SrsTsPESStreamIdVideoCommon;
+            v.write_pcr = (i % 25) == 0;
+            v.dts = v.pts = i * 3600;
+            v.payload->append(video.data(), (int)video.length());
+            if ((err = ctx.encode(&io, &v, SrsVideoCodecIdAVC, SrsAudioCodecIdAAC)) != srs_success) {
+                return srs_error_wrap(err, "video");
+            }
+            
+            SrsTsMessage a;
+            a.sid = SrsTsPESStreamIdAudioCommon;
+            a.dts = a.pts = i * 3600;
+            a.payload->append(audio.data(), (int)audio.length());
+            if ((err = ctx.encode(&io, &a, SrsVideoCodecIdAVC, SrsAudioCodecIdAAC)) != srs_success) {
+                return srs_error_wrap(err, "audio");
+            }
+        }
+    }
+    
+    char* data = (char*)io.captured.data();
+    int nb_packets = (int)(io.captured.length() / SRS_TS_PACKET_SIZE);
+    b->bytes = SRS_TS_PACKET_SIZE;
+    
+    SrsTsContext ctx;
+    SrsBenchTsHandler handler;
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        SrsBuffer buf(data + (i % nb_packets) * SRS_TS_PACKET_SIZE, SRS_TS_PACKET_SIZE);
+        if ((err = ctx.decode(&buf, &handler)) != srs_success) {
+            return srs_error_wrap(err, "decode");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Demux the AVC frame, which is the path of each video message of publisher.
+srs_error_t srs_bench_avc_demux(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    SrsFormat format;
+    if ((err = format.initialize()) != srs_success) {
+        return srs_error_wrap(err, "init format");
+    }
+    if ((err = format.on_video(0, (char*)_srs_bench_avc_sh, sizeof(_srs_bench_avc_sh))) != srs_success) {
+        return srs_error_wrap(err, "sequence header");
+    }
+    
+    string frame = srs_bench_avc_frame(4096);
+    b->bytes = frame.length();
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        if ((err = format.on_video(i * 40, (char*)frame.data(), (int)frame.length())) != srs_success) {
+            return srs_error_wrap(err, "demux");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Demux the AAC frame, which is the path of each audio message of publisher.
+srs_error_t srs_bench_aac_demux(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    SrsFormat format;
+    if ((err = format.initialize()) != srs_success) {
+        return srs_error_wrap(err, "init format");
+    }
+    if ((err = format.on_audio(0, (char*)"\xaf\x00\x12\x10", 4)) != srs_success) {
+        return srs_error_wrap(err, "sequence header");
+    }
+    
+    string frame("\xaf\x01", 2);
+    frame.append(256, (char)0x21);
+    b->bytes = frame.length();
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        if ((err = format.on_audio(i * 23, (char*)frame.data(), (int)frame.length())) != srs_success) {
+            return srs_error_wrap(err, "demux");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Generate an annexb frame of size bytes, with 4 NALUs and random payload without start code.
+string srs_bench_annexb_frame(int size)
+{
+    string frame(size, (char)0);
+    for (int i = 0; i < size; i++) {
+        frame[i] = (char)(0x02 + i % 0xfd);
+    }
+    for (int i = 0; i < 4; i++) {
+        frame.replace(i * (size / 4), 4, "\x00\x00\x00\x01", 4);
+    }
+    return frame;
+}
+
+// Split the annexb frame by the word scanner, which is the path of each frame of RTSP and ingest.
+srs_error_t srs_bench_annexb_split(SrsBench* b, int size)
+{
+    srs_error_t err = srs_success;
+    
+    string frame = srs_bench_annexb_frame(size);
+    b->bytes = frame.length();
+    
+    SrsAnnexbNalu nalus[8];
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        if (srs_avc_split_annexb((char*)frame.data(), (int)frame.length(), nalus, 8) != 4) {
+            return srs_error_new(ERROR_HLS_AVC_TRY_OTHERS, "split");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Split the annexb frame byte by byte, the old scanner, as the baseline of split.
+srs_error_t srs_bench_annexb_bytes(SrsBench* b, int size)
+{
+    srs_error_t err = srs_success;
+    
+    string frame = srs_bench_annexb_frame(size);
+    b->bytes = frame.length();
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        SrsBuffer stream((char*)frame.data(), (int)frame.length());
+        
+        int nn = 0;
+        while (!stream.empty()) {
+            int nb_start_code = 0;
+            if (!srs_avc_startswith_annexb(&stream, &nb_start_code)) {
+                break;
+            }
+            stream.skip(nb_start_code);
+            while (!stream.empty() && !srs_avc_startswith_annexb(&stream, NULL)) {
+                stream.skip(1);
+            }
+            nn++;
+        }
+        if (nn != 4) {
+            return srs_error_new(ERROR_HLS_AVC_TRY_OTHERS, "bytes");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// The typical size of 1080p and 4K I frame, with SPS/PPS/SEI.
+srs_error_t srs_bench_annexb_split_1080p(SrsBench* b)
+{
+    return srs_bench_annexb_split(b, 200 * 1024);
+}
+
+srs_error_t srs_bench_annexb_split_4k(SrsBench* b)
+{
+    return srs_bench_annexb_split(b, 800 * 1024);
+}
+
+srs_error_t srs_bench_annexb_bytes_1080p(SrsBench* b)
+{
+    return srs_bench_annexb_bytes(b, 200 * 1024);
+}
+
+srs_error_t srs_bench_annexb_bytes_4k(SrsBench* b)
+{
+    return srs_bench_annexb_bytes(b, 800 * 1024);
+}
+
+// Dump the stats of 10 streams to JSON, which is the path of HTTP API /api/v1/streams.
+srs_error_t srs_bench_json_dumps(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        SrsJsonObject* obj = SrsJsonAny::object();
+        SrsAutoFree(SrsJsonObject, obj);
+        
+        obj->set("code", SrsJsonAny::integer(ERROR_SUCCESS));
+        obj->set("server", SrsJsonAny::integer(100));
+        
+        SrsJsonArray* streams = SrsJsonAny::array();
+        obj->set("streams", streams);
+        
+        for (int j = 0; j < 10; j++) {
+            SrsJsonObject* stream = SrsJsonAny::object();
+            streams->append(stream);
+            
+            stream->set("id", SrsJsonAny::integer(100 + j));
+            stream->set("name", SrsJsonAny::str("livestream"));
+            stream->set("vhost", SrsJsonAny::integer(99));
+            stream->set("app", SrsJsonAny::str("live"));
+            stream->set("live_ms", SrsJsonAny::integer(1572245364000LL));
+            stream->set("clients", SrsJsonAny::integer(1000));
+            stream->set("frames", SrsJsonAny::integer(123456));
+            stream->set("send_bytes", SrsJsonAny::integer(123456789012LL));
+            stream->set("recv_bytes", SrsJsonAny::integer(1234567890LL));
+            
+            SrsJsonObject* kbps = SrsJsonAny::object();
+            stream->set("kbps", kbps);
+            kbps->set("recv_30s", SrsJsonAny::integer(1000));
+            kbps->set("send_30s", SrsJsonAny::integer(1000000));
+            
+            SrsJsonObject* publish = SrsJsonAny::object();
+            stream->set("publish", publish);
+            publish->set("active", SrsJsonAny::boolean(true));
+            publish->set("cid", SrsJsonAny::integer(101));
+            
+            SrsJsonObject* video = SrsJsonAny::object();
+            stream->set("video", video);
+            video->set("codec", SrsJsonAny::str("H264"));
+            video->set("profile", SrsJsonAny::str("High"));
+            video->set("level", SrsJsonAny::str("3.1"));
+            video->set("width", SrsJsonAny::integer(1280));
+            video->set("height", SrsJsonAny::integer(720));
+            
+            SrsJsonObject* audio = SrsJsonAny::object();
+            stream->set("audio", audio);
+            audio->set("codec", SrsJsonAny::str("AAC"));
+            audio->set("sample_rate", SrsJsonAny::integer(44100));
+            audio->set("channel", SrsJsonAny::integer(2));
+            audio->set("profile", SrsJsonAny::str("LC"));
+        }
+        
+        string json = obj->dumps();
+        b->bytes = json.length();
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Parse the HTTP-FLV request header, which is the path of each HTTP client.
+srs_error_t srs_bench_http_parse(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    string req = "GET /live/livestream.flv?vhost=show.ossrs.net HTTP/1.1\r\n"
+        "Host: ossrs.net:8080\r\n"
+        "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_14_6) AppleWebKit/537.36 Chrome/77.0.3865.120\r\n"
+        "Accept: */*\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Accept-Language: en-US,en;q=0.9\r\n"
+        "Origin: http://ossrs.net\r\n"
+        "Referer: http://ossrs.net/players/srs_player.html\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+    b->bytes = req.length();
+    
+    SrsBenchIO io(req);
+    SrsHttpParser parser;
+    if ((err = parser.initialize(HTTP_REQUEST, false)) != srs_success) {
+        return srs_error_wrap(err, "init parser");
+    }
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        ISrsHttpMessage* msg = NULL;
+        if ((err = parser.parse_message(&io, &msg)) != srs_success) {
+            return srs_error_wrap(err, "parse");
+        }
+        srs_freep(msg);
+    }
+    b->stop();
+    
+    return err;
+}
+
+// Write the HLS playlist response, which is the path of each HLS client.
+srs_error_t srs_bench_http_response(SrsBench* b)
+{
+    srs_error_t err = srs_success;
+    
+    string m3u8 = "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-MEDIA-SEQUENCE:100\n#EXT-X-TARGETDURATION:10\n";
+    for (int i = 0; i < 3; i++) {
+        m3u8 += "#EXTINF:10.000, no desc\nlivestream-" + srs_int2str(100 + i) + ".ts\n";
+    }
+    b->bytes = m3u8.length();
+    
+    SrsBenchIO io;
+    
+    b->start();
+    for (int i = 0; i < b->n; i++) {
+        SrsHttpResponseWriter w(&io);
+        w.header()->set_content_type("application/vnd.apple.mpegurl");
+        w.header()->set_content_length(m3u8.length());
+        w.write_header(SRS_CONSTS_HTTP_OK);
+        if ((err = w.write((char*)m3u8.data(), (int)m3u8.length())) != srs_success) {
+            return srs_error_wrap(err, "write");
+        }
+        if ((err = w.final_request()) != srs_success) {
+            return srs_error_wrap(err, "final");
+        }
+    }
+    b->stop();
+    
+    return err;
+}
+
+// The coroutines to measure the dispatch of ST, while some connections are idle.
+struct SrsBenchStContext
+{
+    // The pipe to block the idle coroutines, which are released when written.
+    int fds[2];
+    int nn_idles;
+    // The socketpair to ping-pong a byte.
+    st_netfd_t pair[2];
+    int nn_rounds;
+};
+
+// The idle connection, which waits for the fd until it's written.
+void* srs_bench_st_idle(void* arg)
+{
+    SrsBenchStContext* ctx = (SrsBenchStContext*)arg;
+    
+    struct pollfd pd;
+    pd.fd = ctx->fds[0];
+    pd.events = POLLIN;
+    st_poll(&pd, 1, ST_UTIME_NO_TIMEOUT);
+    
+    ctx->nn_idles--;
+    return NULL;
+}
+
+// Echo each byte back, which is the peer of the ping-pong.
+void* srs_bench_st_pong(void* arg)
+{
+    SrsBenchStContext* ctx = (SrsBenchStContext*)arg;
+    
+    char buf[1];
+    for (int i = 0; i < ctx->nn_rounds; i++) {
+        st_read(ctx->pair[1], buf, 1, ST_UTIME_NO_TIMEOUT);
+        st_write(ctx->pair[1], buf, 1, ST_UTIME_NO_TIMEOUT);
+    }
+    return NULL;
+}
+
+// Ping-pong a byte by a pair of coroutines, with nn_idles coroutines blocked on another fd, which
+// is the path of each active connection. The cost should not grow with the idle connections.
+srs_error_t srs_bench_st_dispatch(SrsBench* b, int nn_idles)
+{
+    srs_error_t err = srs_success;
+    
+    SrsBenchStContext ctx;
+    if (pipe(ctx.fds) < 0) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "pipe");
+    }
+    
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        ::close(ctx.fds[0]); ::close(ctx.fds[1]);
+        return srs_error_new(ERROR_SOCKET_CREATE, "socketpair");
+    }
+    ctx.pair[0] = st_netfd_open_socket(sv[0]);
+    ctx.pair[1] = st_netfd_open_socket(sv[1]);
+    ctx.nn_rounds = b->n;
+    
+    ctx.nn_idles = 0;
+    for (int i = 0; i < nn_idles; i++) {
+        if (!st_thread_create(srs_bench_st_idle, &ctx, 0, 16 * 1024)) {
+            err = srs_error_new(ERROR_ST_CREATE_CYCLE_THREAD, "create idle %d", i);
+            break;
+        }
+        ctx.nn_idles++;
+    }
+    
+    st_thread_t trd = NULL;
+    if (err == srs_success && (trd = st_thread_create(srs_bench_st_pong, &ctx, 1, 0)) == NULL) {
+        err = srs_error_new(ERROR_ST_CREATE_CYCLE_THREAD, "create pong");
+    }
+    
+    if (err == srs_success) {
+        // Wait for the idle coroutines to block on the pipe.
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        
+        b->start();
+        char buf[1] = {'x'};
+        for (int i = 0; i < b->n; i++) {
+            st_write(ctx.pair[0], buf, 1, ST_UTIME_NO_TIMEOUT);
+            st_read(ctx.pair[0], buf, 1, ST_UTIME_NO_TIMEOUT);
+        }
+        b->stop();
+        
+        st_thread_join(trd, NULL);
+    }
+    
+    // Release and wait for all idle coroutines to quit.
+    if (write(ctx.fds[1], "x", 1) == 1) {
+        while (ctx.nn_idles > 0) {
+            srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        }
+    }
+    
+    st_netfd_close(ctx.pair[0]);
+    st_netfd_close(ctx.pair[1]);
+    ::close(ctx.fds[0]); ::close(ctx.fds[1]);
+    
+    return err;
+}
+
+srs_error_t srs_bench_st_dispatch_0(SrsBench* b)
+{
+    return srs_bench_st_dispatch(b, 0);
+}
+
+srs_error_t srs_bench_st_dispatch_10k(SrsBench* b)
+{
+    return srs_bench_st_dispatch(b, 10000);
+}
+
+srs_error_t srs_bench_st_dispatch_50k(SrsBench* b)
+{
+    return srs_bench_st_dispatch(b, 50000);
+}
+
+// The benchmark function, which should call start and stop around the loop.
+typedef srs_error_t (*SrsBenchFunc)(SrsBench* b);
+
+struct SrsBenchCase
+{
+    const char* name;
+    SrsBenchFunc pfn;
+};
+
+static SrsBenchCase _srs_bench_cases[] = {
+    {"RtmpEncode", srs_bench_rtmp_encode},
+    {"RtmpDecode", srs_bench_rtmp_decode},
+    {"RtmpSendGop", srs_bench_rtmp_send_gop_messages},
+    {"RtmpSendGopChunks", srs_bench_rtmp_send_gop_chunks},
+    {"Amf0Decode", srs_bench_amf0_decode},
+    {"FlvWriteTags", srs_bench_flv_write_tags},
+    {"TsEncode", srs_bench_ts_encode},
+    {"TsDecode", srs_bench_ts_decode},
+    {"AvcDemux", srs_bench_avc_demux},
+    {"AacDemux", srs_bench_aac_demux},
+    {"AnnexbSplit", srs_bench_annexb_split_1080p},
+    {"AnnexbSplit4K", srs_bench_annexb_split_4k},
+    {"AnnexbBytes", srs_bench_annexb_bytes_1080p},
+    {"AnnexbBytes4K", srs_bench_annexb_bytes_4k},
+    {"JsonDumps", srs_bench_json_dumps},
+    {"HttpParse", srs_bench_http_parse},
+    {"HttpResponse", srs_bench_http_response},
+    {"StDispatch", srs_bench_st_dispatch_0},
+    {"StDispatch10k", srs_bench_st_dispatch_10k},
+    {"StDispatch50k", srs_bench_st_dispatch_50k},
+};
+
+// Run the benchmark, grow the n util it runs for the duration, like the testing.B of golang.
+srs_error_t srs_bench_run(SrsBenchCase* c, int64_t duration, SrsBench& result)
+{
+    srs_error_t err = srs_success;
+    
+    int n = 1;
+    while (true) {
+        SrsBench b(n);
+        if ((err = c->pfn(&b)) != srs_success) {
+            return srs_error_wrap(err, "run %s n=%d", c->name, n);
+        }
+        
+        result = b;
+        if (b.elapsed >= duration || n >= 1000000000) {
+            break;
+        }
+        
+        // Predict the n by the last run, grow at least 2x and at most 100x, with 20% more.
+        int64_t ns = srs_max(b.elapsed / n, (int64_t)1);
+        int64_t next = duration * 6 / 5 / ns;
+        next = srs_max(srs_min(next, (int64_t)n * 100), (int64_t)n * 2);
+        n = (int)srs_min(next, (int64_t)1000000000);
+    }
+    
+    return err;
+}
+
+int main(int argc, char** argv)
+{
+    srs_error_t err = srs_success;
+    
+    string filter;
+    int duration = 1000;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "f:t:h")) != -1) {
+        switch (opt) {
+            case 'f': filter = optarg; break;
+            case 't': duration = ::atoi(optarg); break;
+            default:
+                fprintf(stderr, "SRS micro benchmark/%d.%d.%d, the ns/op and allocs/op of hot paths.\n"
+                    "Usage: %s [-f filter] [-t duration]\n"
+                    "       -f Only run the benchmarks whose name contains the filter. Default: all\n"
+                    "       -t The minimum duration in ms to run each benchmark. Default: %d\n"
+                    "For example:\n"
+                    "       %s -f Rtmp -t 3000\n",
+                    VERSION_MAJOR, VERSION_MINOR, VERSION_REVISION, argv[0], duration, argv[0]);
+                exit(-1);
+        }
+    }
+    
+#ifndef __GLIBC__
+    fprintf(stderr, "Warning: No malloc hooks, the allocs/op is always 0.\n");
+#endif
+    
+    // For the benchmarks of coroutines.
+    if ((err = srs_st_init()) != srs_success) {
+        fprintf(stderr, "Init st failed, %s\n", srs_error_desc(err).c_str());
+        int code = srs_error_code(err);
+        srs_freep(err);
+        return code;
+    }
+    // Without the guard pages, or 50k stacks exceed the vm.max_map_count.
+    st_set_stack_guard(0);
+    
+    printf("%-16s %12s %12s %10s %10s %10s\n", "Benchmark", "Ops", "ns/op", "MB/s", "allocs/op", "B/op");
+    
+    for (int i = 0; i < (int)(sizeof(_srs_bench_cases) / sizeof(SrsBenchCase)); i++) {
+        SrsBenchCase* c = &_srs_bench_cases[i];
+        if (!filter.empty() && !srs_string_contains(c->name, filter)) {
+            continue;
+        }
+        
+        SrsBench b(0);
+        if ((err = srs_bench_run(c, duration * 1000000LL, b)) != srs_success) {
+            break;
+        }
+        
+        double ns = (double)b.elapsed / b.n;
+        double mbps = b.bytes * 1000.0 / ns;
+        printf("%-16s %12d %12.1f %10.1f %10.2f %10.1f\n", c->name, b.n, ns, mbps,
+            (double)b.allocs / b.n, (double)b.alloc_bytes / b.n);
+    }
+    
+    int code = srs_error_code(err);
+    if (err != srs_success) {
+        fprintf(stderr, "Bench failed, %s\n", srs_error_desc(err).c_str());
+    }
+    
+    srs_freep(err);
+    return code;
+}
@@ -0,0 +1,707 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013-2020 Winlin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <srs_core.hpp>
+
+#include <srs_kernel_error.hpp>
+#include <srs_service_log.hpp>
+#include <srs_kernel_file.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_kernel_codec.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_kernel_consts.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_rtmp_stack.hpp>
+#include <srs_protocol_utility.hpp>
+#include <srs_protocol_json.hpp>
+#include <srs_http_stack.hpp>
+#include <srs_service_st.hpp>
+#include <srs_service_rtmp_conn.hpp>
+#include <srs_service_http_client.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <string.h>
+#include <st.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+// @global log and context.
+ISrsLog* _srs_log = new SrsConsoleLog(SrsLogLevelError, false);
+ISrsThreadContext* _srs_context = new SrsThreadContext();
+
+// The publisher appends a SEI to each AVC frame, which carries the wallclock in hex, so the
+// players get the latency from the tail of frame, for both RTMP and HTTP-FLV.
+// The SEI is: [4B size=36][NALU type=6][payload type=5][payload size=32][16B uuid][16B time][0x80]
+#define SRS_BENCH_SEI_SIZE 40
+static const char* SRS_BENCH_SEI_UUID = "SRSLoadBenchTime";
+
+// The timeout to connect to and wait for stream.
+#define SRS_BENCH_CONNECT_TIMEOUT (3 * SRS_UTIME_SECONDS)
+#define SRS_BENCH_STREAM_TIMEOUT (5 * SRS_UTIME_SECONDS)
+
+// The size of buffer to read the HTTP-FLV body.
+#define SRS_BENCH_READ_SIZE (64 * 1024)
+
+// The options of bench, which are dumped with the result, for the result to be repeatable.
+struct SrsBenchConfig
+{
+    string input;
+    string rtmp_url;
+    string flv_url;
+    int nn_streams;
+    int nn_rtmp_players;
+    int nn_flv_players;
+    int duration;
+    int pid;
+    string output;
+};
+
+SrsBenchConfig cfg;
+
+// All publishers and players quit at the deadline.
+srs_utime_t deadline = 0;
+
+// Get the url of stream, the first stream uses the url, others append the index.
+string srs_bench_stream_url(string url, int index)
+{
+    if (index == 0) {
+        return url;
+    }
+    
+    // Insert the index before the extension or query, for example, livestream_1.flv?vhost=xxx
+    size_t pos = url.find("?");
+    string query = (pos == string::npos)? "" : url.substr(pos);
+    string path = url.substr(0, pos);
+    
+    // The extension should be in the last path, for example, rtmp://127.0.0.1/live/livestream has no extension.
+    string ext;
+    if ((pos = path.rfind(".")) != string::npos && pos > path.rfind("/")) {
+        ext = path.substr(pos);
+        path = path.substr(0, pos);
+    }
+    
+    return path + "_" + srs_int2str(index) + ext + query;
+}
+
+// Append the SEI with the current wallclock to the AVC frame, the data should have space for it.
+void srs_bench_sei_write(char* data, int size)
+{
+    char* p = data + size;
+    
+    *p++ = 0; *p++ = 0; *p++ = 0; *p++ = SRS_BENCH_SEI_SIZE - 4;
+    *p++ = 0x06; *p++ = 0x05; *p++ = 32;
+    memcpy(p, SRS_BENCH_SEI_UUID, 16);
+    p += 16;
+    
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016" PRIx64, (uint64_t)srs_update_system_time());
+    memcpy(p, buf, 16);
+    p += 16;
+    
+    *p = (char)0x80;
+}
+
+// Read the wallclock from the tail SEI of AVC frame, return -1 if not found.
+int64_t srs_bench_sei_read(char* data, int size)
+{
+    if (size < 5 + SRS_BENCH_SEI_SIZE) {
+        return -1;
+    }
+    
+    // Only AVC NALUs has the SEI.
+    if ((data[0] & 0x0f) != SrsVideoCodecIdAVC || data[1] != SrsVideoAvcFrameTraitNALU) {
+        return -1;
+    }
+    
+    char* p = data + size - SRS_BENCH_SEI_SIZE;
+    if (p[4] != 0x06 || p[5] != 0x05 || memcmp(p + 7, SRS_BENCH_SEI_UUID, 16) != 0) {
+        return -1;
+    }
+    
+    string time(p + 7 + 16, 16);
+    return (int64_t)::strtoull(time.c_str(), NULL, 16);
+}
+
+// The percentile of the sorted values.
+int64_t srs_bench_percentile(vector<int64_t>& values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    
+    int index = (int)(p * (values.size() - 1) + 0.5);
+    return values.at(srs_min(index, (int)values.size() - 1));
+}
+
+// Dump the percentiles of values in ms.
+SrsJsonObject* srs_bench_dumps_percentiles(vector<int64_t>& values)
+{
+    std::sort(values.begin(), values.end());
+    
+    SrsJsonObject* obj = SrsJsonAny::object();
+    obj->set("samples", SrsJsonAny::integer(values.size()));
+    obj->set("p50", SrsJsonAny::number(srs_bench_percentile(values, 0.50) / 1000.0));
+    obj->set("p90", SrsJsonAny::number(srs_bench_percentile(values, 0.90) / 1000.0));
+    obj->set("p99", SrsJsonAny::number(srs_bench_percentile(values, 0.99) / 1000.0));
+    obj->set("max", SrsJsonAny::number(srs_bench_percentile(values, 1.0) / 1000.0));
+    return obj;
+}
+
+// The publisher, which publishes the FLV file in loop, paced by the timestamp.
+class SrsBenchPublisher
+{
+public:
+    string url;
+    int64_t nn_bytes;
+    srs_error_t err;
+private:
+    st_thread_t trd;
+public:
+    SrsBenchPublisher(string u) {
+        url = u;
+        nn_bytes = 0;
+        err = srs_success;
+        trd = NULL;
+    }
+    virtual ~SrsBenchPublisher() {
+        srs_freep(err);
+    }
+public:
+    void start() {
+        trd = st_thread_create(pfn, this, 1, 0);
+    }
+    void join() {
+        st_thread_join(trd, NULL);
+    }
+private:
+    static void* pfn(void* arg) {
+        SrsBenchPublisher* p = (SrsBenchPublisher*)arg;
+        p->err = p->do_cycle();
+        return NULL;
+    }
+    srs_error_t do_cycle() {
+        srs_error_t err = srs_success;
+        
+        SrsBasicRtmpClient sdk(url, SRS_BENCH_CONNECT_TIMEOUT, SRS_BENCH_STREAM_TIMEOUT);
+        if ((err = sdk.connect()) != srs_success) {
+            return srs_error_wrap(err, "connect %s", url.c_str());
+        }
+        if ((err = sdk.publish(SRS_CONSTS_RTMP_SRS_CHUNK_SIZE)) != srs_success) {
+            return srs_error_wrap(err, "publish %s", url.c_str());
+        }
+        
+        // The timestamp of file restarts when loop, so we add an offset.
+        int64_t offset = 0;
+        int64_t base = -1;
+        srs_utime_t starttime = 0;
+        
+        while (srs_update_system_time() < deadline) {
+            int64_t last = 0;
+            if ((err = publish_file(&sdk, offset, base, starttime, last)) != srs_success) {
+                return srs_error_wrap(err, "publish file");
+            }
+            offset = last + 40;
+        }
+        
+        return err;
+    }
+    srs_error_t publish_file(SrsBasicRtmpClient* sdk, int64_t offset, int64_t& base, srs_utime_t& starttime, int64_t& last) {
+        srs_error_t err = srs_success;
+        
+        SrsFileReader fr;
+        if ((err = fr.open(cfg.input)) != srs_success) {
+            return srs_error_wrap(err, "open %s", cfg.input.c_str());
+        }
+        
+        SrsFlvDecoder dec;
+        if ((err = dec.initialize(&fr)) != srs_success) {
+            return srs_error_wrap(err, "init decoder");
+        }
+        
+        char header[9];
+        char pps[4];
+        if ((err = dec.read_header(header)) != srs_success) {
+            return srs_error_wrap(err, "read header");
+        }
+        if ((err = dec.read_previous_tag_size(pps)) != srs_success) {
+            return srs_error_wrap(err, "read pts");
+        }
+        
+        while ((srs_update_system_time() < deadline)) {
+            char type = 0;
+            int32_t size = 0;
+            uint32_t time = 0;
+            if ((err = dec.read_tag_header(&type, &size, &time)) != srs_success) {
+                if (srs_error_code(err) == ERROR_SYSTEM_FILE_EOF) {
+                    srs_freep(err);
+                    break;
+                }
+                return srs_error_wrap(err, "read tag header");
+            }
+            
+            char* data = new char[size + SRS_BENCH_SEI_SIZE];
+            if ((err = dec.read_tag_data(data, size)) != srs_success) {
+                srs_freepa(data);
+                return srs_error_wrap(err, "read tag data");
+            }
+            if ((err = dec.read_previous_tag_size(pps)) != srs_success) {
+                srs_freepa(data);
+                return srs_error_wrap(err, "read pts");
+            }
+            
+            // Wait util the time to send the tag.
+            last = offset + time;
+            if (base < 0) {
+                base = last;
+                starttime = srs_update_system_time();
+            }
+            srs_utime_t due = starttime + (last - base) * SRS_UTIME_MILLISECONDS;
+            srs_utime_t now = srs_update_system_time();
+            if (due > now) {
+                srs_usleep(due - now);
+            }
+            
+            if (type == SrsFrameTypeVideo && size > 5 && (data[0] & 0x0f) == SrsVideoCodecIdAVC
+                && data[1] == SrsVideoAvcFrameTraitNALU) {
+                srs_bench_sei_write(data, size);
+                size += SRS_BENCH_SEI_SIZE;
+            }
+            
+            SrsSharedPtrMessage* msg = NULL;
+            if ((err = srs_rtmp_create_msg(type, (uint32_t)last, data, size, sdk->sid(), &msg)) != srs_success) {
+                return srs_error_wrap(err, "create message");
+            }
+            if ((err = sdk->send_and_free_message(msg)) != srs_success) {
+                return srs_error_wrap(err, "send message");
+            }
+            nn_bytes += size;
+        }
+        
+        return err;
+    }
+};
+
+// The player over RTMP or HTTP-FLV, to sample the join time and latency.
+class SrsBenchPlayer
+{
+public:
+    string url;
+    bool flv;
+    srs_utime_t starttime;
+    // The time from start to the first video frame, -1 if not joined.
+    srs_utime_t join_time;
+    int64_t nn_bytes;
+    vector<int64_t> latencies;
+    srs_error_t err;
+private:
+    st_thread_t trd;
+public:
+    SrsBenchPlayer(string u, bool f) {
+        url = u;
+        flv = f;
+        starttime = 0;
+        join_time = -1;
+        nn_bytes = 0;
+        err = srs_success;
+        trd = NULL;
+    }
+    virtual ~SrsBenchPlayer() {
+        srs_freep(err);
+    }
+public:
+    void start() {
+        trd = st_thread_create(pfn, this, 1, 0);
+    }
+    void join() {
+        st_thread_join(trd, NULL);
+    }
+private:
+    static void* pfn(void* arg) {
+        SrsBenchPlayer* p = (SrsBenchPlayer*)arg;
+        p->starttime = srs_update_system_time();
+        p->err = p->flv? p->do_play_flv() : p->do_play_rtmp();
+        
+        // Ignore the error after deadline, for the publishers quit at the same time.
+        if (p->err != srs_success && srs_update_system_time() >= deadline) {
+            srs_freep(p->err);
+        }
+        return NULL;
+    }
+    void on_frame(char type, char* data, int size) {
+        nn_bytes += size;
+        
+        if (type != SrsFrameTypeVideo) {
+            return;
+        }
+        
+        srs_utime_t now = srs_update_system_time();
+        if (join_time < 0) {
+            join_time = now - starttime;
+        }
+        
+        int64_t sent = srs_bench_sei_read(data, size);
+        if (sent > 0 && now >= sent) {
+            latencies.push_back(now - sent);
+        }
+    }
+    srs_error_t do_play_rtmp() {
+        srs_error_t err = srs_success;
+        
+        SrsBasicRtmpClient sdk(url, SRS_BENCH_CONNECT_TIMEOUT, SRS_BENCH_STREAM_TIMEOUT);
+        if ((err = sdk.connect()) != srs_success) {
+            return srs_error_wrap(err, "connect %s", url.c_str());
+        }
+        if ((err = sdk.play(SRS_CONSTS_RTMP_SRS_CHUNK_SIZE)) != srs_success) {
+            return srs_error_wrap(err, "play %s", url.c_str());
+        }
+        
+        while (srs_update_system_time() < deadline) {
+            SrsCommonMessage* msg = NULL;
+            if ((err = sdk.recv_message(&msg)) != srs_success) {
+                return srs_error_wrap(err, "recv message");
+            }
+            SrsAutoFree(SrsCommonMessage, msg);
+            
+            on_frame(msg->header.message_type, msg->payload, msg->size);
+        }
+        
+        return err;
+    }
+    srs_error_t do_play_flv() {
+        srs_error_t err = srs_success;
+        
+        SrsHttpUri uri;
+        if ((err = uri.initialize(url)) != srs_success) {
+            return srs_error_wrap(err, "parse %s", url.c_str());
+        }
+        
+        SrsHttpClient hc;
+        if ((err = hc.initialize(uri.get_host(), uri.get_port(), SRS_BENCH_STREAM_TIMEOUT)) != srs_success) {
+            return srs_error_wrap(err, "init client");
+        }
+        
+        string path = uri.get_path();
+        if (!uri.get_query().empty()) {
+            path += "?" + uri.get_query();
+        }
+        
+        ISrsHttpMessage* res = NULL;
+        if ((err = hc.get(path, "", &res)) != srs_success) {
+            return srs_error_wrap(err, "get %s", url.c_str());
+        }
+        SrsAutoFree(ISrsHttpMessage, res);
+        
+        if (res->status_code() != SRS_CONSTS_HTTP_OK) {
+            return srs_error_new(ERROR_HTTP_STATUS_INVALID, "status=%d", res->status_code());
+        }
+        
+        // Parse the FLV tags in the buffer, skip the 9B header and 4B previous tag size.
+        ISrsHttpResponseReader* br = res->body_reader();
+        string buf;
+        size_t pos = 13;
+        
+        // Allocate the buffer on heap, because the stack of coroutine is small.
+        char* data = new char[SRS_BENCH_READ_SIZE];
+        SrsAutoFreeA(char, data);
+        
+        while (srs_update_system_time() < deadline && !br->eof()) {
+            ssize_t nread = 0;
+            if ((err = br->read(data, SRS_BENCH_READ_SIZE, &nread)) != srs_success) {
+                return srs_error_wrap(err, "read body");
+            }
+            buf.append(data, nread);
+            
+            // The tag is 11B header, data and 4B previous tag size.
+            while (buf.length() >= pos + 11) {
+                const uint8_t* p = (const uint8_t*)buf.data() + pos;
+                int size = (p[1] << 16) | (p[2] << 8) | p[3];
+                if (buf.length() < pos + 11 + size + 4) {
+                    break;
+                }
+                
+                on_frame((char)p[0], (char*)p + 11, size);
+                pos += 11 + size + 4;
+            }
+            
+            if (pos > 0 && pos <= buf.length()) {
+                buf.erase(0, pos);
+                pos = 0;
+            }
+        }
+        
+        return err;
+    }
+};
+
+// The cpu time in seconds and rss in KB of the server, by its pid.
+bool srs_bench_proc_stat(int pid, double& cpu, int64_t& rss)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    
+    // The 14th and 15th fields are utime and stime, after the comm which might contains spaces.
+    char line[1024];
+    char* p = fgets(line, sizeof(line), f);
+    fclose(f);
+    if (!p || (p = strrchr(line, ')')) == NULL) {
+        return false;
+    }
+    
+    unsigned long utime = 0, stime = 0;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) {
+        return false;
+    }
+    cpu = (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+    
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    if ((f = fopen(path, "r")) == NULL) {
+        return false;
+    }
+    
+    rss = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmRSS: %" PRId64, &rss) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    
+    return true;
+}
+
+srs_error_t do_main()
+{
+    srs_error_t err = srs_success;
+    
+    if ((err = srs_st_init()) != srs_success) {
+        return srs_error_wrap(err, "init st");
+    }
+    
+    double cpu0 = 0;
+    int64_t rss0 = 0;
+    if (cfg.pid > 0 && !srs_bench_proc_stat(cfg.pid, cpu0, rss0)) {
+        return srs_error_new(ERROR_SYSTEM_PID_ACQUIRE, "stat pid=%d", cfg.pid);
+    }
+    
+    srs_utime_t starttime = srs_update_system_time();
+    deadline = starttime + cfg.duration * SRS_UTIME_SECONDS;
+    
+    vector<SrsBenchPublisher*> publishers;
+    vector<SrsBenchPlayer*> players;
+    for (int i = 0; i < cfg.nn_streams; i++) {
+        SrsBenchPublisher* publisher = new SrsBenchPublisher(srs_bench_stream_url(cfg.rtmp_url, i));
+        publishers.push_back(publisher);
+        publisher->start();
+    }
+    
+    // Start players after publishers, or the players fail for no stream.
+    srs_usleep(1 * SRS_UTIME_SECONDS);
+    
+    for (int i = 0; i < cfg.nn_streams; i++) {
+        for (int j = 0; j < cfg.nn_rtmp_players; j++) {
+            players.push_back(new SrsBenchPlayer(srs_bench_stream_url(cfg.rtmp_url, i), false));
+        }
+        for (int j = 0; j < cfg.nn_flv_players; j++) {
+            players.push_back(new SrsBenchPlayer(srs_bench_stream_url(cfg.flv_url, i), true));
+        }
+    }
+    for (int i = 0; i < (int)players.size(); i++) {
+        players.at(i)->start();
+    }
+    fprintf(stderr, "Start %d publishers, %d players, duration %ds\n", (int)publishers.size(), (int)players.size(), cfg.duration);
+    
+    // Sample the server before the clients quit.
+    srs_usleep(deadline - srs_update_system_time() - 100 * SRS_UTIME_MILLISECONDS);
+    double cpu1 = 0;
+    int64_t rss1 = 0;
+    if (cfg.pid > 0 && !srs_bench_proc_stat(cfg.pid, cpu1, rss1)) {
+        return srs_error_new(ERROR_SYSTEM_PID_ACQUIRE, "stat pid=%d", cfg.pid);
+    }
+    srs_utime_t elapsed = srs_update_system_time() - starttime;
+    
+    for (int i = 0; i < (int)publishers.size(); i++) {
+        publishers.at(i)->join();
+    }
+    for (int i = 0; i < (int)players.size(); i++) {
+        players.at(i)->join();
+    }
+    
+    // Collect the results.
+    int nn_published = 0;
+    int64_t nn_sent = 0;
+    for (int i = 0; i < (int)publishers.size(); i++) {
+        SrsBenchPublisher* publisher = publishers.at(i);
+        if (publisher->err != srs_success) {
+            fprintf(stderr, "Publisher %s failed, %s\n", publisher->url.c_str(), srs_error_desc(publisher->err).c_str());
+        } else {
+            nn_published++;
+        }
+        nn_sent += publisher->nn_bytes;
+        srs_freep(publisher);
+    }
+    
+    int nn_joined = 0;
+    int nn_failed = 0;
+    int64_t nn_recv = 0;
+    vector<int64_t> joins, latencies;
+    for (int i = 0; i < (int)players.size(); i++) {
+        SrsBenchPlayer* player = players.at(i);
+        if (player->err != srs_success) {
+            fprintf(stderr, "Player %s failed, %s\n", player->url.c_str(), srs_error_desc(player->err).c_str());
+            nn_failed++;
+        }
+        if (player->join_time >= 0) {
+            nn_joined++;
+            joins.push_back(player->join_time);
+        }
+        nn_recv += player->nn_bytes;
+        latencies.insert(latencies.end(), player->latencies.begin(), player->latencies.end());
+        srs_freep(player);
+    }
+    
+    double seconds = srsu2ms(elapsed) / 1000.0;
+    double recv_gbps = nn_recv * 8 / seconds / 1000 / 1000 / 1000;
+    
+    SrsJsonObject* obj = SrsJsonAny::object();
+    SrsAutoFree(SrsJsonObject, obj);
+    
+    SrsJsonObject* config = SrsJsonAny::object();
+    obj->set("config", config);
+    config->set("input", SrsJsonAny::str(cfg.input.c_str()));
+    config->set("rtmp", SrsJsonAny::str(cfg.rtmp_url.c_str()));
+    config->set("flv", SrsJsonAny::str(cfg.flv_url.c_str()));
+    config->set("streams", SrsJsonAny::integer(cfg.nn_streams));
+    config->set("rtmp_players", SrsJsonAny::integer(cfg.nn_rtmp_players));
+    config->set("flv_players", SrsJsonAny::integer(cfg.nn_flv_players));
+    config->set("duration", SrsJsonAny::integer(cfg.duration));
+    
+    SrsJsonObject* pub = SrsJsonAny::object();
+    obj->set("publishers", pub);
+    pub->set("total", SrsJsonAny::integer(publishers.size()));
+    pub->set("ok", SrsJsonAny::integer(nn_published));
+    pub->set("send_kbps", SrsJsonAny::integer((int64_t)(nn_sent * 8 / seconds / 1000)));
+    
+    SrsJsonObject* play = SrsJsonAny::object();
+    obj->set("players", play);
+    play->set("total", SrsJsonAny::integer(players.size()));
+    play->set("joined", SrsJsonAny::integer(nn_joined));
+    play->set("failed", SrsJsonAny::integer(nn_failed));
+    play->set("recv_kbps", SrsJsonAny::integer((int64_t)(nn_recv * 8 / seconds / 1000)));
+    play->set("join_ms", srs_bench_dumps_percentiles(joins));
+    play->set("latency_ms", srs_bench_dumps_percentiles(latencies));
+    
+    if (cfg.pid > 0) {
+        double cpu_percent = (cpu1 - cpu0) * 100 / seconds;
+        int nn_conns = (int)(publishers.size() + players.size());
+        
+        SrsJsonObject* server = SrsJsonAny::object();
+        obj->set("server", server);
+        server->set("pid", SrsJsonAny::integer(cfg.pid));
+        server->set("cpu_percent", SrsJsonAny::number(cpu_percent));
+        server->set("cpu_percent_per_gbps", SrsJsonAny::number(recv_gbps > 0? cpu_percent / recv_gbps : 0));
+        server->set("rss_kbyte", SrsJsonAny::integer(rss1));
+        server->set("rss_per_conn_kbyte", SrsJsonAny::number(nn_conns > 0? (double)(rss1 - rss0) / nn_conns : 0));
+    }
+    
+    string json = obj->dumps();
+    if (cfg.output.empty()) {
+        printf("%s\n", json.c_str());
+        return err;
+    }
+    
+    SrsFileWriter fw;
+    if ((err = fw.open(cfg.output)) != srs_success) {
+        return srs_error_wrap(err, "open %s", cfg.output.c_str());
+    }
+    if ((err = fw.write((void*)json.data(), json.length(), NULL)) != srs_success) {
+        return srs_error_wrap(err, "write %s", cfg.output.c_str());
+    }
+    
+    return err;
+}
+
+int main(int argc, char** argv)
+{
+    cfg.input = "./doc/source.200kbps.768x320.flv";
+    cfg.rtmp_url = "rtmp://127.0.0.1/live/livestream";
+    cfg.flv_url = "http://127.0.0.1:8080/live/livestream.flv";
+    cfg.nn_streams = 1;
+    cfg.nn_rtmp_players = 1;
+    cfg.nn_flv_players = 0;
+    cfg.duration = 30;
+    cfg.pid = 0;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "i:r:l:s:m:f:d:p:o:h")) != -1) {
+        switch (opt) {
+            case 'i': cfg.input = optarg; break;
+            case 'r': cfg.rtmp_url = optarg; break;
+            case 'l': cfg.flv_url = optarg; break;
+            case 's': cfg.nn_streams = ::atoi(optarg); break;
+            case 'm': cfg.nn_rtmp_players = ::atoi(optarg); break;
+            case 'f': cfg.nn_flv_players = ::atoi(optarg); break;
+            case 'd': cfg.duration = ::atoi(optarg); break;
+            case 'p': cfg.pid = ::atoi(optarg); break;
+            case 'o': cfg.output = optarg; break;
+            default:
+                fprintf(stderr, "SRS load bench/%d.%d.%d, publish and play streams, then report the result in JSON.\n"
+                    "Usage: %s [-i flv] [-r rtmp_url] [-l flv_url] [-s streams] [-m rtmp_players] [-f flv_players]\n"
+                    "       [-d duration] [-p pid] [-o json]\n"
+                    "       -i The FLV file to publish in loop. Default: %s\n"
+                    "       -r The RTMP url to publish and play, the stream i>0 appends _i to name. Default: %s\n"
+                    "       -l The HTTP-FLV url to play. Default: %s\n"
+                    "       -s The number of streams, each stream has a publisher. Default: %d\n"
+                    "       -m The number of RTMP players for each stream. Default: %d\n"
+                    "       -f The number of HTTP-FLV players for each stream. Default: %d\n"
+                    "       -d The duration in seconds. Default: %d\n"
+                    "       -p The pid of local server, to sample its CPU and RSS. Default: no\n"
+                    "       -o The file to write the JSON result. Default: stdout\n"
+                    "For example:\n"
+                    "       %s -s 10 -m 100 -f 100 -d 60 -p `cat objs/srs.pid` -o objs/bench.json\n",
+                    VERSION_MAJOR, VERSION_MINOR, VERSION_REVISION, argv[0], cfg.input.c_str(),
+                    cfg.rtmp_url.c_str(), cfg.flv_url.c_str(), cfg.nn_streams, cfg.nn_rtmp_players,
+                    cfg.nn_flv_players, cfg.duration, argv[0]);
+                exit(-1);
+        }
+    }
+    
+    srs_error_t err = do_main();
+    int code = srs_error_code(err);
+    
+    if (err != srs_success) {
+        fprintf(stderr, "Bench failed, %s\n", srs_error_desc(err).c_str());
+    }
+    
+    srs_freep(err);
+    return code;
+}
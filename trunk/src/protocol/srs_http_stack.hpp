@@ -83,6 +83,8 @@ extern srs_error_t srs_go_http_error(ISrsHttpResponseWriter* w, int code, std::s
 
 // Get the status text of code.
 extern std::string srs_generate_http_status_text(int status);
+// Get the preformatted status line of code, for example, "HTTP/1.1 200 OK\r\n".
+extern std::string srs_generate_http_status_line(int status);
 
 // It reports whether a given response status code
 // permits a body.  See RFC2616, section 4.4.
@@ -148,6 +150,8 @@ public:
 public:
     // write all headers to string stream.
     virtual void write(std::stringstream& ss);
+    // Append all headers to the buffer, without the stream.
+    virtual void write(std::string& buf);
 };
 
 // A ResponseWriter interface is used by an HTTP handler to
@@ -412,6 +416,8 @@ public:
     // Handle registers the handler for the given pattern.
     // If a handler already exists for pattern, Handle panics.
     virtual srs_error_t handle(std::string pattern, ISrsHttpHandler* handler);
+    // Unhandle the pattern and free the handler, ignore if the handler not match.
+    virtual void unhandle(std::string pattern, ISrsHttpHandler* handler);
 // Interface ISrsHttpServeMux
 public:
     virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
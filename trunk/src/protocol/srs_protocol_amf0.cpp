@@ -1703,6 +1703,259 @@ srs_error_t srs_amf0_write_undefined(SrsBuffer* stream)
     return err;
 }
 
+// Whether the next marker in stream is the specified marker.
+bool srs_amf0_is_marker(SrsBuffer* stream, char marker)
+{
+    return stream->require(1) && stream->data()[stream->pos()] == marker;
+}
+
+bool srs_amf0_is_string(SrsBuffer* stream)
+{
+    return srs_amf0_is_marker(stream, RTMP_AMF0_String);
+}
+
+bool srs_amf0_is_number(SrsBuffer* stream)
+{
+    return srs_amf0_is_marker(stream, RTMP_AMF0_Number);
+}
+
+bool srs_amf0_is_boolean(SrsBuffer* stream)
+{
+    return srs_amf0_is_marker(stream, RTMP_AMF0_Boolean);
+}
+
+bool srs_amf0_is_object(SrsBuffer* stream)
+{
+    return srs_amf0_is_marker(stream, RTMP_AMF0_Object);
+}
+
+// Skip the utf8 string, which is 2B length and the bytes.
+srs_error_t srs_amf0_skip_utf8(SrsBuffer* stream)
+{
+    if (!stream->require(2)) {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 2 only %d bytes", stream->left());
+    }
+    
+    int len = (uint16_t)stream->read_2bytes();
+    if (!stream->require(len)) {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires %d only %d bytes", len, stream->left());
+    }
+    stream->skip(len);
+    
+    return srs_success;
+}
+
+srs_error_t srs_amf0_skip_any(SrsBuffer* stream)
+{
+    srs_error_t err = srs_success;
+    
+    if (!stream->require(1)) {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "marker requires 1 only %d bytes", stream->left());
+    }
+    
+    char marker = stream->read_1bytes();
+    switch (marker) {
+        case RTMP_AMF0_String: {
+            return srs_amf0_skip_utf8(stream);
+        }
+        case RTMP_AMF0_Boolean: {
+            if (!stream->require(1)) {
+                return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 1 only %d bytes", stream->left());
+            }
+            stream->skip(1);
+            return err;
+        }
+        case RTMP_AMF0_Number: {
+            if (!stream->require(8)) {
+                return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 8 only %d bytes", stream->left());
+            }
+            stream->skip(8);
+            return err;
+        }
+        case RTMP_AMF0_Date: {
+            if (!stream->require(10)) {
+                return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 10 only %d bytes", stream->left());
+            }
+            stream->skip(10);
+            return err;
+        }
+        case RTMP_AMF0_Null:
+        case RTMP_AMF0_Undefined: {
+            return err;
+        }
+        case RTMP_AMF0_Object:
+        case RTMP_AMF0_EcmaArray: {
+            stream->skip(-1);
+            if ((err = srs_amf0_read_object_begin(stream)) != srs_success) {
+                return srs_error_wrap(err, "object");
+            }
+            
+            while (true) {
+                string name;
+                bool eof = false;
+                if ((err = srs_amf0_read_property(stream, name, eof)) != srs_success) {
+                    return srs_error_wrap(err, "property");
+                }
+                if (eof) {
+                    break;
+                }
+                if ((err = srs_amf0_skip_any(stream)) != srs_success) {
+                    return srs_error_wrap(err, "property %s", name.c_str());
+                }
+            }
+            return err;
+        }
+        case RTMP_AMF0_StrictArray: {
+            if (!stream->require(4)) {
+                return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 4 only %d bytes", stream->left());
+            }
+            
+            int32_t count = stream->read_4bytes();
+            for (int i = 0; i < count; i++) {
+                if ((err = srs_amf0_skip_any(stream)) != srs_success) {
+                    return srs_error_wrap(err, "elem %d", i);
+                }
+            }
+            return err;
+        }
+        default: {
+            return srs_error_new(ERROR_RTMP_AMF0_INVALID, "invalid amf0 message, marker=%#x", marker);
+        }
+    }
+}
+
+srs_error_t srs_amf0_read_object_begin(SrsBuffer* stream)
+{
+    if (!stream->require(1)) {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 1 only %d bytes", stream->left());
+    }
+    
+    char marker = stream->read_1bytes();
+    if (marker == RTMP_AMF0_Object) {
+        return srs_success;
+    }
+    if (marker != RTMP_AMF0_EcmaArray) {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "Object invalid marker=%#x", marker);
+    }
+    
+    // The count of ecma array is ignored, the properties end by object eof.
+    if (!stream->require(4)) {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 4 only %d bytes", stream->left());
+    }
+    stream->skip(4);
+    
+    return srs_success;
+}
+
+srs_error_t srs_amf0_read_property(SrsBuffer* stream, string& name, bool& eof)
+{
+    srs_error_t err = srs_success;
+    
+    if ((eof = srs_amf0_is_object_eof(stream)) == true) {
+        stream->skip(3);
+        return err;
+    }
+    
+    if ((err = srs_amf0_read_utf8(stream, name)) != srs_success) {
+        return srs_error_wrap(err, "property name");
+    }
+    
+    return err;
+}
+
+SrsAmf0Writer::SrsAmf0Writer()
+{
+}
+
+SrsAmf0Writer::~SrsAmf0Writer()
+{
+}
+
+SrsAmf0Writer* SrsAmf0Writer::str(string value)
+{
+    data.append(1, RTMP_AMF0_String);
+    return property(value);
+}
+
+SrsAmf0Writer* SrsAmf0Writer::number(double value)
+{
+    char buf[9];
+    SrsBuffer stream(buf, sizeof(buf));
+    
+    int64_t temp = 0x00;
+    memcpy(&temp, &value, 8);
+    stream.write_1bytes(RTMP_AMF0_Number);
+    stream.write_8bytes(temp);
+    
+    data.append(buf, sizeof(buf));
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::boolean(bool value)
+{
+    data.append(1, RTMP_AMF0_Boolean);
+    data.append(1, value? 0x01 : 0x00);
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::null()
+{
+    data.append(1, RTMP_AMF0_Null);
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::undefined()
+{
+    data.append(1, RTMP_AMF0_Undefined);
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::raw(string value)
+{
+    data.append(value);
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::object_begin()
+{
+    data.append(1, RTMP_AMF0_Object);
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::ecma_array_begin(int32_t count)
+{
+    char buf[5];
+    SrsBuffer stream(buf, sizeof(buf));
+    
+    stream.write_1bytes(RTMP_AMF0_EcmaArray);
+    stream.write_4bytes(count);
+    
+    data.append(buf, sizeof(buf));
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::property(string name)
+{
+    char buf[2];
+    SrsBuffer stream(buf, sizeof(buf));
+    stream.write_2bytes((int16_t)name.length());
+    
+    data.append(buf, sizeof(buf));
+    data.append(name);
+    return this;
+}
+
+SrsAmf0Writer* SrsAmf0Writer::object_end()
+{
+    data.append("\x00\x00\x09", 3);
+    return this;
+}
+
+string SrsAmf0Writer::bytes()
+{
+    return data;
+}
+
 namespace _srs_internal
 {
     srs_error_t srs_amf0_read_utf8(SrsBuffer* stream, string& value)
@@ -625,6 +625,61 @@ extern srs_error_t srs_amf0_write_null(SrsBuffer* stream);
 extern srs_error_t srs_amf0_read_undefined(SrsBuffer* stream);
 extern srs_error_t srs_amf0_write_undefined(SrsBuffer* stream);
 
+/**
+ * The cursor to read amf0 from stream, without the amf0 objects.
+ * For example, to decode the known fields of command object:
+ *      srs_amf0_read_object_begin(stream);
+ *      while (true) {
+ *          srs_amf0_read_property(stream, name, eof);
+ *          if (eof) break;
+ *          if (name == "tcUrl" && srs_amf0_is_string(stream)) srs_amf0_read_string(stream, tcUrl);
+ *          else srs_amf0_skip_any(stream);
+ *      }
+ */
+// Whether the next value in stream is the type, never consume the stream.
+extern bool srs_amf0_is_string(SrsBuffer* stream);
+extern bool srs_amf0_is_number(SrsBuffer* stream);
+extern bool srs_amf0_is_boolean(SrsBuffer* stream);
+extern bool srs_amf0_is_object(SrsBuffer* stream);
+// Skip any amf0 value, for example, the object or array with all its properties.
+extern srs_error_t srs_amf0_skip_any(SrsBuffer* stream);
+// Read the marker of object or ecma array, then read the properties by srs_amf0_read_property.
+extern srs_error_t srs_amf0_read_object_begin(SrsBuffer* stream);
+// Read the name of next property, then user should read or skip the value.
+// @param eof Whether object is end, the object eof is consumed.
+extern srs_error_t srs_amf0_read_property(SrsBuffer* stream, std::string& name, bool& eof);
+
+/**
+ * The cursor to write amf0 to bytes, without the amf0 objects.
+ * For example, to encode the response from the preformatted template:
+ *      SrsAmf0Writer w;
+ *      w.str("_result")->number(1)->object_begin()->property("code")->str("OK")->object_end();
+ *      std::string payload = w.bytes();
+ */
+class SrsAmf0Writer
+{
+private:
+    std::string data;
+public:
+    SrsAmf0Writer();
+    virtual ~SrsAmf0Writer();
+public:
+    virtual SrsAmf0Writer* str(std::string value);
+    virtual SrsAmf0Writer* number(double value);
+    virtual SrsAmf0Writer* boolean(bool value);
+    virtual SrsAmf0Writer* null();
+    virtual SrsAmf0Writer* undefined();
+    // Write the bytes which is already encoded, for example, the template.
+    virtual SrsAmf0Writer* raw(std::string value);
+    // Write the object or ecma array, then write each property and its value, then end it.
+    virtual SrsAmf0Writer* object_begin();
+    virtual SrsAmf0Writer* ecma_array_begin(int32_t count);
+    virtual SrsAmf0Writer* property(std::string name);
+    virtual SrsAmf0Writer* object_end();
+public:
+    virtual std::string bytes();
+};
+
 // internal objects, user should never use it.
 namespace _srs_internal
 {
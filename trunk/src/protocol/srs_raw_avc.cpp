@@ -48,30 +48,63 @@ srs_error_t SrsRawH264Stream::annexb_demux(SrsBuffer* stream, char** pframe, int
     *pframe = NULL;
     *pnb_frame = 0;
     
-    while (!stream->empty()) {
-        // each frame must prefixed by annexb format.
-        // about annexb, @see ISO_IEC_14496-10-AVC-2003.pdf, page 211.
-        int pnb_start_code = 0;
-        if (!srs_avc_startswith_annexb(stream, &pnb_start_code)) {
-            return srs_error_new(ERROR_H264_API_NO_PREFIXED, "annexb start code");
-        }
-        int start = stream->pos() + pnb_start_code;
-        
-        // find the last frame prefixed by annexb format.
-        stream->skip(pnb_start_code);
-        while (!stream->empty()) {
-            if (srs_avc_startswith_annexb(stream, NULL)) {
-                break;
-            }
-            stream->skip(1);
-        }
-        
-        // demux the frame.
-        *pnb_frame = stream->pos() - start;
-        *pframe = stream->data() + start;
-        break;
+    if (stream->empty()) {
+        return err;
+    }
+    
+    char* p = stream->data() + stream->pos();
+    char* end = stream->data() + stream->size();
+    
+    // each frame must prefixed by annexb format.
+    // about annexb, @see ISO_IEC_14496-10-AVC-2003.pdf, page 211.
+    int nb_start_code = 0;
+    if (srs_avc_find_annexb(p, end, &nb_start_code) != p) {
+        return srs_error_new(ERROR_H264_API_NO_PREFIXED, "annexb start code");
+    }
+    char* frame = p + nb_start_code;
+    
+    // find the last frame prefixed by annexb format.
+    char* last = srs_avc_find_annexb(frame, end, NULL);
+    if (!last) {
+        last = end;
+    }
+    stream->skip((int)(last - p));
+    
+    // demux the frame.
+    *pnb_frame = (int)(last - frame);
+    *pframe = frame;
+    
+    return err;
+}
+
+srs_error_t SrsRawH264Stream::annexb_split(SrsBuffer* stream, SrsAnnexbNalu* nalus, int max, int* pnb_nalus)
+{
+    srs_error_t err = srs_success;
+    
+    *pnb_nalus = 0;
+    
+    if (stream->empty()) {
+        return err;
+    }
+    
+    char* p = stream->data() + stream->pos();
+    int left = stream->left();
+    
+    // each frame must prefixed by annexb format.
+    // about annexb, @see ISO_IEC_14496-10-AVC-2003.pdf, page 211.
+    int nn = srs_avc_split_annexb(p, left, nalus, max);
+    if (nn < 0) {
+        return srs_error_new(ERROR_H264_API_NO_PREFIXED, "annexb start code");
     }
     
+    // The last NALU ends at the next start code if got max NALUs, otherwise the end of stream.
+    if (nn == max) {
+        left = (int)(nalus[nn - 1].bytes + nalus[nn - 1].size - p);
+    }
+    stream->skip(left);
+    
+    *pnb_nalus = nn;
+    
     return err;
 }
 
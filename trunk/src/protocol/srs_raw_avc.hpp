@@ -31,6 +31,7 @@
 #include <srs_kernel_codec.hpp>
 
 class SrsBuffer;
+struct SrsAnnexbNalu;
 
 // The raw h.264 stream, in annexb.
 class SrsRawH264Stream
@@ -44,6 +45,11 @@ public:
     // @param pframe the output h.264 frame in stream. user should never free it.
     // @param pnb_frame the output h.264 frame size.
     virtual srs_error_t annexb_demux(SrsBuffer* stream, char** pframe, int* pnb_frame);
+    // Split the NALUs of stream in annexb format in one pass, and skip the stream to the end of the last
+    // NALU. User should split again when stream is not empty, because at most max NALUs are split.
+    // @param nalus the output NALUs in stream. user should never free them.
+    // @param pnb_nalus the output number of NALUs, the empty NALUs are ignored.
+    virtual srs_error_t annexb_split(SrsBuffer* stream, SrsAnnexbNalu* nalus, int max, int* pnb_nalus);
     // whether the frame is sps or pps.
     virtual bool is_sps(char* frame, int nb_frame);
     virtual bool is_pps(char* frame, int nb_frame);
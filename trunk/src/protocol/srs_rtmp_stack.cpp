@@ -844,6 +844,51 @@ srs_error_t SrsProtocol::send_and_free_messages(SrsSharedPtrMessage** msgs, int
     return err;
 }
 
+srs_error_t SrsProtocol::send_and_free_chunks(SrsSharedPtrMessage** msgs, int nb_msgs)
+{
+    // always not NULL msg.
+    srs_assert(msgs);
+    srs_assert(nb_msgs > 0);
+    
+    // realloc the iovs if exceed, one iovs for each message.
+    if (nb_out_iovs < nb_msgs) {
+        nb_out_iovs = nb_msgs;
+        out_iovs = (iovec*)realloc(out_iovs, sizeof(iovec) * nb_out_iovs);
+    }
+    
+    for (int i = 0; i < nb_msgs; i++) {
+        SrsSharedPtrMessage* msg = msgs[i];
+        out_iovs[i].iov_base = msg->payload;
+        out_iovs[i].iov_len = msg->size;
+    }
+    
+    srs_error_t err = do_iovs_send(out_iovs, nb_msgs);
+    
+    for (int i = 0; i < nb_msgs; i++) {
+        SrsSharedPtrMessage* msg = msgs[i];
+        srs_freep(msg);
+    }
+    
+    // donot flush when send failed
+    if (err != srs_success) {
+        return srs_error_wrap(err, "send chunks");
+    }
+    
+    // flush messages in manual queue
+    if ((err = manual_response_flush()) != srs_success) {
+        return srs_error_wrap(err, "manual flush response");
+    }
+    
+    print_debug_info();
+    
+    return err;
+}
+
+int SrsProtocol::get_out_chunk_size()
+{
+    return out_chunk_size;
+}
+
 srs_error_t SrsProtocol::send_and_free_packet(SrsPacket* packet, int stream_id)
 {
     srs_error_t err = srs_success;
@@ -2271,6 +2316,11 @@ srs_error_t SrsRtmpServer::send_and_free_messages(SrsSharedPtrMessage** msgs, in
     return protocol->send_and_free_messages(msgs, nb_msgs, stream_id);
 }
 
+srs_error_t SrsRtmpServer::send_and_free_chunks(SrsSharedPtrMessage** msgs, int nb_msgs)
+{
+    return protocol->send_and_free_chunks(msgs, nb_msgs);
+}
+
 srs_error_t SrsRtmpServer::send_and_free_packet(SrsPacket* packet, int stream_id)
 {
     return protocol->send_and_free_packet(packet, stream_id);
@@ -2313,28 +2363,19 @@ srs_error_t SrsRtmpServer::connect_app(SrsRequest* req)
     SrsAutoFree(SrsCommonMessage, msg);
     SrsAutoFree(SrsConnectAppPacket, pkt);
     
-    SrsAmf0Any* prop = NULL;
-    
-    if ((prop = pkt->command_object->ensure_property_string("tcUrl")) == NULL) {
+    if (pkt->tcUrl.empty()) {
         return srs_error_new(ERROR_RTMP_REQ_CONNECT, "invalid request without tcUrl");
     }
-    req->tcUrl = prop->to_str();
-    
-    if ((prop = pkt->command_object->ensure_property_string("pageUrl")) != NULL) {
-        req->pageUrl = prop->to_str();
-    }
-    
-    if ((prop = pkt->command_object->ensure_property_string("swfUrl")) != NULL) {
-        req->swfUrl = prop->to_str();
-    }
-    
-    if ((prop = pkt->command_object->ensure_property_number("objectEncoding")) != NULL) {
-        req->objectEncoding = prop->to_number();
-    }
+    req->tcUrl = pkt->tcUrl;
+    req->pageUrl = pkt->pageUrl;
+    req->swfUrl = pkt->swfUrl;
+    req->objectEncoding = pkt->objectEncoding;
     
+    // Move the args to request, the packet is freed soon.
     if (pkt->args) {
         srs_freep(req->args);
-        req->args = pkt->args->copy()->to_object();
+        req->args = pkt->args;
+        pkt->args = NULL;
     }
     
     srs_discovery_tc_url(req->tcUrl, req->schema, req->host, req->vhost, req->app, req->stream, req->port, req->param);
@@ -2379,34 +2420,39 @@ srs_error_t SrsRtmpServer::response_connect_app(SrsRequest *req, const char* ser
 {
     srs_error_t err = srs_success;
     
-    SrsConnectAppResPacket* pkt = new SrsConnectAppResPacket();
-
+    // The props and the constant part of info is encoded once, by the template.
     // @remark For windows, there must be a space between const string and macro.
-    pkt->props->set("fmsVer", SrsAmf0Any::str("FMS/" RTMP_SIG_FMS_VER));
-    pkt->props->set("capabilities", SrsAmf0Any::number(127));
-    pkt->props->set("mode", SrsAmf0Any::number(1));
-    
-    pkt->info->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-    pkt->info->set(StatusCode, SrsAmf0Any::str(StatusCodeConnectSuccess));
-    pkt->info->set(StatusDescription, SrsAmf0Any::str("Connection succeeded"));
-    pkt->info->set("objectEncoding", SrsAmf0Any::number(req->objectEncoding));
-    SrsAmf0EcmaArray* data = SrsAmf0Any::ecma_array();
-    pkt->info->set("data", data);
-    
-    data->set("version", SrsAmf0Any::str(RTMP_SIG_FMS_VER));
-    data->set("srs_sig", SrsAmf0Any::str(RTMP_SIG_SRS_KEY));
-    data->set("srs_server", SrsAmf0Any::str(RTMP_SIG_SRS_SERVER));
-    data->set("srs_license", SrsAmf0Any::str(RTMP_SIG_SRS_LICENSE));
-    data->set("srs_url", SrsAmf0Any::str(RTMP_SIG_SRS_URL));
-    data->set("srs_version", SrsAmf0Any::str(RTMP_SIG_SRS_VERSION));
-
+    static string prefix = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_RESULT)->number(1)->object_begin()
+        ->property("fmsVer")->str("FMS/" RTMP_SIG_FMS_VER)
+        ->property("capabilities")->number(127)
+        ->property("mode")->number(1)
+        ->object_end()->object_begin()
+        ->property(StatusLevel)->str(StatusLevelStatus)
+        ->property(StatusCode)->str(StatusCodeConnectSuccess)
+        ->property(StatusDescription)->str("Connection succeeded")
+        ->bytes();
+    
+    SrsAmf0Writer w;
+    w.raw(prefix)->property("objectEncoding")->number(req->objectEncoding);
+    
+    // The count of ecma array is 0, which is same to SrsAmf0EcmaArray.
+    w.property("data")->ecma_array_begin(0)
+        ->property("version")->str(RTMP_SIG_FMS_VER)
+        ->property("srs_sig")->str(RTMP_SIG_SRS_KEY)
+        ->property("srs_server")->str(RTMP_SIG_SRS_SERVER)
+        ->property("srs_license")->str(RTMP_SIG_SRS_LICENSE)
+        ->property("srs_url")->str(RTMP_SIG_SRS_URL)
+        ->property("srs_version")->str(RTMP_SIG_SRS_VERSION);
+    
     if (server_ip) {
-        data->set("srs_server_ip", SrsAmf0Any::str(server_ip));
+        w.property("srs_server_ip")->str(server_ip);
     }
     // for edge to directly get the id of client.
-    data->set("srs_pid", SrsAmf0Any::number(getpid()));
-    data->set("srs_id", SrsAmf0Any::number(_srs_context->get_id()));
+    w.property("srs_pid")->number(getpid());
+    w.property("srs_id")->number(_srs_context->get_id());
+    w.object_end()->object_end();
     
+    SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverConnection, w.bytes());
     if ((err = protocol->send_and_free_packet(pkt, 0)) != srs_success) {
         return srs_error_wrap(err, "send connect app response");
     }
@@ -2575,6 +2621,11 @@ srs_error_t SrsRtmpServer::set_chunk_size(int chunk_size)
     return err;
 }
 
+int SrsRtmpServer::get_chunk_size()
+{
+    return protocol->get_out_chunk_size();
+}
+
 srs_error_t SrsRtmpServer::start_play(int stream_id)
 {
     srs_error_t err = srs_success;
@@ -2591,13 +2642,14 @@ srs_error_t SrsRtmpServer::start_play(int stream_id)
     
     // onStatus(NetStream.Play.Reset)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->data->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodeStreamReset));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Playing and resetting stream."));
-        pkt->data->set(StatusDetails, SrsAmf0Any::str("stream"));
-        pkt->data->set(StatusClientId, SrsAmf0Any::str(RTMP_SIG_CLIENT_ID));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->number(0)->null()->object_begin()
+            ->property(StatusLevel)->str(StatusLevelStatus)
+            ->property(StatusCode)->str(StatusCodeStreamReset)
+            ->property(StatusDescription)->str("Playing and resetting stream.")
+            ->property(StatusDetails)->str("stream")
+            ->property(StatusClientId)->str(RTMP_SIG_CLIENT_ID)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Play.Reset");
@@ -2606,13 +2658,14 @@ srs_error_t SrsRtmpServer::start_play(int stream_id)
     
     // onStatus(NetStream.Play.Start)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->data->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodeStreamStart));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Started playing stream."));
-        pkt->data->set(StatusDetails, SrsAmf0Any::str("stream"));
-        pkt->data->set(StatusClientId, SrsAmf0Any::str(RTMP_SIG_CLIENT_ID));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->number(0)->null()->object_begin()
+            ->property(StatusLevel)->str(StatusLevelStatus)
+            ->property(StatusCode)->str(StatusCodeStreamStart)
+            ->property(StatusDescription)->str("Started playing stream.")
+            ->property(StatusDetails)->str("stream")
+            ->property(StatusClientId)->str(RTMP_SIG_CLIENT_ID)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Play.Start");
@@ -2621,12 +2674,10 @@ srs_error_t SrsRtmpServer::start_play(int stream_id)
     
     // |RtmpSampleAccess(false, false)
     if (true) {
-        SrsSampleAccessPacket* pkt = new SrsSampleAccessPacket();
-        
         // allow audio/video sample.
         // @see: https://github.com/ossrs/srs/issues/49
-        pkt->audio_sample_access = true;
-        pkt->video_sample_access = true;
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_DATA_SAMPLE_ACCESS)->boolean(true)->boolean(true)->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0DataMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send |RtmpSampleAccess true");
@@ -2635,8 +2686,10 @@ srs_error_t SrsRtmpServer::start_play(int stream_id)
     
     // onStatus(NetStream.Data.Start)
     if (true) {
-        SrsOnStatusDataPacket* pkt = new SrsOnStatusDataPacket();
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodeDataStart));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->object_begin()
+            ->property(StatusCode)->str(StatusCodeDataStart)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0DataMessage, RTMP_CID_OverStream, payload);
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Data.Start");
         }
@@ -2763,11 +2816,11 @@ srs_error_t SrsRtmpServer::start_fmle_publish(int stream_id)
     }
     // publish response onFCPublish(NetStream.Publish.Start)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->command_name = RTMP_AMF0_COMMAND_ON_FC_PUBLISH;
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodePublishStart));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Started publishing stream."));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_FC_PUBLISH)->number(0)->null()->object_begin()
+            ->property(StatusCode)->str(StatusCodePublishStart)
+            ->property(StatusDescription)->str("Started publishing stream.")
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Publish.Start");
@@ -2775,12 +2828,13 @@ srs_error_t SrsRtmpServer::start_fmle_publish(int stream_id)
     }
     // publish response onStatus(NetStream.Publish.Start)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->data->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodePublishStart));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Started publishing stream."));
-        pkt->data->set(StatusClientId, SrsAmf0Any::str(RTMP_SIG_CLIENT_ID));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->number(0)->null()->object_begin()
+            ->property(StatusLevel)->str(StatusLevelStatus)
+            ->property(StatusCode)->str(StatusCodePublishStart)
+            ->property(StatusDescription)->str("Started publishing stream.")
+            ->property(StatusClientId)->str(RTMP_SIG_CLIENT_ID)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Publish.Start");
@@ -2808,11 +2862,11 @@ srs_error_t SrsRtmpServer::start_haivision_publish(int stream_id)
     
     // publish response onFCPublish(NetStream.Publish.Start)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->command_name = RTMP_AMF0_COMMAND_ON_FC_PUBLISH;
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodePublishStart));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Started publishing stream."));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_FC_PUBLISH)->number(0)->null()->object_begin()
+            ->property(StatusCode)->str(StatusCodePublishStart)
+            ->property(StatusDescription)->str("Started publishing stream.")
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Publish.Start");
@@ -2821,12 +2875,13 @@ srs_error_t SrsRtmpServer::start_haivision_publish(int stream_id)
     
     // publish response onStatus(NetStream.Publish.Start)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->data->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodePublishStart));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Started publishing stream."));
-        pkt->data->set(StatusClientId, SrsAmf0Any::str(RTMP_SIG_CLIENT_ID));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->number(0)->null()->object_begin()
+            ->property(StatusLevel)->str(StatusLevelStatus)
+            ->property(StatusCode)->str(StatusCodePublishStart)
+            ->property(StatusDescription)->str("Started publishing stream.")
+            ->property(StatusClientId)->str(RTMP_SIG_CLIENT_ID)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Publish.Start");
@@ -2842,11 +2897,11 @@ srs_error_t SrsRtmpServer::fmle_unpublish(int stream_id, double unpublish_tid)
     
     // publish response onFCUnpublish(NetStream.unpublish.Success)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->command_name = RTMP_AMF0_COMMAND_ON_FC_UNPUBLISH;
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodeUnpublishSuccess));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Stop publishing stream."));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_FC_UNPUBLISH)->number(0)->null()->object_begin()
+            ->property(StatusCode)->str(StatusCodeUnpublishSuccess)
+            ->property(StatusDescription)->str("Stop publishing stream.")
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.unpublish.Success");
@@ -2861,12 +2916,13 @@ srs_error_t SrsRtmpServer::fmle_unpublish(int stream_id, double unpublish_tid)
     }
     // publish response onStatus(NetStream.Unpublish.Success)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->data->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodeUnpublishSuccess));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Stream is now unpublished"));
-        pkt->data->set(StatusClientId, SrsAmf0Any::str(RTMP_SIG_CLIENT_ID));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->number(0)->null()->object_begin()
+            ->property(StatusLevel)->str(StatusLevelStatus)
+            ->property(StatusCode)->str(StatusCodeUnpublishSuccess)
+            ->property(StatusDescription)->str("Stream is now unpublished")
+            ->property(StatusClientId)->str(RTMP_SIG_CLIENT_ID)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Unpublish.Success");
@@ -2882,12 +2938,13 @@ srs_error_t SrsRtmpServer::start_flash_publish(int stream_id)
     
     // publish response onStatus(NetStream.Publish.Start)
     if (true) {
-        SrsOnStatusCallPacket* pkt = new SrsOnStatusCallPacket();
-        
-        pkt->data->set(StatusLevel, SrsAmf0Any::str(StatusLevelStatus));
-        pkt->data->set(StatusCode, SrsAmf0Any::str(StatusCodePublishStart));
-        pkt->data->set(StatusDescription, SrsAmf0Any::str("Started publishing stream."));
-        pkt->data->set(StatusClientId, SrsAmf0Any::str(RTMP_SIG_CLIENT_ID));
+        static string payload = SrsAmf0Writer().str(RTMP_AMF0_COMMAND_ON_STATUS)->number(0)->null()->object_begin()
+            ->property(StatusLevel)->str(StatusLevelStatus)
+            ->property(StatusCode)->str(StatusCodePublishStart)
+            ->property(StatusDescription)->str("Started publishing stream.")
+            ->property(StatusClientId)->str(RTMP_SIG_CLIENT_ID)
+            ->object_end()->bytes();
+        SrsPreformattedPacket* pkt = new SrsPreformattedPacket(RTMP_MSG_AMF0CommandMessage, RTMP_CID_OverStream, payload);
         
         if ((err = protocol->send_and_free_packet(pkt, stream_id)) != srs_success) {
             return srs_error_wrap(err, "send NetStream.Publish.Start");
@@ -3016,6 +3073,7 @@ SrsConnectAppPacket::SrsConnectAppPacket()
     command_object = SrsAmf0Any::object();
     // optional
     args = NULL;
+    objectEncoding = RTMP_SIG_AMF0_VER;
 }
 
 SrsConnectAppPacket::~SrsConnectAppPacket()
@@ -3044,10 +3102,37 @@ srs_error_t SrsConnectAppPacket::decode(SrsBuffer* stream)
         srs_warn("invalid transaction_id=%.2f", transaction_id);
     }
     
-    if ((err = command_object->read(stream)) != srs_success) {
+    // Read the known fields by cursor, to avoid building the amf0 objects.
+    if ((err = srs_amf0_read_object_begin(stream)) != srs_success) {
         return srs_error_wrap(err, "command_object");
     }
     
+    while (true) {
+        string name;
+        bool eof = false;
+        if ((err = srs_amf0_read_property(stream, name, eof)) != srs_success) {
+            return srs_error_wrap(err, "command_object");
+        }
+        if (eof) {
+            break;
+        }
+        
+        if (name == "tcUrl" && srs_amf0_is_string(stream)) {
+            err = srs_amf0_read_string(stream, tcUrl);
+        } else if (name == "pageUrl" && srs_amf0_is_string(stream)) {
+            err = srs_amf0_read_string(stream, pageUrl);
+        } else if (name == "swfUrl" && srs_amf0_is_string(stream)) {
+            err = srs_amf0_read_string(stream, swfUrl);
+        } else if (name == "objectEncoding" && srs_amf0_is_number(stream)) {
+            err = srs_amf0_read_number(stream, objectEncoding);
+        } else {
+            err = srs_amf0_skip_any(stream);
+        }
+        if (err != srs_success) {
+            return srs_error_wrap(err, "command_object %s", name.c_str());
+        }
+    }
+    
     if (!stream->empty()) {
         srs_freep(args);
         
@@ -3927,23 +4012,21 @@ srs_error_t SrsPlayPacket::decode(SrsBuffer* stream)
         return err;
     }
     
-    SrsAmf0Any* reset_value = NULL;
-    if ((err = srs_amf0_read_any(stream, &reset_value)) != srs_success) {
-        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "reset");
-    }
-    SrsAutoFree(SrsAmf0Any, reset_value);
-    
-    if (reset_value) {
-        // check if the value is bool or number
-        // An optional Boolean value or number that specifies whether
-        // to flush any previous playlist
-        if (reset_value->is_boolean()) {
-            reset = reset_value->to_boolean();
-        } else if (reset_value->is_number()) {
-            reset = (reset_value->to_number() != 0);
-        } else {
-            return srs_error_new(ERROR_RTMP_AMF0_DECODE, "invalid marker=%#x", (uint8_t)reset_value->marker);
+    // check if the value is bool or number
+    // An optional Boolean value or number that specifies whether
+    // to flush any previous playlist
+    if (srs_amf0_is_boolean(stream)) {
+        if ((err = srs_amf0_read_boolean(stream, reset)) != srs_success) {
+            return srs_error_wrap(err, "reset");
+        }
+    } else if (srs_amf0_is_number(stream)) {
+        double reset_value = 0;
+        if ((err = srs_amf0_read_number(stream, reset_value)) != srs_success) {
+            return srs_error_wrap(err, "reset");
         }
+        reset = (reset_value != 0);
+    } else {
+        return srs_error_new(ERROR_RTMP_AMF0_DECODE, "invalid marker=%#x", (uint8_t)stream->data()[stream->pos()]);
     }
     
     return err;
@@ -4463,6 +4546,43 @@ srs_error_t SrsSampleAccessPacket::encode_packet(SrsBuffer* stream)
     return err;
 }
 
+SrsPreformattedPacket::SrsPreformattedPacket(int mt, int cid, string p)
+{
+    message_type = mt;
+    prefer_cid = cid;
+    payload = p;
+}
+
+SrsPreformattedPacket::~SrsPreformattedPacket()
+{
+}
+
+int SrsPreformattedPacket::get_prefer_cid()
+{
+    return prefer_cid;
+}
+
+int SrsPreformattedPacket::get_message_type()
+{
+    return message_type;
+}
+
+int SrsPreformattedPacket::get_size()
+{
+    return (int)payload.length();
+}
+
+srs_error_t SrsPreformattedPacket::encode_packet(SrsBuffer* stream)
+{
+    if (!stream->require((int)payload.length())) {
+        return srs_error_new(ERROR_RTMP_MESSAGE_ENCODE, "requires %d only %d bytes", (int)payload.length(), stream->left());
+    }
+    
+    stream->write_bytes((char*)payload.data(), (int)payload.length());
+    
+    return srs_success;
+}
+
 SrsOnMetaDataPacket::SrsOnMetaDataPacket()
 {
     name = SRS_CONSTS_RTMP_ON_METADATA;
@@ -295,6 +295,11 @@ public:
     // @param nb_msgs, the size of msgs to send out.
     // @param stream_id, the stream id of packet to send over, 0 for control message.
     virtual srs_error_t send_and_free_messages(SrsSharedPtrMessage** msgs, int nb_msgs, int stream_id);
+    // Send the messages which are already encoded in chunks and always free them.
+    // @param msgs, each msg is the chunks of a RTMP message, in the out chunk size.
+    virtual srs_error_t send_and_free_chunks(SrsSharedPtrMessage** msgs, int nb_msgs);
+    // Get the out chunk size, to encode the chunks.
+    virtual int get_out_chunk_size();
     // Send the RTMP packet and always free it.
     // user must never free or use the packet after this method,
     // For it will always free the packet.
@@ -686,6 +691,9 @@ public:
     // @remark performance issue, to support 6k+ 250kbps client,
     //       @see https://github.com/ossrs/srs/issues/194
     virtual srs_error_t send_and_free_messages(SrsSharedPtrMessage** msgs, int nb_msgs, int stream_id);
+    // Send the messages which are already encoded in chunks and always free them.
+    // @remark The chunks must be encoded in the chunk size of get_chunk_size().
+    virtual srs_error_t send_and_free_chunks(SrsSharedPtrMessage** msgs, int nb_msgs);
     // Send the RTMP packet and always free it.
     // user must never free or use the packet after this method,
     // For it will always free the packet.
@@ -723,6 +731,8 @@ public:
     virtual srs_error_t identify_client(int stream_id, SrsRtmpConnType& type, std::string& stream_name, srs_utime_t& duration);
     // Set the chunk size when client type identified.
     virtual srs_error_t set_chunk_size(int chunk_size);
+    // Get the chunk size to send messages to client.
+    virtual int get_chunk_size();
     // When client type is play, response with packets:
     // StreamBegin,
     // onStatus(NetStream.Play.Reset), onStatus(NetStream.Play.Start).,
@@ -798,10 +808,19 @@ public:
     // @remark: alloc in packet constructor, user can directly use it,
     //       user should never alloc it again which will cause memory leak.
     // @remark, never be NULL.
+    // @remark Only for encoding, the decoder reads the known fields below and skips others.
     SrsAmf0Object* command_object;
     // Any optional information
     // @remark, optional, init to and maybe NULL.
     SrsAmf0Object* args;
+// The known fields of command object, decoded by the amf0 cursor.
+public:
+    // The tcUrl, empty if not specified or not a string.
+    std::string tcUrl;
+    std::string pageUrl;
+    std::string swfUrl;
+    // The objectEncoding, 0 if not specified or not a number.
+    double objectEncoding;
 public:
     SrsConnectAppPacket();
     virtual ~SrsConnectAppPacket();
@@ -1364,6 +1383,27 @@ protected:
     virtual srs_error_t encode_packet(SrsBuffer* stream);
 };
 
+// The packet which payload is already encoded, for example, the constant responses
+// such as onStatus(NetStream.Play.Start), which are encoded once by SrsAmf0Writer.
+// @remark The packet is only for encoding, never decode it.
+class SrsPreformattedPacket : public SrsPacket
+{
+private:
+    int message_type;
+    int prefer_cid;
+    std::string payload;
+public:
+    SrsPreformattedPacket(int message_type, int prefer_cid, std::string payload);
+    virtual ~SrsPreformattedPacket();
+// Encode functions for concrete packet to override.
+public:
+    virtual int get_prefer_cid();
+    virtual int get_message_type();
+protected:
+    virtual int get_size();
+    virtual srs_error_t encode_packet(SrsBuffer* stream);
+};
+
 // The stream metadata.
 // FMLE: @setDataFrame
 // others: onMetaData
@@ -137,6 +137,7 @@ SrsRtpPacket::SrsRtpPacket()
     audio = new SrsAudioFrame();
     chunked = false;
     completed = false;
+    first_chunk = false;
 }
 
 SrsRtpPacket::~SrsRtpPacket()
@@ -145,6 +146,37 @@ SrsRtpPacket::~SrsRtpPacket()
     srs_freep(audio);
 }
 
+void SrsRtpPacket::reset()
+{
+    version = 2;
+    padding = 0;
+    extension = 0;
+    csrc_count = 0;
+    marker = 1;
+    
+    payload_type = 0;
+    sequence_number = 0;
+    timestamp = 0;
+    ssrc = 0;
+    
+    chunked = false;
+    completed = false;
+    first_chunk = false;
+    
+    // the payload and audio maybe reaped by others.
+    if (payload) {
+        payload->erase(payload->length());
+    } else {
+        payload = new SrsSimpleStream();
+    }
+    
+    if (audio) {
+        audio->nb_samples = 0;
+    } else {
+        audio = new SrsAudioFrame();
+    }
+}
+
 void SrsRtpPacket::copy(SrsRtpPacket* src)
 {
     version = src->version;
@@ -159,9 +191,14 @@ void SrsRtpPacket::copy(SrsRtpPacket* src)
     
     chunked = src->chunked;
     completed = src->completed;
-
-    srs_freep(audio);
-    audio = new SrsAudioFrame();
+    first_chunk = src->first_chunk;
+    
+    // only copy the header, drop the samples.
+    if (audio) {
+        audio->nb_samples = 0;
+    } else {
+        audio = new SrsAudioFrame();
+    }
 }
 
 void SrsRtpPacket::reap(SrsRtpPacket* src)
@@ -297,6 +334,7 @@ srs_error_t SrsRtpPacket::decode_96(SrsBuffer* stream)
     if (fu_indicator == 0x1c && (first_chunk || last_chunk || contious_chunk)) {
         chunked = true;
         completed = last_chunk;
+        this->first_chunk = first_chunk;
         
         // generate and append the first byte NALU.
         if (first_chunk) {
@@ -316,6 +354,223 @@ srs_error_t SrsRtpPacket::decode_96(SrsBuffer* stream)
     return err;
 }
 
+SrsRtpJitterBuffer::SrsRtpJitterBuffer(int capacity, srs_utime_t l)
+{
+    // the window must be aligned to the sequence number.
+    srs_assert(capacity > 0 && capacity <= 0x8000 && (capacity & (capacity - 1)) == 0);
+    
+    packets.resize(capacity, NULL);
+    latency = l;
+    started = false;
+    ssrc = 0;
+    next = 0;
+    highest = 0;
+    nb_packets = 0;
+    waiting = -1;
+    
+    nn_received = 0;
+    nn_lost = 0;
+    nn_reordered = 0;
+    nn_dropped = 0;
+}
+
+SrsRtpJitterBuffer::~SrsRtpJitterBuffer()
+{
+    for (int i = 0; i < (int)packets.size(); i++) {
+        SrsRtpPacket* pkt = packets[i];
+        srs_freep(pkt);
+    }
+    packets.clear();
+    
+    for (int i = 0; i < (int)pool.size(); i++) {
+        SrsRtpPacket* pkt = pool[i];
+        srs_freep(pkt);
+    }
+    pool.clear();
+}
+
+SrsRtpPacket* SrsRtpJitterBuffer::alloc()
+{
+    SrsRtpPacket* pkt = NULL;
+    
+    if (pool.empty()) {
+        pkt = new SrsRtpPacket();
+    } else {
+        pkt = pool.back();
+        pool.pop_back();
+    }
+    
+    pkt->reset();
+    return pkt;
+}
+
+void SrsRtpJitterBuffer::recycle(SrsRtpPacket* pkt)
+{
+    pool.push_back(pkt);
+}
+
+void SrsRtpJitterBuffer::push(SrsRtpPacket* pkt, srs_utime_t now)
+{
+    nn_received++;
+    
+    // start over when the source changed.
+    if (started && pkt->ssrc != ssrc) {
+        reset();
+    }
+    
+    int capacity = (int)packets.size();
+    int16_t diff = (int16_t)(pkt->sequence_number - next);
+    
+    // start over when the sequence jumps forward out of window, while the stale packet far behind,
+    // for example, a very late retransmit, is dropped below and never flushes the buffer.
+    if (started && diff >= capacity) {
+        reset();
+    }
+    
+    if (!started) {
+        started = true;
+        ssrc = pkt->ssrc;
+        next = highest = pkt->sequence_number;
+        diff = 0;
+    }
+    
+    // duplicated or too late, the packet is skipped.
+    int index = pkt->sequence_number & (capacity - 1);
+    if (diff < 0 || packets[index]) {
+        nn_dropped++;
+        recycle(pkt);
+        return;
+    }
+    
+    if ((int16_t)(pkt->sequence_number - highest) < 0) {
+        nn_reordered++;
+    } else {
+        highest = pkt->sequence_number;
+    }
+    
+    packets[index] = pkt;
+    nb_packets++;
+    
+    // start to wait for the lost packet.
+    if (diff > 0 && waiting < 0) {
+        waiting = now;
+    }
+}
+
+SrsRtpPacket* SrsRtpJitterBuffer::pop(srs_utime_t now)
+{
+    if (!nb_packets) {
+        return NULL;
+    }
+    
+    int capacity = (int)packets.size();
+    int index = next & (capacity - 1);
+    
+    // skip the lost packets when exceed the latency.
+    if (!packets[index]) {
+        if (waiting >= 0 && now - waiting < latency) {
+            return NULL;
+        }
+        
+        while (!packets[index]) {
+            nn_lost++;
+            next++;
+            index = next & (capacity - 1);
+        }
+    }
+    
+    SrsRtpPacket* pkt = packets[index];
+    packets[index] = NULL;
+    nb_packets--;
+    next++;
+    
+    // still waiting for the next lost packet, restart the timer.
+    waiting = -1;
+    if (nb_packets && !packets[next & (capacity - 1)]) {
+        waiting = now;
+    }
+    
+    return pkt;
+}
+
+int SrsRtpJitterBuffer::size()
+{
+    return nb_packets;
+}
+
+void SrsRtpJitterBuffer::reset()
+{
+    for (int i = 0; i < (int)packets.size(); i++) {
+        SrsRtpPacket* pkt = packets[i];
+        if (pkt) {
+            nn_dropped++;
+            recycle(pkt);
+            packets[i] = NULL;
+        }
+    }
+    
+    started = false;
+    nb_packets = 0;
+    waiting = -1;
+}
+
+SrsRtpFrameAssembler::SrsRtpFrameAssembler()
+{
+    frame = new SrsRtpPacket();
+    assembling = false;
+    next = 0;
+    nn_dropped = 0;
+}
+
+SrsRtpFrameAssembler::~SrsRtpFrameAssembler()
+{
+    srs_freep(frame);
+}
+
+SrsRtpPacket* SrsRtpFrameAssembler::assemble(SrsRtpPacket* pkt)
+{
+    if (!pkt->chunked) {
+        if (assembling) {
+            nn_dropped++;
+            assembling = false;
+        }
+        return pkt;
+    }
+    
+    // the first chunk, start a new message in the reused buffer.
+    if (pkt->first_chunk) {
+        if (assembling) {
+            nn_dropped++;
+        }
+        
+        frame->copy(pkt);
+        frame->payload->erase(frame->payload->length());
+        assembling = true;
+    } else if (!assembling) {
+        // the first chunk is lost, ignore util next message.
+        return NULL;
+    } else if (pkt->sequence_number != next) {
+        // any chunk is lost, drop the message.
+        nn_dropped++;
+        assembling = false;
+        return NULL;
+    }
+    
+    next = pkt->sequence_number + 1;
+    frame->payload->append(pkt->payload);
+    
+    if (!pkt->completed) {
+        return NULL;
+    }
+    
+    // use the header of last chunk, for the marker.
+    frame->marker = pkt->marker;
+    frame->completed = true;
+    assembling = false;
+    
+    return frame;
+}
+
 SrsRtspSdp::SrsRtspSdp()
 {
     state = SrsRtspSdpStateOthers;
@@ -599,6 +854,8 @@ SrsRtspTransport::SrsRtspTransport()
 {
     client_port_min = 0;
     client_port_max = 0;
+    interleaved_min = -1;
+    interleaved_max = -1;
 }
 
 SrsRtspTransport::~SrsRtspTransport()
@@ -652,6 +909,15 @@ srs_error_t SrsRtspTransport::parse(string attr)
             }
             client_port_min = ::atoi(sport.c_str());
             client_port_max = ::atoi(eport.c_str());
+        } else if (item_key == "interleaved") {
+            std::string schannel = item_value;
+            std::string echannel = item_value;
+            if ((pos = echannel.find("-")) != string::npos) {
+                schannel = echannel.substr(0, pos);
+                echannel = echannel.substr(pos + 1);
+            }
+            interleaved_min = ::atoi(schannel.c_str());
+            interleaved_max = ::atoi(echannel.c_str());
         }
     }
     
@@ -792,6 +1058,8 @@ SrsRtspSetupResponse::SrsRtspSetupResponse(int seq) : SrsRtspResponse(seq)
 {
     local_port_min = 0;
     local_port_max = 0;
+    interleaved_min = -1;
+    interleaved_max = -1;
 }
 
 SrsRtspSetupResponse::~SrsRtspSetupResponse()
@@ -801,6 +1069,15 @@ SrsRtspSetupResponse::~SrsRtspSetupResponse()
 srs_error_t SrsRtspSetupResponse::encode_header(stringstream& ss)
 {
     ss << SRS_RTSP_TOKEN_SESSION << ":" << SRS_RTSP_SP << session << SRS_RTSP_CRLF;
+    
+    // rtp over rtsp(tcp).
+    if (interleaved_min >= 0) {
+        ss << SRS_RTSP_TOKEN_TRANSPORT << ":" << SRS_RTSP_SP
+        << "RTP/AVP/TCP;unicast;interleaved=" << interleaved_min << "-" << interleaved_max
+        << SRS_RTSP_CRLF;
+        return srs_success;
+    }
+    
     ss << SRS_RTSP_TOKEN_TRANSPORT << ":" << SRS_RTSP_SP
     << "RTP/AVP;unicast;client_port=" << client_port_min << "-" << client_port_max << ";"
     << "server_port=" << local_port_min << "-" << local_port_max
@@ -808,10 +1085,19 @@ srs_error_t SrsRtspSetupResponse::encode_header(stringstream& ss)
     return srs_success;
 }
 
-SrsRtspStack::SrsRtspStack(ISrsProtocolReadWriter* s)
+ISrsRtspInterleavedHandler::ISrsRtspInterleavedHandler()
+{
+}
+
+ISrsRtspInterleavedHandler::~ISrsRtspInterleavedHandler()
+{
+}
+
+SrsRtspStack::SrsRtspStack(ISrsProtocolReadWriter* s, ISrsRtspInterleavedHandler* h)
 {
     buf = new SrsSimpleStream();
     skt = s;
+    handler = h;
 }
 
 SrsRtspStack::~SrsRtspStack()
@@ -823,6 +1109,10 @@ srs_error_t SrsRtspStack::recv_message(SrsRtspRequest** preq)
 {
     srs_error_t err = srs_success;
     
+    if ((err = recv_interleaved()) != srs_success) {
+        return srs_error_wrap(err, "recv interleaved");
+    }
+    
     SrsRtspRequest* req = new SrsRtspRequest();
     if ((err = do_recv_message(req)) != srs_success) {
         srs_freep(req);
@@ -852,6 +1142,61 @@ srs_error_t SrsRtspStack::send_message(SrsRtspResponse* res)
     return err;
 }
 
+srs_error_t SrsRtspStack::recv_interleaved()
+{
+    srs_error_t err = srs_success;
+    
+    for (;;) {
+        if ((err = require(1)) != srs_success) {
+            return srs_error_wrap(err, "require magic");
+        }
+        
+        // not interleaved, it's a rtsp message.
+        if (buf->bytes()[0] != SRS_RTSP_INTERLEAVED) {
+            return err;
+        }
+        
+        // $ channel(1B) length(2B) data
+        if ((err = require(4)) != srs_success) {
+            return srs_error_wrap(err, "require header");
+        }
+        
+        uint8_t* p = (uint8_t*)buf->bytes();
+        int channel = p[1];
+        int size = (int)(p[2] << 8 | p[3]);
+        
+        if ((err = require(4 + size)) != srs_success) {
+            return srs_error_wrap(err, "require %dB", size);
+        }
+        
+        // consume in place, without copy.
+        if (handler && (err = handler->on_interleaved(channel, buf->bytes() + 4, size)) != srs_success) {
+            return srs_error_wrap(err, "interleaved channel=%d, size=%d", channel, size);
+        }
+        
+        buf->erase(4 + size);
+    }
+    
+    return err;
+}
+
+srs_error_t SrsRtspStack::require(int size)
+{
+    srs_error_t err = srs_success;
+    
+    while (buf->length() < size) {
+        char buffer[SRS_RTSP_BUFFER];
+        ssize_t nb_read = 0;
+        if ((err = skt->read(buffer, SRS_RTSP_BUFFER, &nb_read)) != srs_success) {
+            return srs_error_wrap(err, "recv data");
+        }
+        
+        buf->append(buffer, (int)nb_read);
+    }
+    
+    return err;
+}
+
 srs_error_t SrsRtspStack::do_recv_message(SrsRtspRequest* req)
 {
     srs_error_t err = srs_success;
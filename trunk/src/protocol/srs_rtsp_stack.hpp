@@ -30,6 +30,7 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <srs_kernel_consts.hpp>
 
@@ -45,6 +46,8 @@ class ISrsProtocolReadWriter;
 #define SRS_RTSP_LF SRS_CONSTS_LF // 0x0A
 // SP = <US-ASCII SP, space (32)>
 #define SRS_RTSP_SP ' ' // 0x20
+// The magic of interleaved binary data.
+#define SRS_RTSP_INTERLEAVED '$' // 0x24
 
 // 4 RTSP Message, @see rfc2326-1998-rtsp.pdf, page 37
 // Lines are terminated by CRLF, but
@@ -251,6 +254,8 @@ public:
     // normal message always completed.
     // while chunked completed when the last chunk arriaved.
     bool completed;
+    // Whether it's the first chunk of chunked message.
+    bool first_chunk;
     
     // The audio samples, one rtp packets may contains multiple audio samples.
     SrsAudioFrame* audio;
@@ -258,6 +263,8 @@ public:
     SrsRtpPacket();
     virtual ~SrsRtpPacket();
 public:
+    // Reset the packet to decode another one, reuse the payload and audio.
+    virtual void reset();
     // copy the header from src.
     virtual void copy(SrsRtpPacket* src);
     // reap the src to this packet, reap the payload.
@@ -269,6 +276,89 @@ private:
     virtual srs_error_t decode_96(SrsBuffer* stream);
 };
 
+// The jitter buffer to reorder the rtp packets of a ssrc by sequence number.
+// The packet in order is delivered immediately, while a lost packet is waited at most
+// the latency, then it's skipped and the packets after it are delivered.
+// @remark The packets are reused, user should alloc a packet from the buffer to decode,
+//       and recycle the packet after it's popped.
+class SrsRtpJitterBuffer
+{
+private:
+    // The packets in window [next, next+capacity), indexed by sequence number.
+    std::vector<SrsRtpPacket*> packets;
+    // The free packets to reuse.
+    std::vector<SrsRtpPacket*> pool;
+    srs_utime_t latency;
+    // Whether got the first packet, which starts the sequence.
+    bool started;
+    uint32_t ssrc;
+    // The sequence number of next packet to deliver.
+    uint16_t next;
+    // The max sequence number received.
+    uint16_t highest;
+    // The number of packets in window.
+    int nb_packets;
+    // The time when start to wait for the lost packet, -1 if not waiting.
+    srs_utime_t waiting;
+public:
+    // The number of packets received.
+    int64_t nn_received;
+    // The number of packets never arrived, which are skipped.
+    int64_t nn_lost;
+    // The number of packets arrived out of order, but in time.
+    int64_t nn_reordered;
+    // The number of packets dropped, for example, duplicated or too late.
+    int64_t nn_dropped;
+public:
+    // @param capacity The max number of packets in window, must be power of 2.
+    // @param l The max time to wait for the lost packet.
+    SrsRtpJitterBuffer(int capacity, srs_utime_t l);
+    virtual ~SrsRtpJitterBuffer();
+public:
+    // Alloc a reset packet to decode.
+    virtual SrsRtpPacket* alloc();
+    // Recycle the packet, the buffer will reuse it.
+    virtual void recycle(SrsRtpPacket* pkt);
+    // Push a decoded packet to buffer, which takes the ownership of packet.
+    // @param now The time the packet arrived.
+    virtual void push(SrsRtpPacket* pkt, srs_utime_t now);
+    // Pop the next packet in order, user should recycle it.
+    // @param now The current time, to skip the lost packet when exceed the latency.
+    // @return The packet, or NULL when empty or waiting for the lost packet.
+    virtual SrsRtpPacket* pop(srs_utime_t now);
+    // The number of packets in buffer.
+    virtual int size();
+private:
+    // Drop all packets in buffer, start over by the next packet.
+    virtual void reset();
+};
+
+// The assembler to assemble the chunked rtp packets to a message in a reused buffer,
+// for example, the FU-A fragments of H.264 NALU.
+// @remark The packets must be in order, the message is dropped when any chunk is lost.
+class SrsRtpFrameAssembler
+{
+private:
+    // The message assembled, whose payload is reused.
+    SrsRtpPacket* frame;
+    // Whether assembling a message, that is, got the first chunk.
+    bool assembling;
+    // The sequence number of next chunk.
+    uint16_t next;
+public:
+    // The number of messages dropped, for chunks lost or corrupt.
+    int64_t nn_dropped;
+public:
+    SrsRtpFrameAssembler();
+    virtual ~SrsRtpFrameAssembler();
+public:
+    // Assemble the packet, which is in order.
+    // @return The completed message, which is the pkt itself when not chunked,
+    //       or the assembled frame which is valid util next assemble. NULL when
+    //       the message is not completed.
+    virtual SrsRtpPacket* assemble(SrsRtpPacket* pkt);
+};
+
 // The sdp in announce, @see rfc2326-1998-rtsp.pdf, page 159
 // Appendix C: Use of SDP for RTSP Session Descriptions
 // The Session Description Protocol (SDP, RFC 2327 [6]) may be used to
@@ -373,6 +463,12 @@ public:
     //      [client_port_min, client_port_max)
     int client_port_min;
     int client_port_max;
+    // This parameter implies mixing RTP and RTCP packets onto the
+    // control stream used by RTSP itself, specified as a range, e.g.,
+    //      interleaved=4-5
+    // where -1 if not specified.
+    int interleaved_min;
+    int interleaved_max;
 public:
     SrsRtspTransport();
     virtual ~SrsRtspTransport();
@@ -525,6 +621,9 @@ public:
     //      [local_port_min, local_port_max)
     int local_port_min;
     int local_port_max;
+    // The channels for rtp over rtsp(tcp), -1 for rtp over udp.
+    int interleaved_min;
+    int interleaved_max;
     // The session.
     std::string session;
 public:
@@ -534,6 +633,19 @@ protected:
     virtual srs_error_t encode_header(std::stringstream& ss);
 };
 
+// The handler for the binary data interleaved in rtsp connection, for rtp over tcp.
+// 10.12 Embedded (Interleaved) Binary Data, @see rfc2326-1998-rtsp.pdf, page 40
+class ISrsRtspInterleavedHandler
+{
+public:
+    ISrsRtspInterleavedHandler();
+    virtual ~ISrsRtspInterleavedHandler();
+public:
+    // When got the interleaved data of channel.
+    // @remark The data is only valid in the callback.
+    virtual srs_error_t on_interleaved(int channel, char* data, int size) = 0;
+};
+
 // The rtsp protocol stack to parse the rtsp packets.
 class SrsRtspStack
 {
@@ -542,11 +654,14 @@ private:
     SrsSimpleStream* buf;
     // The underlayer socket object, send/recv bytes.
     ISrsProtocolReadWriter* skt;
+    // The handler for interleaved data, NULL to drop it.
+    ISrsRtspInterleavedHandler* handler;
 public:
-    SrsRtspStack(ISrsProtocolReadWriter* s);
+    SrsRtspStack(ISrsProtocolReadWriter* s, ISrsRtspInterleavedHandler* h = NULL);
     virtual ~SrsRtspStack();
 public:
-    // Recv rtsp message from underlayer io.
+    // Recv rtsp message from underlayer io, the interleaved data before message
+    // is consumed by handler.
     // @param preq the output rtsp request message, which user must free it.
     // @return an int error code.
     //       ERROR_RTSP_REQUEST_HEADER_EOF indicates request header EOF.
@@ -556,6 +671,10 @@ public:
     // @return an int error code.
     virtual srs_error_t send_message(SrsRtspResponse* res);
 private:
+    // Consume the interleaved data util a rtsp message.
+    virtual srs_error_t recv_interleaved();
+    // Read from io util the buffer has size bytes.
+    virtual srs_error_t require(int size);
     // Recv the rtsp message.
     virtual srs_error_t do_recv_message(SrsRtspRequest* req);
     // Read a normal token from io, error when token state is not normal.
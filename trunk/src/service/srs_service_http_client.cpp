@@ -126,6 +126,8 @@ srs_error_t SrsHttpClient::post(string path, string req, ISrsHttpMessage** ppmsg
     
     ISrsHttpMessage* msg = NULL;
     if ((err = parser->parse_message(transport, &msg)) != srs_success) {
+        // Disconnect the transport when channel error, reconnect for next operation.
+        disconnect();
         return srs_error_wrap(err, "http: parse response");
     }
     srs_assert(msg);
@@ -172,6 +174,8 @@ srs_error_t SrsHttpClient::get(string path, string req, ISrsHttpMessage** ppmsg)
     
     ISrsHttpMessage* msg = NULL;
     if ((err = parser->parse_message(transport, &msg)) != srs_success) {
+        // Disconnect the transport when channel error, reconnect for next operation.
+        disconnect();
         return srs_error_wrap(err, "http: parse response");
     }
     srs_assert(msg);
@@ -185,6 +189,11 @@ srs_error_t SrsHttpClient::get(string path, string req, ISrsHttpMessage** ppmsg)
     return err;
 }
 
+bool SrsHttpClient::is_stale()
+{
+    return transport && !transport->is_alive();
+}
+
 void SrsHttpClient::set_recv_timeout(srs_utime_t tm)
 {
     recv_timeout = tm;
@@ -91,6 +91,9 @@ public:
     // @param ppmsg output the http message to read the response.
     // @remark user must free the ppmsg if not NULL.
     virtual srs_error_t get(std::string path, std::string req, ISrsHttpMessage** ppmsg);
+    // Whether the keep-alive connection is closed by server, so user should never reuse it.
+    // @remark Never stale if not connected, because it connects for the next request.
+    virtual bool is_stale();
 private:
     virtual void set_recv_timeout(srs_utime_t tm);
 public:
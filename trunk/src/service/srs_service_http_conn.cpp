@@ -41,6 +41,7 @@ SrsHttpParser::SrsHttpParser()
 {
     buffer = new SrsFastStream();
     header = NULL;
+    type_ = HTTP_REQUEST;
 
     p_body_start = p_header_tail = NULL;
 }
@@ -66,6 +67,7 @@ srs_error_t SrsHttpParser::initialize(enum http_parser_type type, bool allow_jso
     settings.on_body = on_body;
     settings.on_message_complete = on_message_complete;
     
+    type_ = type;
     http_parser_init(&parser, type);
     // callback object ptr.
     parser.data = (void*)this;
@@ -82,10 +84,14 @@ srs_error_t SrsHttpParser::parse_message(ISrsReader* reader, ISrsHttpMessage** p
     // Reset request data.
     state = SrsHttpParseStateInit;
     hp_header = http_parser();
+    // The body is never fed to the parser, so it must restart for each message on a keep-alive connection.
+    http_parser_init(&parser, type_);
+    parser.data = (void*)this;
     // The body that we have read from cache.
     p_body_start = p_header_tail = NULL;
     // We must reset the field name and value, because we may get a partial value in on_header_value.
     field_name = field_value = "";
+    url = "";
     // The header of the request.
     srs_freep(header);
     header = new SrsHttpHeader();
@@ -122,11 +128,16 @@ srs_error_t SrsHttpParser::parse_message_imp(ISrsReader* reader)
 
             // The error is set in http_errno.
             enum http_errno code;
-	        if ((code = HTTP_PARSER_ERRNO(&parser)) != HPE_OK) {
+	        if ((code = HTTP_PARSER_ERRNO(&parser)) != HPE_OK && code != HPE_PAUSED) {
 	            return srs_error_new(ERROR_HTTP_PARSE_HEADER, "parse %dB, nparsed=%d, err=%d/%s %s",
 	                buffer->size(), consumed, code, http_errno_name(code), http_errno_description(code));
 	        }
 
+	        // Paused at the last LF of header, see on_headers_complete, which is also consumed.
+	        if (code == HPE_PAUSED) {
+	            consumed++;
+	        }
+
             // When buffer consumed these bytes, it's dropped so the new ptr is actually the HTTP body. But http-parser
             // doesn't indicate the specific sizeof header, so we must finger it out.
             // @remark We shouldn't use on_body, because it only works for normal case, and losts the chunk header and length.
@@ -192,6 +203,10 @@ int SrsHttpParser::on_headers_complete(http_parser* parser)
 
     srs_info("***HEADERS COMPLETE***");
     
+    // Pause the parser, never parse the body or the next pipelined message in buffer,
+    // which are read by the body reader and the next parse_message.
+    http_parser_pause(parser, 1);
+    
     // see http_parser.c:1570, return 1 to skip body.
     return 0;
 }
@@ -214,8 +229,9 @@ int SrsHttpParser::on_url(http_parser* parser, const char* at, size_t length)
     SrsHttpParser* obj = (SrsHttpParser*)parser->data;
     srs_assert(obj);
     
+    // The url maybe in fragments, when the header is read by multiple times.
     if (length > 0) {
-        obj->url = string(at, (int)length);
+        obj->url.append(at, (int)length);
     }
 
     // When header parsed, we must save the position of start for body,
@@ -708,10 +724,10 @@ srs_error_t SrsHttpResponseWriter::final_request()
     
     // complete the chunked encoding.
     if (content_length == -1) {
-        std::stringstream ss;
-        ss << 0 << SRS_HTTP_CRLF << SRS_HTTP_CRLF;
-        std::string ch = ss.str();
-        return skt->write((void*)ch.data(), (int)ch.length(), NULL);
+        iovec iovs[2];
+        iovs[1].iov_base = (char*)"0" SRS_HTTP_CRLF SRS_HTTP_CRLF;
+        iovs[1].iov_len = 5;
+        return send_iovs(iovs, 2, NULL);
     }
     
     // flush when send with content length
@@ -749,31 +765,34 @@ srs_error_t SrsHttpResponseWriter::write(char* data, int size)
         return srs_error_new(ERROR_HTTP_CONTENT_LENGTH, "overflow writen=%d, max=%d", (int)written, (int)content_length);
     }
     
-    // ignore NULL content.
+    // ignore NULL content, but the header should be sent.
     if (!data || size <= 0) {
-        return err;
+        iovec iovs[1];
+        return send_iovs(iovs, 1, NULL);
     }
     
     // directly send with content length
     if (content_length != -1) {
-        return skt->write((void*)data, size, NULL);
+        iovec iovs[2];
+        iovs[1].iov_base = (char*)data;
+        iovs[1].iov_len = size;
+        return send_iovs(iovs, 2, NULL);
     }
     
     // send in chunked encoding.
     int nb_size = snprintf(header_cache, SRS_HTTP_HEADER_CACHE_SIZE, "%x", size);
     
-    iovec iovs[4];
-    iovs[0].iov_base = (char*)header_cache;
-    iovs[0].iov_len = (int)nb_size;
-    iovs[1].iov_base = (char*)SRS_HTTP_CRLF;
-    iovs[1].iov_len = 2;
-    iovs[2].iov_base = (char*)data;
-    iovs[2].iov_len = size;
-    iovs[3].iov_base = (char*)SRS_HTTP_CRLF;
-    iovs[3].iov_len = 2;
-    
-    ssize_t nwrite;
-    if ((err = skt->writev(iovs, 4, &nwrite)) != srs_success) {
+    iovec iovs[5];
+    iovs[1].iov_base = (char*)header_cache;
+    iovs[1].iov_len = (int)nb_size;
+    iovs[2].iov_base = (char*)SRS_HTTP_CRLF;
+    iovs[2].iov_len = 2;
+    iovs[3].iov_base = (char*)data;
+    iovs[3].iov_len = size;
+    iovs[4].iov_base = (char*)SRS_HTTP_CRLF;
+    iovs[4].iov_len = 2;
+    
+    if ((err = send_iovs(iovs, 5, NULL)) != srs_success) {
         return srs_error_wrap(err, "write chunk");
     }
     
@@ -811,8 +830,8 @@ srs_error_t SrsHttpResponseWriter::writev(const iovec* iov, int iovcnt, ssize_t*
         return srs_error_wrap(err, "send header");
     }
     
-    // send in chunked encoding.
-    int nb_iovss = 3 + iovcnt;
+    // send in chunked encoding, the first iov is reserved for header.
+    int nb_iovss = 4 + iovcnt;
     iovec* iovss = iovss_cache;
     if (nb_iovss_cache < nb_iovss) {
         srs_freepa(iovss_cache);
@@ -830,26 +849,26 @@ srs_error_t SrsHttpResponseWriter::writev(const iovec* iov, int iovcnt, ssize_t*
     
     // chunk header
     int nb_size = snprintf(header_cache, SRS_HTTP_HEADER_CACHE_SIZE, "%x", size);
-    iovss[0].iov_base = (char*)header_cache;
-    iovss[0].iov_len = (int)nb_size;
+    iovss[1].iov_base = (char*)header_cache;
+    iovss[1].iov_len = (int)nb_size;
 
     // chunk header eof.
-    iovss[1].iov_base = (char*)SRS_HTTP_CRLF;
-    iovss[1].iov_len = 2;
+    iovss[2].iov_base = (char*)SRS_HTTP_CRLF;
+    iovss[2].iov_len = 2;
 
     // chunk body.
     for (int i = 0; i < iovcnt; i++) {
-        iovss[2+i].iov_base = (char*)iov[i].iov_base;
-        iovss[2+i].iov_len = (int)iov[i].iov_len;
+        iovss[3+i].iov_base = (char*)iov[i].iov_base;
+        iovss[3+i].iov_len = (int)iov[i].iov_len;
     }
     
     // chunk body eof.
-    iovss[2+iovcnt].iov_base = (char*)SRS_HTTP_CRLF;
-    iovss[2+iovcnt].iov_len = 2;
+    iovss[3+iovcnt].iov_base = (char*)SRS_HTTP_CRLF;
+    iovss[3+iovcnt].iov_len = 2;
 
     // sendout all ioves.
     ssize_t nwrite;
-    if ((err = srs_write_large_iovs(skt, iovss, nb_iovss, &nwrite)) != srs_success) {
+    if ((err = send_iovs(iovss, nb_iovss, &nwrite)) != srs_success) {
         return srs_error_wrap(err, "writev large iovs");
     }
     
@@ -883,12 +902,6 @@ srs_error_t SrsHttpResponseWriter::send_header(char* data, int size)
     }
     header_sent = true;
     
-    std::stringstream ss;
-    
-    // status_line
-    ss << "HTTP/1.1 " << status << " "
-    << srs_generate_http_status_text(status) << SRS_HTTP_CRLF;
-    
     // detect content type
     if (srs_go_http_body_allowd(status)) {
         if (data && hdr->content_type().empty()) {
@@ -914,14 +927,38 @@ srs_error_t SrsHttpResponseWriter::send_header(char* data, int size)
         return srs_error_wrap(err, "filter header");
     }
     
+    // status_line
+    std::string& buf = header_bytes;
+    buf.reserve(SRS_HTTP_HEADER_CACHE_SIZE * 4);
+    buf.append(srs_generate_http_status_line(status));
+    
     // write header
-    hdr->write(ss);
+    hdr->write(buf);
     
     // header_eof
-    ss << SRS_HTTP_CRLF;
+    buf.append(SRS_HTTP_CRLF);
     
-    std::string buf = ss.str();
-    return skt->write((void*)buf.c_str(), buf.length(), NULL);
+    return err;
+}
+
+srs_error_t SrsHttpResponseWriter::send_iovs(iovec* iovs, int nb_iovs, ssize_t* pnwrite)
+{
+    srs_error_t err = srs_success;
+    
+    // Send the header with the body, and never send it again.
+    int start = 1;
+    if (!header_bytes.empty()) {
+        iovs[0].iov_base = (char*)header_bytes.data();
+        iovs[0].iov_len = header_bytes.length();
+        start = 0;
+    }
+    
+    if (nb_iovs > start) {
+        err = srs_write_large_iovs(skt, iovs + start, nb_iovs - start, pnwrite);
+    }
+    header_bytes.clear();
+    
+    return err;
 }
 
 SrsHttpResponseReader::SrsHttpResponseReader(SrsHttpMessage* msg, ISrsReader* reader, SrsFastStream* body)
@@ -1040,7 +1077,9 @@ srs_error_t SrsHttpResponseReader::read_chunked(void* data, size_t nb_data, ssiz
     if (nb_chunk <= 0) {
         // for the last chunk, eof.
         is_eof = true;
-        *nb_read = 0;
+        if (nb_read) {
+            *nb_read = 0;
+        }
     } else {
         // for not the last chunk, there must always exists bytes.
         // left bytes in chunk, read some.
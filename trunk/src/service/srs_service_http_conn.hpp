@@ -44,6 +44,8 @@ class SrsHttpParser
 private:
     http_parser_settings settings;
     http_parser parser;
+    // The type of message to parse, request or response.
+    enum http_parser_type type_;
     // The global parse buffer.
     SrsFastStream* buffer;
     // Whether allow jsonp parse.
@@ -240,6 +242,9 @@ private:
     // (*response).wroteHeader, which tells only whether it was
     // logically written.
     bool header_sent;
+    // The header bytes which is formatted but not sent, which is sent with the body in one writev,
+    // so a small response is sent in one TCP packet.
+    std::string header_bytes;
 public:
     SrsHttpResponseWriter(ISrsProtocolReadWriter* io);
     virtual ~SrsHttpResponseWriter();
@@ -249,7 +254,11 @@ public:
     virtual srs_error_t write(char* data, int size);
     virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite);
     virtual void write_header(int code);
+    // Format the header, which is sent with the body by send_iovs.
     virtual srs_error_t send_header(char* data, int size);
+private:
+    // Send the iovs in one writev, the iovs[0] is reserved for the header if not sent.
+    virtual srs_error_t send_iovs(iovec* iovs, int nb_iovs, ssize_t* pnwrite);
 };
 
 // Response reader use st socket.
@@ -28,13 +28,29 @@
 #include <unistd.h>
 using namespace std;
 
+#include <st.h>
+
 #include <srs_kernel_error.hpp>
 #include <srs_kernel_utility.hpp>
 
 #define SRS_BASIC_LOG_SIZE 1024
 
+// The key of st-thread specific data, a copy of the id in cache for peek_id.
+static int _srs_context_key = -1;
+
+// Set the id to the specific data of current st-thread.
+void srs_context_set_specific(int v)
+{
+    if (_srs_context_key >= 0 && srs_thread_self()) {
+        st_thread_setspecific(_srs_context_key, (void*)(intptr_t)v);
+    }
+}
+
 SrsThreadContext::SrsThreadContext()
 {
+    if (_srs_context_key < 0) {
+        st_key_create(&_srs_context_key, NULL);
+    }
 }
 
 SrsThreadContext::~SrsThreadContext()
@@ -51,6 +67,7 @@ int SrsThreadContext::generate_id()
     
     int gid = id++;
     cache[srs_thread_self()] = gid;
+    srs_context_set_specific(gid);
     return gid;
 }
 
@@ -69,6 +86,7 @@ int SrsThreadContext::set_id(int v)
     }
     
     cache[self] = v;
+    srs_context_set_specific(v);
     
     return ov;
 }
@@ -80,6 +98,15 @@ void SrsThreadContext::clear_cid()
     if (it != cache.end()) {
         cache.erase(it);
     }
+    srs_context_set_specific(0);
+}
+
+int SrsThreadContext::peek_id()
+{
+    if (_srs_context_key < 0 || !srs_thread_self()) {
+        return 0;
+    }
+    return (int)(intptr_t)st_thread_getspecific(_srs_context_key);
 }
 
 // LCOV_EXCL_START
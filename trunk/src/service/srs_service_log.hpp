@@ -46,6 +46,10 @@ public:
     virtual int set_id(int v);
 public:
     virtual void clear_cid();
+public:
+    // Get the id of current st-thread without the cache, which is async-signal-safe, for example, used
+    // by the SIGPROF handler of cpu profiler. Return 0 if no id.
+    static int peek_id();
 };
 
 // The basic console log, which write log to console.
@@ -147,6 +147,11 @@ srs_thread_t srs_thread_self()
     return (srs_thread_t)st_thread_self();
 }
 
+bool srs_thread_stack(char** bottom, char** top)
+{
+    return st_thread_stack(bottom, top) == 0;
+}
+
 srs_error_t srs_tcp_connect(string server, int port, srs_utime_t tm, srs_netfd_t* pstfd)
 {
     st_utime_t timeout = ST_UTIME_NO_TIMEOUT;
@@ -628,6 +633,19 @@ srs_error_t SrsTcpClient::connect()
     return err;
 }
 
+bool SrsTcpClient::is_alive()
+{
+    if (!stfd) {
+        return false;
+    }
+    
+    // The idle connection is alive only when nothing to read, otherwise it's closed(0) or reset(-1),
+    // or it's got unexpected data.
+    char c;
+    ssize_t nn = ::recv(srs_netfd_fileno(stfd), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return nn < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
 void SrsTcpClient::close()
 {
     // Ignore when already closed.
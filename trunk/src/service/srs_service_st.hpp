@@ -57,6 +57,9 @@ extern srs_error_t srs_fd_keepalive(int fd);
 
 // Get current coroutine/thread.
 extern srs_thread_t srs_thread_self();
+// Get the usable stack of current coroutine.
+// @return false for the primordial coroutine, which runs on the stack of main thread.
+extern bool srs_thread_stack(char** bottom, char** top);
 
 // For client, to open socket and connect to server.
 // @param tm The timeout in srs_utime_t.
@@ -180,6 +183,10 @@ public:
     // Connect to server over TCP.
     // @remark We will close the exists connection before do connect.
     virtual srs_error_t connect();
+    // Whether the connection is still usable, that is, the server never closed it and sent nothing,
+    // for example, to check a keep-alive connection before reuse it.
+    // @remark Peek the socket without blocking, so the data is never consumed.
+    virtual bool is_alive();
 private:
     // Close the connection to server.
     // @remark User should never use the client when close it.
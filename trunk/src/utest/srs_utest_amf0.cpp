@@ -2493,6 +2493,129 @@ VOID TEST(ProtocolAMF0Test, Amf0Object2)
     }
 }
 
+VOID TEST(ProtocolAMF0Test, Amf0Cursor)
+{
+    srs_error_t err;
+
+    // Encode by DOM, then read by cursor.
+    SrsAmf0Object* o = SrsAmf0Any::object();
+    SrsAutoFree(SrsAmf0Object, o);
+    o->set("app", SrsAmf0Any::str("live"));
+    o->set("tcUrl", SrsAmf0Any::number(3.0));
+    o->set("fpad", SrsAmf0Any::boolean(false));
+    o->set("args", SrsAmf0Any::object());
+    o->set("data", SrsAmf0Any::ecma_array());
+    o->set("authors", SrsAmf0Any::strict_array());
+    o->set("date", SrsAmf0Any::date(1));
+    o->set("pageUrl", SrsAmf0Any::null());
+    o->set("swfUrl", SrsAmf0Any::undefined());
+    o->set("objectEncoding", SrsAmf0Any::number(3.0));
+    o->get_property("args")->to_object()->set("license", SrsAmf0Any::str("MIT"));
+    o->get_property("authors")->to_strict_array()->append(SrsAmf0Any::str("winlin"));
+
+    int nn = o->total_size();
+    char* b = new char[nn];
+    SrsAutoFreeA(char, b);
+
+    SrsBuffer s(b, nn);
+    HELPER_ASSERT_SUCCESS(o->write(&s));
+
+    if (true) {
+        SrsBuffer s(b, nn);
+        HELPER_EXPECT_SUCCESS(srs_amf0_skip_any(&s));
+        EXPECT_TRUE(s.empty());
+    }
+
+    if (true) {
+        SrsBuffer s(b, nn);
+        HELPER_ASSERT_SUCCESS(srs_amf0_read_object_begin(&s));
+
+        string app;
+        double encoding = 0;
+        int nb_properties = 0;
+        while (true) {
+            string name;
+            bool eof = false;
+            HELPER_ASSERT_SUCCESS(srs_amf0_read_property(&s, name, eof));
+            if (eof) {
+                break;
+            }
+
+            nb_properties++;
+            if (name == "app" && srs_amf0_is_string(&s)) {
+                HELPER_ASSERT_SUCCESS(srs_amf0_read_string(&s, app));
+            } else if (name == "objectEncoding" && srs_amf0_is_number(&s)) {
+                HELPER_ASSERT_SUCCESS(srs_amf0_read_number(&s, encoding));
+            } else {
+                EXPECT_FALSE(name == "tcUrl" && srs_amf0_is_string(&s));
+                HELPER_ASSERT_SUCCESS(srs_amf0_skip_any(&s));
+            }
+        }
+
+        EXPECT_TRUE(s.empty());
+        EXPECT_EQ(10, nb_properties);
+        EXPECT_STREQ("live", app.c_str());
+        EXPECT_EQ(3.0, encoding);
+    }
+
+    // Fail for truncated bytes.
+    for (int i = 0; i < nn; i++) {
+        SrsBuffer s(b, i);
+        HELPER_EXPECT_FAILED(srs_amf0_skip_any(&s));
+    }
+
+    // Fail for not object.
+    if (true) {
+        char b[] = {0x02, 0x00, 0x00};
+        SrsBuffer s(b, sizeof(b));
+        EXPECT_TRUE(srs_amf0_is_string(&s));
+        EXPECT_FALSE(srs_amf0_is_number(&s));
+        EXPECT_FALSE(srs_amf0_is_object(&s));
+        HELPER_EXPECT_FAILED(srs_amf0_read_object_begin(&s));
+    }
+}
+
+VOID TEST(ProtocolAMF0Test, Amf0Writer)
+{
+    srs_error_t err;
+
+    SrsAmf0Object* o = SrsAmf0Any::object();
+    SrsAutoFree(SrsAmf0Object, o);
+    o->set("level", SrsAmf0Any::str("status"));
+    o->set("objectEncoding", SrsAmf0Any::number(3.0));
+    o->set("fpad", SrsAmf0Any::boolean(true));
+    o->set("args", SrsAmf0Any::null());
+    o->set("data", SrsAmf0Any::ecma_array());
+    o->get_property("data")->to_ecma_array()->set("srs_pid", SrsAmf0Any::number(100));
+    SrsAmf0Any* u = SrsAmf0Any::undefined();
+    SrsAutoFree(SrsAmf0Any, u);
+
+    int nn = o->total_size() + u->total_size();
+    char* b = new char[nn];
+    SrsAutoFreeA(char, b);
+
+    SrsBuffer s(b, nn);
+    HELPER_ASSERT_SUCCESS(o->write(&s));
+    HELPER_ASSERT_SUCCESS(u->write(&s));
+
+    SrsAmf0Writer w;
+    w.object_begin()->property("level")->str("status")
+        ->property("objectEncoding")->number(3.0)
+        ->property("fpad")->boolean(true)
+        ->property("args")->null()
+        ->property("data")->ecma_array_begin(0)->property("srs_pid")->number(100)->object_end()
+        ->object_end()->undefined();
+
+    string v = w.bytes();
+    ASSERT_EQ(nn, (int)v.length());
+    EXPECT_TRUE(0 == memcmp(b, v.data(), nn));
+
+    // The raw bytes is written as is.
+    SrsAmf0Writer r;
+    r.raw(v);
+    EXPECT_TRUE(v == r.bytes());
+}
+
 VOID TEST(ProtocolJSONTest, Interfaces)
 {
     if (true) {
@@ -22,6 +22,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #include <srs_utest_app.hpp>
 
+#include <st.h>
+
 using namespace std;
 
 #include <srs_kernel_error.hpp>
@@ -30,6 +32,28 @@ using namespace std;
 #include <srs_app_config.hpp>
 
 #include <srs_app_st.hpp>
+#include <srs_app_http_client.hpp>
+#include <srs_app_http_hooks.hpp>
+#include <srs_app_http_conn.hpp>
+#include <srs_app_listener.hpp>
+#include <srs_app_ingest_pull.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_http_stack.hpp>
+#include <srs_app_source.hpp>
+#include <srs_app_conn.hpp>
+#include <srs_app_shm_stat.hpp>
+#include <srs_app_statistic.hpp>
+#include <srs_app_profiler.hpp>
+#include <srs_service_log.hpp>
+#include <srs_protocol_json.hpp>
+#include <srs_rtmp_stack.hpp>
+#include <srs_protocol_amf0.hpp>
+#include <srs_rtmp_msg_array.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_utest_config.hpp>
+#include <srs_utest_protocol.hpp>
+#include <srs_utest_kernel.hpp>
 
 VOID TEST(AppCoroutineTest, Dummy)
 {
@@ -306,6 +330,79 @@ VOID TEST(AppCoroutineTest, StartThread)
     srs_freep(err);
 }
 
+int mock_st_stack_size = 0;
+void* mock_st_thread_create_stack(void *(*/*start*/)(void *arg), void */*arg*/, int /*joinable*/, int stack_size) {
+    mock_st_stack_size = stack_size;
+    return NULL;
+}
+
+void* mock_st_stack_cycle(void* /*arg*/) {
+    st_usleep(1 * SRS_UTIME_MILLISECONDS);
+    return NULL;
+}
+
+VOID TEST(AppCoroutineTest, StackPool)
+{
+    // The stack size is passed to ST.
+    if (true) {
+        MockCoroutineHandler ch;
+        SrsSTCoroutine sc("test", &ch);
+        sc.set_stack_size(32 * 1024);
+
+        _ST_THREAD_CREATE_PFN ov = _pfn_st_thread_create;
+        _pfn_st_thread_create = (_ST_THREAD_CREATE_PFN)mock_st_thread_create_stack;
+
+        srs_error_t err = sc.start();
+        _pfn_st_thread_create = ov;
+        srs_freep(err);
+
+        EXPECT_EQ(32 * 1024, mock_st_stack_size);
+    }
+
+    // The stack is freed after the joined thread is scheduled to exit.
+    int ov = st_set_stack_pool(2);
+
+    // The freed stack is reused by the same size.
+    if (true) {
+        st_thread_join(st_thread_create(mock_st_stack_cycle, NULL, 1, 32 * 1024), NULL);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+
+        st_stack_stat_t s0;
+        st_stack_stat(&s0);
+        st_thread_join(st_thread_create(mock_st_stack_cycle, NULL, 1, 32 * 1024), NULL);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+
+        st_stack_stat_t s1;
+        st_stack_stat(&s1);
+        EXPECT_EQ(s0.nn_reused + 1, s1.nn_reused);
+        EXPECT_EQ(s0.nn_stacks, s1.nn_stacks);
+        EXPECT_EQ(s0.nn_bytes, s1.nn_bytes);
+    }
+
+    // The free stacks are released when exceed the pool.
+    if (true) {
+        st_stack_stat_t s0;
+        st_stack_stat(&s0);
+
+        st_thread_t trds[5];
+        for (int i = 0; i < 5; i++) {
+            trds[i] = st_thread_create(mock_st_stack_cycle, NULL, 1, 32 * 1024);
+        }
+        for (int i = 0; i < 5; i++) {
+            st_thread_join(trds[i], NULL);
+        }
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+
+        st_stack_stat_t s1;
+        st_stack_stat(&s1);
+        EXPECT_LE(s1.nn_free, 2);
+        EXPECT_LT(s0.nn_unmapped, s1.nn_unmapped);
+        EXPECT_GE(s0.nn_stacks + 2, s1.nn_stacks);
+    }
+
+    st_set_stack_pool(ov);
+}
+
 VOID TEST(AppFragmentTest, CheckDuration)
 {
 	if (true) {
@@ -557,3 +654,1242 @@ VOID TEST(AppSecurity, CheckSecurity)
     //       4. deny if matches deny strategy.
 }
 
+
+VOID TEST(AppHttpClientPool, FetchGiveback)
+{
+    srs_error_t err;
+
+    // Create new client when pool is empty.
+    if (true) {
+        SrsHttpClientPool pool(1, 30 * SRS_UTIME_SECONDS);
+
+        bool reused = true; SrsHttpClient* hc = NULL;
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, &hc, &reused));
+        EXPECT_TRUE(hc != NULL);
+        EXPECT_FALSE(reused);
+        EXPECT_EQ(1, (int)pool.nn_created);
+
+        // Reuse the keep-alive client.
+        pool.giveback("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, hc, true);
+        EXPECT_EQ(1, pool.nn_idle());
+
+        SrsHttpClient* hc2 = NULL;
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, &hc2, &reused));
+        EXPECT_TRUE(hc == hc2);
+        EXPECT_TRUE(reused);
+        EXPECT_EQ(1, (int)pool.nn_reused);
+        EXPECT_EQ(0, pool.nn_idle());
+
+        // Free the client which is not reusable.
+        pool.giveback("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, hc2, false);
+        EXPECT_EQ(0, pool.nn_idle());
+    }
+
+    // Never reuse client of other upstream, and never exceed the max idle.
+    if (true) {
+        SrsHttpClientPool pool(1, 30 * SRS_UTIME_SECONDS);
+
+        bool reused = true; SrsHttpClient* hc0 = NULL; SrsHttpClient* hc1 = NULL; SrsHttpClient* hc2 = NULL;
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, &hc0, &reused));
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, &hc1, &reused));
+        pool.giveback("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, hc0, true);
+        pool.giveback("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, hc1, true);
+        EXPECT_EQ(1, pool.nn_idle());
+
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8086, 3 * SRS_UTIME_SECONDS, &hc2, &reused));
+        EXPECT_FALSE(reused);
+        pool.giveback("127.0.0.1", 8086, 3 * SRS_UTIME_SECONDS, hc2, true);
+        EXPECT_EQ(2, pool.nn_idle());
+    }
+
+    // Drop the expired idle client.
+    if (true) {
+        SrsHttpClientPool pool(1, -1 * SRS_UTIME_SECONDS);
+
+        bool reused = true; SrsHttpClient* hc = NULL;
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, &hc, &reused));
+        pool.giveback("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, hc, true);
+
+        HELPER_EXPECT_SUCCESS(pool.fetch("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, &hc, &reused));
+        EXPECT_FALSE(reused);
+        pool.giveback("127.0.0.1", 8085, 3 * SRS_UTIME_SECONDS, hc, false);
+    }
+}
+
+// The HTTP server to response each request over a keep-alive connection.
+class MockHttpKeepAliveServer : public ISrsTcpHandler
+{
+public:
+    srs_netfd_t fd;
+    // The header and body of responses, the body is sent later, so the client parses the header only.
+    std::vector<std::string> headers;
+    std::vector<std::string> bodies;
+public:
+    MockHttpKeepAliveServer() {
+        fd = NULL;
+    }
+    virtual ~MockHttpKeepAliveServer() {
+        srs_close_stfd(fd);
+    }
+public:
+    virtual srs_error_t on_tcp_client(srs_netfd_t stfd) {
+        srs_error_t err = srs_success;
+
+        fd = stfd;
+
+        SrsStSocket skt;
+        if ((err = skt.initialize(stfd)) != srs_success) {
+            return err;
+        }
+
+        // Response when got the request, which is small enough to read in a time.
+        for (int i = 0; i < (int)headers.size(); i++) {
+            char buf[4096];
+            if ((err = skt.read(buf, sizeof(buf), NULL)) != srs_success) {
+                return err;
+            }
+
+            std::string& header = headers.at(i);
+            if ((err = skt.write((void*)header.data(), header.length(), NULL)) != srs_success) {
+                return err;
+            }
+
+            srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+
+            std::string& body = bodies.at(i);
+            if ((err = skt.write((void*)body.data(), body.length(), NULL)) != srs_success) {
+                return err;
+            }
+        }
+        return err;
+    }
+};
+
+VOID TEST(AppHttpClientPool, ReuseKeepAlive)
+{
+    srs_error_t err;
+
+    MockHttpKeepAliveServer h;
+    h.headers.push_back("HTTP/1.1 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 5\r\n\r\n");
+    h.bodies.push_back("Hello");
+    h.headers.push_back("HTTP/1.1 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 3\r\n\r\n");
+    h.bodies.push_back("SRS");
+
+    SrsTcpListener l(&h, _srs_tmp_host, _srs_tmp_port);
+    HELPER_ASSERT_SUCCESS(l.listen());
+
+    SrsHttpClientPool pool(1, 30 * SRS_UTIME_SECONDS);
+    const char* bodies[] = {"Hello", "SRS"};
+    for (int i = 0; i < 2; i++) {
+        bool reused = false; SrsHttpClient* hc = NULL;
+        HELPER_ASSERT_SUCCESS(pool.fetch(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout, &hc, &reused));
+        EXPECT_EQ(i == 1, reused);
+
+        ISrsHttpMessage* msg = NULL;
+        HELPER_EXPECT_SUCCESS(hc->post("/api/v1/clients", "{}", &msg));
+        if (!msg) {
+            pool.giveback(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout, hc, false);
+            break;
+        }
+
+        std::string body;
+        HELPER_EXPECT_SUCCESS(msg->body_read_all(body));
+        EXPECT_EQ(200, msg->status_code());
+        EXPECT_TRUE(msg->is_keep_alive());
+        EXPECT_STREQ(bodies[i], body.c_str());
+        srs_freep(msg);
+
+        pool.giveback(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout, hc, true);
+    }
+
+    // Both requests are over the same connection.
+    EXPECT_EQ(1, (int)pool.nn_created);
+    EXPECT_EQ(1, (int)pool.nn_reused);
+}
+
+VOID TEST(AppHttpConnTest, DropRequestBody)
+{
+    srs_error_t err;
+
+    // The chunked body is dropped, so the pipelined request is parsed.
+    MockBufferIO io;
+    io.append("POST /live/a.flv HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nHello\r\n0\r\n\r\n"
+        "POST /live/b.flv HTTP/1.1\r\nContent-Length: 5\r\n\r\nWorld"
+        "GET /live/c.flv HTTP/1.1\r\n\r\n");
+
+    SrsHttpParser p;
+    HELPER_ASSERT_SUCCESS(p.initialize(HTTP_REQUEST, false));
+
+    // The connection gets the stack size from config.
+    MockSrsConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF));
+    SrsConfig* oc = _srs_config;
+    _srs_config = &conf;
+
+    if (true) {
+        SrsResponseOnlyHttpConn conn(NULL, NULL, NULL, "");
+
+        const char* paths[] = {"/live/a.flv", "/live/b.flv", "/live/c.flv"};
+        for (int i = 0; i < 3; i++) {
+            ISrsHttpMessage* msg = NULL;
+            HELPER_ASSERT_SUCCESS(p.parse_message(&io, &msg));
+            SrsAutoFree(ISrsHttpMessage, msg);
+            EXPECT_STREQ(paths[i], msg->path().c_str());
+
+            HELPER_EXPECT_SUCCESS(conn.on_got_http_message(msg));
+            EXPECT_TRUE(msg->body_reader()->eof());
+        }
+        EXPECT_EQ(0, io.length());
+    }
+
+    _srs_config = oc;
+}
+
+VOID TEST(AppHttpHooksCache, HitUpdate)
+{
+    if (true) {
+        SrsHttpHooksCache cache(2);
+        EXPECT_FALSE(cache.hit("k0"));
+
+        cache.update("k0", 30 * SRS_UTIME_SECONDS);
+        EXPECT_TRUE(cache.hit("k0"));
+        EXPECT_FALSE(cache.hit("k1"));
+    }
+
+    // Expired entry.
+    if (true) {
+        SrsHttpHooksCache cache(2);
+        cache.update("k0", -1 * SRS_UTIME_SECONDS);
+        EXPECT_FALSE(cache.hit("k0"));
+        EXPECT_EQ(0, cache.size());
+    }
+
+    // Bounded size.
+    if (true) {
+        SrsHttpHooksCache cache(2);
+        cache.update("k0", 30 * SRS_UTIME_SECONDS);
+        cache.update("k1", 30 * SRS_UTIME_SECONDS);
+        cache.update("k2", 30 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(1, cache.size());
+        EXPECT_TRUE(cache.hit("k2"));
+    }
+}
+
+class MockSourceHandler : public ISrsSourceHandler
+{
+public:
+    int nn_retired;
+public:
+    MockSourceHandler() {
+        nn_retired = 0;
+    }
+    virtual ~MockSourceHandler() {
+    }
+public:
+    virtual srs_error_t on_publish(SrsSource* /*s*/, SrsRequest* /*r*/) {
+        return srs_success;
+    }
+    virtual void on_unpublish(SrsSource* /*s*/, SrsRequest* /*r*/) {
+    }
+    virtual void on_retire(SrsSource* /*s*/, SrsRequest* /*r*/) {
+        nn_retired++;
+    }
+};
+
+extern _srs_gettimeofday_t _srs_gettimeofday;
+
+srs_utime_t _mock_source_now = 0;
+int _mock_source_gettimeofday(struct timeval* tv, struct timezone* /*tz*/)
+{
+    tv->tv_sec = (time_t)(_mock_source_now / SRS_UTIME_SECONDS);
+    tv->tv_usec = (suseconds_t)(_mock_source_now % SRS_UTIME_SECONDS);
+    return 0;
+}
+
+// Use the config and mock the system time, restore when done.
+class MockSourceContext
+{
+private:
+    SrsConfig* oc;
+    _srs_gettimeofday_t ot;
+public:
+    MockSourceContext(SrsConfig* c) {
+        oc = _srs_config;
+        _srs_config = c;
+
+        ot = _srs_gettimeofday;
+        _mock_source_now = srs_update_system_time();
+        _srs_gettimeofday = _mock_source_gettimeofday;
+    }
+    virtual ~MockSourceContext() {
+        _srs_config = oc;
+        _srs_gettimeofday = ot;
+        srs_update_system_time();
+    }
+    void tick(srs_utime_t duration) {
+        _mock_source_now += duration;
+        srs_update_system_time();
+    }
+};
+
+VOID TEST(AppSourceTest, RetireIdleSource)
+{
+    srs_error_t err;
+
+    SrsRequest r;
+    r.vhost = "__defaultVhost__";
+    r.app = "live";
+    r.stream = "livestream";
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "source_idle_timeout 10; vhost __defaultVhost__{}"));
+        MockSourceContext ctx(&conf);
+
+        MockSourceHandler h;
+        SrsSourceManager sources;
+
+        SrsSource* s = NULL;
+        HELPER_ASSERT_SUCCESS(sources.fetch_or_create(&r, &h, &s));
+
+        // Never retire the source when serving it.
+        if (true) {
+            SrsSourceRef ref(s);
+            ctx.tick(30 * SRS_UTIME_SECONDS);
+            HELPER_ASSERT_SUCCESS(sources.cycle());
+            EXPECT_TRUE(s == sources.fetch(&r));
+        }
+
+        // Start to count the idle time when connection is done.
+        ctx.tick(5 * SRS_UTIME_SECONDS);
+        HELPER_ASSERT_SUCCESS(sources.cycle());
+        EXPECT_TRUE(s == sources.fetch(&r));
+        EXPECT_EQ(0, h.nn_retired);
+
+        ctx.tick(6 * SRS_UTIME_SECONDS);
+        HELPER_ASSERT_SUCCESS(sources.cycle());
+        EXPECT_TRUE(NULL == sources.fetch(&r));
+        EXPECT_EQ(1, h.nn_retired);
+
+        // Create the source again.
+        HELPER_ASSERT_SUCCESS(sources.fetch_or_create(&r, &h, &s));
+        EXPECT_TRUE(s == sources.fetch(&r));
+        sources.destroy();
+    }
+
+    // Never retire when disabled.
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "source_idle_timeout 0; vhost __defaultVhost__{}"));
+        MockSourceContext ctx(&conf);
+
+        MockSourceHandler h;
+        SrsSourceManager sources;
+
+        SrsSource* s = NULL;
+        HELPER_ASSERT_SUCCESS(sources.fetch_or_create(&r, &h, &s));
+        if (true) {
+            SrsSourceRef ref(s);
+        }
+
+        ctx.tick(3600 * SRS_UTIME_SECONDS);
+        HELPER_ASSERT_SUCCESS(sources.cycle());
+        EXPECT_TRUE(s == sources.fetch(&r));
+        EXPECT_EQ(0, h.nn_retired);
+        sources.destroy();
+    }
+}
+
+SrsSharedPtrMessage* _mock_burst_message(bool video, int64_t timestamp, const char* data, int size)
+{
+    SrsMessageHeader h;
+    if (video) {
+        h.initialize_video(size, (uint32_t)timestamp, 1);
+    } else {
+        h.initialize_audio(size, (uint32_t)timestamp, 1);
+    }
+
+    char* payload = new char[size];
+    memcpy(payload, data, size);
+
+    SrsSharedPtrMessage* msg = new SrsSharedPtrMessage();
+    srs_error_t err = msg->create(&h, payload, size);
+    srs_assert(err == srs_success);
+    return msg;
+}
+
+// Cache the message and free it.
+srs_error_t _mock_burst_cache(SrsGopCache* gop, SrsSharedPtrMessage* msg)
+{
+    srs_error_t err = gop->cache(msg);
+    srs_freep(msg);
+    return err;
+}
+
+// Send the caches by consumer, which is the bytes expected for the burst.
+string _mock_burst_expect(SrsSource* s, SrsMetaCache* meta, SrsGopCache* gop, SrsBurstFormat format, int64_t& time)
+{
+    srs_error_t err;
+
+    SrsConsumer consumer(s, NULL);
+    consumer.set_queue_size(30 * SRS_UTIME_SECONDS);
+    HELPER_EXPECT_SUCCESS(meta->dumps(&consumer, false, SrsRtmpJitterAlgorithmFULL, true, true));
+    HELPER_EXPECT_SUCCESS(gop->dump(&consumer, false, SrsRtmpJitterAlgorithmFULL));
+    time = consumer.get_time();
+
+    MockBufferIO io;
+    SrsProtocol p(&io);
+
+    MockSrsFileWriter fw;
+    SrsFlvTransmuxer enc;
+    HELPER_EXPECT_SUCCESS(enc.initialize(&fw));
+
+    SrsMessageArray msgs(SRS_PERF_MW_MSGS);
+    while (true) {
+        int count = 0;
+        HELPER_EXPECT_SUCCESS(consumer.dump_packets(&msgs, count));
+        if (count <= 0) {
+            break;
+        }
+
+        if (format == SrsBurstFormatRtmp) {
+            HELPER_EXPECT_SUCCESS(p.send_and_free_messages(msgs.msgs, count, 1));
+            continue;
+        }
+
+        HELPER_EXPECT_SUCCESS(enc.write_tags(msgs.msgs, count));
+        for (int i = 0; i < count; i++) {
+            srs_freep(msgs.msgs[i]);
+        }
+    }
+
+    if (format == SrsBurstFormatRtmp) {
+        return string(io.out_buffer.bytes(), io.out_buffer.length());
+    }
+    return fw.str();
+}
+
+// Send the caches in a burst.
+string _mock_burst_send(SrsSource* s, SrsBurstCache* cache, SrsMetaCache* meta, SrsGopCache* gop, SrsBurstFormat format, int64_t& time)
+{
+    srs_error_t err;
+
+    SrsConsumer consumer(s, NULL);
+    std::vector<SrsSharedPtrMessage*> burst;
+    HELPER_EXPECT_SUCCESS(cache->dumps(meta, gop, SrsRtmpJitterAlgorithmFULL, 1, 128, &consumer, burst));
+    time = consumer.get_time();
+    if (burst.empty()) {
+        return "";
+    }
+
+    if (format == SrsBurstFormatRtmp) {
+        MockBufferIO io;
+        SrsProtocol p(&io);
+        HELPER_EXPECT_SUCCESS(p.send_and_free_chunks(&burst[0], (int)burst.size()));
+        return string(io.out_buffer.bytes(), io.out_buffer.length());
+    }
+
+    MockSrsFileWriter fw;
+    SrsFlvTransmuxer enc;
+    HELPER_EXPECT_SUCCESS(enc.initialize(&fw));
+    HELPER_EXPECT_SUCCESS(enc.write_encoded_tags(&burst[0], (int)burst.size()));
+    for (int i = 0; i < (int)burst.size(); i++) {
+        srs_freep(burst[i]);
+    }
+    return fw.str();
+}
+
+VOID TEST(AppSourceTest, BurstCache)
+{
+    srs_error_t err;
+
+    MockSrsConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost __defaultVhost__{}"));
+    MockSourceContext ctx(&conf);
+
+    // The AVC sequence header.
+    uint8_t sh[] = {
+        0x17, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x64, 0x00, 0x20, 0xff, 0xe1, 0x00, 0x19, 0x67, 0x64, 0x00, 0x20,
+        0xac, 0xd9, 0x40, 0xc0, 0x29, 0xb0, 0x11, 0x00, 0x00, 0x03, 0x00, 0x01,
+        0x00, 0x00, 0x03, 0x00, 0x32, 0x0f, 0x18, 0x31, 0x96, 0x01, 0x00, 0x05,
+        0x68, 0xeb, 0xec, 0xb2, 0x2c
+    };
+
+    // The video frames, larger than the chunk size.
+    char idr[500], frame[300];
+    memset(idr, 0x41, sizeof(idr));
+    memcpy(idr, "\x17\x01\x00\x00\x00", 5);
+    memset(frame, 0x42, sizeof(frame));
+    memcpy(frame, "\x27\x01\x00\x00\x00", 5);
+
+    SrsBurstFormat formats[] = {SrsBurstFormatRtmp, SrsBurstFormatFlv};
+    for (int i = 0; i < 2; i++) {
+        SrsBurstFormat format = formats[i];
+
+        SrsSource s;
+        SrsMetaCache meta;
+        SrsGopCache gop;
+        SrsBurstCache cache(format);
+
+        SrsSharedPtrMessage* msg = _mock_burst_message(false, 1000, "\xaf\x00\x12\x10", 4);
+        HELPER_EXPECT_SUCCESS(meta.update_ash(msg));
+        srs_freep(msg);
+
+        msg = _mock_burst_message(true, 1000, (char*)sh, sizeof(sh));
+        HELPER_EXPECT_SUCCESS(meta.update_vsh(msg));
+        srs_freep(msg);
+
+        HELPER_EXPECT_SUCCESS(_mock_burst_cache(&gop, _mock_burst_message(true, 1000, idr, sizeof(idr))));
+        HELPER_EXPECT_SUCCESS(_mock_burst_cache(&gop, _mock_burst_message(false, 1020, "\xaf\x01\x21\x10", 4)));
+        HELPER_EXPECT_SUCCESS(_mock_burst_cache(&gop, _mock_burst_message(true, 1040, frame, sizeof(frame))));
+
+        // The burst is same to the messages sent by consumer, and the consumer continues the timestamp.
+        int64_t expect_time = 0, time = 0;
+        string expect = _mock_burst_expect(&s, &meta, &gop, format, expect_time);
+        EXPECT_FALSE(expect.empty());
+        EXPECT_TRUE(expect == _mock_burst_send(&s, &cache, &meta, &gop, format, time));
+        EXPECT_EQ(expect_time, time);
+        EXPECT_EQ(5, cache.size());
+
+        // Only encode the appended messages of gop.
+        HELPER_EXPECT_SUCCESS(_mock_burst_cache(&gop, _mock_burst_message(true, 1080, frame, sizeof(frame))));
+        expect = _mock_burst_expect(&s, &meta, &gop, format, expect_time);
+        EXPECT_TRUE(expect == _mock_burst_send(&s, &cache, &meta, &gop, format, time));
+        EXPECT_EQ(expect_time, time);
+        EXPECT_EQ(6, cache.size());
+
+        // Reset when got a new gop.
+        HELPER_EXPECT_SUCCESS(_mock_burst_cache(&gop, _mock_burst_message(true, 1100, idr, sizeof(idr))));
+        expect = _mock_burst_expect(&s, &meta, &gop, format, expect_time);
+        EXPECT_TRUE(expect == _mock_burst_send(&s, &cache, &meta, &gop, format, time));
+        EXPECT_EQ(expect_time, time);
+        EXPECT_EQ(3, cache.size());
+
+        // Reset when sequence header changed.
+        msg = _mock_burst_message(false, 1120, "\xaf\x00\x11\x90", 4);
+        HELPER_EXPECT_SUCCESS(meta.update_ash(msg));
+        srs_freep(msg);
+        expect = _mock_burst_expect(&s, &meta, &gop, format, expect_time);
+        EXPECT_TRUE(expect == _mock_burst_send(&s, &cache, &meta, &gop, format, time));
+        EXPECT_EQ(3, cache.size());
+    }
+}
+
+VOID TEST(AppSourceTest, AbrSplice)
+{
+    srs_error_t err;
+
+    MockSrsConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost __defaultVhost__{}"));
+    MockSourceContext ctx(&conf);
+
+    char sh[] = "\x17\x00\x00\x00\x00\x01";
+    char idr[] = "\x17\x01\x00\x00\x00\x41";
+    char frame[] = "\x27\x01\x00\x00\x00\x42";
+
+    SrsSource current, rendition;
+    SrsConsumer* consumer = new SrsConsumer(&current, NULL);
+    SrsAutoFree(SrsConsumer, consumer);
+    consumer->set_queue_size(10 * SRS_UTIME_SECONDS);
+    current.consumers.push_back(consumer);
+
+    SrsConsumer* pending = new SrsConsumer(&rendition, NULL);
+    pending->set_queue_size(10 * SRS_UTIME_SECONDS);
+    rendition.consumers.push_back(pending);
+
+    // The current rendition is playing.
+    int64_t times[] = {0, 0, 40, 80};
+    char* payloads[] = {sh, idr, frame, frame};
+    for (int i = 0; i < 4; i++) {
+        SrsSharedPtrMessage* msg = _mock_burst_message(true, times[i], payloads[i], 6);
+        HELPER_EXPECT_SUCCESS(consumer->enqueue(msg, false, SrsRtmpJitterAlgorithmFULL));
+        srs_freep(msg);
+    }
+    EXPECT_EQ(80, consumer->get_time());
+
+    // The rendition continues the timestamp, and the keyframe is after the current messages.
+    pending->follow(consumer);
+    int64_t ptimes[] = {90, 100, 120, 160};
+    char* ppayloads[] = {sh, frame, idr, frame};
+    for (int i = 0; i < 4; i++) {
+        SrsSharedPtrMessage* msg = _mock_burst_message(true, ptimes[i], ppayloads[i], 6);
+        HELPER_EXPECT_SUCCESS(pending->enqueue(msg, false, SrsRtmpJitterAlgorithmFULL));
+        srs_freep(msg);
+    }
+    EXPECT_EQ(-1, pending->find_keyframe(120));
+    EXPECT_EQ(120, pending->find_keyframe(consumer->get_time()));
+
+    // The messages of current rendition after the keyframe are dropped.
+    consumer->set_cut_time(120);
+    if (true) {
+        SrsSharedPtrMessage* msg = _mock_burst_message(true, 120, idr, 6);
+        HELPER_EXPECT_SUCCESS(consumer->enqueue(msg, false, SrsRtmpJitterAlgorithmFULL));
+        srs_freep(msg);
+    }
+    EXPECT_EQ(4, consumer->queue->size());
+
+    // Start from the keyframe of rendition, with the sequence header before it.
+    HELPER_EXPECT_SUCCESS(consumer->splice(pending, 120));
+    EXPECT_EQ(0, pending->queue->size());
+    EXPECT_EQ(7, consumer->queue->size());
+    EXPECT_EQ(160, consumer->get_time());
+
+    consumer->switch_source(&rendition);
+    srs_freep(pending);
+    EXPECT_EQ(0, (int)current.consumers.size());
+    EXPECT_EQ(1, (int)rendition.consumers.size());
+
+    SrsMessageArray msgs(10);
+    int count = 0;
+    HELPER_EXPECT_SUCCESS(consumer->dump_packets(&msgs, count));
+    ASSERT_EQ(7, count);
+
+    int64_t expect_times[] = {0, 0, 40, 80, 120, 120, 160};
+    char* expect_payloads[] = {sh, idr, frame, frame, sh, idr, frame};
+    for (int i = 0; i < count; i++) {
+        SrsSharedPtrMessage* msg = msgs.msgs[i];
+        EXPECT_EQ(expect_times[i], msg->timestamp);
+        EXPECT_EQ(0, memcmp(expect_payloads[i], msg->payload, 6));
+        srs_freep(msg);
+    }
+}
+
+VOID TEST(AppSourceTest, FrameDrop)
+{
+    // The AVC frames with one NALU, whose header and slice header are the last two bytes.
+    char sh[] = "\x17\x00\x00\x00\x00\x01\x64\x00\x20\xff";
+    char idr[] = "\x17\x01\x00\x00\x00\x00\x00\x00\x02\x65\x88";
+    char pref[] = "\x27\x01\x00\x00\x00\x00\x00\x00\x02\x41\xc0";
+    char pnonref[] = "\x27\x01\x00\x00\x00\x00\x00\x00\x02\x01\xc0";
+    char bref[] = "\x27\x01\x00\x00\x00\x00\x00\x00\x02\x21\xa0";
+    char bnonref[] = "\x27\x01\x00\x00\x00\x00\x00\x00\x02\x01\xa0";
+    char audio[] = "\xaf\x01\x00\x00";
+
+    if (true) {
+        SrsFrameDropper d;
+        d.update(8 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelNone, d.current());
+
+        d.set_enabled(true);
+        d.update(2 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelNone, d.current());
+        d.update(3 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelBFrame, d.current());
+        d.update(5 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelNonRef, d.current());
+        d.update(8 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelGop, d.current());
+        d.update(20 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelGop, d.current());
+
+        // Raise a step when socket is congested.
+        d.set_occupancy(90);
+        d.update(3 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelNonRef, d.current());
+        d.update(0, 10 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(SrsDropLevelBFrame, d.current());
+    }
+
+    if (true) {
+        SrsFrameDropper d;
+        d.set_enabled(true);
+
+        SrsSharedPtrMessage* msgs[] = {
+            _mock_burst_message(true, 0, sh, sizeof(sh) - 1), _mock_burst_message(true, 0, idr, sizeof(idr) - 1),
+            _mock_burst_message(true, 40, pref, sizeof(pref) - 1), _mock_burst_message(true, 80, pnonref, sizeof(pnonref) - 1),
+            _mock_burst_message(true, 120, bref, sizeof(bref) - 1), _mock_burst_message(true, 160, bnonref, sizeof(bnonref) - 1),
+            _mock_burst_message(false, 160, audio, sizeof(audio) - 1),
+        };
+        // Nothing dropped without congestion.
+        for (int i = 0; i < 7; i++) {
+            EXPECT_FALSE(d.drop(msgs[i]));
+        }
+
+        // Only drop the B-frames which are never referenced.
+        d.update(3 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        bool expect_bframe[] = {false, false, false, false, false, true, false};
+        for (int i = 0; i < 7; i++) {
+            EXPECT_EQ(expect_bframe[i], d.drop(msgs[i]));
+        }
+        EXPECT_EQ(1, d.nn_bframes);
+
+        // Drop all non-reference frames.
+        d.update(5 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        bool expect_nonref[] = {false, false, false, true, false, true, false};
+        for (int i = 0; i < 7; i++) {
+            EXPECT_EQ(expect_nonref[i], d.drop(msgs[i]));
+        }
+        EXPECT_EQ(2, d.nn_bframes);
+        EXPECT_EQ(1, d.nn_nonrefs);
+
+        // Drop the video util the next keyframe, even when the congestion is gone.
+        d.update(8 * SRS_UTIME_SECONDS, 10 * SRS_UTIME_SECONDS);
+        EXPECT_TRUE(d.drop(msgs[2]));
+        EXPECT_FALSE(d.drop(msgs[0]));
+        EXPECT_FALSE(d.drop(msgs[6]));
+        d.update(0, 10 * SRS_UTIME_SECONDS);
+        EXPECT_TRUE(d.drop(msgs[4]));
+        EXPECT_FALSE(d.drop(msgs[6]));
+        EXPECT_FALSE(d.drop(msgs[1]));
+        EXPECT_FALSE(d.drop(msgs[2]));
+        EXPECT_EQ(2, d.nn_gop_frames);
+
+        for (int i = 0; i < 7; i++) {
+            srs_freep(msgs[i]);
+        }
+    }
+}
+
+VOID TEST(AppSourceTest, MetadataPassthrough)
+{
+    srs_error_t err;
+
+    SrsMetaCache meta;
+    bool updated = false;
+
+    // The metadata from encoder, which is modified and encoded again.
+    SrsCommonMessage msg;
+    if (true) {
+        SrsOnMetaDataPacket* pkt = new SrsOnMetaDataPacket();
+        SrsAutoFree(SrsOnMetaDataPacket, pkt);
+        pkt->metadata->set("width", SrsAmf0Any::number(768));
+        pkt->metadata->set("duration", SrsAmf0Any::number(0));
+        HELPER_ASSERT_SUCCESS(pkt->to_msg(&msg, 1));
+    }
+
+    if (true) {
+        SrsOnMetaDataPacket pkt;
+        SrsBuffer b(msg.payload, msg.size);
+        HELPER_ASSERT_SUCCESS(pkt.decode(&b));
+        HELPER_ASSERT_SUCCESS(meta.update_data(&msg, &pkt, updated));
+        EXPECT_TRUE(updated);
+
+        ASSERT_TRUE(meta.data() != NULL);
+        EXPECT_TRUE(msg.size != meta.data()->size);
+        EXPECT_TRUE(NULL == pkt.metadata->get_property("duration"));
+        EXPECT_TRUE(NULL != pkt.metadata->get_property("server"));
+    }
+
+    // The metadata from SRS origin, which is already modified, so use the payload.
+    SrsCommonMessage origin;
+    origin.header = msg.header;
+    origin.create_payload(meta.data()->size);
+    origin.size = meta.data()->size;
+    memcpy(origin.payload, meta.data()->payload, origin.size);
+
+    if (true) {
+        SrsOnMetaDataPacket pkt;
+        SrsBuffer b(origin.payload, origin.size);
+        HELPER_ASSERT_SUCCESS(pkt.decode(&b));
+        HELPER_ASSERT_SUCCESS(meta.update_data(&origin, &pkt, updated));
+        EXPECT_TRUE(updated);
+
+        ASSERT_TRUE(meta.data() != NULL);
+        ASSERT_EQ(origin.size, meta.data()->size);
+        EXPECT_TRUE(origin.payload != meta.data()->payload);
+        EXPECT_TRUE(0 == memcmp(origin.payload, meta.data()->payload, origin.size));
+    }
+}
+
+VOID TEST(AppConnTest, TcpBandwidth)
+{
+    if (true) {
+        SrsTcpInfo info;
+        EXPECT_EQ(0, (int)info.bandwidth());
+    }
+
+    // The BDP is 10*1000 bytes in 100ms.
+    if (true) {
+        SrsTcpInfo info;
+        info.cwnd = 10;
+        info.mss = 1000;
+        info.rtt = 100 * SRS_UTIME_MILLISECONDS;
+        EXPECT_EQ(100000, (int)info.bandwidth());
+
+        // Use the delivery rate when larger.
+        info.delivery_rate = 200000;
+        EXPECT_EQ(200000, (int)info.bandwidth());
+
+        // Use the cwnd/rtt when app-limited.
+        info.delivery_rate = 50000;
+        EXPECT_EQ(100000, (int)info.bandwidth());
+    }
+}
+
+// Find the stream by name, return the index of slot, or -1 if not found.
+int mock_shm_stat_find(SrsShmStatistic* shm, string stream, SrsShmStatStream* copy)
+{
+    SrsShmStatServer s;
+    if (!srs_shm_stat_read(shm->server(), &s, sizeof(SrsShmStatServer))) {
+        return -1;
+    }
+    
+    for (int i = 0; i < s.nb_stream_slots; i++) {
+        if (!srs_shm_stat_read(shm->stream_at(i), copy, sizeof(SrsShmStatStream)) || !copy->used) {
+            continue;
+        }
+        if (stream == copy->stream) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+VOID TEST(AppStatisticTest, SharedMemory)
+{
+    srs_error_t err;
+
+    string path = "/tmp/srs-utest-shm.stat";
+    SrsStatistic* stat = SrsStatistic::instance();
+
+    SrsShmStatistic* w = new SrsShmStatistic();
+    HELPER_ASSERT_SUCCESS(w->initialize(path, stat->server_id()));
+
+    SrsShmStatistic r;
+    HELPER_ASSERT_SUCCESS(r.open(path));
+    EXPECT_EQ(SRS_SHM_STAT_MAGIC, (int)r.header()->magic);
+    EXPECT_EQ(stat->server_id(), r.header()->server_id);
+    EXPECT_EQ(SRS_SHM_STAT_MAX_STREAMS, (int)r.header()->max_streams);
+    EXPECT_TRUE(r.vhost_at(SRS_SHM_STAT_MAX_VHOSTS) == NULL);
+    EXPECT_TRUE(r.stream_at(SRS_SHM_STAT_MAX_STREAMS) == NULL);
+
+    SrsRequest req;
+    req.vhost = "shm.ossrs.net"; req.app = "live"; req.stream = "shm-livestream";
+
+    // Publish a stream, which is visible by reader.
+    if (true) {
+        stat->on_stream_publish(&req, 100);
+        HELPER_EXPECT_SUCCESS(stat->on_video_info(&req, SrsVideoCodecIdAVC, SrsAvcProfileHigh, SrsAvcLevel_31, 1280, 720));
+        HELPER_EXPECT_SUCCESS(stat->on_video_frames(&req, 10));
+        stat->dumps_shm(w);
+
+        SrsShmStatServer s;
+        EXPECT_TRUE(srs_shm_stat_read(r.server(), &s, sizeof(SrsShmStatServer)));
+        EXPECT_EQ(0, (int)(s.seq & 0x01));
+        EXPECT_GT(s.nb_streams, 0);
+
+        SrsShmStatStream v;
+        ASSERT_TRUE(mock_shm_stat_find(&r, "shm-livestream", &v) >= 0);
+        EXPECT_STREQ("live", v.app);
+        EXPECT_EQ(1, v.active);
+        EXPECT_EQ(100, v.cid);
+        EXPECT_EQ(10, v.nb_frames);
+        EXPECT_EQ(1, v.has_video);
+        EXPECT_EQ(SrsVideoCodecIdAVC, v.vcodec);
+        EXPECT_EQ(1280, v.width);
+        EXPECT_EQ(720, v.height);
+        EXPECT_EQ(0, v.has_audio);
+    }
+
+    // The reader never gets a slot which is being updated.
+    if (true) {
+        SrsShmStatServer s;
+        srs_shm_stat_write_begin(&w->server()->seq);
+        EXPECT_FALSE(srs_shm_stat_read(r.server(), &s, sizeof(SrsShmStatServer)));
+        srs_shm_stat_write_end(&w->server()->seq);
+        EXPECT_TRUE(srs_shm_stat_read(r.server(), &s, sizeof(SrsShmStatServer)));
+    }
+
+    // Close the stream, which is removed from segment.
+    if (true) {
+        stat->on_stream_close(&req);
+        stat->dumps_shm(w);
+
+        SrsShmStatStream v;
+        EXPECT_EQ(-1, mock_shm_stat_find(&r, "shm-livestream", &v));
+    }
+
+    // Each stream keeps its slot, and the slot of closed stream is reused.
+    if (true) {
+        SrsRequest r0, r1, r2, r3;
+        r0.vhost = r1.vhost = r2.vhost = r3.vhost = "shm.ossrs.net";
+        r0.app = r1.app = r2.app = r3.app = "live";
+        r0.stream = "shm-s0"; r1.stream = "shm-s1"; r2.stream = "shm-s2"; r3.stream = "shm-s3";
+
+        stat->on_stream_publish(&r0, 100);
+        stat->on_stream_publish(&r1, 101);
+        stat->dumps_shm(w);
+
+        SrsShmStatStream v;
+        int s0 = mock_shm_stat_find(&r, "shm-s0", &v);
+        int s1 = mock_shm_stat_find(&r, "shm-s1", &v);
+        ASSERT_TRUE(s0 >= 0 && s1 >= 0 && s0 != s1);
+
+        // The slot of s0 is freed after s2 got its slot.
+        stat->on_stream_close(&r0);
+        stat->on_stream_publish(&r2, 102);
+        stat->dumps_shm(w);
+        EXPECT_EQ(-1, mock_shm_stat_find(&r, "shm-s0", &v));
+        EXPECT_EQ(s1, mock_shm_stat_find(&r, "shm-s1", &v));
+        int s2 = mock_shm_stat_find(&r, "shm-s2", &v);
+        EXPECT_TRUE(s2 >= 0 && s2 != s0 && s2 != s1);
+
+        stat->on_stream_publish(&r3, 103);
+        stat->dumps_shm(w);
+        EXPECT_EQ(s0, mock_shm_stat_find(&r, "shm-s3", &v));
+        EXPECT_EQ(s1, mock_shm_stat_find(&r, "shm-s1", &v));
+        EXPECT_EQ(s2, mock_shm_stat_find(&r, "shm-s2", &v));
+
+        stat->on_stream_close(&r1);
+        stat->on_stream_close(&r2);
+        stat->on_stream_close(&r3);
+    }
+
+    // The segment is removed by writer, so new reader fails.
+    srs_freep(w);
+    if (true) {
+        SrsShmStatistic r2;
+        HELPER_EXPECT_FAILED(r2.open(path));
+    }
+}
+
+VOID TEST(AppStatisticTest, LatencyHistogram)
+{
+    SrsLatencyHistogram h;
+    EXPECT_EQ(0, (int)h.count());
+    EXPECT_EQ(0, h.percentile(50));
+
+    // The small values are exact.
+    for (int i = 0; i < 8; i++) {
+        h.update(i);
+    }
+    EXPECT_EQ(8, (int)h.count());
+    EXPECT_EQ(3, h.percentile(50));
+    EXPECT_EQ(7, h.percentile(100));
+    EXPECT_EQ(7, h.maximum());
+
+    // The large values are in the relative error.
+    if (true) {
+        SrsLatencyHistogram h;
+        for (int i = 1; i <= 1000; i++) {
+            h.update(i * SRS_UTIME_MILLISECONDS);
+        }
+        EXPECT_EQ(1000, (int)h.count());
+        EXPECT_EQ(500500, (int)h.average());
+        EXPECT_EQ(1000 * SRS_UTIME_MILLISECONDS, h.maximum());
+
+        srs_utime_t p50 = h.percentile(50);
+        EXPECT_GE(p50, 500 * SRS_UTIME_MILLISECONDS);
+        EXPECT_LE(p50, 500 * SRS_UTIME_MILLISECONDS * 9 / 8);
+
+        srs_utime_t p99 = h.percentile(99);
+        EXPECT_GE(p99, 990 * SRS_UTIME_MILLISECONDS);
+        EXPECT_LE(p99, 1000 * SRS_UTIME_MILLISECONDS);
+    }
+
+    // Never overflow for the huge or negative values.
+    if (true) {
+        SrsLatencyHistogram h;
+        h.update(-1);
+        h.update(100 * 3600 * SRS_UTIME_SECONDS);
+        EXPECT_EQ(2, (int)h.count());
+        EXPECT_EQ(0, h.percentile(50));
+        EXPECT_EQ(100 * 3600 * SRS_UTIME_SECONDS, h.percentile(100));
+    }
+}
+
+VOID TEST(AppStatisticTest, LatencyTrace)
+{
+    srs_error_t err;
+
+    SrsStatistic* stat = SrsStatistic::instance();
+
+    SrsRequest req;
+    req.vhost = "latency.ossrs.net"; req.app = "live"; req.stream = "latency-livestream";
+
+    int publisher = 10049, player = 10050;
+    HELPER_ASSERT_SUCCESS(stat->on_client(publisher, &req, NULL, SrsRtmpConnFMLEPublish));
+    HELPER_ASSERT_SUCCESS(stat->on_client(player, &req, NULL, SrsRtmpConnPlay));
+
+    SrsStatisticClient* client = stat->find_client(player);
+    ASSERT_TRUE(client != NULL);
+    SrsStatisticStream* stream = client->stream;
+
+    // The message without ingest time is never traced.
+    if (true) {
+        SrsCommonMessage m;
+        m.header.initialize_video(1, 0, 1);
+        m.create_payload(1);
+        SrsSharedPtrMessage msg;
+        HELPER_ASSERT_SUCCESS(msg.create(&m));
+        EXPECT_EQ(0, msg.ingest_time());
+
+        SrsSharedPtrMessage* msgs[] = {&msg};
+        SrsLatencyTracer tracer(player);
+        tracer.on_dump(msgs, 1);
+        tracer.on_sent();
+        EXPECT_TRUE(stream->latency == NULL);
+        EXPECT_EQ(-1, client->send_lag);
+    }
+
+    // The ingest time is shared by copies, while the enqueue time is for each copy.
+    if (true) {
+        srs_utime_t now = srs_update_system_time();
+
+        SrsCommonMessage m;
+        m.header.initialize_video(1, 0, 1);
+        m.create_payload(1);
+        m.ingest_time = now - 30 * SRS_UTIME_MILLISECONDS;
+        SrsSharedPtrMessage msg;
+        HELPER_ASSERT_SUCCESS(msg.create(&m));
+
+        SrsSharedPtrMessage* copy = msg.copy();
+        SrsAutoFree(SrsSharedPtrMessage, copy);
+        EXPECT_EQ(m.ingest_time, copy->ingest_time());
+        EXPECT_EQ(0, copy->enqueue_time);
+        copy->enqueue_time = now - 10 * SRS_UTIME_MILLISECONDS;
+
+        srs_utime_t v = 5 * SRS_UTIME_MILLISECONDS;
+        stat->on_latency(publisher, SrsLatencyStageIngest, &v, 1);
+
+        SrsSharedPtrMessage* msgs[] = {copy};
+        SrsLatencyTracer tracer(player);
+        tracer.on_dump(msgs, 1);
+        tracer.on_sent();
+
+        ASSERT_TRUE(stream->latency != NULL);
+        ASSERT_TRUE(stream->vhost->latency != NULL);
+        EXPECT_EQ(1, (int)stream->latency->stages[SrsLatencyStageIngest].count());
+        EXPECT_EQ(0, (int)stream->latency->stages[SrsLatencyStageHub].count());
+        EXPECT_EQ(1, (int)stream->latency->stages[SrsLatencyStageQueue].count());
+        EXPECT_EQ(1, (int)stream->latency->stages[SrsLatencyStageSend].count());
+        EXPECT_EQ(1, (int)stream->latency->stages[SrsLatencyStageTotal].count());
+        EXPECT_GE(stream->latency->stages[SrsLatencyStageQueue].maximum(), 10 * SRS_UTIME_MILLISECONDS);
+        EXPECT_GE(client->send_lag, 30 * SRS_UTIME_MILLISECONDS);
+
+        SrsJsonObject* obj = SrsJsonAny::object();
+        SrsAutoFree(SrsJsonObject, obj);
+        HELPER_EXPECT_SUCCESS(stream->dumps(obj));
+        EXPECT_TRUE(obj->get_property("latency") != NULL);
+    }
+
+    stat->on_disconnect(player);
+    stat->on_disconnect(publisher);
+}
+
+VOID TEST(AppIngestPullTest, ParsePlaylist)
+{
+    srs_error_t err;
+
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_SUCCESS(pl.parse("http://127.0.0.1:8080/live/livestream.m3u8?token=xxx",
+            "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-MEDIA-SEQUENCE:100\n#EXT-X-TARGETDURATION:10\n"
+            "#EXTINF:9.5, no desc\r\nlivestream-100.ts\r\n"
+            "#EXTINF:10.0,\n/hls/livestream-101.ts?token=xxx\n"
+            "#EXT-X-DISCONTINUITY\n#EXTINF:8.0,\nhttp://cdn.com/livestream-102.ts\n"));
+
+        EXPECT_EQ(10 * SRS_UTIME_SECONDS, pl.target_duration);
+        EXPECT_EQ(100, pl.media_sequence);
+        EXPECT_FALSE(pl.endlist);
+        EXPECT_TRUE(pl.variant.empty());
+        ASSERT_EQ(3, (int)pl.segments.size());
+
+        EXPECT_STREQ("http://127.0.0.1:8080/live/livestream-100.ts", pl.segments[0]->url.c_str());
+        EXPECT_EQ(9500 * SRS_UTIME_MILLISECONDS, pl.segments[0]->duration);
+        EXPECT_EQ(100, pl.segments[0]->sequence);
+
+        EXPECT_STREQ("http://127.0.0.1:8080/hls/livestream-101.ts?token=xxx", pl.segments[1]->url.c_str());
+        EXPECT_EQ(101, pl.segments[1]->sequence);
+
+        EXPECT_STREQ("http://cdn.com/livestream-102.ts", pl.segments[2]->url.c_str());
+        EXPECT_EQ(102, pl.segments[2]->sequence);
+    }
+
+    // For master playlist, use the first variant.
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_SUCCESS(pl.parse("http://127.0.0.1/live/livestream.m3u8",
+            "#EXTM3U\n#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=73207\nhd/livestream.m3u8\n"
+            "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=3207\nsd/livestream.m3u8\n"));
+        EXPECT_TRUE(pl.segments.empty());
+        EXPECT_STREQ("http://127.0.0.1/live/hd/livestream.m3u8", pl.variant.c_str());
+    }
+
+    // For VoD, without media sequence.
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_SUCCESS(pl.parse("http://127.0.0.1/vod/index.m3u8",
+            "#EXTM3U\n#EXT-X-PLAYLIST-TYPE:VOD\n#EXTINF:10,\n0.ts\n#EXTINF:10,\n1.ts\n#EXT-X-ENDLIST\n"));
+        EXPECT_TRUE(pl.endlist);
+        ASSERT_EQ(2, (int)pl.segments.size());
+        EXPECT_EQ(0, pl.segments[0]->sequence);
+        EXPECT_EQ(1, pl.segments[1]->sequence);
+    }
+
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_FAILED(pl.parse("http://127.0.0.1/live/livestream.m3u8", "<html>Not Found</html>"));
+    }
+}
+
+VOID TEST(AppIngestPullTest, PrefetchWindow)
+{
+    srs_error_t err;
+
+    MockSrsConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF));
+    MockSourceContext ctx(&conf);
+
+    SrsHlsPuller p(NULL, 2);
+
+    // For fresh playlist, start from the live edge.
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_SUCCESS(pl.parse("http://127.0.0.1/live/livestream.m3u8",
+            "#EXTM3U\n#EXT-X-MEDIA-SEQUENCE:10\n#EXTINF:10,\n10.ts\n#EXTINF:10,\n11.ts\n#EXTINF:10,\n12.ts\n"));
+        EXPECT_EQ(1, p.update(&pl));
+        EXPECT_EQ(13, p.next_sequence);
+    }
+
+    // Queue the new segments only.
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_SUCCESS(pl.parse("http://127.0.0.1/live/livestream.m3u8",
+            "#EXTM3U\n#EXT-X-MEDIA-SEQUENCE:11\n#EXTINF:10,\n11.ts\n#EXTINF:10,\n12.ts\n#EXTINF:10,\n13.ts\n#EXTINF:10,\n14.ts\n"));
+        EXPECT_EQ(2, p.update(&pl));
+        EXPECT_EQ(0, p.update(&pl));
+        ASSERT_EQ(3, (int)p.segments.size());
+        EXPECT_EQ(12, p.segments[0]->sequence);
+        EXPECT_EQ(14, p.segments[2]->sequence);
+    }
+
+    // Fetch at most 2 segments concurrently.
+    if (true) {
+        SrsHlsPullSegment* s0 = p.acquire();
+        SrsHlsPullSegment* s1 = p.acquire();
+        ASSERT_TRUE(s0 != NULL && s1 != NULL);
+        EXPECT_EQ(12, s0->sequence);
+        EXPECT_EQ(13, s1->sequence);
+        EXPECT_TRUE(p.acquire() == NULL);
+
+        // The window never moves until the first one is consumed.
+        s1->fetching = false; s1->fetched = true;
+        EXPECT_TRUE(p.acquire() == NULL);
+
+        s0->fetching = false; s0->failed = true;
+        p.segments.pop_front();
+        srs_freep(s0);
+
+        SrsHlsPullSegment* s2 = p.acquire();
+        ASSERT_TRUE(s2 != NULL);
+        EXPECT_EQ(14, s2->sequence);
+    }
+
+    // When sequence goes back, restart from the live edge.
+    if (true) {
+        SrsHlsPullPlaylist pl;
+        HELPER_EXPECT_SUCCESS(pl.parse("http://127.0.0.1/live/livestream.m3u8",
+            "#EXTM3U\n#EXT-X-MEDIA-SEQUENCE:0\n#EXTINF:10,\n0.ts\n#EXTINF:10,\n1.ts\n"));
+        EXPECT_EQ(1, p.update(&pl));
+        EXPECT_EQ(2, p.next_sequence);
+        EXPECT_EQ(1, p.segments.back()->sequence);
+    }
+}
+
+
+// Burn the cpu for profiler to sample, which is global for the symbol.
+int64_t mock_profiler_burn(srs_utime_t duration)
+{
+    int64_t v = 0;
+    srs_utime_t starttime = srs_update_system_time();
+    while (srs_update_system_time() - starttime < duration) {
+        for (int i = 0; i < 10000; i++) {
+            v += i ^ v;
+        }
+    }
+    return v;
+}
+
+VOID TEST(AppIngestPullTest, PublishAsClient)
+{
+    srs_error_t err;
+
+    SrsRequest r;
+    r.vhost = "__defaultVhost__";
+    r.app = "live";
+    r.stream = "ingest-pull";
+    r.ip = "127.0.0.1";
+
+    // The security of vhost applies to the ingest from localhost.
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost __defaultVhost__{security{enabled on;deny publish 127.0.0.1;}}"));
+        MockSourceContext ctx(&conf);
+
+        MockSourceHandler h;
+        SrsIngestPublisher p(&h);
+        HELPER_ASSERT_SUCCESS(p.initialize(&r));
+        HELPER_EXPECT_FAILED(p.publish());
+        EXPECT_TRUE(NULL == _srs_sources->fetch(&r));
+    }
+
+    // The ingest is a publish client of statistic.
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost __defaultVhost__{}"));
+        MockSourceContext ctx(&conf);
+
+        MockSourceHandler h;
+        SrsIngestPublisher p(&h);
+        HELPER_ASSERT_SUCCESS(p.initialize(&r));
+        HELPER_ASSERT_SUCCESS(p.publish());
+
+        SrsStatisticClient* client = SrsStatistic::instance()->find_client(_srs_context->get_id());
+        ASSERT_TRUE(client != NULL);
+        EXPECT_TRUE(client->conn == NULL);
+        EXPECT_EQ(SrsRtmpConnFMLEPublish, client->type);
+
+        // The stream is busy for other publishers.
+        SrsSource* s = _srs_sources->fetch(&r);
+        ASSERT_TRUE(s != NULL);
+        EXPECT_FALSE(s->can_publish(false));
+
+        p.unpublish();
+        EXPECT_TRUE(NULL == SrsStatistic::instance()->find_client(_srs_context->get_id()));
+        EXPECT_TRUE(s->can_publish(false));
+    }
+}
+
+VOID TEST(AppProfilerTest, SampleStack)
+{
+    srs_error_t err;
+
+    // The cid is peeked without cache, for the signal handler.
+    if (true) {
+        SrsThreadContext ctx;
+        ctx.set_id(10051);
+        EXPECT_EQ(10051, SrsThreadContext::peek_id());
+
+        ctx.clear_cid();
+        EXPECT_EQ(0, SrsThreadContext::peek_id());
+    }
+
+    if (true) {
+        SrsCpuProfiler p;
+        HELPER_EXPECT_FAILED(p.start(0, 1));
+        HELPER_EXPECT_FAILED(p.start(99, SRS_PROFILER_MAX_SECONDS + 1));
+        EXPECT_FALSE(p.is_started());
+
+        SrsThreadContext ctx;
+        ctx.set_id(10052);
+        HELPER_ASSERT_SUCCESS(p.start(1000, 1));
+        EXPECT_TRUE(p.is_started());
+
+        // Only one profiler is sampling.
+        SrsCpuProfiler p2;
+        HELPER_EXPECT_FAILED(p2.start(1000, 1));
+
+        mock_profiler_burn(100 * SRS_UTIME_MILLISECONDS);
+        p.stop();
+        ctx.clear_cid();
+        EXPECT_FALSE(p.is_started());
+        EXPECT_GT(p.nn_samples(), 0);
+
+        string folded;
+        p.dumps(folded);
+        EXPECT_TRUE(srs_string_starts_with(folded, "cid-10052;"));
+        EXPECT_TRUE(folded.find(";mock_profiler_burn") != string::npos);
+    }
+}
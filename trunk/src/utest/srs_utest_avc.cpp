@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <srs_kernel_buffer.hpp>
 #include <srs_kernel_error.hpp>
 #include <srs_core_autofree.hpp>
+#include <srs_kernel_utility.hpp>
 
 VOID TEST(SrsAVCTest, H264ParseAnnexb)
 {
@@ -123,6 +124,63 @@ VOID TEST(SrsAVCTest, H264ParseAnnexb)
     }
 }
 
+VOID TEST(SrsAVCTest, H264SplitAnnexb)
+{
+    srs_error_t err;
+
+    // All NALUs in one pass.
+    if (true) {
+        SrsRawH264Stream h;
+
+        uint8_t buf[] = {
+            0, 0, 1, 0xd, 0xa, 0xf, 0, 0, 0, 1, 0xa, 0, 0, 1, 0xb,
+        };
+        SrsBuffer b((char*)buf, sizeof(buf));
+
+        SrsAnnexbNalu nalus[4]; int nb_nalus = 0;
+        HELPER_ASSERT_SUCCESS(h.annexb_split(&b, nalus, 4, &nb_nalus));
+        EXPECT_EQ(3, nb_nalus);
+        EXPECT_EQ((char*)(buf+3), nalus[0].bytes); EXPECT_EQ(3, nalus[0].size);
+        EXPECT_EQ((char*)(buf+10), nalus[1].bytes); EXPECT_EQ(1, nalus[1].size);
+        EXPECT_EQ((char*)(buf+14), nalus[2].bytes); EXPECT_EQ(1, nalus[2].size);
+        EXPECT_TRUE(b.empty());
+    }
+
+    // Split again for the left NALUs, which starts with the start code.
+    if (true) {
+        SrsRawH264Stream h;
+
+        uint8_t buf[] = {
+            0, 0, 1, 0xd, 0xa, 0xf, 0, 0, 0, 1, 0xa, 0, 0, 1, 0xb,
+        };
+        SrsBuffer b((char*)buf, sizeof(buf));
+
+        SrsAnnexbNalu nalus[2]; int nb_nalus = 0;
+        HELPER_ASSERT_SUCCESS(h.annexb_split(&b, nalus, 2, &nb_nalus));
+        EXPECT_EQ(2, nb_nalus);
+        EXPECT_EQ(11, b.pos());
+
+        HELPER_ASSERT_SUCCESS(h.annexb_split(&b, nalus, 2, &nb_nalus));
+        EXPECT_EQ(1, nb_nalus);
+        EXPECT_EQ((char*)(buf+14), nalus[0].bytes); EXPECT_EQ(1, nalus[0].size);
+        EXPECT_TRUE(b.empty());
+    }
+
+    // No prefix, should fail.
+    if (true) {
+        SrsRawH264Stream h;
+
+        uint8_t buf[] = {
+            0xd, 0xa, 0, 0, 1, 0xa,
+        };
+        SrsBuffer b((char*)buf, sizeof(buf));
+
+        SrsAnnexbNalu nalus[2]; int nb_nalus = 0;
+        HELPER_EXPECT_FAILED(h.annexb_split(&b, nalus, 2, &nb_nalus));
+        EXPECT_EQ(0, nb_nalus);
+    }
+}
+
 VOID TEST(SrsAVCTest, H264SequenceHeader)
 {
     srs_error_t err;
@@ -586,3 +644,4 @@ VOID TEST(SrsAVCTest, AACMuxToFLV)
     }
 }
 
+
@@ -1945,6 +1945,35 @@ VOID TEST(ConfigMainTest, CheckConf_vhost_ingest_id)
     HELPER_ASSERT_FAILED(conf.parse(_MIN_OK_CONF "vhost v{ingest{} ingest{}}"));
 }
 
+VOID TEST(ConfigMainTest, CheckConf_vhost_ingest_pull)
+{
+    srs_error_t err;
+
+    // The hls and flv ingest never transcode, the engine must be disabled or copy.
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost v{ingest id{input{type hls;} engine{enabled off;vcodec libx264;}}}"));
+    }
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost v{ingest id{input{type flv;} engine{enabled on;vcodec copy;acodec copy;}}}"));
+    }
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_FAILED(conf.parse(_MIN_OK_CONF "vhost v{ingest id{input{type hls;} engine{enabled on;vcodec libx264;acodec copy;}}}"));
+    }
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_FAILED(conf.parse(_MIN_OK_CONF "vhost v{ingest id{input{type flv;} engine{enabled on;acodec libfdk_aac;}}}"));
+    }
+
+    // The stream ingest transcodes by ffmpeg.
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost v{ingest id{input{type stream;} engine{enabled on;vcodec libx264;}}}"));
+    }
+}
+
 VOID TEST(ConfigUnitTest, CheckDefaultValuesVhost)
 {
     srs_error_t err;
@@ -1979,6 +2008,16 @@ VOID TEST(ConfigUnitTest, CheckDefaultValuesVhost)
 	    EXPECT_EQ(10 * SRS_UTIME_SECONDS, conf.get_heartbeat_interval());
     }
 
+    if (true) {
+	    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF));
+	    EXPECT_FALSE(conf.get_frame_drop(""));
+	    EXPECT_EQ(0, conf.get_notsent_lowat(""));
+
+	    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost v{play{frame_drop on; notsent_lowat 16384;}}"));
+	    EXPECT_TRUE(conf.get_frame_drop("v"));
+	    EXPECT_EQ(16384, conf.get_notsent_lowat("v"));
+    }
+
     if (true) {
 	    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF));
 	    EXPECT_EQ(10 * SRS_UTIME_SECONDS, conf.get_pithy_print());
@@ -3589,10 +3628,11 @@ VOID TEST(ConfigMainTest, CheckVhostConfig5)
 
     if (true) {
         MockSrsConfig conf;
-        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "http_api{enabled on;listen xxx;crossdomain off;raw_api {enabled on;allow_reload on;allow_query on;allow_update on;}}"));
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "http_api{enabled on;listen xxx;crossdomain off;profiler on;raw_api {enabled on;allow_reload on;allow_query on;allow_update on;}}"));
         EXPECT_TRUE(conf.get_http_api_enabled());
         EXPECT_STREQ("xxx", conf.get_http_api_listen().c_str());
         EXPECT_FALSE(conf.get_http_api_crossdomain());
+        EXPECT_TRUE(conf.get_http_api_profiler());
         EXPECT_TRUE(conf.get_raw_api());
         EXPECT_TRUE(conf.get_raw_api_allow_reload());
         EXPECT_TRUE(conf.get_raw_api_allow_query());
@@ -3639,6 +3679,13 @@ VOID TEST(ConfigMainTest, CheckVhostConfig5)
         HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "stats{network 0;disk xxx;}"));
         EXPECT_EQ(0, conf.get_stats_network());
         EXPECT_TRUE(conf.get_stats_disk_device() != NULL);
+        EXPECT_TRUE(conf.get_stats_shm().empty());
+    }
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "stats{shm /dev/shm/srs.stat;}"));
+        EXPECT_STREQ("/dev/shm/srs.stat", conf.get_stats_shm().c_str());
     }
 }
 
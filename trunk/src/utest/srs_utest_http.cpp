@@ -34,6 +34,7 @@ using namespace std;
 #include <srs_utest_kernel.hpp>
 #include <srs_app_http_static.hpp>
 #include <srs_service_utility.hpp>
+#include <srs_core_autofree.hpp>
 
 class MockMSegmentsReader : public ISrsReader
 {
@@ -347,6 +348,133 @@ VOID TEST(ProtocolHTTPTest, ResponseWriter)
     }
 }
 
+// The IO to count the writes, each write or writev maybe a TCP packet.
+class MockWritevIO : public MockBufferIO
+{
+public:
+    int nn_writes;
+public:
+    MockWritevIO() {
+        nn_writes = 0;
+    }
+    virtual ~MockWritevIO() {
+    }
+public:
+    virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite) {
+        nn_writes++;
+        return MockBufferIO::write(buf, size, nwrite);
+    }
+    virtual srs_error_t writev(const iovec *iov, int iov_size, ssize_t* nwrite) {
+        nn_writes++;
+        ssize_t size = 0;
+        for (int i = 0; i < iov_size; i++) {
+            out_buffer.append((char*)iov[i].iov_base, iov[i].iov_len);
+            size += iov[i].iov_len;
+        }
+        if (nwrite) {
+            *nwrite = size;
+        }
+        return srs_success;
+    }
+};
+
+VOID TEST(ProtocolHTTPTest, ResponseCoalesce)
+{
+    srs_error_t err;
+
+    // The header is sent with the body in one write.
+    if (true) {
+        MockWritevIO io;
+        SrsHttpResponseWriter w(&io);
+
+        w.header()->set_content_length(13);
+        w.write_header(SRS_CONSTS_HTTP_OK);
+        HELPER_EXPECT_SUCCESS(w.write((char*)"Hello, world!", 13));
+        HELPER_ASSERT_SUCCESS(w.final_request());
+
+        EXPECT_EQ(1, io.nn_writes);
+        string res = HELPER_BUFFER2STR(&io.out_buffer);
+        string body = "\r\n\r\nHello, world!";
+        EXPECT_EQ(0, (int)res.find("HTTP/1.1 200 OK\r\n"));
+        EXPECT_EQ(res.length() - body.length(), res.find(body));
+    }
+
+    // The header is sent with the first chunk.
+    if (true) {
+        MockWritevIO io;
+        SrsHttpResponseWriter w(&io);
+
+        w.write_header(SRS_CONSTS_HTTP_OK);
+        HELPER_EXPECT_SUCCESS(w.write((char*)"Hello", 5));
+        EXPECT_EQ(1, io.nn_writes);
+
+        HELPER_ASSERT_SUCCESS(w.final_request());
+        EXPECT_EQ(2, io.nn_writes);
+
+        string res = HELPER_BUFFER2STR(&io.out_buffer);
+        string body = "\r\n\r\n5\r\nHello\r\n0\r\n\r\n";
+        EXPECT_EQ(res.length() - body.length(), res.find(body));
+    }
+
+    // The header only response.
+    if (true) {
+        MockWritevIO io;
+        SrsHttpResponseWriter w(&io);
+
+        w.header()->set_content_length(0);
+        HELPER_ASSERT_SUCCESS(w.final_request());
+        EXPECT_EQ(1, io.nn_writes);
+        EXPECT_EQ(0, (int)HELPER_BUFFER2STR(&io.out_buffer).find("HTTP/1.1 200 OK\r\n"));
+    }
+
+    EXPECT_STREQ("HTTP/1.1 404 Not Found\r\n", srs_generate_http_status_line(SRS_CONSTS_HTTP_NotFound).c_str());
+    EXPECT_STREQ("HTTP/1.1 999 Status Unknown\r\n", srs_generate_http_status_line(999).c_str());
+}
+
+VOID TEST(ProtocolHTTPTest, ParsePipelined)
+{
+    srs_error_t err;
+
+    // The pipelined requests with body, the body should never overflow to next request.
+    MockMSegmentsReader r;
+    r.append("POST /api/v1/a HTTP/1.1\r\nContent-Length: 5\r\n\r\nHello"
+        "POST /api/v1/b HTTP/1.1\r\nContent-Length: 5\r\n\r\nWorld"
+        "GET /api/v1/c HTTP/1.1\r\n\r\n");
+
+    SrsHttpParser p;
+    HELPER_ASSERT_SUCCESS(p.initialize(HTTP_REQUEST, false));
+
+    if (true) {
+        ISrsHttpMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(p.parse_message(&r, &msg));
+        SrsAutoFree(ISrsHttpMessage, msg);
+        EXPECT_STREQ("/api/v1/a", msg->path().c_str());
+
+        string body;
+        HELPER_ASSERT_SUCCESS(msg->body_read_all(body));
+        EXPECT_STREQ("Hello", body.c_str());
+    }
+
+    if (true) {
+        ISrsHttpMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(p.parse_message(&r, &msg));
+        SrsAutoFree(ISrsHttpMessage, msg);
+        EXPECT_STREQ("/api/v1/b", msg->path().c_str());
+
+        string body;
+        HELPER_ASSERT_SUCCESS(msg->body_read_all(body));
+        EXPECT_STREQ("World", body.c_str());
+    }
+
+    if (true) {
+        ISrsHttpMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(p.parse_message(&r, &msg));
+        SrsAutoFree(ISrsHttpMessage, msg);
+        EXPECT_STREQ("/api/v1/c", msg->path().c_str());
+        EXPECT_TRUE(msg->is_http_get());
+    }
+}
+
 VOID TEST(ProtocolHTTPTest, ChunkSmallBuffer)
 {
     srs_error_t err;
@@ -651,6 +779,58 @@ VOID TEST(ProtocolHTTPTest, HTTPServerMuxerVhost)
     }
 }
 
+VOID TEST(ProtocolHTTPTest, HTTPServerMuxerUnhandle)
+{
+    srs_error_t err;
+
+    if (true) {
+        SrsHttpServeMux s;
+        HELPER_ASSERT_SUCCESS(s.initialize());
+
+        MockHttpHandler* h0 = new MockHttpHandler("Hello, world!");
+        HELPER_ASSERT_SUCCESS(s.handle("/", h0));
+
+        MockHttpHandler* h1 = new MockHttpHandler("Done");
+        HELPER_ASSERT_SUCCESS(s.handle("ossrs.net/live/livestream.flv", h1));
+
+        // Ignore if handler not match.
+        s.unhandle("ossrs.net/live/livestream.flv", h0);
+
+        if (true) {
+            MockResponseWriter w;
+            SrsHttpMessage r(NULL, NULL);
+
+            SrsHttpHeader h;
+            h.set("Host", "ossrs.net");
+            r.set_header(&h, false);
+            HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.flv", false));
+
+            HELPER_ASSERT_SUCCESS(s.serve_http(&w, &r));
+            __MOCK_HTTP_EXPECT_STREQ(200, "Done", w);
+        }
+
+        // Fallback to the root handler.
+        s.unhandle("ossrs.net/live/livestream.flv", h1);
+
+        if (true) {
+            MockResponseWriter w;
+            SrsHttpMessage r(NULL, NULL);
+
+            SrsHttpHeader h;
+            h.set("Host", "ossrs.net");
+            r.set_header(&h, false);
+            HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.flv", false));
+
+            HELPER_ASSERT_SUCCESS(s.serve_http(&w, &r));
+            __MOCK_HTTP_EXPECT_STREQ(200, "Hello, world!", w);
+        }
+
+        // Mount again.
+        h1 = new MockHttpHandler("Done");
+        HELPER_ASSERT_SUCCESS(s.handle("ossrs.net/live/livestream.flv", h1));
+    }
+}
+
 VOID TEST(ProtocolHTTPTest, HTTPServerMuxerImplicitHandler)
 {
     srs_error_t err;
@@ -1404,6 +1584,32 @@ VOID TEST(ProtocolHTTPTest, MSegmentsReader)
     }
 }
 
+VOID TEST(ProtocolHTTPTest, ParseFragmentedUrl)
+{
+    srs_error_t err;
+
+    // The URL in fragments should be appended, and reset for the next message.
+    MockMSegmentsReader r;
+    r.in_bytes.push_back("GET /api/v1");
+    r.in_bytes.push_back("/versions?vhost=ossrs.net HTTP/1.1\r\n");
+    r.in_bytes.push_back("Host: ossrs.net\r\n\r\n");
+    r.in_bytes.push_back("GET /api/v1/summaries HTTP/1.1\r\n");
+    r.in_bytes.push_back("Host: ossrs.net\r\n\r\n");
+
+    SrsHttpParser p;
+    HELPER_ASSERT_SUCCESS(p.initialize(HTTP_REQUEST, false));
+
+    ISrsHttpMessage* msg = NULL;
+    HELPER_ASSERT_SUCCESS(p.parse_message(&r, &msg));
+    EXPECT_STREQ("/api/v1/versions", msg->path().c_str());
+    EXPECT_STREQ("ossrs.net", msg->query_get("vhost").c_str());
+    srs_freep(msg);
+
+    HELPER_ASSERT_SUCCESS(p.parse_message(&r, &msg));
+    EXPECT_STREQ("/api/v1/summaries", msg->path().c_str());
+    srs_freep(msg);
+}
+
 VOID TEST(ProtocolHTTPTest, HTTPMessageParser)
 {
     srs_error_t err;
@@ -394,6 +394,21 @@ srs_error_t MockTsHandler::on_ts_message(SrsTsMessage* m)
     return srs_success;
 }
 
+MockTsFrameHandler::MockTsFrameHandler()
+{
+}
+
+MockTsFrameHandler::~MockTsFrameHandler()
+{
+}
+
+srs_error_t MockTsFrameHandler::on_ts_message(SrsTsMessage* m)
+{
+    msgs.push_back(m);
+    payloads.push_back(string(m->payload->bytes(), m->payload->length()));
+    return srs_success;
+}
+
 void mock_print_err(srs_error_t err)
 {
     fprintf(stderr, "err %s\n", srs_error_desc(err).c_str());
@@ -2649,6 +2664,70 @@ VOID TEST(KernelUtility, AnnexbUtils)
     }
 }
 
+VOID TEST(KernelUtility, AnnexbFind)
+{
+    if (true) {
+        char data[] = {0x00, 0x00, 0x02};
+        EXPECT_TRUE(NULL == srs_avc_find_annexb(data, data + sizeof(data), NULL));
+        EXPECT_TRUE(NULL == srs_avc_find_annexb(data, data, NULL));
+    }
+    
+    if (true) {
+        char data[] = {0x00, 0x00, 0x00, 0x01, 0x65};
+        int nb = 0;
+        EXPECT_EQ(data, srs_avc_find_annexb(data, data + sizeof(data), &nb));
+        EXPECT_EQ(4, nb);
+    }
+    
+    // The leading zeros are trailing zeros of previous NALU, but not before the start.
+    if (true) {
+        char data[] = {0x09, 0x00, 0x00, 0x00, 0x00, 0x01};
+        int nb = 0;
+        EXPECT_EQ(data + 1, srs_avc_find_annexb(data, data + sizeof(data), &nb));
+        EXPECT_EQ(5, nb);
+        EXPECT_EQ(data + 2, srs_avc_find_annexb(data + 2, data + sizeof(data), &nb));
+        EXPECT_EQ(4, nb);
+    }
+    
+    // Covers the SIMD block, block boundary and scalar tail, compare with the byte scanner.
+    for (int size = 3; size < 100; size++) {
+        for (int pos = 0; pos + 3 <= size; pos++) {
+            char data[100];
+            memset(data, 0x0f, sizeof(data));
+            data[pos] = data[pos + 1] = 0x00; data[pos + 2] = 0x01;
+            
+            int nb = 0;
+            char* p = srs_avc_find_annexb(data, data + size, &nb);
+            EXPECT_EQ(data + pos, p);
+            EXPECT_EQ(3, nb);
+            
+            // Never read out of range.
+            EXPECT_TRUE(NULL == srs_avc_find_annexb(data, data + pos + 2, NULL));
+        }
+    }
+}
+
+VOID TEST(KernelUtility, AnnexbSplit)
+{
+    SrsAnnexbNalu nalus[4];
+    
+    if (true) {
+        char data[] = {0x09, 0x00, 0x00, 0x01};
+        EXPECT_EQ(-1, srs_avc_split_annexb(data, sizeof(data), nalus, 4));
+        EXPECT_EQ(-1, srs_avc_split_annexb(data, 0, nalus, 4));
+    }
+    
+    if (true) {
+        char data[] = {0x00, 0x00, 0x00, 0x01, 0x09, (char)0xf0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x00, 0x00, 0x01, 0x65};
+        EXPECT_EQ(3, srs_avc_split_annexb(data, sizeof(data), nalus, 4));
+        EXPECT_EQ(data + 4, nalus[0].bytes); EXPECT_EQ(2, nalus[0].size);
+        EXPECT_EQ(data + 12, nalus[1].bytes); EXPECT_EQ(2, nalus[1].size);
+        EXPECT_EQ(data + 18, nalus[2].bytes); EXPECT_EQ(1, nalus[2].size);
+        
+        EXPECT_EQ(2, srs_avc_split_annexb(data, sizeof(data), nalus, 2));
+    }
+}
+
 VOID TEST(KernelUtility, AdtsUtils)
 {
     if (true) {
@@ -3020,6 +3099,102 @@ VOID TEST(KernelLBRRTest, CoverAll)
     }
 }
 
+VOID TEST(KernelLBConsistentHashTest, CoverAll)
+{
+    vector<string> servers;
+    servers.push_back("s0");
+    servers.push_back("s1");
+    servers.push_back("s2");
+    
+    // The same key always selects the same server.
+    if (true) {
+        SrsLbServerTable table;
+        SrsLbConsistentHash lb0(&table, "vhost/live/livestream", 0);
+        SrsLbConsistentHash lb1(&table, "vhost/live/livestream", 0);
+        
+        string s = lb0.select(servers);
+        EXPECT_TRUE(s == lb1.select(servers));
+        EXPECT_TRUE(s == lb0.select(servers));
+        EXPECT_TRUE(s == lb0.selected());
+        EXPECT_TRUE(s == servers.at(lb0.current()));
+        EXPECT_EQ(2, table.fetch(s)->load);
+        
+        lb0.release();
+        lb1.release();
+        EXPECT_EQ(0, table.fetch(s)->load);
+    }
+    
+    // Only the streams of removed server are moved.
+    if (true) {
+        SrsLbServerTable table;
+        
+        vector<string> others;
+        others.push_back("s0");
+        others.push_back("s2");
+        
+        for (int i = 0; i < 100; i++) {
+            SrsLbConsistentHash lb(&table, srs_int2str(i), 0);
+            string s = lb.select(servers);
+            string t = lb.select(others);
+            if (s != "s1") {
+                EXPECT_TRUE(s == t);
+            }
+        }
+    }
+    
+    // The bounded load, never exceed factor*average.
+    if (true) {
+        SrsLbServerTable table;
+        
+        vector<SrsLbConsistentHash*> lbs;
+        for (int i = 0; i < 30; i++) {
+            SrsLbConsistentHash* lb = new SrsLbConsistentHash(&table, srs_int2str(i), 1.0);
+            lb->select(servers);
+            lbs.push_back(lb);
+        }
+        
+        EXPECT_EQ(10, table.fetch("s0")->load);
+        EXPECT_EQ(10, table.fetch("s1")->load);
+        EXPECT_EQ(10, table.fetch("s2")->load);
+        
+        for (int i = 0; i < (int)lbs.size(); i++) {
+            SrsLbConsistentHash* lb = lbs.at(i);
+            srs_freep(lb);
+        }
+        EXPECT_EQ(0, table.fetch("s0")->load);
+    }
+    
+    // The failed server is ejected.
+    if (true) {
+        SrsLbServerTable table(2, 30 * SRS_UTIME_SECONDS);
+        SrsLbConsistentHash lb(&table, "vhost/live/livestream", 0);
+        
+        string s = lb.select(servers);
+        lb.on_failure();
+        EXPECT_TRUE(s == lb.select(servers));
+        lb.on_failure();
+        EXPECT_EQ(1, (int)table.fetch(s)->nn_ejected);
+        EXPECT_FALSE(table.fetch(s)->healthy(srs_get_system_time()));
+        
+        string t = lb.select(servers);
+        EXPECT_TRUE(s != t);
+        lb.on_success();
+        EXPECT_EQ(0, table.fetch(t)->failures);
+    }
+    
+    // All servers are ejected, still select one.
+    if (true) {
+        SrsLbServerTable table(1, 30 * SRS_UTIME_SECONDS);
+        SrsLbConsistentHash lb(&table, "vhost/live/livestream");
+        
+        table.on_failure("s0");
+        table.on_failure("s1");
+        table.on_failure("s2");
+        EXPECT_FALSE(lb.select(servers).empty());
+        EXPECT_EQ(3, (int)table.list().size());
+    }
+}
+
 VOID TEST(KernelCodecTest, CoverAll)
 {
     if (true) {
@@ -4788,6 +4963,83 @@ VOID TEST(KernelTSTest, CoverTransmuxer)
     }
 }
 
+// Encode nb_frames of video and audio to ts, each video frame is vsize bytes.
+srs_error_t _mock_ts_stream(MockSrsFileWriter* f, int nb_frames, int vsize)
+{
+    srs_error_t err = srs_success;
+    
+    SrsTsContext ctx;
+    string video(vsize, 'V'), audio(200, 'A');
+    
+    for (int i = 0; i < nb_frames; i++) {
+        SrsTsMessage v;
+        v.sid = SrsTsPESStreamIdVideoCommon;
+        v.write_pcr = (i % 25) == 0;
+        v.dts = v.pts = i * 3600;
+        video[0] = (char)i;
+        v.payload->append(video.data(), (int)video.length());
+        if ((err = ctx.encode(f, &v, SrsVideoCodecIdAVC, SrsAudioCodecIdAAC)) != srs_success) {
+            return srs_error_wrap(err, "video");
+        }
+        
+        SrsTsMessage a;
+        a.sid = SrsTsPESStreamIdAudioCommon;
+        a.dts = a.pts = i * 3600;
+        audio[0] = (char)i;
+        a.payload->append(audio.data(), (int)audio.length());
+        if ((err = ctx.encode(f, &a, SrsVideoCodecIdAVC, SrsAudioCodecIdAAC)) != srs_success) {
+            return srs_error_wrap(err, "audio");
+        }
+    }
+    
+    return err;
+}
+
+VOID TEST(KernelTSTest, DecodeReuseMessage)
+{
+    srs_error_t err;
+    
+    MockSrsFileWriter f;
+    HELPER_ASSERT_SUCCESS(_mock_ts_stream(&f, 10, 1000));
+    ASSERT_EQ(0, f.filesize() % SRS_TS_PACKET_SIZE);
+    
+    SrsTsContext ctx;
+    MockTsFrameHandler h;
+    for (int i = 0; i < f.filesize() / SRS_TS_PACKET_SIZE; i++) {
+        SrsBuffer b(f.data() + i * SRS_TS_PACKET_SIZE, SRS_TS_PACKET_SIZE);
+        HELPER_ASSERT_SUCCESS(ctx.decode(&b, &h));
+    }
+    
+    SrsTsMessage* video = NULL;
+    SrsTsMessage* audio = NULL;
+    int nb_videos = 0, nb_audios = 0;
+    for (int i = 0; i < (int)h.msgs.size(); i++) {
+        SrsTsMessage* m = h.msgs[i];
+        string& payload = h.payloads[i];
+        
+        if (m->channel->apply == SrsTsPidApplyVideo) {
+            ASSERT_EQ(1000, (int)payload.length());
+            EXPECT_EQ(nb_videos++, payload.at(0));
+            EXPECT_EQ('V', payload.at(999));
+            EXPECT_TRUE(!video || video == m);
+            video = m;
+        } else {
+            ASSERT_EQ(200, (int)payload.length());
+            EXPECT_EQ(nb_audios++, payload.at(0));
+            EXPECT_EQ('A', payload.at(199));
+            EXPECT_TRUE(!audio || audio == m);
+            audio = m;
+        }
+    }
+    EXPECT_EQ(10, nb_videos);
+    EXPECT_EQ(10, nb_audios);
+    
+    // The message is reused by channel, and it's reset after handled.
+    EXPECT_TRUE(video && video != audio);
+    EXPECT_TRUE(audio == audio->channel->msg);
+    EXPECT_TRUE(audio->fresh());
+}
+
 VOID TEST(KernelMP4Test, CoverMP4All)
 {
 	if (true) {
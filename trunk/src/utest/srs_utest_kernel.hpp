@@ -146,5 +146,18 @@ public:
     virtual srs_error_t on_ts_message(SrsTsMessage* m);
 };
 
+class MockTsFrameHandler : public ISrsTsHandler
+{
+public:
+    // The messages and payload got from context.
+    std::vector<SrsTsMessage*> msgs;
+    std::vector<std::string> payloads;
+public:
+    MockTsFrameHandler();
+    virtual ~MockTsFrameHandler();
+public:
+    virtual srs_error_t on_ts_message(SrsTsMessage* m);
+};
+
 #endif
 
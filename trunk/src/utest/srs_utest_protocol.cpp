@@ -34,6 +34,8 @@ using namespace std;
 #include <srs_protocol_amf0.hpp>
 #include <srs_rtmp_stack.hpp>
 #include <srs_service_http_conn.hpp>
+#include <srs_kernel_buffer.hpp>
+#include <srs_kernel_stream.hpp>
 
 MockEmptyIO::MockEmptyIO()
 {
@@ -6472,3 +6474,287 @@ VOID TEST(ProtocolKbpsTest, WriteLargeIOVs)
     }
 }
 
+MockRtspInterleavedHandler::MockRtspInterleavedHandler()
+{
+}
+
+MockRtspInterleavedHandler::~MockRtspInterleavedHandler()
+{
+}
+
+srs_error_t MockRtspInterleavedHandler::on_interleaved(int channel, char* data, int size)
+{
+    channels.push_back(channel);
+    packets.push_back(string(data, size));
+    return srs_success;
+}
+
+// Alloc a packet of seq and ssrc from jitter buffer.
+SrsRtpPacket* _mock_rtp_packet(SrsRtpJitterBuffer* jb, uint16_t seq, uint32_t ssrc = 0x100)
+{
+    SrsRtpPacket* pkt = jb->alloc();
+    pkt->sequence_number = seq;
+    pkt->ssrc = ssrc;
+    return pkt;
+}
+
+// Pop a packet from jitter buffer, return the seq or -1 if none.
+int _mock_rtp_pop(SrsRtpJitterBuffer* jb, srs_utime_t now)
+{
+    SrsRtpPacket* pkt = jb->pop(now);
+    if (!pkt) {
+        return -1;
+    }
+    
+    int seq = pkt->sequence_number;
+    jb->recycle(pkt);
+    return seq;
+}
+
+// Encode a H.264 rtp packet, whose payload is FU-A when fu is not zero.
+int _mock_rtp_h264(char* buf, uint16_t seq, uint8_t fu, const char* data, int size)
+{
+    SrsBuffer b(buf, 1500);
+    b.write_1bytes(0x80);
+    b.write_1bytes(96);
+    b.write_2bytes(seq);
+    b.write_4bytes(9000);
+    b.write_4bytes(0x100);
+    if (fu) {
+        b.write_1bytes(0x7c);
+        b.write_1bytes(fu);
+    }
+    b.write_bytes((char*)data, size);
+    return b.pos();
+}
+
+VOID TEST(ProtocolRTSPTest, RtpJitterBuffer)
+{
+    // The packets in order.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 100 * SRS_UTIME_MILLISECONDS);
+        EXPECT_EQ(-1, _mock_rtp_pop(&jb, 0));
+        
+        for (int i = 0; i < 3; i++) {
+            jb.push(_mock_rtp_packet(&jb, 65534 + i), 0);
+            EXPECT_EQ((uint16_t)(65534 + i), _mock_rtp_pop(&jb, 0));
+        }
+        EXPECT_EQ(3, jb.nn_received);
+        EXPECT_EQ(0, jb.nn_lost);
+        EXPECT_EQ(0, jb.size());
+    }
+    
+    // The packets reordered in latency.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 100 * SRS_UTIME_MILLISECONDS);
+        jb.push(_mock_rtp_packet(&jb, 10), 0);
+        EXPECT_EQ(10, _mock_rtp_pop(&jb, 0));
+        
+        jb.push(_mock_rtp_packet(&jb, 12), 0);
+        jb.push(_mock_rtp_packet(&jb, 13), 10 * SRS_UTIME_MILLISECONDS);
+        EXPECT_EQ(-1, _mock_rtp_pop(&jb, 10 * SRS_UTIME_MILLISECONDS));
+        
+        jb.push(_mock_rtp_packet(&jb, 11), 20 * SRS_UTIME_MILLISECONDS);
+        EXPECT_EQ(11, _mock_rtp_pop(&jb, 20 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(12, _mock_rtp_pop(&jb, 20 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(13, _mock_rtp_pop(&jb, 20 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(1, jb.nn_reordered);
+        EXPECT_EQ(0, jb.nn_lost);
+        
+        // The duplicated and late packets are dropped.
+        jb.push(_mock_rtp_packet(&jb, 13), 20 * SRS_UTIME_MILLISECONDS);
+        jb.push(_mock_rtp_packet(&jb, 9), 20 * SRS_UTIME_MILLISECONDS);
+        EXPECT_EQ(-1, _mock_rtp_pop(&jb, 20 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(2, jb.nn_dropped);
+    }
+    
+    // The lost packet is skipped when exceed the latency.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 100 * SRS_UTIME_MILLISECONDS);
+        jb.push(_mock_rtp_packet(&jb, 10), 0);
+        EXPECT_EQ(10, _mock_rtp_pop(&jb, 0));
+        
+        jb.push(_mock_rtp_packet(&jb, 13), 0);
+        EXPECT_EQ(-1, _mock_rtp_pop(&jb, 99 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(13, _mock_rtp_pop(&jb, 100 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(2, jb.nn_lost);
+        
+        // The lost packet arrives too late.
+        jb.push(_mock_rtp_packet(&jb, 12), 100 * SRS_UTIME_MILLISECONDS);
+        EXPECT_EQ(-1, _mock_rtp_pop(&jb, 100 * SRS_UTIME_MILLISECONDS));
+        EXPECT_EQ(1, jb.nn_dropped);
+    }
+    
+    // Never wait when latency is zero.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 0);
+        jb.push(_mock_rtp_packet(&jb, 10), 0);
+        jb.push(_mock_rtp_packet(&jb, 12), 0);
+        EXPECT_EQ(10, _mock_rtp_pop(&jb, 0));
+        EXPECT_EQ(12, _mock_rtp_pop(&jb, 0));
+        EXPECT_EQ(1, jb.nn_lost);
+    }
+    
+    // Start over when ssrc changed or sequence jumps forward out of window.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 100 * SRS_UTIME_MILLISECONDS);
+        jb.push(_mock_rtp_packet(&jb, 10), 0);
+        jb.push(_mock_rtp_packet(&jb, 12), 0);
+        EXPECT_EQ(10, _mock_rtp_pop(&jb, 0));
+        
+        jb.push(_mock_rtp_packet(&jb, 100, 0x200), 0);
+        EXPECT_EQ(100, _mock_rtp_pop(&jb, 0));
+        EXPECT_EQ(1, jb.nn_dropped);
+        
+        jb.push(_mock_rtp_packet(&jb, 117, 0x200), 0);
+        EXPECT_EQ(117, _mock_rtp_pop(&jb, 0));
+        
+        EXPECT_EQ(0, jb.nn_lost);
+    }
+    
+    // The stale packet far behind is dropped, without flushing the buffered packets.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 100 * SRS_UTIME_MILLISECONDS);
+        jb.push(_mock_rtp_packet(&jb, 100), 0);
+        EXPECT_EQ(100, _mock_rtp_pop(&jb, 0));
+        
+        jb.push(_mock_rtp_packet(&jb, 102), 0);
+        jb.push(_mock_rtp_packet(&jb, 50), 0);
+        EXPECT_EQ(1, jb.nn_dropped);
+        EXPECT_EQ(1, jb.size());
+        
+        jb.push(_mock_rtp_packet(&jb, 101), 0);
+        EXPECT_EQ(101, _mock_rtp_pop(&jb, 0));
+        EXPECT_EQ(102, _mock_rtp_pop(&jb, 0));
+        EXPECT_EQ(0, jb.nn_lost);
+    }
+    
+    // The packets are reused.
+    if (true) {
+        SrsRtpJitterBuffer jb(16, 0);
+        SrsRtpPacket* pkt = jb.alloc();
+        pkt->payload->append("Hello", 5);
+        pkt->chunked = true;
+        jb.recycle(pkt);
+        
+        SrsRtpPacket* reused = jb.alloc();
+        EXPECT_TRUE(pkt == reused);
+        EXPECT_EQ(0, reused->payload->length());
+        EXPECT_FALSE(reused->chunked);
+        jb.recycle(reused);
+    }
+}
+
+VOID TEST(ProtocolRTSPTest, RtpFrameAssembler)
+{
+    srs_error_t err;
+    
+    char buf[1500];
+    SrsRtpPacket pkt;
+    SrsRtpFrameAssembler fa;
+    
+    // The FU-A is assembled to a NALU.
+    if (true) {
+        SrsBuffer b(buf, _mock_rtp_h264(buf, 10, 0x85, "\x01\x02", 2));
+        pkt.reset();
+        HELPER_EXPECT_SUCCESS(pkt.decode(&b));
+        EXPECT_TRUE(pkt.chunked && pkt.first_chunk && !pkt.completed);
+        EXPECT_TRUE(NULL == fa.assemble(&pkt));
+        
+        SrsBuffer b2(buf, _mock_rtp_h264(buf, 11, 0x05, "\x03", 1));
+        pkt.reset();
+        HELPER_EXPECT_SUCCESS(pkt.decode(&b2));
+        EXPECT_TRUE(NULL == fa.assemble(&pkt));
+        
+        SrsBuffer b3(buf, _mock_rtp_h264(buf, 12, 0x45, "\x04", 1));
+        pkt.reset();
+        HELPER_EXPECT_SUCCESS(pkt.decode(&b3));
+        SrsRtpPacket* frame = fa.assemble(&pkt);
+        ASSERT_TRUE(frame != NULL);
+        EXPECT_TRUE(frame->completed);
+        EXPECT_EQ(10, frame->sequence_number);
+        EXPECT_EQ(9000, (int)frame->timestamp);
+        ASSERT_EQ(5, frame->payload->length());
+        EXPECT_EQ(0, memcmp(frame->payload->bytes(), "\x65\x01\x02\x03\x04", 5));
+    }
+    
+    // The NALU is dropped when chunk lost.
+    if (true) {
+        SrsBuffer b(buf, _mock_rtp_h264(buf, 20, 0x85, "\x01", 1));
+        pkt.reset();
+        HELPER_EXPECT_SUCCESS(pkt.decode(&b));
+        EXPECT_TRUE(NULL == fa.assemble(&pkt));
+        
+        SrsBuffer b2(buf, _mock_rtp_h264(buf, 22, 0x45, "\x02", 1));
+        pkt.reset();
+        HELPER_EXPECT_SUCCESS(pkt.decode(&b2));
+        EXPECT_TRUE(NULL == fa.assemble(&pkt));
+        EXPECT_EQ(1, fa.nn_dropped);
+    }
+    
+    // The single NALU is the packet itself.
+    if (true) {
+        SrsBuffer b(buf, _mock_rtp_h264(buf, 30, 0, "\x65\x01", 2));
+        pkt.reset();
+        HELPER_EXPECT_SUCCESS(pkt.decode(&b));
+        EXPECT_TRUE(&pkt == fa.assemble(&pkt));
+        EXPECT_EQ(2, pkt.payload->length());
+    }
+}
+
+VOID TEST(ProtocolRTSPTest, Interleaved)
+{
+    srs_error_t err;
+    
+    // The transport of rtp over tcp.
+    if (true) {
+        SrsRtspTransport t;
+        HELPER_EXPECT_SUCCESS(t.parse("RTP/AVP/TCP;unicast;interleaved=2-3;mode=record"));
+        EXPECT_STREQ("TCP", t.lower_transport.c_str());
+        EXPECT_EQ(2, t.interleaved_min);
+        EXPECT_EQ(3, t.interleaved_max);
+    }
+    
+    if (true) {
+        SrsRtspSetupResponse res(1);
+        res.session = "abc";
+        res.interleaved_min = 2;
+        res.interleaved_max = 3;
+        
+        stringstream ss;
+        HELPER_EXPECT_SUCCESS(res.encode(ss));
+        EXPECT_TRUE(ss.str().find("Transport: RTP/AVP/TCP;unicast;interleaved=2-3\r\n") != string::npos);
+    }
+    
+    // The interleaved data before the rtsp message.
+    if (true) {
+        MockBufferIO io;
+        io.append((uint8_t*)"$\x00\x00\x03" "abc" "$\x01\x00\x01" "x", 12);
+        io.append("OPTIONS rtsp://127.0.0.1/live RTSP/1.0\r\nCSeq: 2\r\n\r\n");
+        io.append((uint8_t*)"$\x02\x00\x00", 4);
+        io.append("OPTIONS rtsp://127.0.0.1/live RTSP/1.0\r\nCSeq: 3\r\n\r\n");
+        
+        MockRtspInterleavedHandler h;
+        SrsRtspStack rtsp(&io, &h);
+        
+        SrsRtspRequest* req = NULL;
+        HELPER_ASSERT_SUCCESS(rtsp.recv_message(&req));
+        EXPECT_TRUE(req->is_options());
+        EXPECT_EQ(2, req->seq);
+        srs_freep(req);
+        
+        ASSERT_EQ(2, (int)h.packets.size());
+        EXPECT_EQ(0, h.channels[0]);
+        EXPECT_STREQ("abc", h.packets[0].c_str());
+        EXPECT_EQ(1, h.channels[1]);
+        EXPECT_STREQ("x", h.packets[1].c_str());
+        
+        HELPER_ASSERT_SUCCESS(rtsp.recv_message(&req));
+        EXPECT_EQ(3, req->seq);
+        srs_freep(req);
+        
+        ASSERT_EQ(3, (int)h.packets.size());
+        EXPECT_EQ(2, h.channels[2]);
+        EXPECT_TRUE(h.packets[2].empty());
+    }
+}
@@ -40,6 +40,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 using namespace _srs_internal;
 
 #include <srs_protocol_io.hpp>
+#include <srs_rtsp_stack.hpp>
 
 class MockEmptyIO : public ISrsProtocolReadWriter
 {
@@ -147,5 +148,18 @@ public:
     virtual MockWallClock* set_clock(srs_utime_t v);
 };
 
+class MockRtspInterleavedHandler : public ISrsRtspInterleavedHandler
+{
+public:
+    // The channel and data of interleaved packets.
+    std::vector<int> channels;
+    std::vector<std::string> packets;
+public:
+    MockRtspInterleavedHandler();
+    virtual ~MockRtspInterleavedHandler();
+public:
+    virtual srs_error_t on_interleaved(int channel, char* data, int size);
+};
+
 #endif
 
@@ -918,3 +918,46 @@ VOID TEST(ConfigReloadTest, ReloadVhostIngestUpdated)
     handler.reset();
 }
 
+
+VOID TEST(ConfigReloadTest, ReloadVhostSubscribe)
+{
+    MockReloadHandler handler;
+    MockReloadHandler h0, h1, h2;
+    MockSrsReloadConfig conf;
+    
+    conf.subscribe(&handler);
+    conf.subscribe(&h0, "a", SrsReloadVhostHls);
+    conf.subscribe(&h1, "b", SrsReloadVhostHls | SrsReloadVhostPlay);
+    conf.subscribe(&h2, "a", SrsReloadVhostPlay);
+    EXPECT_TRUE(ERROR_SUCCESS == conf.parse(_MIN_OK_CONF"vhost a{hls {enabled on;}} vhost b{hls {enabled on;}}"));
+    
+    // Only notify the handlers of the changed section of vhost.
+    EXPECT_TRUE(ERROR_SUCCESS == conf.do_reload(_MIN_OK_CONF"vhost a{hls {enabled off;}} vhost b{hls {enabled on;}}"));
+    EXPECT_TRUE(handler.vhost_hls_reloaded);
+    EXPECT_EQ(1, handler.count_true());
+    EXPECT_TRUE(h0.vhost_hls_reloaded);
+    EXPECT_EQ(1, h0.count_true());
+    EXPECT_TRUE(h1.all_false());
+    EXPECT_TRUE(h2.all_false());
+    handler.reset(); h0.reset(); h1.reset(); h2.reset();
+    
+    // Subscribe again to change the vhost.
+    conf.unsubscribe(&h0);
+    conf.subscribe(&h1, "a", SrsReloadVhostHls);
+    EXPECT_TRUE(ERROR_SUCCESS == conf.do_reload(_MIN_OK_CONF"vhost a{hls {enabled on;}} vhost b{hls {enabled off;}}"));
+    EXPECT_TRUE(handler.vhost_hls_reloaded);
+    EXPECT_EQ(1, handler.count_true());
+    EXPECT_TRUE(h0.all_false());
+    EXPECT_TRUE(h1.vhost_hls_reloaded);
+    EXPECT_EQ(1, h1.count_true());
+    EXPECT_TRUE(h2.all_false());
+    handler.reset(); h0.reset(); h1.reset(); h2.reset();
+    
+    // Unsubscribe all handlers of vhost.
+    conf.unsubscribe(&h1);
+    conf.unsubscribe(&h2);
+    EXPECT_TRUE(ERROR_SUCCESS == conf.do_reload(_MIN_OK_CONF"vhost a{hls {enabled off;}} vhost b{hls {enabled off;}}"));
+    EXPECT_TRUE(handler.vhost_hls_reloaded);
+    EXPECT_TRUE(h1.all_false());
+    EXPECT_TRUE(h2.all_false());
+}
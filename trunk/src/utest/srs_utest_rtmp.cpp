@@ -2853,12 +2853,10 @@ VOID TEST(ProtocolRTMPTest, ConnectAppWithArgs)
             SrsConnectAppPacket* pkt = NULL;
             HELPER_ASSERT_SUCCESS(p.expect_message(&msg, &pkt));
 
-            SrsAmf0Any* prop = pkt->command_object->get_property("tcUrl");
-            ASSERT_TRUE(prop && prop->is_string());
-            EXPECT_STREQ("rtmp://127.0.0.1/live", prop->to_str().c_str());
+            EXPECT_STREQ("rtmp://127.0.0.1/live", pkt->tcUrl.c_str());
 
             ASSERT_TRUE(pkt->args);
-            prop = pkt->args->get_property("license");
+            SrsAmf0Any* prop = pkt->args->get_property("license");
             ASSERT_TRUE(prop && prop->is_string());
             EXPECT_STREQ("MIT", prop->to_str().c_str());
         }
@@ -38,8 +38,12 @@ using namespace std;
 #include <srs_service_utility.hpp>
 #include <srs_service_http_client.hpp>
 #include <srs_service_rtmp_conn.hpp>
+#include <srs_kernel_utility.hpp>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <st.h>
 
 class MockSrsConnection : public ISrsConnection
 {
@@ -245,6 +249,49 @@ VOID TEST(TCPServerTest, PingPongWithTimeout)
 	}
 }
 
+VOID TEST(TCPServerTest, ClientIsAlive)
+{
+	srs_error_t err;
+
+	if (true) {
+		SrsTcpClient c(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout);
+		EXPECT_FALSE(c.is_alive());
+	}
+
+	// Alive when idle, stale after server closed it.
+	if (true) {
+		MockTcpHandler h;
+		SrsTcpListener l(&h, _srs_tmp_host, _srs_tmp_port);
+		HELPER_EXPECT_SUCCESS(l.listen());
+
+		SrsTcpClient c(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout);
+		HELPER_EXPECT_SUCCESS(c.connect());
+		ASSERT_TRUE(h.fd != NULL);
+		EXPECT_TRUE(c.is_alive());
+
+		srs_close_stfd(h.fd);
+		srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+		EXPECT_FALSE(c.is_alive());
+	}
+
+	// Not alive if got unexpected data.
+	if (true) {
+		MockTcpHandler h;
+		SrsTcpListener l(&h, _srs_tmp_host, _srs_tmp_port);
+		HELPER_EXPECT_SUCCESS(l.listen());
+
+		SrsTcpClient c(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout);
+		HELPER_EXPECT_SUCCESS(c.connect());
+		ASSERT_TRUE(h.fd != NULL);
+
+		SrsStSocket skt;
+		HELPER_EXPECT_SUCCESS(skt.initialize(h.fd));
+		HELPER_EXPECT_SUCCESS(skt.write((void*)"Hello", 5, NULL));
+		srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+		EXPECT_FALSE(c.is_alive());
+	}
+}
+
 VOID TEST(TCPServerTest, StringIsDigital)
 {
     EXPECT_EQ(0, ::atoi("0"));
@@ -1286,3 +1333,280 @@ VOID TEST(TCPServerTest, ContextUtility)
     }
 }
 
+// The coroutine to poll the fds once, and record the revents.
+class MockStPoller
+{
+public:
+    struct pollfd pds[2];
+    int npds;
+    srs_utime_t timeout;
+    int r0;
+    bool done;
+    st_thread_t trd;
+public:
+    MockStPoller(int fd, short events, srs_utime_t tm = SRS_UTIME_NO_TIMEOUT) {
+        npds = 1;
+        pds[0].fd = fd;
+        pds[0].events = events;
+        pds[0].revents = 0;
+        timeout = tm;
+        r0 = 0;
+        done = false;
+        trd = st_thread_create(pfn, this, 1, 0);
+    }
+    virtual ~MockStPoller() {
+        st_thread_join(trd, NULL);
+    }
+    // Poll another fd together.
+    void add(int fd, short events) {
+        pds[npds].fd = fd;
+        pds[npds].events = events;
+        pds[npds].revents = 0;
+        npds++;
+    }
+    static void* pfn(void* arg) {
+        MockStPoller* p = (MockStPoller*)arg;
+        p->r0 = st_poll(p->pds, p->npds, p->timeout);
+        p->done = true;
+        return NULL;
+    }
+};
+
+VOID TEST(ServiceStDispatchTest, WakeupReady)
+{
+    int p0[2], p1[2], sv[2];
+    ASSERT_EQ(0, pipe(p0));
+    ASSERT_EQ(0, pipe(p1));
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+
+    // Only wakeup the coroutine whose fd is ready.
+    if (true) {
+        MockStPoller a(p0[0], POLLIN), b(p1[0], POLLIN);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(a.done);
+        EXPECT_FALSE(b.done);
+
+        EXPECT_EQ(1, write(p1[1], "x", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(a.done);
+        EXPECT_TRUE(b.done);
+        EXPECT_EQ(1, b.r0);
+        EXPECT_EQ(POLLIN, b.pds[0].revents);
+
+        EXPECT_EQ(1, write(p0[1], "x", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(a.done);
+
+        char buf[1];
+        EXPECT_EQ(1, read(p0[0], buf, 1));
+        EXPECT_EQ(1, read(p1[0], buf, 1));
+    }
+
+    // The coroutines wait for different events of the same fd.
+    if (true) {
+        MockStPoller r(sv[0], POLLIN), w(sv[0], POLLOUT);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(r.done);
+        EXPECT_TRUE(w.done);
+        EXPECT_EQ(POLLOUT, w.pds[0].revents);
+
+        EXPECT_EQ(1, write(sv[1], "x", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(r.done);
+        EXPECT_EQ(POLLIN, r.pds[0].revents);
+
+        char buf[1];
+        EXPECT_EQ(1, read(sv[0], buf, 1));
+    }
+
+    // Only the ready fd has revents, when poll many fds.
+    if (true) {
+        MockStPoller a(p0[0], POLLIN);
+        a.add(p1[0], POLLIN);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(a.done);
+
+        EXPECT_EQ(1, write(p1[1], "x", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(a.done);
+        EXPECT_EQ(1, a.r0);
+        EXPECT_EQ(0, a.pds[0].revents);
+        EXPECT_EQ(POLLIN, a.pds[1].revents);
+
+        char buf[1];
+        EXPECT_EQ(1, read(p1[0], buf, 1));
+    }
+
+    // The timeout coroutine is never woken up by the fd again.
+    if (true) {
+        MockStPoller a(p0[0], POLLIN, 1 * SRS_UTIME_MILLISECONDS);
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(a.done);
+        EXPECT_EQ(0, a.r0);
+
+        MockStPoller b(p0[0], POLLIN);
+        EXPECT_EQ(1, write(p0[1], "x", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(b.done);
+
+        char buf[1];
+        EXPECT_EQ(1, read(p0[0], buf, 1));
+    }
+
+    ::close(p0[0]); ::close(p0[1]);
+    ::close(p1[0]); ::close(p1[1]);
+    ::close(sv[0]); ::close(sv[1]);
+}
+
+// The coroutine to read the netfd once.
+class MockStReader
+{
+public:
+    st_netfd_t stfd;
+    srs_utime_t timeout;
+    char buf[8];
+    ssize_t nread;
+    bool done;
+    st_thread_t trd;
+public:
+    MockStReader(st_netfd_t fd, srs_utime_t tm = SRS_UTIME_NO_TIMEOUT) {
+        stfd = fd;
+        timeout = tm;
+        nread = 0;
+        done = false;
+        trd = st_thread_create(pfn, this, 1, 0);
+    }
+    virtual ~MockStReader() {
+        st_thread_join(trd, NULL);
+    }
+    static void* pfn(void* arg) {
+        MockStReader* p = (MockStReader*)arg;
+        p->nread = st_read(p->stfd, p->buf, 1, p->timeout);
+        p->done = true;
+        return NULL;
+    }
+};
+
+// The coroutine to write the netfd until all written.
+class MockStWriter
+{
+public:
+    st_netfd_t stfd;
+    std::string data;
+    ssize_t nwrite;
+    bool done;
+    st_thread_t trd;
+public:
+    MockStWriter(st_netfd_t fd, int size) {
+        stfd = fd;
+        data.resize(size, 'x');
+        nwrite = 0;
+        done = false;
+        trd = st_thread_create(pfn, this, 1, 0);
+    }
+    virtual ~MockStWriter() {
+        st_thread_join(trd, NULL);
+    }
+    static void* pfn(void* arg) {
+        MockStWriter* p = (MockStWriter*)arg;
+        p->nwrite = st_write(p->stfd, p->data.data(), p->data.length(), ST_UTIME_NO_TIMEOUT);
+        p->done = true;
+        return NULL;
+    }
+};
+
+VOID TEST(ServiceStDispatchTest, EdgeTriggered)
+{
+    int sv[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+    st_netfd_t stfd = st_netfd_open_socket(sv[0]);
+    ASSERT_TRUE(stfd != NULL);
+
+    // The edge is reported once, but the cached readiness keeps the left data readable.
+    if (true) {
+        MockStReader r(stfd);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(r.done);
+
+        EXPECT_EQ(2, write(sv[1], "xy", 2));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(r.done);
+        EXPECT_EQ(1, r.nread);
+        EXPECT_EQ('x', r.buf[0]);
+
+        srs_utime_t starttime = srs_update_system_time();
+        EXPECT_EQ(0, st_netfd_poll(stfd, POLLIN, 100 * SRS_UTIME_MILLISECONDS));
+        EXPECT_LT(srs_update_system_time() - starttime, 50 * SRS_UTIME_MILLISECONDS);
+
+        char buf[1];
+        EXPECT_EQ(1, st_read(stfd, buf, 1, ST_UTIME_NO_TIMEOUT));
+        EXPECT_EQ('y', buf[0]);
+    }
+
+    // The EAGAIN clears the cached readiness, then wait for the next edge.
+    if (true) {
+        MockStReader r(stfd, 1 * SRS_UTIME_MILLISECONDS);
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(r.done);
+        EXPECT_EQ(-1, r.nread);
+
+        MockStReader r2(stfd);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(r2.done);
+
+        EXPECT_EQ(1, write(sv[1], "z", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(r2.done);
+        EXPECT_EQ(1, r2.nread);
+        EXPECT_EQ('z', r2.buf[0]);
+    }
+
+    // The first write wait registers the EPOLLOUT, then the writer wakes up when the peer reads.
+    if (true) {
+        MockStWriter w(stfd, 1024 * 1024);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(w.done);
+
+        int flags = fcntl(sv[1], F_GETFL);
+        ASSERT_EQ(0, fcntl(sv[1], F_SETFL, flags | O_NONBLOCK));
+
+        char buf[4096];
+        ssize_t nread = 0;
+        for (int i = 0; i < 1000 && nread < (ssize_t)w.data.length(); i++) {
+            ssize_t nn = read(sv[1], buf, sizeof(buf));
+            if (nn > 0) {
+                nread += nn;
+            } else {
+                srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+            }
+        }
+        EXPECT_EQ((ssize_t)w.data.length(), nread);
+        EXPECT_TRUE(w.done);
+        EXPECT_EQ((ssize_t)w.data.length(), w.nwrite);
+
+        ASSERT_EQ(0, fcntl(sv[1], F_SETFL, flags));
+    }
+
+    // The netfd is unregistered when closed, so the number is able to be polled by others.
+    if (true) {
+        st_netfd_close(stfd);
+
+        // The pipe reuses the closed number of netfd.
+        int fds[2];
+        ASSERT_EQ(0, pipe(fds));
+        EXPECT_EQ(sv[0], fds[0]);
+
+        MockStPoller a(fds[0], POLLIN);
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_FALSE(a.done);
+
+        EXPECT_EQ(1, write(fds[1], "x", 1));
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(a.done);
+        EXPECT_EQ(POLLIN, a.pds[0].revents);
+
+        ::close(fds[0]); ::close(fds[1]);
+    }
+
+    ::close(sv[1]);
+}